@@ -59,6 +59,15 @@ else()
   find_package(Poppler 0.24  COMPONENTS Qt4)
 endif()
 
+if(PKG_CONFIG_EXECUTABLE)
+  find_package(TIFF )
+  if((NOT TIFF_FOUND) AND (NOT TIFF_FOUND))
+    pkg_check_modules(TIFF TIFF)
+  endif()
+else()
+  find_package(TIFF  )
+endif()
+
 if(PKG_CONFIG_EXECUTABLE)
   find_package(GLUT )
   if((NOT GLUT_FOUND) AND (NOT GLUT_FOUND))
@@ -198,6 +207,22 @@ if(Poppler_name)
   endif()
 endif()
 
+if(TIFF_FOUND)
+  set(TIFF_name TIFF)
+  set(TIFF_FOUND TRUE)
+elseif(TIFF_FOUND)
+  set(TIFF_name TIFF)
+  set(TIFF_FOUND TRUE)
+endif()
+if(TIFF_name)
+  list(APPEND FIND_PACKAGES_DEFINES DISPLAYCLUSTER_USE_TIFF)
+  set(FIND_PACKAGES_FOUND "${FIND_PACKAGES_FOUND} TIFF")
+  link_directories(${${TIFF_name}_LIBRARY_DIRS})
+  if(NOT "${${TIFF_name}_INCLUDE_DIRS}" MATCHES "-NOTFOUND")
+    include_directories(${${TIFF_name}_INCLUDE_DIRS})
+  endif()
+endif()
+
 if(GLUT_FOUND)
   set(GLUT_name GLUT)
   set(GLUT_FOUND TRUE)
@@ -294,9 +319,9 @@ if(FCGI_name)
   endif()
 endif()
 
-set(DISPLAYCLUSTER_BUILD_DEBS autoconf;automake;cmake;doxygen;freeglut3-dev;git;git-review;libavcodec-dev;libavformat-dev;libavutil-dev;libboost-date-time-dev;libboost-program-options-dev;libboost-regex-dev;libboost-serialization-dev;libboost-system-dev;libboost-test-dev;libboost-thread-dev;libfcgi-dev;libjpeg-turbo8-dev;libopenmpi-dev;libpoppler-dev;libswscale-dev;libturbojpeg;libxmu-dev;openmpi-bin;pkg-config;subversion)
+set(DISPLAYCLUSTER_BUILD_DEBS autoconf;automake;cmake;doxygen;freeglut3-dev;git;git-review;libavcodec-dev;libavformat-dev;libavutil-dev;libboost-date-time-dev;libboost-program-options-dev;libboost-regex-dev;libboost-serialization-dev;libboost-system-dev;libboost-test-dev;libboost-thread-dev;libfcgi-dev;libjpeg-turbo8-dev;libopenmpi-dev;libpoppler-dev;libswscale-dev;libtiff-dev;libturbojpeg;libxmu-dev;openmpi-bin;pkg-config;subversion)
 
-set(DISPLAYCLUSTER_DEPENDS Boost;LibJpegTurbo;Qt4;MPI;Poppler;GLUT;OpenGL;TUIO;FFMPEG;OpenMP;FCGI)
+set(DISPLAYCLUSTER_DEPENDS Boost;LibJpegTurbo;Qt4;MPI;Poppler;TIFF;GLUT;OpenGL;TUIO;FFMPEG;OpenMP;FCGI)
 
 # Write defines.h and options.cmake
 if(NOT PROJECT_INCLUDE_NAME)
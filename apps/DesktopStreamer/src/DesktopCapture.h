@@ -0,0 +1,91 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DESKTOPCAPTURE_H
+#define DESKTOPCAPTURE_H
+
+#include <QImage>
+#include <QRect>
+#include <QRegion>
+
+/**
+ * Grab the content of a rectangle of the desktop.
+ *
+ * Implementations may reuse the same buffer for successive captures; the
+ * returned image is only valid until the next call to capture().
+ */
+class DesktopCapture
+{
+public:
+    /** Destructor */
+    virtual ~DesktopCapture() {}
+
+    /**
+     * Capture a rectangle of the desktop.
+     *
+     * @param rect The rectangle to grab, in desktop pixel coordinates.
+     * @param damage Output: the regions which changed since the previous
+     *        capture, in image coordinates. Backends which cannot track
+     *        changes report the whole image.
+     * @return The captured image in QImage::Format_RGB32, or a null image on
+     *         failure.
+     */
+    virtual QImage capture( const QRect& rect, QRegion& damage ) = 0;
+
+    /**
+     * Create the most efficient capture backend available on this system.
+     * @return A new capture object, to be deleted by the caller.
+     */
+    static DesktopCapture* create();
+};
+
+/**
+ * Capture the desktop through QPixmap::grabWindow.
+ *
+ * This backend works on all platforms but does not track changes. It must be
+ * used from the GUI thread.
+ */
+class QtDesktopCapture : public DesktopCapture
+{
+public:
+    /** @copydoc DesktopCapture::capture */
+    QImage capture( const QRect& rect, QRegion& damage ) override;
+};
+
+#endif // DESKTOPCAPTURE_H
@@ -41,8 +41,7 @@
 #include "DesktopSelectionWindow.h"
 #include "DesktopSelectionView.h"
 #include "DesktopSelectionRectangle.h"
-
-#include "dcstream/Stream.h"
+#include "DesktopCapture.h"
 
 #include <QAction>
 #include <QToolBar>
@@ -58,10 +57,8 @@
     #include <stdint.h>
 #endif
 
-#include <unistd.h>
 #include <iostream>
 
-#define SHARE_DESKTOP_UPDATE_DELAY      1
 #define FRAME_RATE_AVERAGE_NUM_FRAMES  10
 
 #define DEFAULT_HOST_ADDRESS  "bbplxviz03.epfl.ch"
@@ -75,6 +72,7 @@ MainWindow::MainWindow()
     , width_(0)
     , height_(0)
     , deviceScale_(1.f)
+    , sendPending_(false)
 {
     generateCursorImage();
     setupUI();
@@ -185,17 +183,31 @@ void MainWindow::startStreaming()
         return;
     }
 
-    shareDesktopUpdateTimer_.start(SHARE_DESKTOP_UPDATE_DELAY);
+    desktopCapture_.reset(DesktopCapture::create());
+    cursorPosition_ = QPoint();
+
+    shareDesktopUpdateTimer_.start(1000 / frameRateSpinBox_.value());
 }
 
 void MainWindow::stopStreaming()
 {
     shareDesktopUpdateTimer_.stop();
     frameRateLabel_.setText("");
+    frameSentTimes_.clear();
+
+    // The stream worker may still be reading the image of the last frame
+    if( sendPending_ )
+    {
+        sendFuture_.wait();
+        sendPending_ = false;
+    }
 
     delete dcStream_;
     dcStream_ = 0;
 
+    sentImage_ = QImage();
+    desktopCapture_.reset();
+
     emit streaming(false);
 }
 
@@ -258,63 +270,75 @@ void MainWindow::showDesktopSelectionWindow(bool set)
 
 void MainWindow::shareDesktopUpdate()
 {
-    // time the frame
-    QTime frameTime;
-    frameTime.start();
+    // The previous frame is still being compressed and sent, skip this one
+    // rather than overwriting the image used by the stream worker.
+    if( sendPending_ && !sendFuture_.is_ready( ))
+        return;
 
-    const int w = width_ * deviceScale_;
-    const int h = height_ * deviceScale_;
+    if( !finishPendingSend( ))
+    {
+        handleStreamingError("Streaming failure, connection closed.");
+        return;
+    }
+
+    const QRect rect( x_, y_, width_ * deviceScale_, height_ * deviceScale_ );
 
     // take screenshot
-    QPixmap desktopPixmap =
-        QPixmap::grabWindow( QApplication::desktop()->winId(), x_, y_, w, h );
+    QRegion damage;
+    QImage image = desktopCapture_->capture( rect, damage );
 
-    if( desktopPixmap.isNull( ))
+    if( image.isNull( ))
     {
-        handleStreamingError("Got NULL desktop pixmap");
+        handleStreamingError("Got NULL desktop image");
         return;
     }
 
-    QImage image = desktopPixmap.toImage();
+    const QPoint cursorPosition =
+        ( QCursor::pos() - QPoint( x_, y_ )) * deviceScale_ -
+        QPoint( cursor_.width()/2, cursor_.height()/2 );
 
-    // render mouse cursor
-    QPoint mousePos = ( QCursor::pos() - QPoint( x_, y_ )) * deviceScale_ -
-                        QPoint( cursor_.width()/2, cursor_.height()/2);
+    // Nothing changed since the last frame, the wall is already up to date
+    if( damage.isEmpty() && cursorPosition == cursorPosition_ )
+        return;
+
+    cursorPosition_ = cursorPosition;
 
+    // render mouse cursor
     QPainter painter( &image );
-    painter.drawImage( mousePos, cursor_ );
+    painter.drawImage( cursorPosition, cursor_ );
     painter.end(); // Make sure to release the QImage before using it to update the segements
 
+    // The image must stay valid until the stream worker is done with it
+    sentImage_ = image;
+
     // QImage Format_RGB32 (0xffRRGGBB) corresponds in fact to GL_BGRA == dc::BGRA
-    dc::ImageWrapper dcImage((const void*)image.bits(), image.width(), image.height(), dc::BGRA);
+    dc::ImageWrapper dcImage((const void*)sentImage_.constBits(),
+                             sentImage_.width(), sentImage_.height(), dc::BGRA);
     dcImage.compressionPolicy = dc::COMPRESSION_ON;
 
-    bool success = dcStream_->send(dcImage) && dcStream_->finishFrame();
+    sendFuture_ = dcStream_->asyncSend(dcImage);
+    sendPending_ = true;
 
-    if( !success )
-    {
-        handleStreamingError("Streaming failure, connection closed.");
-        return;
-    }
+    regulateFrameRate();
+}
 
-    regulateFrameRate(frameTime.elapsed());
+bool MainWindow::finishPendingSend()
+{
+    if( !sendPending_ )
+        return true;
+
+    sendPending_ = false;
+    return sendFuture_.get();
 }
 
-void MainWindow::regulateFrameRate(const int elapsedFrameTime)
+void MainWindow::regulateFrameRate()
 {
-    // frame rate limiting
+    // frame rate limiting, the timer paces the captures
     const int maxFrameRate = frameRateSpinBox_.value();
     const int desiredFrameTime = (int)(1000. * 1. / (float)maxFrameRate);
-    const int sleepTime = desiredFrameTime - elapsedFrameTime;
 
-    if(sleepTime > 0)
-    {
-#ifdef _WIN32
-        Sleep(sleepTime);
-#else
-        usleep(1000 * sleepTime);
-#endif
-    }
+    if( shareDesktopUpdateTimer_.interval() != desiredFrameTime )
+        shareDesktopUpdateTimer_.setInterval(desiredFrameTime);
 
     // frame rate is calculated for every FRAME_RATE_AVERAGE_NUM_FRAMES sequential frames
     frameSentTimes_.push_back(QTime::currentTime());
@@ -47,10 +47,10 @@
 #include <QLabel>
 #include <QMainWindow>
 
-namespace dc
-{
-class Stream;
-}
+#include <boost/scoped_ptr.hpp>
+
+#include "dcstream/Stream.h"
+#include "DesktopCapture.h"
 
 class DesktopSelectionWindow;
 
@@ -107,9 +107,19 @@ private:
     /*@}*/
 
     QImage cursor_;
+    QPoint cursorPosition_;
 
     QTimer shareDesktopUpdateTimer_;
 
+    boost::scoped_ptr<DesktopCapture> desktopCapture_;
+
+    /** @name Frame being sent by the stream worker */
+    /*@{*/
+    QImage sentImage_;
+    dc::Stream::Future sendFuture_;
+    bool sendPending_;
+    /*@}*/
+
     // used for frame rate calculations
     std::vector<QTime> frameSentTimes_;
 
@@ -120,7 +130,8 @@ private:
     void stopStreaming();
     void handleStreamingError(const QString& errorMessage);
 
-    void regulateFrameRate(const int elapsedFrameTime);
+    bool finishPendingSend();
+    void regulateFrameRate();
 };
 
 #endif
@@ -0,0 +1,282 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "XShmDesktopCapture.h"
+
+#include <iostream>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+// Xlib defines macros (None, Bool, Status...) which clash with Qt headers
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+
+namespace
+{
+bool xErrorOccurred = false;
+
+int trapXError( Display*, XErrorEvent* )
+{
+    xErrorOccurred = true;
+    return 0;
+}
+}
+
+struct XShmDesktopCapture::Impl
+{
+    Impl( const char* displayName )
+        : display( XOpenDisplay( displayName ))
+        , root( 0 )
+        , damage( 0 )
+        , image( 0 )
+        , fullDamage( true )
+    {
+        shmInfo.shmid = -1;
+        shmInfo.shmaddr = 0;
+
+        if( !display )
+            return;
+
+        int eventBase, errorBase, major, minor;
+        if( !XShmQueryExtension( display ) ||
+            !XDamageQueryExtension( display, &eventBase, &errorBase ) ||
+            !XDamageQueryVersion( display, &major, &minor ) ||
+            !XFixesQueryExtension( display, &eventBase, &errorBase ) ||
+            !XFixesQueryVersion( display, &major, &minor ))
+        {
+            std::cerr << "X display lacks the MIT-SHM, DAMAGE or XFIXES "
+                         "extension" << std::endl;
+            XCloseDisplay( display );
+            display = 0;
+            return;
+        }
+
+        // Only 32 bits pixels map directly to QImage::Format_RGB32
+        const int depth = DefaultDepth( display, DefaultScreen( display ));
+        if( depth != 24 && depth != 32 )
+        {
+            std::cerr << "Unsupported X display depth: " << depth << std::endl;
+            XCloseDisplay( display );
+            display = 0;
+            return;
+        }
+
+        root = DefaultRootWindow( display );
+        damage = XDamageCreate( display, root, XDamageReportNonEmpty );
+    }
+
+    ~Impl()
+    {
+        if( !display )
+            return;
+
+        destroyImage();
+        XDamageDestroy( display, damage );
+        XCloseDisplay( display );
+    }
+
+    bool createImage( const QSize& size )
+    {
+        const int screen = DefaultScreen( display );
+        image = XShmCreateImage( display, DefaultVisual( display, screen ),
+                                 DefaultDepth( display, screen ), ZPixmap,
+                                 0, &shmInfo, size.width(), size.height( ));
+        if( !image )
+            return false;
+
+        if( image->bits_per_pixel != 32 )
+        {
+            std::cerr << "Unsupported X image format: "
+                      << image->bits_per_pixel << " bpp" << std::endl;
+            XDestroyImage( image );
+            image = 0;
+            return false;
+        }
+
+        shmInfo.shmid = shmget( IPC_PRIVATE,
+                                image->bytes_per_line * image->height,
+                                IPC_CREAT | 0600 );
+        if( shmInfo.shmid < 0 )
+        {
+            XDestroyImage( image );
+            image = 0;
+            return false;
+        }
+
+        shmInfo.shmaddr = image->data = (char*)shmat( shmInfo.shmid, 0, 0 );
+        shmInfo.readOnly = False;
+
+        // Attaching fails asynchronously, e.g. for a remote display
+        bool attached = false;
+        if( shmInfo.shmaddr != (char*)-1 )
+        {
+            xErrorOccurred = false;
+            XErrorHandler previousHandler = XSetErrorHandler( trapXError );
+            XShmAttach( display, &shmInfo );
+            XSync( display, False );
+            XSetErrorHandler( previousHandler );
+            attached = !xErrorOccurred;
+        }
+
+        // The segment is released once both processes have detached from it
+        shmctl( shmInfo.shmid, IPC_RMID, 0 );
+
+        if( !attached )
+        {
+            if( shmInfo.shmaddr != (char*)-1 )
+                shmdt( shmInfo.shmaddr );
+            shmInfo.shmaddr = 0;
+            XDestroyImage( image );
+            image = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void destroyImage()
+    {
+        if( !image )
+            return;
+
+        XShmDetach( display, &shmInfo );
+        XSync( display, False );
+        XDestroyImage( image );
+        shmdt( shmInfo.shmaddr );
+        shmInfo.shmaddr = 0;
+        image = 0;
+    }
+
+    QRegion takeDamage()
+    {
+        // Discard the notifications, the region is queried directly
+        while( XPending( display ))
+        {
+            XEvent event;
+            XNextEvent( display, &event );
+        }
+
+        XserverRegion region = XFixesCreateRegion( display, 0, 0 );
+        XDamageSubtract( display, damage, None, region );
+
+        int count = 0;
+        XRectangle* rects = XFixesFetchRegion( display, region, &count );
+        QRegion result;
+        for( int i = 0; i < count; ++i )
+            result += QRect( rects[i].x, rects[i].y,
+                             rects[i].width, rects[i].height );
+        if( rects )
+            XFree( rects );
+        XFixesDestroyRegion( display, region );
+
+        return result;
+    }
+
+    Display* display;
+    Window root;
+    Damage damage;
+    XImage* image;
+    XShmSegmentInfo shmInfo;
+    QRect area;
+    bool fullDamage;
+};
+
+XShmDesktopCapture::XShmDesktopCapture( const char* displayName )
+    : impl_( new Impl( displayName ))
+{
+}
+
+XShmDesktopCapture::~XShmDesktopCapture()
+{
+}
+
+bool XShmDesktopCapture::isValid() const
+{
+    return impl_->display != 0;
+}
+
+QImage XShmDesktopCapture::capture( const QRect& rect, QRegion& damage )
+{
+    damage = QRegion();
+    if( !isValid( ))
+        return QImage();
+
+    // XShmGetImage fails for areas outside of the root window
+    const int screen = DefaultScreen( impl_->display );
+    const QRect rootRect( 0, 0, DisplayWidth( impl_->display, screen ),
+                          DisplayHeight( impl_->display, screen ));
+    const QRect area = rect & rootRect;
+    if( area.isEmpty( ))
+        return QImage();
+
+    if( !impl_->image || area.size() != QSize( impl_->image->width,
+                                               impl_->image->height ))
+    {
+        impl_->destroyImage();
+        if( !impl_->createImage( area.size( )))
+            return QImage();
+    }
+    if( area != impl_->area )
+    {
+        impl_->area = area;
+        impl_->fullDamage = true;
+    }
+
+    // Collect the damage before grabbing so that no change can be missed
+    const QRegion changed = impl_->takeDamage();
+
+    if( !XShmGetImage( impl_->display, impl_->root, impl_->image,
+                       area.x(), area.y(), AllPlanes ))
+    {
+        return QImage();
+    }
+
+    const QRect imageRect( QPoint(), area.size( ));
+    if( impl_->fullDamage )
+        damage = QRegion( imageRect );
+    else
+        damage = changed.translated( -area.topLeft( )) & imageRect;
+    impl_->fullDamage = false;
+
+    return QImage( (uchar*)impl_->image->data, area.width(), area.height(),
+                   impl_->image->bytes_per_line, QImage::Format_RGB32 );
+}
@@ -0,0 +1,83 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef XSHMDESKTOPCAPTURE_H
+#define XSHMDESKTOPCAPTURE_H
+
+#include "DesktopCapture.h"
+
+#include <boost/scoped_ptr.hpp>
+
+/**
+ * Capture the desktop of an X11 display using the MIT-SHM and DAMAGE
+ * extensions.
+ *
+ * The screen content is copied by the X server directly into a shared memory
+ * segment which is exposed as a QImage without further copies, and the DAMAGE
+ * extension reports which parts of the root window changed between captures.
+ * This class opens its own connection to the display, so it does not depend
+ * on the GUI thread.
+ */
+class XShmDesktopCapture : public DesktopCapture
+{
+public:
+    /**
+     * Connect to an X display.
+     * @param displayName The display to open, or 0 for the DISPLAY variable.
+     */
+    XShmDesktopCapture( const char* displayName = 0 );
+
+    /** Destructor */
+    ~XShmDesktopCapture();
+
+    /**
+     * Check that the display provides all the required extensions.
+     * @return true if this object can be used for capturing.
+     */
+    bool isValid() const;
+
+    /** @copydoc DesktopCapture::capture */
+    QImage capture( const QRect& rect, QRegion& damage ) override;
+
+private:
+    struct Impl;
+    boost::scoped_ptr<Impl> impl_;
+};
+
+#endif // XSHMDESKTOPCAPTURE_H
@@ -44,6 +44,7 @@
 #include "ContentFactory.h"
 #include "configuration/MasterConfiguration.h"
 #include "MPIChannel.h"
+#include "MovieStreamer.h"
 #include "Options.h"
 
 #if ENABLE_JOYSTICK_SUPPORT
@@ -121,6 +122,9 @@ void MasterApplication::init(const MasterConfiguration* config)
     startWebservice(config->getWebServicePort());
     restoreBackground(config);
 
+    if (config->getStreamMoviesFromMaster())
+        startMovieStreamer();
+
 #if ENABLE_JOYSTICK_SUPPORT
     startJoystickThread();
 #endif
@@ -195,6 +199,13 @@ void MasterApplication::initPixelStreamLauncher()
                                        SLOT(hideDock()));
 }
 
+void MasterApplication::startMovieStreamer()
+{
+    movieStreamer_.reset(new MovieStreamer(displayGroup_));
+    connect(movieStreamer_.get(), SIGNAL(sendPackets(MoviePacketsPtr)),
+            mpiChannel_.get(), SLOT(send(MoviePacketsPtr)));
+}
+
 #if ENABLE_JOYSTICK_SUPPORT
 void MasterApplication::startJoystickThread()
 {
@@ -44,6 +44,7 @@
 #include <boost/scoped_ptr.hpp>
 
 class MasterWindow;
+class MovieStreamer;
 class NetworkListener;
 class PixelStreamerLauncher;
 class PixelStreamWindowManager;
@@ -77,6 +78,7 @@ private:
     boost::scoped_ptr<PixelStreamWindowManager> pixelStreamWindowManager_;
     boost::scoped_ptr<WebServiceServer> webServiceServer_;
     boost::scoped_ptr<TextInputDispatcher> textInputDispatcher_;
+    boost::scoped_ptr<MovieStreamer> movieStreamer_;
 
 #if ENABLE_JOYSTICK_SUPPORT
     boost::scoped_ptr<JoystickThread> joystickThread_;
@@ -91,6 +93,7 @@ private:
     void startWebservice(const int webServicePort);
     void restoreBackground(const MasterConfiguration* configuration);
     void initPixelStreamLauncher();
+    void startMovieStreamer();
 
 #if ENABLE_JOYSTICK_SUPPORT
     void startJoystickThread();
@@ -50,6 +50,7 @@
 #include "localstreamer/DockPixelStreamer.h"
 
 #include "DynamicTexture.h"
+#include "ImagePyramidBuilder.h"
 
 #include "DisplayGroupManager.h"
 #include "ContentWindowManager.h"
@@ -486,8 +487,13 @@ void MasterWindow::computeImagePyramid()
 
         put_flog(LOG_DEBUG, "target image pyramid folder %s", imagePyramidPath.toLocal8Bit().constData());
 
-        DynamicTexturePtr dynamicTexture(new DynamicTexture(imageFilename));
-        dynamicTexture->generateImagePyramid(imagePyramidPath);
+        ImagePyramidBuilder builder(imageFilename, imagePyramidPath);
+        if(!builder.build())
+        {
+            QMessageBox::warning(this, "Error", "Could not generate the image pyramid.",
+                                 QMessageBox::Ok, QMessageBox::Ok);
+            return;
+        }
 
         put_flog(LOG_DEBUG, "done");
     }
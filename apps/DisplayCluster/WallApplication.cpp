@@ -45,6 +45,7 @@
 #include "RenderContext.h"
 #include "Factories.h"
 #include "PixelStreamFrame.h"
+#include "MoviePackets.h"
 #include "GLWindow.h"
 #include "TestPattern.h"
 #include "DisplayGroupManager.h"
@@ -53,6 +54,20 @@
 
 #include <boost/foreach.hpp>
 
+namespace
+{
+bool isDisplayed(DisplayGroupManagerPtr displayGroup, const QString& uri)
+{
+    BOOST_FOREACH(ContentWindowManagerPtr window, displayGroup->getContentWindowManagers())
+    {
+        if (window->getContent()->getURI() == uri)
+            return true;
+    }
+    ContentWindowManagerPtr backgroundWindow = displayGroup->getBackgroundContentWindow();
+    return backgroundWindow && backgroundWindow->getContent()->getURI() == uri;
+}
+}
+
 WallApplication::WallApplication(int& argc_, char** argv_, MPIChannelPtr mpiChannel)
     : Application(argc_, argv_, mpiChannel)
 {
@@ -62,8 +77,8 @@ WallApplication::WallApplication(int& argc_, char** argv_, MPIChannelPtr mpiChan
 
     renderContext_.reset(new RenderContext(config));
 
-    factories_.reset(new Factories(*renderContext_));
-    displayGroupRenderer_.reset(new DisplayGroupRenderer(factories_));
+    factories_.reset(new Factories(*renderContext_, *config));
+    displayGroupRenderer_.reset(new DisplayGroupRenderer(factories_, *renderContext_));
     displayGroupRenderer_->setDisplayGroup(displayGroup_);
 
     if (mpiChannel_->getRank() == 1)
@@ -90,6 +105,9 @@ WallApplication::WallApplication(int& argc_, char** argv_, MPIChannelPtr mpiChan
     connect(mpiChannel_.get(), SIGNAL(received(PixelStreamFramePtr)),
             this, SLOT(processPixelStreamFrame(PixelStreamFramePtr)));
 
+    connect(mpiChannel_.get(), SIGNAL(received(MoviePacketsPtr)),
+            this, SLOT(processMoviePackets(MoviePacketsPtr)));
+
     // setup connection so renderFrame() will be called continuously.
     // Must be a queued connection to avoid infinite recursion.
     connect(this, SIGNAL(frameFinished()),
@@ -111,12 +129,16 @@ void WallApplication::renderFrame()
     // accurate time for rendering, etc. below
     mpiChannel_->synchronizeClock();
 
+    // Contents loaded in the background become available for rendering
+    factories_->finishPendingObjects();
+
     // All processes swap windows sychronously
     renderContext_->updateGLWindows();
     mpiChannel_->globalBarrier();
     renderContext_->swapBuffers();
 
     advanceContent();
+    forwardMoviePacketBacklog();
 
     factories_->clearStaleFactoryObjects();
 
@@ -167,3 +189,64 @@ void WallApplication::processPixelStreamFrame(PixelStreamFramePtr frame)
     Factory<PixelStream>& pixelStreamFactory = factories_->getPixelStreamFactory();
     pixelStreamFactory.getObject(frame->uri)->insertNewFrame(frame->segments);
 }
+
+void WallApplication::processMoviePackets(MoviePacketsPtr packets)
+{
+    if (!packets)
+        return;
+
+    Factory<Movie>& movieFactory = factories_->getMovieFactory();
+    boost::shared_ptr<Movie> movie = movieFactory.findObject(packets->uri);
+    if (movie)
+    {
+        movie->addPackets(*packets);
+        return;
+    }
+
+    // Movies are created by advanceContent(), possibly after their first
+    // packets are received. The master sends nothing while a movie is paused
+    // or finished, so keep the stream parameters and the packets since the
+    // last keyframe for the Movie to be able to decode its current frame.
+    MoviePacketsPtr& backlog = moviePacketBacklog_[packets->uri];
+    if (!backlog)
+    {
+        backlog = packets;
+    }
+    else
+    {
+        backlog->parameters = packets->parameters;
+        backlog->position = packets->position;
+        backlog->loop = packets->loop;
+        backlog->packets.insert(backlog->packets.end(), packets->packets.begin(),
+                                packets->packets.end());
+    }
+
+    std::vector<MoviePacket>& backlogPackets = backlog->packets;
+    for (size_t i = backlogPackets.size(); i > 1; --i)
+    {
+        if (backlogPackets[i - 1].keyframe)
+        {
+            backlogPackets.erase(backlogPackets.begin(), backlogPackets.begin() + i - 1);
+            break;
+        }
+    }
+}
+
+void WallApplication::forwardMoviePacketBacklog()
+{
+    Factory<Movie>& movieFactory = factories_->getMovieFactory();
+
+    std::map<QString, MoviePacketsPtr>::iterator it = moviePacketBacklog_.begin();
+    while (it != moviePacketBacklog_.end())
+    {
+        boost::shared_ptr<Movie> movie = movieFactory.findObject(it->first);
+        if (movie)
+            movie->addPackets(*it->second);
+
+        // Drop the backlog once forwarded, or if the movie is not displayed
+        if (movie || !isDisplayed(displayGroup_, it->first))
+            moviePacketBacklog_.erase(it++);
+        else
+            ++it;
+    }
+}
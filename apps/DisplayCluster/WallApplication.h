@@ -46,6 +46,7 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #endif
 #include <boost/scoped_ptr.hpp>
+#include <map>
 
 class WallConfiguration;
 class RenderContext;
@@ -78,6 +79,7 @@ private slots:
     void updateDisplayGroup(DisplayGroupManagerPtr displayGroup);
     void updateOptions(OptionsPtr options);
     void processPixelStreamFrame(PixelStreamFramePtr frame);
+    void processMoviePackets(MoviePacketsPtr packets);
 
 private:
     boost::scoped_ptr<RenderContext> renderContext_;
@@ -85,9 +87,15 @@ private:
     FactoriesPtr factories_;
     boost::posix_time::ptime lastFrameTime_;
 
+    /** Packets received for movies not created yet, from their last keyframe. */
+    std::map<QString, MoviePacketsPtr> moviePacketBacklog_;
+
     /** Update the content every frame. */
     void advanceContent();
 
+    /** Give the backlog of packets to the movies created since they arrived. */
+    void forwardMoviePacketBacklog();
+
     /** Get the time since the last frame was rendered. */
     boost::posix_time::time_duration getTimeSinceLastFrame() const;
 };
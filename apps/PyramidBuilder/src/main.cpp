@@ -0,0 +1,186 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ImagePyramidBuilder.h"
+#include "ImagePyramidContainer.h"
+#include "DynamicTexture.h"
+
+#include <QCoreApplication>
+#include <QString>
+
+#include <boost/program_options.hpp>
+#include <iostream>
+
+#define INVALID_ARGUMENTS_ERROR_CODE 1
+#define PYRAMID_BUILD_ERROR_CODE     2
+#define CONVERSION_ERROR_CODE        3
+
+namespace
+{
+bool parseTileFormat(const std::string& compression, ImagePyramidContainer::TileFormat& tileFormat)
+{
+    if(compression == "none")
+        tileFormat = ImagePyramidContainer::TILES_JPEG;
+    else if(compression == "bc1")
+        tileFormat = ImagePyramidContainer::TILES_BC1;
+    else if(compression == "bc3")
+        tileFormat = ImagePyramidContainer::TILES_BC3;
+    else
+        return false;
+    return true;
+}
+}
+
+namespace po = boost::program_options;
+
+int main(int argc, char * argv[])
+{
+    po::options_description desc("Usage: pyramidbuilder [options] image\n"
+                                 "       pyramidbuilder --convert [--output file] [--compression bc1|bc3] metadata.pyr\n"
+                                 "Allowed options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("convert", "convert an existing pyramid folder to a single-file container")
+        ("output", po::value<std::string>()->default_value(""),
+                   "pyramid folder (default: image.pyramid/), or container file "
+                   "when converting (default: replace metadata.pyr)")
+        ("threads", po::value<int>()->default_value(0),
+                    "number of encoding threads (default: number of cores)")
+        ("strip-size", po::value<unsigned int>()->default_value(512),
+                       "maximum size of the image strips read at once in MB")
+        ("compression", po::value<std::string>()->default_value("none"),
+                        "store GPU compressed tiles in a container: none, bc1 "
+                        "(opaque, 4 bits per pixel) or bc3 (alpha, 8 bits per pixel). "
+                        "The JPEG tiles are kept in the pyramid folder.")
+    ;
+
+    po::options_description hidden;
+    hidden.add_options()
+        ("image", po::value<std::string>(), "source image");
+
+    po::options_description all;
+    all.add(desc).add(hidden);
+
+    po::positional_options_description positional;
+    positional.add("image", 1);
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(all).positional(positional).run(), vm);
+        po::notify(vm);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return INVALID_ARGUMENTS_ERROR_CODE;
+    }
+
+    if(vm.count("help") || !vm.count("image"))
+    {
+        std::cout << desc << std::endl;
+        return vm.count("help") ? 0 : INVALID_ARGUMENTS_ERROR_CODE;
+    }
+
+    ImagePyramidContainer::TileFormat tileFormat;
+    if(!parseTileFormat(vm["compression"].as<std::string>(), tileFormat))
+    {
+        std::cerr << "Invalid compression: " << vm["compression"].as<std::string>() << std::endl;
+        return INVALID_ARGUMENTS_ERROR_CODE;
+    }
+
+    // Required for loading the image format plugins
+    QCoreApplication app(argc, argv);
+
+    const QString imageFilename = QString::fromStdString(vm["image"].as<std::string>());
+
+    if(vm.count("convert"))
+    {
+        QString containerFilename = QString::fromStdString(vm["output"].as<std::string>());
+        if(containerFilename.isEmpty())
+            containerFilename = imageFilename;
+
+        if(!ImagePyramidContainer::convert(imageFilename, containerFilename, tileFormat))
+        {
+            std::cerr << "Failed to convert the image pyramid." << std::endl;
+            return CONVERSION_ERROR_CODE;
+        }
+        return 0;
+    }
+
+    QString pyramidFolder = QString::fromStdString(vm["output"].as<std::string>());
+    if(pyramidFolder.isEmpty())
+        pyramidFolder = imageFilename + DynamicTexture::pyramidFolderSuffix;
+
+    ImagePyramidBuilder builder(imageFilename, pyramidFolder);
+
+    const int threads = vm["threads"].as<int>();
+    if(threads > 0)
+        builder.setEncodingThreadCount(threads);
+    builder.setMaxStripSize(size_t(vm["strip-size"].as<unsigned int>()) * 1024 * 1024);
+
+    if(!builder.build())
+    {
+        std::cerr << "Failed to build the image pyramid." << std::endl;
+        return PYRAMID_BUILD_ERROR_CODE;
+    }
+
+    // Replace the metadata file next to the pyramid folder, which is the one
+    // opened by the users, by a container of compressed tiles
+    if(tileFormat != ImagePyramidContainer::TILES_JPEG)
+    {
+        if(!pyramidFolder.endsWith('/'))
+            pyramidFolder.append('/');
+        const QString metadataFilename = pyramidFolder + DynamicTexture::pyramidMetadataFilename;
+
+        QString containerFilename = pyramidFolder;
+        if(containerFilename.endsWith(DynamicTexture::pyramidFolderSuffix))
+            containerFilename.chop(DynamicTexture::pyramidFolderSuffix.size());
+        else
+            containerFilename.chop(1);
+        containerFilename.append(".").append(DynamicTexture::pyramidFileExtension);
+
+        if(!ImagePyramidContainer::convert(metadataFilename, containerFilename, tileFormat))
+        {
+            std::cerr << "Failed to convert the image pyramid." << std::endl;
+            return CONVERSION_ERROR_CODE;
+        }
+    }
+    return 0;
+}
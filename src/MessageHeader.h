@@ -66,7 +66,10 @@ enum MessageType
     MESSAGE_TYPE_COMMAND,
     MESSAGE_TYPE_QUIT,
     MESSAGE_TYPE_ACK,
-    MESSAGE_TYPE_OPTIONS
+    MESSAGE_TYPE_OPTIONS,
+    MESSAGE_TYPE_MOVIE_PACKETS,
+    MESSAGE_TYPE_PIXELSTREAM_SHARED_OPEN,
+    MESSAGE_TYPE_PIXELSTREAM_SHARED
 };
 
 #define MESSAGE_HEADER_URI_LENGTH 64
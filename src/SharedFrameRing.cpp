@@ -0,0 +1,325 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "SharedFrameRing.h"
+
+#include "log.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SHARED_FRAME_RING_MAGIC   "DCFRAME1"
+#define SHARED_FRAME_RING_VERSION 1
+
+namespace dc
+{
+
+namespace
+{
+const uint32_t MAX_SLOT_COUNT = 16;
+const int POLL_INTERVAL_US = 200;
+
+const int SLOT_FREE = 0;
+const int SLOT_USED = 1;
+
+size_t alignTo64(const size_t size)
+{
+    return (size + 63) & ~size_t(63);
+}
+
+// Atomic read with a full memory barrier, available in all Qt versions
+int readAtomic(QAtomicInt& value)
+{
+    return value.fetchAndAddOrdered(0);
+}
+
+std::string makeUniqueName()
+{
+    static QAtomicInt counter;
+    char name[64];
+#ifdef _WIN32
+    const int pid = 0;
+#else
+    const int pid = getpid();
+#endif
+    snprintf(name, sizeof(name), "/dcstream-%d-%d", pid,
+             counter.fetchAndAddOrdered(1));
+    return std::string(name);
+}
+}
+
+struct SharedFrameRing::Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint64_t slotSize;
+    QAtomicInt readerAttached;
+    QAtomicInt slotStates[MAX_SLOT_COUNT];
+};
+
+SharedFrameRing::SharedFrameRing(const uint32_t slotCount, const size_t slotSize)
+    : name_(makeUniqueName())
+    , owner_(true)
+    , fd_(-1)
+    , mapping_(0)
+    , mappingSize_(0)
+    , header_(0)
+    , data_(0)
+    , nextSlot_(0)
+{
+    if(!create(slotCount, slotSize))
+    {
+        put_flog(LOG_WARN, "could not create the shared frame ring %s", name_.c_str());
+        detach();
+    }
+}
+
+SharedFrameRing::SharedFrameRing(const std::string& name)
+    : name_(name)
+    , owner_(false)
+    , fd_(-1)
+    , mapping_(0)
+    , mappingSize_(0)
+    , header_(0)
+    , data_(0)
+    , nextSlot_(0)
+{
+    if(!attach())
+    {
+        put_flog(LOG_WARN, "could not attach to the shared frame ring %s", name_.c_str());
+        detach();
+    }
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+    detach();
+}
+
+bool SharedFrameRing::isOpen() const
+{
+    return header_ != 0;
+}
+
+bool SharedFrameRing::isReaderAttached() const
+{
+    return header_ && readAtomic(header_->readerAttached) == 1;
+}
+
+const std::string& SharedFrameRing::getName() const
+{
+    return name_;
+}
+
+uint32_t SharedFrameRing::getSlotCount() const
+{
+    return header_ ? header_->slotCount : 0;
+}
+
+size_t SharedFrameRing::getSlotSize() const
+{
+    return header_ ? header_->slotSize : 0;
+}
+
+int SharedFrameRing::acquireSlot(const int timeoutMs)
+{
+    if(!header_)
+        return -1;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while(isReaderAttached())
+    {
+        for(uint32_t i = 0; i < header_->slotCount; ++i)
+        {
+            const uint32_t slot = (nextSlot_ + i) % header_->slotCount;
+            if(header_->slotStates[slot].testAndSetOrdered(SLOT_FREE, SLOT_USED))
+            {
+                nextSlot_ = (slot + 1) % header_->slotCount;
+                return slot;
+            }
+        }
+
+        if(timer.elapsed() >= timeoutMs)
+            break;
+#ifndef _WIN32
+        usleep(POLL_INTERVAL_US);
+#endif
+    }
+    return -1;
+}
+
+void SharedFrameRing::releaseSlot(const int slot)
+{
+    if(header_ && slot >= 0 && (uint32_t)slot < header_->slotCount)
+        header_->slotStates[slot].fetchAndStoreOrdered(SLOT_FREE);
+}
+
+unsigned char* SharedFrameRing::getSlotData(const int slot) const
+{
+    if(!header_ || slot < 0 || (uint32_t)slot >= header_->slotCount)
+        return 0;
+
+    return data_ + size_t(slot) * header_->slotSize;
+}
+
+bool SharedFrameRing::create(const uint32_t slotCount, const size_t slotSize)
+{
+#ifdef _WIN32
+    Q_UNUSED(slotCount);
+    Q_UNUSED(slotSize);
+    return false;
+#else
+    fd_ = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if(fd_ < 0)
+        return false;
+
+    const uint32_t count = std::max(std::min(slotCount, MAX_SLOT_COUNT), uint32_t(1));
+    const size_t alignedSlotSize = alignTo64(slotSize);
+    const size_t dataOffset = alignTo64(sizeof(Header));
+    const size_t size = dataOffset + count * alignedSlotSize;
+
+    // The new segment is zero-filled, which is the initial state of the slots
+    if(ftruncate(fd_, size) != 0)
+    {
+        put_flog(LOG_ERROR, "could not allocate %lu bytes of shared memory", (unsigned long)size);
+        return false;
+    }
+
+    mapping_ = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(mapping_ == MAP_FAILED)
+    {
+        mapping_ = 0;
+        return false;
+    }
+    mappingSize_ = size;
+
+    header_ = new(mapping_) Header;
+    memcpy(header_->magic, SHARED_FRAME_RING_MAGIC, sizeof(header_->magic));
+    header_->version = SHARED_FRAME_RING_VERSION;
+    header_->slotCount = count;
+    header_->slotSize = alignedSlotSize;
+
+    data_ = static_cast<unsigned char*>(mapping_) + dataOffset;
+    return true;
+#endif
+}
+
+bool SharedFrameRing::attach()
+{
+#ifdef _WIN32
+    return false;
+#else
+    fd_ = shm_open(name_.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+    if(fd_ < 0)
+        return false;
+
+    struct stat status;
+    if(fstat(fd_, &status) != 0 || (size_t)status.st_size < sizeof(Header))
+        return false;
+
+    mapping_ = mmap(0, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(mapping_ == MAP_FAILED)
+    {
+        mapping_ = 0;
+        return false;
+    }
+    mappingSize_ = status.st_size;
+
+    Header* header = static_cast<Header*>(mapping_);
+    if(memcmp(header->magic, SHARED_FRAME_RING_MAGIC, sizeof(header->magic)) != 0 ||
+       header->version != SHARED_FRAME_RING_VERSION ||
+       header->slotCount == 0 || header->slotCount > MAX_SLOT_COUNT)
+        return false;
+
+    const size_t dataOffset = alignTo64(sizeof(Header));
+    if(dataOffset + size_t(header->slotCount) * header->slotSize > mappingSize_)
+        return false;
+
+    header_ = header;
+    data_ = static_cast<unsigned char*>(mapping_) + dataOffset;
+
+    // The segment is not needed by any other process, and must not outlive
+    // the writer and the reader
+    shm_unlink(name_.c_str());
+
+    // The writer starts using the ring only once it is attached
+    header_->readerAttached.fetchAndStoreOrdered(1);
+    return true;
+#endif
+}
+
+void SharedFrameRing::detach()
+{
+#ifndef _WIN32
+    if(header_ && !owner_)
+        header_->readerAttached.fetchAndStoreOrdered(0);
+
+    // The name is normally unlinked by the reader, unless it never attached
+    if(owner_ && fd_ >= 0)
+        shm_unlink(name_.c_str());
+
+    if(mapping_)
+        munmap(mapping_, mappingSize_);
+    if(fd_ >= 0)
+        close(fd_);
+#endif
+
+    fd_ = -1;
+    mapping_ = 0;
+    mappingSize_ = 0;
+    header_ = 0;
+    data_ = 0;
+}
+
+}
@@ -0,0 +1,149 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef SHAREDFRAMERING_H
+#define SHAREDFRAMERING_H
+
+#include "PixelStreamSegmentParameters.h"
+
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <stdint.h>
+
+namespace dc
+{
+
+/** Reference to a raw segment stored in a slot of a SharedFrameRing. */
+struct SharedSegmentReference
+{
+    /** The parameters of the segment. */
+    PixelStreamSegmentParameters parameters;
+
+    /** The position of the segment data in the slot, in bytes. */
+    uint32_t offset;
+
+    /** The size of the segment data, in bytes. */
+    uint32_t size;
+};
+
+/**
+ * A ring of frame buffers in POSIX shared memory, used by Streams to send raw
+ * images to a DisplayCluster master running on the same host without copying
+ * them through the network stack.
+ *
+ * The Stream creates the ring and announces its name to the master with a
+ * MESSAGE_TYPE_PIXELSTREAM_SHARED_OPEN message. The master attaches to it,
+ * which unlinks the name so that the memory is released when both processes
+ * exit, even if one of them crashes.
+ *
+ * For each image, the Stream acquires a free slot, writes the segments in it
+ * and sends a MESSAGE_TYPE_PIXELSTREAM_SHARED message referencing them over
+ * its Socket, which acts as the doorbell. The master releases the slot once
+ * it has read the segments.
+ */
+class SharedFrameRing : public boost::noncopyable
+{
+public:
+    /**
+     * Create a new ring, for the writer.
+     * @param slotCount The number of slots.
+     * @param slotSize The size of each slot, in bytes.
+     */
+    SharedFrameRing(const uint32_t slotCount, const size_t slotSize);
+
+    /**
+     * Attach to an existing ring, for the reader.
+     * @param name The name of the ring created by the writer.
+     */
+    explicit SharedFrameRing(const std::string& name);
+
+    /** Detach from the ring. */
+    ~SharedFrameRing();
+
+    /** @return true if the shared memory segment could be opened. */
+    bool isOpen() const;
+
+    /** @return true if a reader is attached to the ring. */
+    bool isReaderAttached() const;
+
+    /** @return The name of the shared memory segment. */
+    const std::string& getName() const;
+
+    /** @return The number of slots. */
+    uint32_t getSlotCount() const;
+
+    /** @return The size of each slot, in bytes. */
+    size_t getSlotSize() const;
+
+    /**
+     * Acquire a free slot to write a frame, waiting for the reader to release
+     * one if needed.
+     * @param timeoutMs The maximum time to wait for a free slot.
+     * @return The index of the slot, or -1 if none was released in time or if
+     *         the reader is not attached.
+     */
+    int acquireSlot(const int timeoutMs);
+
+    /** Release a slot once its frame has been read. */
+    void releaseSlot(const int slot);
+
+    /** @return The data of a slot, or 0 if the index is invalid. */
+    unsigned char* getSlotData(const int slot) const;
+
+private:
+    struct Header;
+
+    std::string name_;
+    bool owner_;
+    int fd_;
+    void* mapping_;
+    size_t mappingSize_;
+
+    Header* header_;
+    unsigned char* data_;
+    uint32_t nextSlot_;
+
+    bool create(const uint32_t slotCount, const size_t slotSize);
+    bool attach();
+    void detach();
+};
+
+}
+
+#endif // SHAREDFRAMERING_H
@@ -0,0 +1,458 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "CompressedImage.h"
+
+#include <QDataStream>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cmath>
+
+#define COMPRESSED_IMAGE_MAGIC       "DCBC"
+#define COMPRESSED_IMAGE_MAGIC_SIZE  4
+#define COMPRESSED_IMAGE_HEADER_SIZE 16
+#define COMPRESSED_IMAGE_MAX_SIZE    65536
+
+namespace
+{
+const int BLOCK_SIZE = 4;
+const int BLOCK_PIXELS = BLOCK_SIZE * BLOCK_SIZE;
+const int COLOR_BLOCK_BYTES = 8;
+const int ALPHA_BLOCK_BYTES = 8;
+const int POWER_ITERATIONS = 8;
+
+int getBlockBytes(const CompressedImage::Format format)
+{
+    return format == CompressedImage::BC3 ? ALPHA_BLOCK_BYTES + COLOR_BLOCK_BYTES
+                                          : COLOR_BLOCK_BYTES;
+}
+
+int getBlockCount(const int pixels)
+{
+    return (pixels + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+quint16 toRGB565(const float r, const float g, const float b)
+{
+    const int r5 = std::max(0, std::min(31, int(r * 31.f / 255.f + .5f)));
+    const int g6 = std::max(0, std::min(63, int(g * 63.f / 255.f + .5f)));
+    const int b5 = std::max(0, std::min(31, int(b * 31.f / 255.f + .5f)));
+    return (r5 << 11) | (g6 << 5) | b5;
+}
+
+void fromRGB565(const quint16 color, int rgb[3])
+{
+    const int r5 = color >> 11;
+    const int g6 = (color >> 5) & 63;
+    const int b5 = color & 31;
+    rgb[0] = (r5 << 3) | (r5 >> 2);
+    rgb[1] = (g6 << 2) | (g6 >> 4);
+    rgb[2] = (b5 << 3) | (b5 >> 2);
+}
+
+void getColorPalette(const quint16 color0, const quint16 color1,
+                     const bool fourColors, int palette[4][4])
+{
+    fromRGB565(color0, palette[0]);
+    fromRGB565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+
+    for(int c = 0; c < 3; ++c)
+    {
+        if(fourColors)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+}
+
+void getAlphaPalette(const int alpha0, const int alpha1, int palette[8])
+{
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+
+    if(alpha0 > alpha1)
+    {
+        for(int i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+    }
+    else
+    {
+        for(int i = 1; i < 5; ++i)
+            palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void writeUInt16(uchar* out, const quint16 value)
+{
+    out[0] = value & 0xff;
+    out[1] = value >> 8;
+}
+
+quint16 readUInt16(const uchar* in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+void encodeColorBlock(const QRgb pixels[BLOCK_PIXELS], uchar* out)
+{
+    float mean[3] = { 0.f, 0.f, 0.f };
+    for(int i = 0; i < BLOCK_PIXELS; ++i)
+    {
+        mean[0] += qRed(pixels[i]);
+        mean[1] += qGreen(pixels[i]);
+        mean[2] += qBlue(pixels[i]);
+    }
+    for(int c = 0; c < 3; ++c)
+        mean[c] /= BLOCK_PIXELS;
+
+    float covariance[3][3] = { { 0.f } };
+    for(int i = 0; i < BLOCK_PIXELS; ++i)
+    {
+        const float d[3] = { qRed(pixels[i]) - mean[0],
+                             qGreen(pixels[i]) - mean[1],
+                             qBlue(pixels[i]) - mean[2] };
+        for(int j = 0; j < 3; ++j)
+            for(int k = 0; k < 3; ++k)
+                covariance[j][k] += d[j] * d[k];
+    }
+
+    // The endpoints are the extremes of the colors along their principal axis
+    float axis[3] = { 1.f, 1.f, 1.f };
+    for(int iteration = 0; iteration < POWER_ITERATIONS; ++iteration)
+    {
+        float next[3];
+        for(int j = 0; j < 3; ++j)
+            next[j] = covariance[j][0] * axis[0] + covariance[j][1] * axis[1] +
+                      covariance[j][2] * axis[2];
+
+        const float norm = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if(norm < 1e-6f)
+            break;
+        for(int j = 0; j < 3; ++j)
+            axis[j] = next[j] / norm;
+    }
+
+    float minT = 0.f, maxT = 0.f;
+    for(int i = 0; i < BLOCK_PIXELS; ++i)
+    {
+        const float t = (qRed(pixels[i]) - mean[0]) * axis[0] +
+                        (qGreen(pixels[i]) - mean[1]) * axis[1] +
+                        (qBlue(pixels[i]) - mean[2]) * axis[2];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+
+    quint16 color0 = toRGB565(mean[0] + maxT * axis[0], mean[1] + maxT * axis[1],
+                              mean[2] + maxT * axis[2]);
+    quint16 color1 = toRGB565(mean[0] + minT * axis[0], mean[1] + minT * axis[1],
+                              mean[2] + minT * axis[2]);
+
+    // color0 > color1 selects the four colors mode
+    if(color0 < color1)
+        std::swap(color0, color1);
+
+    quint32 indices = 0;
+    if(color0 != color1)
+    {
+        int palette[4][4];
+        getColorPalette(color0, color1, true, palette);
+
+        for(int i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            int bestIndex = 0;
+            int bestDistance = INT_MAX;
+            for(int p = 0; p < 4; ++p)
+            {
+                const int dr = qRed(pixels[i]) - palette[p][0];
+                const int dg = qGreen(pixels[i]) - palette[p][1];
+                const int db = qBlue(pixels[i]) - palette[p][2];
+                const int distance = dr * dr + dg * dg + db * db;
+                if(distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indices |= quint32(bestIndex) << (2 * i);
+        }
+    }
+
+    writeUInt16(out, color0);
+    writeUInt16(out + 2, color1);
+    for(int i = 0; i < 4; ++i)
+        out[4 + i] = (indices >> (8 * i)) & 0xff;
+}
+
+void encodeAlphaBlock(const QRgb pixels[BLOCK_PIXELS], uchar* out)
+{
+    int alpha0 = 0, alpha1 = 255;
+    for(int i = 0; i < BLOCK_PIXELS; ++i)
+    {
+        alpha0 = std::max(alpha0, qAlpha(pixels[i]));
+        alpha1 = std::min(alpha1, qAlpha(pixels[i]));
+    }
+
+    quint64 indices = 0;
+    if(alpha0 != alpha1)
+    {
+        // alpha0 > alpha1 selects the eight values mode
+        int palette[8];
+        getAlphaPalette(alpha0, alpha1, palette);
+
+        for(int i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            int bestIndex = 0;
+            int bestDistance = INT_MAX;
+            for(int p = 0; p < 8; ++p)
+            {
+                const int distance = std::abs(qAlpha(pixels[i]) - palette[p]);
+                if(distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indices |= quint64(bestIndex) << (3 * i);
+        }
+    }
+
+    out[0] = alpha0;
+    out[1] = alpha1;
+    for(int i = 0; i < 6; ++i)
+        out[2 + i] = (indices >> (8 * i)) & 0xff;
+}
+
+void decodeColorBlock(const uchar* in, const bool forceFourColors, int colors[BLOCK_PIXELS][4])
+{
+    const quint16 color0 = readUInt16(in);
+    const quint16 color1 = readUInt16(in + 2);
+
+    int palette[4][4];
+    getColorPalette(color0, color1, forceFourColors || color0 > color1, palette);
+
+    const quint32 indices = in[4] | (in[5] << 8) | (in[6] << 16) | (quint32(in[7]) << 24);
+    for(int i = 0; i < BLOCK_PIXELS; ++i)
+    {
+        const int index = (indices >> (2 * i)) & 3;
+        std::copy(palette[index], palette[index] + 4, colors[i]);
+    }
+}
+
+void decodeAlphaBlock(const uchar* in, int colors[BLOCK_PIXELS][4])
+{
+    int palette[8];
+    getAlphaPalette(in[0], in[1], palette);
+
+    quint64 indices = 0;
+    for(int i = 0; i < 6; ++i)
+        indices |= quint64(in[2 + i]) << (8 * i);
+
+    for(int i = 0; i < BLOCK_PIXELS; ++i)
+        colors[i][3] = palette[(indices >> (3 * i)) & 7];
+}
+}
+
+CompressedImage::CompressedImage()
+    : format_(BC1)
+{
+}
+
+CompressedImage::CompressedImage(const QImage& image, const Format format)
+    : format_(format)
+{
+    if(image.isNull())
+        return;
+
+    const QImage source = image.convertToFormat(QImage::Format_ARGB32);
+    const int width = source.width();
+    const int height = source.height();
+
+    size_ = source.size();
+    blocks_.resize(getBlocksSize(size_, format));
+    uchar* out = reinterpret_cast<uchar*>(blocks_.data());
+
+    QRgb pixels[BLOCK_PIXELS];
+    for(int blockY = 0; blockY < getBlockCount(height); ++blockY)
+    {
+        for(int blockX = 0; blockX < getBlockCount(width); ++blockX)
+        {
+            for(int y = 0; y < BLOCK_SIZE; ++y)
+            {
+                const int sourceY = std::min(blockY * BLOCK_SIZE + y, height - 1);
+                const QRgb* line = reinterpret_cast<const QRgb*>(source.constScanLine(sourceY));
+                for(int x = 0; x < BLOCK_SIZE; ++x)
+                    pixels[y * BLOCK_SIZE + x] = line[std::min(blockX * BLOCK_SIZE + x, width - 1)];
+            }
+
+            if(format == BC3)
+            {
+                encodeAlphaBlock(pixels, out);
+                out += ALPHA_BLOCK_BYTES;
+            }
+            encodeColorBlock(pixels, out);
+            out += COLOR_BLOCK_BYTES;
+        }
+    }
+}
+
+bool CompressedImage::isCompressedImage(const QByteArray& data)
+{
+    return data.startsWith(COMPRESSED_IMAGE_MAGIC);
+}
+
+CompressedImage CompressedImage::fromData(const QByteArray& data)
+{
+    CompressedImage image;
+
+    if(data.size() < COMPRESSED_IMAGE_HEADER_SIZE || !isCompressedImage(data))
+        return image;
+
+    QDataStream in(data.mid(COMPRESSED_IMAGE_MAGIC_SIZE, COMPRESSED_IMAGE_HEADER_SIZE - COMPRESSED_IMAGE_MAGIC_SIZE));
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 format, width, height;
+    in >> format >> width >> height;
+
+    if((format != BC1 && format != BC3) || width == 0 || height == 0 ||
+       width > COMPRESSED_IMAGE_MAX_SIZE || height > COMPRESSED_IMAGE_MAX_SIZE)
+        return image;
+
+    const QSize size(width, height);
+    if(size_t(data.size() - COMPRESSED_IMAGE_HEADER_SIZE) != getBlocksSize(size, Format(format)))
+        return image;
+
+    image.size_ = size;
+    image.format_ = Format(format);
+    image.blocks_ = data.mid(COMPRESSED_IMAGE_HEADER_SIZE);
+    return image;
+}
+
+size_t CompressedImage::getBlocksSize(const QSize& size, const Format format)
+{
+    return size_t(getBlockCount(size.width())) * getBlockCount(size.height()) *
+           getBlockBytes(format);
+}
+
+size_t CompressedImage::getDataSize(const QSize& size, const Format format)
+{
+    return COMPRESSED_IMAGE_HEADER_SIZE + getBlocksSize(size, format);
+}
+
+QByteArray CompressedImage::toData() const
+{
+    QByteArray data;
+    if(isNull())
+        return data;
+
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData(COMPRESSED_IMAGE_MAGIC, COMPRESSED_IMAGE_MAGIC_SIZE);
+    out << quint32(format_) << quint32(size_.width()) << quint32(size_.height());
+    out.writeRawData(blocks_.constData(), blocks_.size());
+    return data;
+}
+
+QImage CompressedImage::decompress() const
+{
+    if(isNull())
+        return QImage();
+
+    QImage image(size_, QImage::Format_ARGB32);
+    const uchar* in = reinterpret_cast<const uchar*>(blocks_.constData());
+
+    int colors[BLOCK_PIXELS][4];
+    for(int blockY = 0; blockY < getBlockCount(size_.height()); ++blockY)
+    {
+        for(int blockX = 0; blockX < getBlockCount(size_.width()); ++blockX)
+        {
+            if(format_ == BC3)
+            {
+                decodeColorBlock(in + ALPHA_BLOCK_BYTES, true, colors);
+                decodeAlphaBlock(in, colors);
+            }
+            else
+                decodeColorBlock(in, false, colors);
+            in += getBlockBytes(format_);
+
+            for(int y = 0; y < BLOCK_SIZE && blockY * BLOCK_SIZE + y < size_.height(); ++y)
+            {
+                QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(blockY * BLOCK_SIZE + y));
+                for(int x = 0; x < BLOCK_SIZE && blockX * BLOCK_SIZE + x < size_.width(); ++x)
+                {
+                    const int* color = colors[y * BLOCK_SIZE + x];
+                    line[blockX * BLOCK_SIZE + x] = qRgba(color[0], color[1], color[2], color[3]);
+                }
+            }
+        }
+    }
+    return image;
+}
+
+bool CompressedImage::isNull() const
+{
+    return blocks_.isEmpty();
+}
+
+const QSize& CompressedImage::size() const
+{
+    return size_;
+}
+
+CompressedImage::Format CompressedImage::format() const
+{
+    return format_;
+}
+
+const QByteArray& CompressedImage::blocks() const
+{
+    return blocks_;
+}
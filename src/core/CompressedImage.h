@@ -0,0 +1,120 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef COMPRESSEDIMAGE_H
+#define COMPRESSEDIMAGE_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+
+/**
+ * An image compressed in a GPU block compression format.
+ *
+ * BC1 (DXT1) stores opaque images in 4 bits per pixel, BC3 (DXT5) stores
+ * images with an alpha channel in 8 bits per pixel. The compressed blocks
+ * can be uploaded to the GPU without decoding with glCompressedTexImage2D.
+ *
+ * The encoder is a simple principal axis fit, fast enough to compress the
+ * tiles of an image pyramid in a preprocessing step. The decoder is used for
+ * testing and when the GPU does not support S3TC texture compression.
+ */
+class CompressedImage
+{
+public:
+    /** The block compression formats. */
+    enum Format
+    {
+        BC1 = 1,
+        BC3 = 2
+    };
+
+    /** Construct a null image. */
+    CompressedImage();
+
+    /**
+     * Compress an image.
+     * Incomplete blocks on the right and bottom borders are padded by
+     * repeating the border pixels.
+     * @param image The image to compress.
+     * @param format The compression format.
+     */
+    CompressedImage(const QImage& image, const Format format);
+
+    /** @return true if the data starts with a serialized CompressedImage. */
+    static bool isCompressedImage(const QByteArray& data);
+
+    /**
+     * Deserialize an image.
+     * @param data The data produced by toData().
+     * @return The image, null if the data is invalid.
+     */
+    static CompressedImage fromData(const QByteArray& data);
+
+    /** @return The size of the compressed blocks of an image. */
+    static size_t getBlocksSize(const QSize& size, const Format format);
+
+    /** @return The size of the serialized form of an image. */
+    static size_t getDataSize(const QSize& size, const Format format);
+
+    /** @return The image and its format in a serialized form. */
+    QByteArray toData() const;
+
+    /** @return The decompressed image, in Format_ARGB32. */
+    QImage decompress() const;
+
+    /** @return true if the image is empty. */
+    bool isNull() const;
+
+    /** @return The size of the image in pixels. */
+    const QSize& size() const;
+
+    /** @return The compression format. */
+    Format format() const;
+
+    /** @return The compressed blocks, ordered by row. */
+    const QByteArray& blocks() const;
+
+private:
+    QSize size_;
+    Format format_;
+    QByteArray blocks_;
+};
+
+#endif // COMPRESSEDIMAGE_H
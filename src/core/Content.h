@@ -83,6 +83,7 @@ class Content : public QObject
         void getDimensions(int &width, int &height);
         void setDimensions(int width, int height);
         void blockAdvance( bool block ) { blockAdvance_ = block; }
+        bool isAdvanceBlocked() const { return blockAdvance_; }
 
         // virtual method for implementing actions on advancing to a new frame
         // useful when a process has multiple GLWindows
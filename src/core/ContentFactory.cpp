@@ -55,6 +55,9 @@
 #  include "DisplayGroupManager.h"
 #endif
 #include "PixelStreamContent.h"
+#if ENABLE_TIFF_SUPPORT
+#  include "TiffPyramidReader.h"
+#endif
 
 #include <QFile>
 #include <QFileInfo>
@@ -99,6 +102,19 @@ ContentPtr ContentFactory::getContent(const QString& uri)
         return content;
     }
 
+#if ENABLE_TIFF_SUPPORT
+    // Tiled TIFF images are always read region by region, whatever their size
+    if(TiffPyramidReader::hasTiffExtension(uri) && TiffPyramidReader().open(uri))
+    {
+        ContentPtr content(new DynamicTextureContent(uri));
+
+        if (!content->readMetadata())
+            return getErrorContent();
+
+        return content;
+    }
+#endif
+
     // see if this is an image
     QImageReader imageReader(uri);
     if(imageReader.canRead())
@@ -45,6 +45,7 @@
 #include "ContentWindowManager.h"
 #include "Content.h"
 #include "GLWindow.h"
+#include "RenderContext.h"
 #include "Factories.h"
 
 #define CONTEXT_VIEW_REL_SIZE       0.25f
@@ -53,8 +54,15 @@
 #define CONTEXT_VIEW_ALPHA          0.5f
 #define CONTEXT_VIEW_BORDER_WIDTH   5.f
 
-ContentWindowRenderer::ContentWindowRenderer(FactoriesPtr factories)
+#define PLACEHOLDER_GREY            0.2f
+
+#define VIEW_PREDICTOR_TIMEOUT      100 // frames
+
+ContentWindowRenderer::ContentWindowRenderer(FactoriesPtr factories,
+                                             RenderContext& renderContext)
     : factories_(factories)
+    , renderContext_(renderContext)
+    , frameIndex_(0)
 {
     quad_.setEnableTexture(false);
 }
@@ -64,19 +72,12 @@ void ContentWindowRenderer::render()
     if(!window_)
         return;
 
-    bool showWindowBorders = true;
     bool showZoomContext = false;
 
     if(g_configuration)
-    {
-        showWindowBorders = g_configuration->getOptions()->getShowWindowBorders();
         showZoomContext = g_configuration->getOptions()->getShowZoomContext();
-    }
 
     renderContent(showZoomContext);
-
-    if(showWindowBorders || window_->selected())
-        renderWindowBorder();
 }
 
 void ContentWindowRenderer::setContentWindow(ContentWindowManagerPtr window)
@@ -84,8 +85,29 @@ void ContentWindowRenderer::setContentWindow(ContentWindowManagerPtr window)
     window_ = window;
 }
 
-void ContentWindowRenderer::renderWindowBorder()
+bool ContentWindowRenderer::isWindowVisible() const
 {
+    if(!window_)
+        return false;
+
+    return renderContext_.getActiveGLWindow()->isRegionVisible(window_->getCoordinates());
+}
+
+void ContentWindowRenderer::appendWindowBorder(GLQuadBatch& borders,
+                                               GLQuadBatch& selectedBorders,
+                                               const float z) const
+{
+    if(!window_)
+        return;
+
+    bool showWindowBorders = true;
+
+    if(g_configuration)
+        showWindowBorders = g_configuration->getOptions()->getShowWindowBorders();
+
+    if(!showWindowBorders && !window_->selected())
+        return;
+
     double horizontalBorder = 5. / (double)g_configuration->getTotalHeight(); // 5 pixels
 
     if(window_->getHighlighted())
@@ -93,21 +115,16 @@ void ContentWindowRenderer::renderWindowBorder()
 
     double verticalBorder = horizontalBorder / g_configuration->getAspectRatio();
 
-    glPushAttrib(GL_CURRENT_BIT);
+    const QRectF winCoord = window_->getCoordinates();
+    const QRectF borderCoord(winCoord.x() - verticalBorder,
+                             winCoord.y() - horizontalBorder,
+                             winCoord.width() + 2.f*verticalBorder,
+                             winCoord.height() + 2.f*horizontalBorder);
 
     if(window_->selected())
-        glColor4f(1,0,0,1);
+        selectedBorders.append(borderCoord, z);
     else
-        glColor4f(1,1,1,1);
-
-    const QRectF winCoord = window_->getCoordinates();
-
-    drawQuad(QRectF(winCoord.x() - verticalBorder,
-                    winCoord.y() - horizontalBorder,
-                    winCoord.width() + 2.f*verticalBorder,
-                    winCoord.height() + 2.f*horizontalBorder));
-
-    glPopAttrib();
+        borders.append(borderCoord, z);
 }
 
 void ContentWindowRenderer::renderContent(const bool showZoomContext)
@@ -117,18 +134,60 @@ void ContentWindowRenderer::renderContent(const bool showZoomContext)
 
     // transform to a normalize coordinate system so the content
     // can be rendered at (x,y,w,h) = (0,0,1,1)
-    glPushMatrix();
+    GLWindowPtr glWindow = renderContext_.getActiveGLWindow();
+    glWindow->pushTransform(winCoord);
 
-    glTranslatef(winCoord.x(), winCoord.y(), 0.f);
-    glScalef(winCoord.width(), winCoord.height(), 1.f);
+    FactoryObjectPtr object = factories_->requestFactoryObject(window_->getContent());
+    if(object)
+    {
+        object->render(texCoord);
+        prefetch(object, texCoord);
 
-    FactoryObjectPtr object = factories_->getFactoryObject(window_->getContent());
-    object->render(texCoord);
+        if(showZoomContext && window_->getZoom() > 1.)
+            renderContextView(object, texCoord);
+    }
+    else
+        renderPlaceholder();
 
-    if(showZoomContext && window_->getZoom() > 1.)
-        renderContextView(object, texCoord);
+    glWindow->popTransform();
+}
 
-    glPopMatrix();
+void ContentWindowRenderer::renderPlaceholder()
+{
+    glPushAttrib(GL_CURRENT_BIT);
+
+    glColor4f(PLACEHOLDER_GREY, PLACEHOLDER_GREY, PLACEHOLDER_GREY, 1.f);
+    drawQuad(QRectF(0.f, 0.f, 1.f, 1.f));
+
+    glPopAttrib();
+}
+
+void ContentWindowRenderer::prefetch(FactoryObjectPtr object, const QRectF& texCoord)
+{
+    // The object is touched by the Factories each frame in which it is rendered
+    const uint64_t frameIndex = object->getFrameIndex();
+
+    // Forget the windows which have not been rendered recently
+    if(frameIndex != frameIndex_)
+    {
+        frameIndex_ = frameIndex;
+
+        ViewPredictors::iterator it = viewPredictors_.begin();
+        while(it != viewPredictors_.end())
+        {
+            if(it->second.getLastFrameIndex() + VIEW_PREDICTOR_TIMEOUT < frameIndex_)
+                viewPredictors_.erase(it++);
+            else
+                ++it;
+        }
+    }
+
+    ViewPredictor& predictor = viewPredictors_[window_->getID()];
+    predictor.addView(frameIndex, texCoord);
+
+    QRectF predictedTexCoord;
+    if(predictor.predict(predictedTexCoord))
+        object->prefetch(predictedTexCoord);
 }
 
 QRectF ContentWindowRenderer::getTexCoord() const
@@ -147,13 +206,13 @@ void ContentWindowRenderer::renderContextView(FactoryObjectPtr object,
     const QRectF unitRect(0.f, 0.f, 1.f, 1.f);
 
     glPushAttrib(GL_CURRENT_BIT | GL_ENABLE_BIT | GL_LINE_BIT);
-    glPushMatrix();
 
     // position at lower left
-    glTranslatef(CONTEXT_VIEW_PADDING,
-                 1.f - CONTEXT_VIEW_REL_SIZE - CONTEXT_VIEW_PADDING,
-                 CONTEXT_VIEW_DELTA_Z);
-    glScalef(CONTEXT_VIEW_REL_SIZE, CONTEXT_VIEW_REL_SIZE, 1.f);
+    GLWindowPtr glWindow = renderContext_.getActiveGLWindow();
+    glWindow->pushTransform(QRectF(CONTEXT_VIEW_PADDING,
+                                   1.f - CONTEXT_VIEW_REL_SIZE - CONTEXT_VIEW_PADDING,
+                                   CONTEXT_VIEW_REL_SIZE, CONTEXT_VIEW_REL_SIZE));
+    glTranslatef(0.f, 0.f, CONTEXT_VIEW_DELTA_Z);
 
     // render border rectangle
     glColor4f(1,1,1,1);
@@ -175,7 +234,7 @@ void ContentWindowRenderer::renderContextView(FactoryObjectPtr object,
     glColor4f(1.f, 1.f, 1.f, CONTEXT_VIEW_ALPHA);
     drawQuad(texCoord);
 
-    glPopMatrix();
+    glWindow->popTransform();
     glPopAttrib();
 }
 
@@ -43,11 +43,20 @@
 #include "types.h"
 #include "Renderable.h"
 #include "GLQuad.h"
+#include "GLQuadBatch.h"
+#include "ViewPredictor.h"
 
 #include <QRectF>
+#include <QUuid>
+#include <map>
+
+class RenderContext;
 
 /**
  * Render a ContentWindow and its Content using the associated FactoryObject.
+ *
+ * The pan and zoom motion of each ContentWindow is tracked to prefetch the
+ * region of the Content it is expected to show in the next frames.
  */
 class ContentWindowRenderer : public Renderable
 {
@@ -55,28 +64,55 @@ public:
     /**
      * Constructor.
      * @param factories Used to retrieve FactoryObjects for rendering Contents.
+     * @param renderContext Provides the GLWindow currently being rendered.
      */
-    ContentWindowRenderer(FactoriesPtr factories);
+    ContentWindowRenderer(FactoriesPtr factories, RenderContext& renderContext);
 
     /**
-     * Render the associated ContentWindow.
+     * Render the Content of the associated ContentWindow.
+     *
+     * A placeholder is rendered while the Content is being loaded.
      * @see setContentWindow()
      */
     void render() override;
 
+    /**
+     * Add the border of the associated ContentWindow to a batch.
+     *
+     * Borders are not drawn by render() so that the borders of all windows
+     * can be drawn in a single call.
+     * @param borders The batch for the borders of unselected windows.
+     * @param selectedBorders The batch for the borders of selected windows.
+     * @param z The depth at which the window is rendered.
+     */
+    void appendWindowBorder(GLQuadBatch& borders, GLQuadBatch& selectedBorders,
+                            const float z) const;
+
     /**
      * Set the ContentWindow to be rendered.
      * @see render()
      */
     void setContentWindow(ContentWindowManagerPtr window);
 
+    /**
+     * Check if the associated ContentWindow is visible in the active GLWindow.
+     * @see RenderContext::getActiveGLWindow()
+     */
+    bool isWindowVisible() const;
+
 private:
     FactoriesPtr factories_;
+    RenderContext& renderContext_;
     ContentWindowManagerPtr window_;
     GLQuad quad_;
 
-    void renderWindowBorder();
+    typedef std::map<QUuid, ViewPredictor> ViewPredictors;
+    ViewPredictors viewPredictors_;
+    uint64_t frameIndex_;
+
     void renderContent(const bool showZoomContext);
+    void renderPlaceholder();
+    void prefetch(FactoryObjectPtr object, const QRectF& texCoord);
     void renderContextView(FactoryObjectPtr object, const QRectF& texCoord);
     QRectF getTexCoord() const;
 
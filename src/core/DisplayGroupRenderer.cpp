@@ -41,11 +41,13 @@
 
 #include "DisplayGroupManager.h"
 #include "ContentWindowManager.h"
+#include "Factories.h"
 #include "Marker.h"
 
-DisplayGroupRenderer::DisplayGroupRenderer(FactoriesPtr factories)
+DisplayGroupRenderer::DisplayGroupRenderer(FactoriesPtr factories,
+                                           RenderContext& renderContext)
     : factories_(factories)
-    , windowRenderer_(factories)
+    , windowRenderer_(factories, renderContext)
 {
 }
 
@@ -54,11 +56,15 @@ void DisplayGroupRenderer::render()
     if(!displayGroup_)
         return;
 
+    windowBorders_.clear();
+    selectedWindowBorders_.clear();
+
     renderBackgroundContent(displayGroup_->getBackgroundContentWindow());
     renderContentWindows(displayGroup_->getContentWindowManagers());
+    renderWindowBorders();
 
     // Markers should be rendered last since they're blended
-    renderMarkers(displayGroup_->getMarkers());
+    markerRenderer_.render(displayGroup_->getMarkers());
 
 #if ENABLE_SKELETON_SUPPORT
     if (g_configuration->getOptions()->getShowSkeletons())
@@ -76,13 +82,17 @@ void DisplayGroupRenderer::renderBackgroundContent(ContentWindowManagerPtr backg
     // Render background content window
     if (backgroundContentWindow)
     {
+        const float zCoordinate = -1.f + std::numeric_limits<float>::epsilon();
+
         glPushMatrix();
-        glTranslatef(0., 0., -1.f + std::numeric_limits<float>::epsilon());
+        glTranslatef(0., 0., zCoordinate);
 
         windowRenderer_.setContentWindow(backgroundContentWindow);
         windowRenderer_.render();
 
         glPopMatrix();
+
+        windowRenderer_.appendWindowBorder(windowBorders_, selectedWindowBorders_, zCoordinate);
     }
 }
 
@@ -92,35 +102,44 @@ void DisplayGroupRenderer::renderContentWindows(ContentWindowManagerPtrs content
     unsigned int i = 0;
     for(ContentWindowManagerPtrs::iterator it = contentWindowManagers.begin(); it != contentWindowManagers.end(); ++it)
     {
-        // It is currently not possible to cull windows that are invisible as this conflics
-        // with the "garbage collection" mechanism for Contents. In fact, "stale" objects are objects
-        // which have not been rendered for more than one frame (implicitly: objects without a window)
-        // and those are destroyed by Factory::clearStaleObjects(). It is currently the only way to
-        // remove a Content.
-        //if ( isRegionVisible( (*it)->getCoordinates( )))
-        {
-            // the visible depths are in the range (-1,1); make the content window depths be in the range (-1,0)
-            const float zCoordinate = -(float)(windowCount - i) / (float)(windowCount + 1);
+        // the visible depths are in the range (-1,1); make the content window depths be in the range (-1,0)
+        const float zCoordinate = -(float)(windowCount - i) / (float)(windowCount + 1);
 
+        windowRenderer_.setContentWindow(*it);
+
+        if(windowRenderer_.isWindowVisible())
+        {
             glPushMatrix();
             glTranslatef(0.f, 0.f, zCoordinate);
 
-            windowRenderer_.setContentWindow(*it);
             windowRenderer_.render();
 
             glPopMatrix();
         }
+        else if((*it)->getContent()->getType() == CONTENT_TYPE_PIXEL_STREAM)
+        {
+            // PixelStreams are not managed by residency: "stale" ones, which
+            // have not been requested for more than one frame, are destroyed by
+            // Factory::clearStaleObjects(). A culled stream must stay alive to
+            // keep its last frame until the streamer sends a new one.
+            factories_->getFactoryObject((*it)->getContent());
+        }
+
+        windowRenderer_.appendWindowBorder(windowBorders_, selectedWindowBorders_, zCoordinate);
 
         ++i;
     }
 }
 
-void DisplayGroupRenderer::renderMarkers(const MarkerPtrs& markers)
+void DisplayGroupRenderer::renderWindowBorders()
 {
-    for(MarkerPtrs::const_iterator it = markers.begin(); it != markers.end(); ++it)
-    {
-        // only render recently active markers
-        if((*it)->isActive())
-            markerRenderer_.render(*it);
-    }
+    glPushAttrib(GL_CURRENT_BIT | GL_ENABLE_BIT);
+
+    glColor4f(1,1,1,1);
+    windowBorders_.render();
+
+    glColor4f(1,0,0,1);
+    selectedWindowBorders_.render();
+
+    glPopAttrib();
 }
@@ -43,6 +43,7 @@
 #include "types.h"
 
 #include "ContentWindowRenderer.h"
+#include "GLQuadBatch.h"
 #include "MarkerRenderer.h"
 #include "Renderable.h"
 
@@ -52,12 +53,21 @@
 
 /**
  * Renders a DisplayGroup.
+ *
+ * The Contents are rendered first, ordered by depth. Windows which are outside
+ * of the active GLWindow are culled. The overlays (window
+ * borders and markers) are then collected into batches sharing the same
+ * OpenGL state and drawn with one call per batch.
  */
 class DisplayGroupRenderer : public Renderable
 {
 public:
-    /** Constructor */
-    DisplayGroupRenderer(FactoriesPtr factories);
+    /**
+     * Constructor.
+     * @param factories Used to retrieve FactoryObjects for rendering Contents.
+     * @param renderContext Provides the GLWindow currently being rendered.
+     */
+    DisplayGroupRenderer(FactoriesPtr factories, RenderContext& renderContext);
 
     /**
      * Render the associated DisplayGroup.
@@ -76,13 +86,15 @@ private:
     DisplayGroupManagerPtr displayGroup_;
     ContentWindowRenderer windowRenderer_;
     MarkerRenderer markerRenderer_;
+    GLQuadBatch windowBorders_;
+    GLQuadBatch selectedWindowBorders_;
 #if ENABLE_SKELETON_SUPPORT
     SkeletonRenderer skeletonRenderer_;
 #endif
 
     void renderBackgroundContent(ContentWindowManagerPtr backgroundContentWindow);
     void renderContentWindows(ContentWindowManagerPtrs contentWindowManagers);
-    void renderMarkers(const MarkerPtrs& markers);
+    void renderWindowBorders();
 };
 
 #endif // DISPLAYGROUPRENDERER_H
@@ -40,12 +40,18 @@
 #include "RenderContext.h"
 #include "GLWindow.h"
 #include "log.h"
+#include "config.h"
+
+#if ENABLE_TIFF_SUPPORT
+#  include "TiffPyramidReader.h"
+#endif
 
 #include <fstream>
 #include <boost/tokenizer.hpp>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QImageReader>
-#include <QtConcurrentRun>
 
 #ifdef __APPLE__
     #include <OpenGL/glu.h>
@@ -64,17 +70,20 @@
 
 const QString DynamicTexture::pyramidFileExtension = QString(PYRAMID_METADATA_FILE_EXTENSION);
 const QString DynamicTexture::pyramidFolderSuffix = QString(PYRAMID_FOLDER_SUFFIX);
+const QString DynamicTexture::pyramidMetadataFilename = QString(PYRAMID_METADATA_FILE_NAME);
+const QString DynamicTexture::pyramidImageExtension = QString(IMAGE_EXTENSION);
+const int DynamicTexture::pyramidTileSize = TEXTURE_SIZE;
 
 DynamicTexture::DynamicTexture(const QString& uri, DynamicTexturePtr parent,
                                const QRectF& parentCoordinates, const int childIndex)
     : uri_(uri)
     , useImagePyramid_(false)
-    , threadCount_(0)
+    , uriLastModified_(0)
     , parent_(parent)
     , imageCoordsInParentImage_(parentCoordinates)
     , depth_(0)
-    , loadImageThreadStarted_(false)
     , renderedChildren_(false)
+    , prefetchedChildren_(false)
 {
     // if we're a child...
     if(parent)
@@ -93,18 +102,27 @@ DynamicTexture::DynamicTexture(const QString& uri, DynamicTexturePtr parent,
         // this is the top-level object, so its path is 0
         treePath_.push_back(0);
 
+        uriLastModified_ = QFileInfo(uri_).lastModified().toMSecsSinceEpoch();
+
         // Try to read the pyramid metadata from file
         const QString extension = QString(".").append(pyramidFileExtension);
         if(uri_.endsWith(extension))
             readPyramidMetadataFromFile(uri_);
-        // Read the whole image to get the size. There might be a more optimized solution.
-        else
+        // Tiled TIFF files are read one region at a time
+        else if(!openTiffPyramid())
+            // Read the whole image to get the size. There might be a more optimized solution.
             loadFullResImage();
     }
 }
 
 DynamicTexture::~DynamicTexture()
 {
+    if(renderContext_)
+        renderContext_->getTileTexturePool().release(textureHandle_);
+
+    // The tile was read but never decoded
+    if(SharedTileCache* cache = getSharedTileCache())
+        cache->abandon(sharedTileClaim_);
 }
 
 bool DynamicTexture::isRoot() const
@@ -112,7 +130,7 @@ bool DynamicTexture::isRoot() const
     return depth_ == 0;
 }
 
-bool DynamicTexture::readPyramidMetadataFromFile(const QString& uri)
+bool DynamicTexture::readPyramidMetadata(const QString& uri, QString& pyramidFolder, QSize& imageSize)
 {
     std::ifstream ifs(uri.toAscii());
 
@@ -137,10 +155,34 @@ bool DynamicTexture::readPyramidMetadataFromFile(const QString& uri)
         return false;
     }
 
-    imagePyramidPath_ = QString(tokens[0].c_str());
+    pyramidFolder = QString(tokens[0].c_str());
+
+    imageSize.setWidth(atoi(tokens[1].c_str()));
+    imageSize.setHeight(atoi(tokens[2].c_str()));
+
+    return true;
+}
+
+bool DynamicTexture::readPyramidMetadataFromFile(const QString& uri)
+{
+    if(ImagePyramidContainer::isContainer(uri))
+    {
+        imagePyramidContainer_.reset(new ImagePyramidContainer);
+        if(!imagePyramidContainer_->open(uri))
+        {
+            imagePyramidContainer_.reset();
+            return false;
+        }
+        imageSize_ = imagePyramidContainer_->getImageSize();
+        useImagePyramid_ = true;
+
+        put_flog(LOG_DEBUG, "got image pyramid container %s, imageWidth = %i, imageHeight = %i",
+                 uri.toLocal8Bit().constData(), imageSize_.width(), imageSize_.height());
+        return true;
+    }
 
-    imageSize_.setWidth(atoi(tokens[1].c_str()));
-    imageSize_.setHeight(atoi(tokens[2].c_str()));
+    if(!readPyramidMetadata(uri, imagePyramidPath_, imageSize_))
+        return false;
 
     useImagePyramid_ = true;
 
@@ -180,6 +222,24 @@ bool DynamicTexture::writePyramidMetadataFiles(const QString& pyramidFolder) con
            writeMetadataFile(pyramidFolder, secondMetadataFilename);
 }
 
+bool DynamicTexture::openTiffPyramid()
+{
+#if ENABLE_TIFF_SUPPORT
+    if(!TiffPyramidReader::hasTiffExtension(uri_))
+        return false;
+
+    TiffPyramidReaderPtr reader(new TiffPyramidReader);
+    if(!reader->open(uri_))
+        return false;
+
+    tiffPyramidReader_ = reader;
+    imageSize_ = reader->getImageSize();
+    return true;
+#else
+    return false;
+#endif
+}
+
 QString DynamicTexture::getPyramidImageFilename() const
 {
     QString filename;
@@ -197,35 +257,150 @@ QString DynamicTexture::getPyramidImageFilename() const
     return filename;
 }
 
-void loadImageInThread(DynamicTexturePtr dynamicTexture)
+bool DynamicTexture::prepareTileRead()
+{
+    SharedTileCache* cache = getSharedTileCache();
+    if(!cache)
+        return true;
+
+    try
+    {
+        DynamicTexturePtr root = getRoot();
+        if(!root->useImagePyramid_ && !root->tiffPyramidReader_)
+            return true;
+
+        // Compressed tiles are not decoded, caching them would not save anything
+        if(root->imagePyramidContainer_ &&
+           root->imagePyramidContainer_->getTileFormat() != ImagePyramidContainer::TILES_JPEG)
+            return true;
+
+        // Retry later rather than decoding the tile twice
+        return cache->acquire(getSharedTileKey(), scaledImage_, sharedTileClaim_) != SharedTileCache::PENDING;
+    }
+    catch(const boost::bad_weak_ptr&)
+    {
+        put_flog(LOG_INFO, "The parent image was deleted during image loading.");
+        return true;
+    }
+}
+
+QByteArray DynamicTexture::readTileData()
+{
+    // The image was copied from the shared tile cache
+    if(!scaledImage_.isNull())
+        return QByteArray();
+
+    return readPyramidImageData();
+}
+
+QByteArray DynamicTexture::readPyramidImageData()
 {
     try
     {
-        dynamicTexture->loadImage();
-        dynamicTexture->decrementGlobalThreadCount();
+        DynamicTexturePtr root = getRoot();
+        if(!root->useImagePyramid_)
+            return QByteArray();
+
+        if(root->imagePyramidContainer_)
+            return root->imagePyramidContainer_->readTile(treePath_);
+
+        QFile file(root->imagePyramidPath_+'/'+getPyramidImageFilename());
+        if(!file.open(QIODevice::ReadOnly))
+        {
+            put_flog(LOG_ERROR, "could not open %s", file.fileName().toLocal8Bit().constData());
+            return QByteArray();
+        }
+        return file.readAll();
     }
     catch(const boost::bad_weak_ptr&)
     {
         put_flog(LOG_INFO, "The parent image was deleted during image loading.");
+        return QByteArray();
     }
 }
 
-void DynamicTexture::loadImageAsync()
+void DynamicTexture::decodeTileData(const QByteArray& data)
 {
-    // only start the thread if this DynamicTexture tree has one available
-    // each DynamicTexture tree is limited to (maxThreads - 2) threads, where
-    // the max is determined by the global QThreadPool instance
-    // we increase responsiveness / interactivity by not queuing up image loading
-    // const int maxThreads = std::max(QThreadPool::globalInstance()->maxThreadCount() - 2, 1);
-    // todo: this doesn't perform well with too many threads; restricting to 1 thread for now
-    const int maxThreads = 1;
+    try
+    {
+        // The image was copied from the shared tile cache
+        if(!scaledImage_.isNull())
+            return;
+
+        if(data.isEmpty())
+            loadImage();
+        else if(!decodePyramidImage(data))
+            put_flog(LOG_ERROR, "failed to decode %s", getPyramidImageFilename().toLocal8Bit().constData());
+    }
+    catch(const boost::bad_weak_ptr&)
+    {
+        put_flog(LOG_INFO, "The parent image was deleted during image loading.");
+    }
+    publishSharedTile();
+}
 
-    if(getGlobalThreadCount() < maxThreads)
+bool DynamicTexture::decodePyramidImage(const QByteArray& data)
+{
+    // Compressed tiles are uploaded to the GPU without decoding
+    if(CompressedImage::isCompressedImage(data))
     {
-        loadImageThreadStarted_ = true;
-        incrementGlobalThreadCount();
-        loadImageThread_ = QtConcurrent::run(loadImageInThread, shared_from_this());
+        compressedImage_ = CompressedImage::fromData(data);
+        return !compressedImage_.isNull();
     }
+    return scaledImage_.loadFromData(data, IMAGE_EXTENSION);
+}
+
+SharedTileCache* DynamicTexture::getSharedTileCache() const
+{
+    return renderContext_ ? renderContext_->getSharedTileCache() : 0;
+}
+
+SharedTileCache::Key DynamicTexture::getSharedTileKey()
+{
+    // The modification date invalidates the tiles of a regenerated pyramid
+    const DynamicTexturePtr root = getRoot();
+    return SharedTileCache::makeKey(QString("%1@%2#%3").arg(root->uri_)
+                                                       .arg(root->uriLastModified_)
+                                                       .arg(getPyramidImageFilename()));
+}
+
+void DynamicTexture::publishSharedTile()
+{
+    SharedTileCache* cache = getSharedTileCache();
+    if(!cache)
+        return;
+
+    if(scaledImage_.isNull())
+        cache->abandon(sharedTileClaim_);
+    else
+        cache->publish(sharedTileClaim_, scaledImage_);
+}
+
+void DynamicTexture::loadImageAsync(const TilePriority& priority)
+{
+    TileLoadScheduler& scheduler = renderContext_->getTileLoadScheduler();
+
+    // Requests which are not renewed every frame get cancelled by the scheduler
+    if(isLoadImageRequested())
+        scheduler.renew(loadImageRequest_, priority);
+    else
+        loadImageRequest_ = scheduler.request(shared_from_this(), priority);
+}
+
+bool DynamicTexture::isLoadImageRequested() const
+{
+    return loadImageRequest_ && !loadImageRequest_->isCancelled();
+}
+
+bool DynamicTexture::isImageLoaded() const
+{
+    return isLoadImageRequested() && loadImageRequest_->isFinished();
+}
+
+void DynamicTexture::waitForImage() const
+{
+    if(loadImageRequest_)
+        loadImageRequest_->waitForFinished();
 }
 
 bool DynamicTexture::loadFullResImage()
@@ -275,11 +450,28 @@ QImage DynamicTexture::loadImageRegionFromFullResImageFile(const QString& filena
 
 void DynamicTexture::loadImage()
 {
+#if ENABLE_TIFF_SUPPORT
+    const DynamicTexturePtr tiffRoot = getRoot();
+    if(tiffRoot->tiffPyramidReader_)
+    {
+        const QRect rootRect = isRoot() ? QRect(QPoint(0, 0), imageSize_)
+                                        : getRootImageCoordinates(0., 0., 1., 1.);
+        if(!isRoot())
+            imageSize_ = rootRect.size();
+
+        const QSize maxSize(TEXTURE_SIZE, TEXTURE_SIZE);
+        scaledImage_ = tiffRoot->tiffPyramidReader_->readRegion(rootRect, maxSize);
+        if(scaledImage_.isNull())
+            put_flog(LOG_ERROR, "failed to load the image. aborting.");
+        return;
+    }
+#endif
+
     if(isRoot())
     {
         if(useImagePyramid_)
         {
-            scaledImage_.load(imagePyramidPath_+'/'+getPyramidImageFilename(), IMAGE_EXTENSION);
+            decodePyramidImage(readPyramidImageData());
         }
         else
         {
@@ -293,7 +485,7 @@ void DynamicTexture::loadImage()
 
         if(root->useImagePyramid_)
         {
-            scaledImage_.load(root->imagePyramidPath_+'/'+getPyramidImageFilename(), IMAGE_EXTENSION);
+            decodePyramidImage(readPyramidImageData());
         }
         else
         {
@@ -314,7 +506,7 @@ void DynamicTexture::loadImage()
         }
     }
 
-    if(scaledImage_.isNull())
+    if(scaledImage_.isNull() && compressedImage_.isNull())
     {
         put_flog(LOG_ERROR, "failed to load the image. aborting.");
         return;
@@ -324,10 +516,8 @@ void DynamicTexture::loadImage()
 void DynamicTexture::getDimensions(int &width, int &height) const
 {
     // if we don't have a width and height, and the load image thread is running, wait for it to finish
-    if(imageSize_.isEmpty() && loadImageThreadStarted_)
-    {
-        loadImageThread_.waitForFinished();
-    }
+    if(imageSize_.isEmpty())
+        waitForImage();
 
     width = imageSize_.width();
     height = imageSize_.height();
@@ -346,17 +536,90 @@ void DynamicTexture::render(const QRectF& texCoords)
     }
 
     // Normal rendering: load the texture if not already available
-    if(!loadImageThreadStarted_)
-        loadImageAsync();
+    // Renew the request every frame, it may have been made by prefetch()
+    if(!hasTexture())
+        loadImageAsync(getPriorityInCurrentGLView());
 
     render_(texCoords);
 }
 
+void DynamicTexture::prefetch(const QRectF& texCoords)
+{
+    GLWindowPtr glWindow = renderContext_->getActiveGLWindow();
+    const QRectF windowRect = glWindow->getProjectedPixelRect(false);
+    const QRectF visibleRect = glWindow->getProjectedPixelRect(true);
+
+    if(windowRect.isEmpty() || visibleRect.isEmpty() || texCoords.isEmpty())
+        return;
+
+    // Only prefetch the part of the texture shown in the visible part of the window
+    const QRectF region(texCoords.x() + (visibleRect.x() - windowRect.x()) / windowRect.width() * texCoords.width(),
+                        texCoords.y() + (visibleRect.y() - windowRect.y()) / windowRect.height() * texCoords.height(),
+                        visibleRect.width() / windowRect.width() * texCoords.width(),
+                        visibleRect.height() / windowRect.height() * texCoords.height());
+
+    // Size of the whole texture on screen, in pixels
+    const QSizeF fullSize(windowRect.width() / texCoords.width(),
+                          windowRect.height() / texCoords.height());
+
+    prefetchRegion(region, fullSize);
+}
+
+void DynamicTexture::prefetchRegion(const QRectF& region, const QSizeF& fullSize)
+{
+    const QRectF visibleRegion = region.intersected(QRectF(0., 0., 1., 1.));
+    if(visibleRegion.isEmpty())
+        return;
+
+    // Same criterion as isResolutionSufficientForCurrentGLView()
+    if(canHaveChildren() && (fullSize.width() > TEXTURE_SIZE || fullSize.height() > TEXTURE_SIZE))
+    {
+        createChildren();
+        prefetchedChildren_ = true;
+
+        for(unsigned int i=0; i<children_.size(); i++)
+        {
+            const QRectF& bounds = children_[i]->imageCoordsInParentImage_;
+            const QRectF childRegion = visibleRegion.intersected(bounds).translated(-bounds.x(), -bounds.y());
+
+            children_[i]->prefetchRegion(QRectF(childRegion.x() / bounds.width(),
+                                                childRegion.y() / bounds.height(),
+                                                childRegion.width() / bounds.width(),
+                                                childRegion.height() / bounds.height()),
+                                         QSizeF(fullSize.width() * bounds.width(),
+                                                fullSize.height() * bounds.height()));
+        }
+        return;
+    }
+
+    if(!hasTexture() && !isImageLoaded())
+    {
+        const double coverage = visibleRegion.width() * fullSize.width() *
+                                visibleRegion.height() * fullSize.height();
+        loadImageAsync(TilePriority(depth_, coverage, true));
+    }
+}
+
+size_t DynamicTexture::getHostMemoryUsage() const
+{
+    size_t usage = 0;
+
+    // The images are written by the loading thread
+    if(!loadImageRequest_ || loadImageRequest_->isFinished())
+        usage += fullscaleImage_.byteCount() + scaledImage_.byteCount() +
+                 compressedImage_.blocks().size();
+
+    for(unsigned int i=0; i<children_.size(); i++)
+        usage += children_[i]->getHostMemoryUsage();
+
+    return usage;
+}
+
 void DynamicTexture::postRenderUpdate()
 {
     // Root needs to always have a texture for renderInParent()
-    if (isRoot() && !loadImageThreadStarted_)
-        loadImageAsync();
+    if (isRoot() && !isImageLoaded() && !hasTexture())
+        loadImageAsync(TilePriority(0, 0.));
 
     clearOldChildren();
     renderedChildren_ = false;
@@ -364,18 +627,22 @@ void DynamicTexture::postRenderUpdate()
 
 bool DynamicTexture::isVisibleInCurrentGLView()
 {
-    // TODO This objects visibility should be determined by using the GLWindow
-    // as a pre-render step, not retro-fitted in here!
-    const QRectF screenRect = renderContext_->getGLWindow()->getProjectedPixelRect(true);
+    const QRectF screenRect = renderContext_->getActiveGLWindow()->getProjectedPixelRect(true);
     return screenRect.width()*screenRect.height() > 0.;
 }
 
 bool DynamicTexture::isResolutionSufficientForCurrentGLView()
 {
-    const QRectF fullRect = renderContext_->getGLWindow()->getProjectedPixelRect(false);
+    const QRectF fullRect = renderContext_->getActiveGLWindow()->getProjectedPixelRect(false);
     return fullRect.width() <= TEXTURE_SIZE && fullRect.height() <= TEXTURE_SIZE;
 }
 
+TilePriority DynamicTexture::getPriorityInCurrentGLView() const
+{
+    const QRectF screenRect = renderContext_->getActiveGLWindow()->getProjectedPixelRect(true);
+    return TilePriority(depth_, screenRect.width()*screenRect.height());
+}
+
 bool DynamicTexture::canHaveChildren()
 {
     return (getRoot()->imageSize_.width() / (1 << depth_) > TEXTURE_SIZE ||
@@ -384,10 +651,10 @@ bool DynamicTexture::canHaveChildren()
 
 void DynamicTexture::render_(const QRectF& texCoords)
 {
-    if(!texture_.isValid() && loadImageThreadStarted_ && loadImageThread_.isFinished())
+    if(!hasTexture() && isImageLoaded() && (!scaledImage_.isNull() || !compressedImage_.isNull()))
         generateTexture();
 
-    if(texture_.isValid())
+    if(hasTexture())
     {
 #ifdef DYNAMIC_TEXTURE_SHOW_BORDER
         renderTextureBorder();
@@ -420,10 +687,10 @@ void DynamicTexture::renderTexturedUnitQuad(const QRectF& texCoords)
 {
     glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
 
-    texture_.bind();
+    const QRectF textureRegion = renderContext_->getTileTexturePool().bind(textureHandle_, texCoords);
 
     quad_.setEnableTexture(true);
-    quad_.setTexCoords(texCoords);
+    quad_.setTexCoords(textureRegion);
     quad_.setRenderMode(GL_QUADS);
     quad_.render();
 
@@ -432,8 +699,9 @@ void DynamicTexture::renderTexturedUnitQuad(const QRectF& texCoords)
 
 void DynamicTexture::clearOldChildren()
 {
-    if(!renderedChildren_ && !children_.empty() && getThreadsDoneDescending())
+    if(!renderedChildren_ && !prefetchedChildren_ && !children_.empty() && getThreadsDoneDescending())
         children_.clear();
+    prefetchedChildren_ = false;
 
     // run on my children (if i still have any)
     for(unsigned int i=0; i<children_.size(); i++)
@@ -459,8 +727,7 @@ bool DynamicTexture::generateImagePyramid(const QString& pyramidFolder)
 {
     if(isRoot())
     {
-        if(loadImageThreadStarted_)
-            loadImageThread_.waitForFinished();
+        waitForImage();
 
         if (!makePyramidFolder(pyramidFolder))
             return false;
@@ -502,19 +769,6 @@ bool DynamicTexture::generateImagePyramid(const QString& pyramidFolder)
     return true;
 }
 
-void DynamicTexture::decrementGlobalThreadCount()
-{
-    if(isRoot())
-    {
-        QMutexLocker locker(&threadCountMutex_);
-        threadCount_ = threadCount_ - 1;
-    }
-    else
-    {
-        return getRoot()->decrementGlobalThreadCount();
-    }
-}
-
 DynamicTexturePtr DynamicTexture::getRoot()
 {
     if(isRoot())
@@ -528,8 +782,7 @@ QRect DynamicTexture::getRootImageCoordinates(float x, float y, float w, float h
     if(isRoot())
     {
         // if necessary, block and wait for image loading to complete
-        if( loadImageThreadStarted_ && !loadImageThread_.isFinished( ))
-            loadImageThread_.waitForFinished();
+        waitForImage();
 
         return QRect(x*imageSize_.width(), y*imageSize_.height(),
                      w*imageSize_.width(), h*imageSize_.height());
@@ -575,8 +828,7 @@ QImage DynamicTexture::getImageFromParent(const QRectF& imageRegion, DynamicText
     }
 
     // wait for the load image thread to complete if it's in progress
-    if(loadImageThreadStarted_ && !loadImageThread_.isFinished())
-        loadImageThread_.waitForFinished();
+    waitForImage();
 
     if(!fullscaleImage_.isNull())
     {
@@ -601,10 +853,33 @@ QImage DynamicTexture::getImageFromParent(const QRectF& imageRegion, DynamicText
 
 void DynamicTexture::generateTexture()
 {
-    texture_.init(scaledImage_, GL_BGRA);
+    TileTexturePool& tileTexturePool = renderContext_->getTileTexturePool();
+
+    if(!compressedImage_.isNull())
+        textureHandle_ = tileTexturePool.upload(compressedImage_);
+    else
+        textureHandle_ = tileTexturePool.upload(scaledImage_);
+
+    // no longer need the images, unless the pool is full for this frame
+    if(textureHandle_.slot >= 0)
+    {
+        scaledImage_ = QImage();
+        compressedImage_ = CompressedImage();
+    }
+}
+
+bool DynamicTexture::hasTexture()
+{
+    if(textureHandle_.slot < 0)
+        return false;
+
+    if(renderContext_->getTileTexturePool().isValid(textureHandle_))
+        return true;
 
-    // no longer need the scaled image
-    scaledImage_ = QImage();
+    // The texture was recycled for another tile, load the image again
+    textureHandle_ = TileTextureHandle();
+    loadImageRequest_.reset();
+    return false;
 }
 
 void DynamicTexture::renderChildren(const QRectF& texCoords)
@@ -626,15 +901,7 @@ void DynamicTexture::renderChildren(const QRectF& texCoords)
     imageBounds[2] = QRectF(0.5,0.5,0.5,0.5);
     imageBounds[3] = QRectF(0.,0.5,0.5,0.5);
 
-    // see if we need to generate children
-    if(children_.empty())
-    {
-        for(unsigned int i=0; i<4; i++)
-        {
-            DynamicTexturePtr child(new DynamicTexture("", shared_from_this(), imageBounds[i], i));
-            children_.push_back(child);
-        }
-    }
+    createChildren();
 
     // render children
     for(unsigned int i=0; i<children_.size(); i++)
@@ -657,19 +924,37 @@ void DynamicTexture::renderChildren(const QRectF& texCoords)
                                 childTextureRect.width() / texCoords.width(),
                                 childTextureRect.height() / texCoords.height());
 
-        glPushMatrix();
-        glTranslatef(renderRect.x(), renderRect.y(), 0.);
-        glScalef(renderRect.width(), renderRect.height(), 1.);
+        GLWindowPtr glWindow = renderContext_->getActiveGLWindow();
+        glWindow->pushTransform(renderRect);
 
         children_[i]->render(childTextureRectTranslatedAndScaled);
 
-        glPopMatrix();
+        glWindow->popTransform();
+    }
+}
+
+void DynamicTexture::createChildren()
+{
+    if(!children_.empty())
+        return;
+
+    // image rectange a child quadrant contains
+    QRectF imageBounds[4];
+    imageBounds[0] = QRectF(0.,0.,0.5,0.5);
+    imageBounds[1] = QRectF(0.5,0.,0.5,0.5);
+    imageBounds[2] = QRectF(0.5,0.5,0.5,0.5);
+    imageBounds[3] = QRectF(0.,0.5,0.5,0.5);
+
+    for(unsigned int i=0; i<4; i++)
+    {
+        DynamicTexturePtr child(new DynamicTexture("", shared_from_this(), imageBounds[i], i));
+        children_.push_back(child);
     }
 }
 
 bool DynamicTexture::getThreadsDoneDescending()
 {
-    if(!loadImageThread_.isFinished())
+    if(loadImageRequest_ && !loadImageRequest_->isFinished())
         return false;
 
     for(unsigned int i=0; i<children_.size(); i++)
@@ -680,29 +965,3 @@ bool DynamicTexture::getThreadsDoneDescending()
 
     return true;
 }
-
-int DynamicTexture::getGlobalThreadCount()
-{
-    if(isRoot())
-    {
-        QMutexLocker locker(&threadCountMutex_);
-        return threadCount_;
-    }
-    else
-    {
-        return getRoot()->getGlobalThreadCount();
-    }
-}
-
-void DynamicTexture::incrementGlobalThreadCount()
-{
-    if(isRoot())
-    {
-        QMutexLocker locker(&threadCountMutex_);
-        threadCount_ = threadCount_ + 1;
-    }
-    else
-    {
-        return getRoot()->incrementGlobalThreadCount();
-    }
-}
@@ -40,12 +40,15 @@
 #define DYNAMIC_TEXTURE_H
 
 #include "types.h"
+#include "CompressedImage.h"
 #include "FactoryObject.h"
-#include "GLTexture2D.h"
 #include "GLQuad.h"
+#include "ImagePyramidContainer.h"
+#include "SharedTileCache.h"
+#include "TileLoadScheduler.h"
+#include "TileTexturePool.h"
 
 #include <QImage>
-#include <QFuture>
 #include <QRectF>
 
 #include <boost/shared_ptr.hpp>
@@ -58,9 +61,11 @@
  * It can work with two types of image files:
  * (1) A custom precomuted image pyramid (recommended)
  * (2) Direct reading from a large image
+ * The tiles are loaded by the TileLoadScheduler of the RenderContext.
  * @see generateImagePyramid()
  */
-class DynamicTexture : public boost::enable_shared_from_this<DynamicTexture>, public FactoryObject
+class DynamicTexture : public boost::enable_shared_from_this<DynamicTexture>, public FactoryObject,
+                       public TileSource
 {
 public:
     /**
@@ -82,6 +87,24 @@ public:
     /** The standard suffix for pyramid image folders */
     static const QString pyramidFolderSuffix;
 
+    /** The name of the metadata file in pyramid image folders */
+    static const QString pyramidMetadataFilename;
+
+    /** The file extension of pyramid images */
+    static const QString pyramidImageExtension;
+
+    /** The maximum size of pyramid images */
+    static const int pyramidTileSize;
+
+    /**
+     * Read a pyramid metadata file.
+     * @param uri The metadata file
+     * @param pyramidFolder Returned folder containing the pyramid images
+     * @param imageSize Returned size of the full resolution image
+     * @return true on success
+     */
+    static bool readPyramidMetadata(const QString& uri, QString& pyramidFolder, QSize& imageSize);
+
     /**
      * Get the dimensions of the full resolution texture.
      * @param width Returned width
@@ -95,6 +118,19 @@ public:
      */
     void render(const QRectF& texCoords) override;
 
+    /**
+     * Request the tiles needed to render a region at low priority.
+     * The requests are cancelled if they are not renewed in the next frame.
+     * @param texCoords The area of the full scale texture expected to be rendered
+     */
+    void prefetch(const QRectF& texCoords) override;
+
+    /**
+     * Get the host memory used by the images of this object and its children.
+     * Images which are being loaded are not taken into account.
+     */
+    size_t getHostMemoryUsage() const override;
+
     /**
      * Post render step.
      */
@@ -109,16 +145,32 @@ public:
     /**
      * Load the image for this part of the texture
      * @throw boost::bad_weak_ptr exception if a parent object is deleted during thread execution
-     * @internal asynchronous loading thread needs access to this method
      */
     void loadImage();
 
     /**
-     * Decrement the global count of loading threads.
-     * @throw boost::bad_weak_ptr exception if a parent object is deleted during thread execution
-     * @internal asynchronous loading thread needs access to this method
+     * Look for the tile in the RenderContext's SharedTileCache.
+     * If another process of this host has already decoded the tile, the
+     * image is copied from the cache.
+     * @return false if another process is still decoding the tile.
+     * @internal TileLoadScheduler I/O stage
+     */
+    bool prepareTileRead() override;
+
+    /**
+     * Read the pyramid image file of this tile, or its data in the pyramid container.
+     * @return The file content, empty if not using an image pyramid or if
+     *         the tile was found in the shared cache.
+     * @internal TileLoadScheduler I/O stage
      */
-    void decrementGlobalThreadCount();
+    QByteArray readTileData() override;
+
+    /**
+     * Decode the pyramid image of this tile, or load it from the full image.
+     * @param data The pyramid image file content, as returned by readTileData()
+     * @internal TileLoadScheduler decoding stage
+     */
+    void decodeTileData(const QByteArray& data) override;
 
 private:
     /* for root only: */
@@ -127,9 +179,9 @@ private:
 
     QString imagePyramidPath_;
     bool useImagePyramid_;
-
-    int threadCount_;
-    QMutex threadCountMutex_;
+    ImagePyramidContainerPtr imagePyramidContainer_; // Null for pyramid folders
+    TiffPyramidReaderPtr tiffPyramidReader_; // Null if not a tiled TIFF file
+    qint64 uriLastModified_; // Identifies the version of the tiles in the SharedTileCache
 
     QImage fullscaleImage_;
 
@@ -143,20 +195,25 @@ private:
     std::vector<int> treePath_; // To construct the image name for each object
     int depth_; // The depth of the object in the image pyramid
 
-    mutable QFuture<void> loadImageThread_; // Future for asychronous image loading
-    bool loadImageThreadStarted_; // True if the texture loading has been started
+    TileLoadRequestPtr loadImageRequest_; // Asynchronous image loading, null if not requested
+    SharedTileCache::Claim sharedTileClaim_; // This process decodes the tile for the SharedTileCache
 
     QSize imageSize_; // full scale image dimensions
     QImage scaledImage_; // for texture upload to GPU
-    GLTexture2D texture_;
+    CompressedImage compressedImage_; // for texture upload to GPU, from compressed pyramid containers
+    TileTextureHandle textureHandle_; // Texture in the RenderContext's TileTexturePool
     GLQuad quad_;
 
     std::vector<DynamicTexturePtr> children_; // Children in the image pyramid
     bool renderedChildren_; // Used for garbage-collecting unused child objects
+    bool prefetchedChildren_; // Children are used for prefetching
 
     bool isVisibleInCurrentGLView();
     bool isResolutionSufficientForCurrentGLView();
     bool canHaveChildren();
+    TilePriority getPriorityInCurrentGLView() const;
+    void prefetchRegion(const QRectF& region, const QSizeF& fullSize);
+    void createChildren();
 
     /**
      * Recursively clear children of this object which have not been rendered recently.
@@ -185,15 +242,25 @@ private:
     bool makePyramidFolder(const QString& pyramidFolder); // @Root only
     bool writeMetadataFile(const QString& pyramidFolder, const QString& filename) const; // @Root only
     bool writePyramidMetadataFiles(const QString& pyramidFolder) const; // @Root only
+    bool openTiffPyramid(); // @Root only
     QString getPyramidImageFilename() const; // @All
+    QByteArray readPyramidImageData(); // Read the tile from the pyramid files // @All
+    bool decodePyramidImage(const QByteArray& data); // Decode a JPEG or CompressedImage tile // @All
+    SharedTileCache* getSharedTileCache() const; // Null if disabled // @All
+    SharedTileCache::Key getSharedTileKey(); // @All
+    void publishSharedTile(); // Publish or abandon the claim on the shared tile // @All
 
     QRectF getImageRegionInParentImage(const QRectF& imageRegion) const;
 
-    void loadImageAsync(); // Trigger the loading of the image in a separate thread // @All
+    void loadImageAsync(const TilePriority& priority); // Request or renew the loading of the image // @All
+    bool isLoadImageRequested() const; // True if the loading was requested and not cancelled // @All
+    bool isImageLoaded() const; // True if the loading is finished // @All
+    void waitForImage() const; // Block until the image is loaded, if requested // @All
     bool loadFullResImage(); // @Root only
     QImage loadImageRegionFromFullResImageFile(const QString& filename); // @Child only
     QImage getImageFromParent(const QRectF& imageRegion, DynamicTexture * start); // @Child only
     void generateTexture(); // @All
+    bool hasTexture(); // True if the texture is in the TileTexturePool // @All
 
     void renderChildren(const QRectF& texCoords); // @All
     void renderTextureBorder(); // @All
@@ -201,9 +268,6 @@ private:
 
     bool getThreadsDoneDescending(); // Used by clearOldChildren() // @Root
 
-    int getGlobalThreadCount(); // Get the global count of loading threads // @Root
-    void incrementGlobalThreadCount(); // Increment the global cound of loading threads // @Root
-
     QRect getRootImageCoordinates(float x, float y, float w, float h); // @TODO-Remove
 };
 
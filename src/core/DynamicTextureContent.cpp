@@ -39,8 +39,14 @@
 #include "DynamicTextureContent.h"
 #include "globals.h"
 #include "DynamicTexture.h"
+#include "ImagePyramidContainer.h"
 #include "serializationHelpers.h"
 #include "Factories.h"
+#include "config.h"
+
+#if ENABLE_TIFF_SUPPORT
+#  include "TiffPyramidReader.h"
+#endif
 
 #include <boost/serialization/export.hpp>
 
@@ -58,7 +64,32 @@ CONTENT_TYPE DynamicTextureContent::getType()
 bool DynamicTextureContent::readMetadata()
 {
     QFileInfo file( getURI( ));
-    return file.exists() && file.isReadable();
+    if( !file.exists() || !file.isReadable( ))
+        return false;
+
+    // Pyramid containers store the image size in their header
+    if( ImagePyramidContainer::isContainer( getURI( )))
+    {
+        ImagePyramidContainer container;
+        if( !container.open( getURI( )))
+            return false;
+
+        const QSize& size = container.getImageSize();
+        setDimensions( size.width(), size.height( ));
+    }
+#if ENABLE_TIFF_SUPPORT
+    // Tiled TIFF files are not necessarily readable by QImageReader
+    else if( TiffPyramidReader::hasTiffExtension( getURI( )))
+    {
+        TiffPyramidReader reader;
+        if( reader.open( getURI( )))
+        {
+            const QSize size = reader.getImageSize();
+            setDimensions( size.width(), size.height( ));
+        }
+    }
+#endif
+    return true;
 }
 
 const QStringList& DynamicTextureContent::getSupportedExtensions()
@@ -68,6 +99,9 @@ const QStringList& DynamicTextureContent::getSupportedExtensions()
     if (extensions.empty())
     {
         extensions << "pyr";
+#if ENABLE_TIFF_SUPPORT
+        extensions << "tif" << "tiff";
+#endif
 
         const QList<QByteArray>& imageFormats = QImageReader::supportedImageFormats();
         foreach( const QByteArray entry, imageFormats )
@@ -83,5 +117,7 @@ void DynamicTextureContent::advance(FactoriesPtr factories, ContentWindowManager
         return;
 
     // recall that advance() is called after rendering
-    factories->getDynamicTextureFactory().getObject(getURI())->postRenderUpdate();
+    DynamicTexturePtr dynamicTexture = factories->getDynamicTextureFactory().findObject(getURI());
+    if( dynamicTexture )
+        dynamicTexture->postRenderUpdate();
 }
@@ -40,47 +40,117 @@
 #include "FFMPEGMovie.h"
 
 #include "FFMPEGVideoFrameConverter.h"
+#include "MovieFrameQueue.h"
+#include "MovieKeyframeIndex.h"
+#include "MoviePacketQueue.h"
 
 #include "log.h"
 
 #include "globals.h"
 
+#include <QMutex>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <limits>
+
 #define INVALID_STREAM_INDEX -1
 
 #define MICROSEC 1000000.0
 
+// Number of frames decoded ahead of the playback position
+#define DECODED_FRAMES_QUEUE_SIZE 4
+
+// Streamed mode: maximum time the decoding thread waits for new packets
+#define PACKET_WAIT_TIMEOUT_MS 20
+
 #pragma clang diagnostic ignored "-Wdeprecated"
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 
-FFMPEGMovie::FFMPEGMovie(const QString& uri)
+namespace
+{
+// Movies can be opened from background threads, but the registration of the
+// formats and avcodec_open2() / avcodec_close() are not thread-safe
+QMutex ffmpegMutex;
+}
+
+/**
+ * Decode the frames of an FFMPEGMovie until its MovieFrameQueue is stopped.
+ */
+class FFMPEGMovieDecodeThread : public QThread
+{
+public:
+    FFMPEGMovieDecodeThread(FFMPEGMovie& movie)
+        : movie_(movie)
+    {}
+
+protected:
+    void run() override
+    {
+        movie_.decodeFrames();
+    }
+
+private:
+    FFMPEGMovie& movie_;
+};
+
+FFMPEGMovie::FFMPEGMovie(const QString& uri, const bool streamed)
     : avFormatContext_(0)
     , videoCodecContext_(0)
     , avFrame_(0)
     , videoStream_(0)
     , videoFrameConverter_(0)
+    , startTime_(AV_NOPTS_VALUE)
+    , streamDuration_(0)
     // Seeking parameters
     , den2_(0)
     , num2_(0)
     , numFrames_(0)
     , frameDurationInSeconds_(0)
+    , uri_(uri)
+    , seekTarget_(0.0)
+    , endOfFile_(false)
     // Internal
+    , streamed_(streamed)
     , loop_(false)
     , frameDecodingComplete_(0)
     , isValid_(false)
     , skippedFrames_(false)
     // Public status
     , newFrameAvailable_(false)
+    , streamLoop_(0)
+    , waitForKeyframe_(true)
+    , convertFullFrames_(false)
+    , reconvertPending_(false)
 {
     FFMPEGMovie::initGlobalState();
 
-    isValid_ = open(uri);
+    timeBase_.num = 0;
+    timeBase_.den = 1;
+    frameRate_.num = 0;
+    frameRate_.den = 1;
+
+    // Streamed movies are opened by the first addPackets()
+    if (streamed_)
+        packetQueue_.reset(new MoviePacketQueue);
+    else
+        isValid_ = open(uri);
 }
 
 FFMPEGMovie::~FFMPEGMovie()
 {
+    stopDecodeThread();
+    stopKeyframeIndexing();
+
     closeVideoStreamDecoder();
     releaseAvFormatContext();
 
+    if (streamed_ && videoCodecContext_)
+    {
+        av_freep(&videoCodecContext_->extradata);
+        av_freep(&videoCodecContext_);
+    }
+
     av_free(avFrame_);
 }
 
@@ -95,6 +165,52 @@ bool FFMPEGMovie::open(const QString& uri)
     if (!openVideoStreamDecoder())
         return false;
 
+    return initDecoding();
+}
+
+bool FFMPEGMovie::openStream(const MovieStreamParameters& parameters)
+{
+    videoCodecContext_ = avcodec_alloc_context3(NULL);
+    if (!videoCodecContext_)
+    {
+        put_flog(LOG_ERROR, "error allocating codec context");
+        return false;
+    }
+
+    videoCodecContext_->codec_type = AVMEDIA_TYPE_VIDEO;
+    videoCodecContext_->codec_id = (AVCodecID)parameters.codecId;
+    videoCodecContext_->codec_tag = parameters.codecTag;
+    videoCodecContext_->width = parameters.width;
+    videoCodecContext_->height = parameters.height;
+    videoCodecContext_->pix_fmt = (PixelFormat)parameters.pixelFormat;
+    videoCodecContext_->bits_per_coded_sample = parameters.bitsPerCodedSample;
+
+    // The decoders read past the end of the extradata, it must be padded
+    if (!parameters.extradata.empty())
+    {
+        const size_t size = parameters.extradata.size();
+        videoCodecContext_->extradata = (uint8_t*)av_mallocz(size + FF_INPUT_BUFFER_PADDING_SIZE);
+        if (!videoCodecContext_->extradata)
+            return false;
+        memcpy(videoCodecContext_->extradata, parameters.extradata.data(), size);
+        videoCodecContext_->extradata_size = size;
+    }
+
+    timeBase_.num = parameters.timeBaseNum;
+    timeBase_.den = parameters.timeBaseDen;
+    frameRate_.num = parameters.frameRateNum;
+    frameRate_.den = parameters.frameRateDen;
+    startTime_ = parameters.startTime;
+    streamDuration_ = parameters.duration;
+
+    if (!openVideoStreamDecoder())
+        return false;
+
+    return initDecoding();
+}
+
+bool FFMPEGMovie::initDecoding()
+{
     avFrame_ = avcodec_alloc_frame();
     if( !avFrame_ )
     {
@@ -141,6 +257,14 @@ bool FFMPEGMovie::findVideoStream()
         if(avFormatContext_->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO)
         {
             videoStream_ = avFormatContext_->streams[i]; // Shortcut pointer - don't free
+
+            // Contains information about the codec that the stream is using
+            videoCodecContext_ = videoStream_->codec; // Shortcut - don't free
+
+            timeBase_ = videoStream_->time_base;
+            frameRate_ = videoStream_->r_frame_rate;
+            startTime_ = videoStream_->start_time;
+            streamDuration_ = videoStream_->duration;
             return true;
         }
     }
@@ -152,9 +276,6 @@ bool FFMPEGMovie::findVideoStream()
 
 bool FFMPEGMovie::openVideoStreamDecoder()
 {
-    // Contains information about the codec that the stream is using
-    videoCodecContext_ = videoStream_->codec; // Shortcut - don't free
-
     AVCodec * codec = avcodec_find_decoder(videoCodecContext_->codec_id);
     if(!codec)
     {
@@ -162,7 +283,12 @@ bool FFMPEGMovie::openVideoStreamDecoder()
         return false;
     }
 
+    // Decode with multiple threads, using frame and slice parallelism
+    videoCodecContext_->thread_count = QThread::idealThreadCount();
+    videoCodecContext_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
     // open codec
+    QMutexLocker locker(&ffmpegMutex);
     const int ret = avcodec_open2(videoCodecContext_, codec, NULL);
 
     if(ret < 0)
@@ -179,11 +305,16 @@ bool FFMPEGMovie::openVideoStreamDecoder()
 
 void FFMPEGMovie::closeVideoStreamDecoder() const
 {
+    if (!videoCodecContext_)
+        return;
+
+    QMutexLocker locker(&ffmpegMutex);
     avcodec_close( videoCodecContext_ );
 }
 
 void FFMPEGMovie::initGlobalState()
 {
+    QMutexLocker locker(&ffmpegMutex);
     static bool initialized = false;
 
     if (!initialized)
@@ -200,17 +331,79 @@ bool FFMPEGMovie::isValid() const
 
 unsigned int FFMPEGMovie::getWidth() const
 {
-    return videoCodecContext_->width;
+    return videoCodecContext_ ? videoCodecContext_->width : 0;
 }
 
 unsigned int FFMPEGMovie::getHeight() const
 {
-    return videoCodecContext_->height;
+    return videoCodecContext_ ? videoCodecContext_->height : 0;
+}
+
+void FFMPEGMovie::addPackets(const MoviePackets& packets)
+{
+    if (!streamed_)
+        return;
+
+    if (!videoCodecContext_ && packets.parameters.isValid())
+        isValid_ = openStream(packets.parameters);
+
+    if (!isValid_)
+        return;
+
+    // All the wall processes receive the packets in the same frame and
+    // follow the playback position of the master
+    timePosition_ = boost::posix_time::microseconds(packets.position * MICROSEC);
+
+    if (packets.loop != streamLoop_)
+    {
+        streamLoop_ = packets.loop;
+        packetQueue_->setLoop(streamLoop_);
+        if (frameQueue_)
+            frameQueue_->seek(packets.position);
+    }
+
+    packetQueue_->push(packets.packets);
 }
 
 const void* FFMPEGMovie::getData() const
 {
-    return videoFrameConverter_->getData();
+    const uint8_t* frame = frameQueue_ ? frameQueue_->getCurrentFrame() : 0;
+    return frame ? frame : videoFrameConverter_->getData();
+}
+
+QRect FFMPEGMovie::getDataRegion() const
+{
+    if (frameQueue_ && frameQueue_->getCurrentFrame())
+        return frameQueue_->getCurrentFrameRegion();
+    return QRect(0, 0, getWidth(), getHeight());
+}
+
+void FFMPEGMovie::setVisibleRegion(const QRectF& region)
+{
+    const QRectF frame(0, 0, getWidth(), getHeight());
+    const QRectF pixelRegion(region.x() * frame.width(), region.y() * frame.height(),
+                             region.width() * frame.width(), region.height() * frame.height());
+
+    QMutexLocker locker(&visibleRegionMutex_);
+    visibleRegion_ = pixelRegion.toAlignedRect() & frame.toRect();
+}
+
+QRect FFMPEGMovie::getVisibleRegion() const
+{
+    QMutexLocker locker(&visibleRegionMutex_);
+    return convertFullFrames_ ? QRect() : visibleRegion_;
+}
+
+void FFMPEGMovie::setConvertFullFrames(const bool convertFullFrames)
+{
+    QMutexLocker locker(&visibleRegionMutex_);
+    convertFullFrames_ = convertFullFrames;
+}
+
+size_t FFMPEGMovie::getMemoryUsage() const
+{
+    const size_t frameBytes = (size_t)getWidth() * getHeight() * 4;
+    return frameBytes + (frameQueue_ ? frameQueue_->getMemoryUsage() : 0);
 }
 
 void FFMPEGMovie::setLoop(const bool loop)
@@ -220,8 +413,7 @@ void FFMPEGMovie::setLoop(const bool loop)
 
 double FFMPEGMovie::getDuration() const
 {
-    const double duration = (double)videoStream_->duration *
-            (double)videoStream_->time_base.num / (double)videoStream_->time_base.den;
+    const double duration = (double)streamDuration_ * av_q2d(timeBase_);
     return std::max(duration, 0.0);
 }
 
@@ -229,73 +421,157 @@ bool FFMPEGMovie::jumpTo(const double timePosInSeconds)
 {
     newFrameAvailable_ = false;
 
-    const int64_t frameIndex = timePosInSeconds / frameDurationInSeconds_;
-    if (!seekToNearestFullframe(frameIndex))
+    // The master application controls the position of streamed movies
+    if (streamed_)
         return false;
 
-    do {
-        if(!readVideoFrame())
-            return false;
+    // The decoding thread owns the decoder once it is started
+    if (frameQueue_)
+    {
+        timePosition_ = boost::posix_time::microseconds(timePosInSeconds * MICROSEC);
+        frameQueue_->seek(timePosInSeconds);
+        return true;
     }
-    while( !frameDecodingComplete_ );
 
-    timePosition_ = boost::posix_time::microseconds(timePosInSeconds * MICROSEC);
+    if (!decodeFrameAt(timePosInSeconds))
+        return false;
 
     convertVideoFrame();
     return true;
 }
 
-void FFMPEGMovie::update(const boost::posix_time::time_duration timeSinceLastFrame, const bool skipDecoding)
+QImage FFMPEGMovie::decodeImage(const double timePosInSeconds, const QSize& size)
 {
     newFrameAvailable_ = false;
 
-    // If decoding is slower than frame rate, slow down decoding speed
-    const double timeIncrementInSec = timeSinceLastFrame.total_microseconds() / MICROSEC;
-    if (timeIncrementInSec < frameDurationInSeconds_)
-        timePosition_ += timeSinceLastFrame;
-    else
+    if (streamed_ || frameQueue_ || size.isEmpty())
+        return QImage();
+
+    if (!decodeFrameAt(timePosInSeconds))
+        return QImage();
+
+    // The converter writes packed RGBA rows, which are 32 bits aligned like QImage rows
+    QImage image(size, QImage::Format_ARGB32);
+    if (!videoFrameConverter_->scale(avFrame_, image.bits(), size))
+        return QImage();
+
+    return image.rgbSwapped();
+}
+
+bool FFMPEGMovie::decodeFrameAt(const double timePosInSeconds)
+{
+    if (!seek(timePosInSeconds))
+        return false;
+
+    // Decode forward to the frame at the requested position
+    while (getFrameTimestampInSeconds() + frameDurationInSeconds_ <= timePosInSeconds)
     {
-        const double factor = frameDurationInSeconds_ / timeIncrementInSec;
-        const double increment = factor * frameDurationInSeconds_;
-        timePosition_ += boost::posix_time::microseconds(increment * MICROSEC);
+        if (!readVideoFrame())
+            break;
     }
 
+    timePosition_ = boost::posix_time::microseconds(timePosInSeconds * MICROSEC);
+    return true;
+}
+
+void FFMPEGMovie::update(const boost::posix_time::time_duration timeSinceLastFrame, const bool skipDecoding)
+{
+    newFrameAvailable_ = false;
+
+    if (!isValid_)
+        return;
+
+    // Follow the wall clock, the decoding thread drops the frames it is late for.
+    // The clock stops on the last frame and while the current frame is
+    // decoded again.
+    const bool frozen = frameQueue_ && (frameQueue_->isEndOfStream() || reconvertPending_);
+    if (!frozen)
+        timePosition_ += timeSinceLastFrame;
+
+    // The packets preceding the playback position are not needed anymore
+    if (streamed_)
+        packetQueue_->trim(getTimePositionInSeconds());
+
     if (skipDecoding)
     {
         skippedFrames_ = true;
         return;
     }
 
-    if (skippedFrames_)
-        clampTimePosition();
-
-    const double timePositionInSec = timePosition_.total_microseconds() / MICROSEC;
-    const int64_t index = timePositionInSec / frameDurationInSeconds_;
-
-    bool readNewVideoFrame = false;
+    if (!decodeThread_)
+    {
+        startKeyframeIndexing();
+        startDecodeThread();
+    }
 
-    // Catch up on missed frames
-    if (skippedFrames_)
+    // Catch up on missed frames. Streamed movies can't seek, the decoding
+    // thread skips the late frames instead.
+    if (skippedFrames_ && !streamed_)
     {
-        readNewVideoFrame = seekToNearestFullframe(index);
-        skippedFrames_ = false;
+        clampTimePosition();
+        frameQueue_->seek(getTimePositionInSeconds());
     }
+    skippedFrames_ = false;
 
-    // Read frames until we reach the correct timestamp
-    while(avFrame_->pkt_dts < getTimestampForFrameIndex(index))
+    // Return to start once all the frames were displayed
+    if (loop_ && !streamed_ && frameQueue_->isEndOfStream())
     {
-        readNewVideoFrame = true;
+        timePosition_ = boost::posix_time::time_duration();
+        frameQueue_->seek(0.0);
+    }
 
-        // Read one frame and return to start if EOF reached
-        if(!readVideoFrame() && loop_)
-        {
-            rewind();
-            break;
-        }
+    // The last frame stays displayed at the end of the movie
+    if (frameQueue_->isEndOfStream() || reconvertPending_)
+        reconvertCurrentFrame();
+    else
+        setConvertFullFrames(false);
+
+    newFrameAvailable_ = frameQueue_->update(getTimePositionInSeconds());
+    if (newFrameAvailable_)
+        reconvertPending_ = false;
+}
+
+void FFMPEGMovie::refreshFrame()
+{
+    newFrameAvailable_ = false;
+
+    // The first frame is converted entirely until playback starts
+    if (!isValid_ || !frameQueue_)
+        return;
+
+    reconvertCurrentFrame();
+
+    newFrameAvailable_ = frameQueue_->update(getTimePositionInSeconds());
+    if (newFrameAvailable_)
+        reconvertPending_ = false;
+}
+
+void FFMPEGMovie::reconvertCurrentFrame()
+{
+    // The current frame is displayed for a while, convert the next ones
+    // entirely so that the visible region can change without decoding again
+    setConvertFullFrames(true);
+
+    if (reconvertPending_ || !frameQueue_->getCurrentFrame())
+        return;
+
+    QRect visibleRegion;
+    {
+        QMutexLocker locker(&visibleRegionMutex_);
+        visibleRegion = visibleRegion_;
     }
+    if (visibleRegion.isEmpty())
+        visibleRegion = QRect(0, 0, getWidth(), getHeight());
 
-    if (readNewVideoFrame)
-        convertVideoFrame();
+    if (frameQueue_->getCurrentFrameRegion().contains(visibleRegion))
+        return;
+
+    // Decode the current frame again. The position is moved just after its
+    // timestamp, so the decoding thread does not drop it as a late frame.
+    const double timestamp = frameQueue_->getCurrentFrameTimestamp();
+    timePosition_ = boost::posix_time::microseconds(timestamp * MICROSEC + 1);
+    frameQueue_->seek(getTimePositionInSeconds());
+    reconvertPending_ = true;
 }
 
 bool FFMPEGMovie::isNewFrameAvailable() const
@@ -314,6 +590,11 @@ void FFMPEGMovie::clampTimePosition()
         timePosition_ -= boost::posix_time::microseconds(duration * MICROSEC);
 }
 
+double FFMPEGMovie::getTimePositionInSeconds() const
+{
+    return timePosition_.total_microseconds() / MICROSEC;
+}
+
 int64_t FFMPEGMovie::getTimestampForFrameIndex(const int64_t frameIndex) const
 {
     if (frameIndex < 0 || (numFrames_ && frameIndex >= numFrames_))
@@ -324,14 +605,42 @@ int64_t FFMPEGMovie::getTimestampForFrameIndex(const int64_t frameIndex) const
 
     int64_t timestamp = av_rescale(frameIndex, den2_, num2_);
 
-    if (videoStream_->start_time != (int64_t)AV_NOPTS_VALUE)
-        timestamp += videoStream_->start_time;
+    if (startTime_ != (int64_t)AV_NOPTS_VALUE)
+        timestamp += startTime_;
 
     return timestamp;
 }
 
-bool FFMPEGMovie::seekToNearestFullframe(const int64_t frameIndex)
+double FFMPEGMovie::getFrameTimestampInSeconds() const
+{
+    // The pts follows the reordering of frame threading, unlike the dts
+    int64_t timestamp = avFrame_->pkt_pts;
+    if (timestamp == (int64_t)AV_NOPTS_VALUE)
+        timestamp = avFrame_->pkt_dts;
+
+    if (startTime_ != (int64_t)AV_NOPTS_VALUE)
+        timestamp -= startTime_;
+
+    return timestamp * av_q2d(timeBase_);
+}
+
+double FFMPEGMovie::getPacketTimestampInSeconds(const AVPacket& packet) const
 {
+    int64_t timestamp = packet.pts;
+    if (timestamp == (int64_t)AV_NOPTS_VALUE)
+        timestamp = packet.dts;
+    if (timestamp == (int64_t)AV_NOPTS_VALUE)
+        return std::numeric_limits<double>::max();
+
+    if (startTime_ != (int64_t)AV_NOPTS_VALUE)
+        timestamp -= startTime_;
+
+    return timestamp * av_q2d(timeBase_);
+}
+
+bool FFMPEGMovie::seek(const double timePosInSeconds)
+{
+    const int64_t frameIndex = timePosInSeconds / frameDurationInSeconds_;
     if (frameIndex < 0 || (numFrames_ && frameIndex >= numFrames_))
     {
         put_flog(LOG_WARN, "Invalid index: %i, seeking aborted.", frameIndex);
@@ -340,13 +649,24 @@ bool FFMPEGMovie::seekToNearestFullframe(const int64_t frameIndex)
 
     const int64_t desiredTimestamp = getTimestampForFrameIndex(frameIndex);
 
-    // Seek to the nearest keyframe before desiredTimestamp.
-    if(avformat_seek_file(avFormatContext_, videoStream_->index, 0, desiredTimestamp,
-                          desiredTimestamp, AVSEEK_FLAG_FRAME) != 0)
+    // The frames preceding the target are only decoded if other frames depend on them
+    seekTarget_ = timePosInSeconds;
+
+    // Decoding forward within the current group of pictures is cheaper than seeking
+    if (isInCurrentKeyframeInterval(desiredTimestamp))
+        return readVideoFrame();
+
+    if (!seekToKeyframe(desiredTimestamp))
     {
-        put_flog(LOG_ERROR, "seeking error, seeking aborted.");
-        return false;
+        // Seek to the nearest keyframe before desiredTimestamp.
+        if(avformat_seek_file(avFormatContext_, videoStream_->index, 0, desiredTimestamp,
+                              desiredTimestamp, AVSEEK_FLAG_FRAME) != 0)
+        {
+            put_flog(LOG_ERROR, "seeking error, seeking aborted.");
+            return false;
+        }
     }
+    endOfFile_ = false;
 
     // Always flush buffers after seeking
     avcodec_flush_buffers(videoCodecContext_);
@@ -355,8 +675,48 @@ bool FFMPEGMovie::seekToNearestFullframe(const int64_t frameIndex)
     return readVideoFrame();
 }
 
+bool FFMPEGMovie::seekToKeyframe(const int64_t timestamp)
+{
+    if (!keyframeIndex_)
+        return false;
+
+    MovieKeyframeIndex::Keyframe keyframe;
+    if (!keyframeIndex_->findKeyframe(timestamp, keyframe))
+        return false;
+
+    // Demuxers without an index of their own search the file for timestamps
+    const bool byteSeek = videoStream_->nb_index_entries == 0 && keyframe.position >= 0 &&
+                          !(avFormatContext_->iformat->flags & AVFMT_NO_BYTE_SEEK);
+    if (byteSeek)
+        return av_seek_frame(avFormatContext_, videoStream_->index, keyframe.position,
+                             AVSEEK_FLAG_BYTE) >= 0;
+
+    const int64_t keyframeTimestamp = (keyframe.dts != (int64_t)AV_NOPTS_VALUE) ?
+                                      keyframe.dts : keyframe.pts;
+    return av_seek_frame(avFormatContext_, videoStream_->index, keyframeTimestamp,
+                         AVSEEK_FLAG_BACKWARD) >= 0;
+}
+
+bool FFMPEGMovie::isInCurrentKeyframeInterval(const int64_t timestamp) const
+{
+    if (!keyframeIndex_ || endOfFile_ || !frameDecodingComplete_)
+        return false;
+
+    const int64_t currentTimestamp = avFrame_->pkt_pts;
+    if (currentTimestamp == (int64_t)AV_NOPTS_VALUE || currentTimestamp > timestamp)
+        return false;
+
+    MovieKeyframeIndex::Keyframe current, target;
+    return keyframeIndex_->findKeyframe(currentTimestamp, current) &&
+           keyframeIndex_->findKeyframe(timestamp, target) &&
+           current.pts == target.pts;
+}
+
 bool FFMPEGMovie::readVideoFrame()
 {
+    if (streamed_)
+        return readStreamedVideoFrame();
+
     int avReadStatus = 0;
 
     AVPacket packet;
@@ -365,6 +725,14 @@ bool FFMPEGMovie::readVideoFrame()
     // keep reading frames until we decode a valid video frame
     while((avReadStatus = av_read_frame(avFormatContext_, &packet)) >= 0)
     {
+        // Frames which are not displayed after seeking are only decoded if
+        // other frames depend on them
+        if(isVideoStream(packet))
+        {
+            const bool skipped = getPacketTimestampInSeconds(packet) + frameDurationInSeconds_ <= seekTarget_;
+            videoCodecContext_->skip_frame = skipped ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+        }
+
         if(isVideoStream(packet) && decodeVideoFrame(packet))
         {
             // free the packet that was allocated by av_read_frame
@@ -375,28 +743,71 @@ bool FFMPEGMovie::readVideoFrame()
         av_free_packet(&packet);
     }
 
-    // False if file read error or EOF reached
-    return avReadStatus >= 0;
-}
+    if (avReadStatus >= 0)
+        return true;
 
-bool FFMPEGMovie::isVideoStream(const AVPacket& packet) const
-{
-    return packet.stream_index == videoStream_->index;
+    endOfFile_ = true;
+    videoCodecContext_->skip_frame = AVDISCARD_DEFAULT;
+
+    // Frame threading delays the output, flush the remaining frames at EOF
+    packet.data = 0;
+    packet.size = 0;
+
+    // False if file read error or EOF reached and no more frames are delayed
+    return decodeVideoFrame(packet);
 }
 
-void FFMPEGMovie::rewind()
+bool FFMPEGMovie::readStreamedVideoFrame()
 {
-    if (av_seek_frame(avFormatContext_, videoStream_->index, 0, AVSEEK_FLAG_BACKWARD) >= 0)
+    MoviePacket moviePacket;
+    bool discontinuity = false;
+
+    while (packetQueue_->pop(moviePacket, discontinuity, PACKET_WAIT_TIMEOUT_MS))
     {
-        put_flog(LOG_DEBUG, "Time: %lf", timePosition_.total_microseconds() / MICROSEC );
+        // Packets were dropped, restart decoding from the next keyframe
+        if (discontinuity)
+        {
+            avcodec_flush_buffers(videoCodecContext_);
+            waitForKeyframe_ = true;
+        }
 
-        timePosition_ = boost::posix_time::time_duration();
+        if (waitForKeyframe_ && !moviePacket.keyframe)
+            continue;
+        waitForKeyframe_ = false;
+
+        // The decoders read past the end of the data, it must be padded
+        const size_t size = moviePacket.data.size();
+        moviePacket.data.resize(size + FF_INPUT_BUFFER_PADDING_SIZE, 0);
+
+        AVPacket packet;
+        av_init_packet(&packet);
+        packet.data = moviePacket.data.data();
+        packet.size = size;
+        packet.pts = moviePacket.pts;
+        packet.dts = moviePacket.dts;
+        packet.flags = moviePacket.keyframe ? AV_PKT_FLAG_KEY : 0;
 
-        // Always flush buffers after seeking
-        avcodec_flush_buffers(videoCodecContext_);
+        if (decodeVideoFrame(packet))
+            return true;
+    }
 
-        readVideoFrame();
+    // Frame threading delays the output, flush the remaining frames of the
+    // current loop before the next one starts
+    if (packetQueue_->isEndOfLoop() && !waitForKeyframe_)
+    {
+        AVPacket packet;
+        av_init_packet(&packet);
+        packet.data = 0;
+        packet.size = 0;
+        return decodeVideoFrame(packet);
     }
+
+    return false;
+}
+
+bool FFMPEGMovie::isVideoStream(const AVPacket& packet) const
+{
+    return packet.stream_index == videoStream_->index;
 }
 
 bool FFMPEGMovie::decodeVideoFrame(AVPacket& packet)
@@ -412,7 +823,7 @@ bool FFMPEGMovie::decodeVideoFrame(AVPacket& packet)
     // make sure we got a full video frame and convert the frame from its native format to RGB
     if(!frameDecodingComplete_)
     {
-        put_flog(LOG_INFO, "Frame could not be decoded entierly (may be caused by seeking).");
+        put_flog(LOG_DEBUG, "Frame could not be decoded entierly (may be caused by seeking or frame threading).");
         return false;
     }
 
@@ -428,23 +839,110 @@ bool FFMPEGMovie::convertVideoFrame()
     return true;
 }
 
+void FFMPEGMovie::startKeyframeIndexing()
+{
+    // Streamed movies are never seeked
+    if (streamed_)
+        return;
+
+    keyframeIndex_.reset(new MovieKeyframeIndex);
+    keyframeIndexFuture_ = QtConcurrent::run(keyframeIndex_.get(), &MovieKeyframeIndex::loadOrBuild,
+                                             uri_, videoStream_->index);
+}
+
+void FFMPEGMovie::stopKeyframeIndexing()
+{
+    if (!keyframeIndex_)
+        return;
+
+    keyframeIndex_->abort();
+    keyframeIndexFuture_.waitForFinished();
+}
+
+void FFMPEGMovie::startDecodeThread()
+{
+    const size_t frameBytes = (size_t)getWidth() * getHeight() * 4;
+    frameQueue_.reset(new MovieFrameQueue(frameBytes, DECODED_FRAMES_QUEUE_SIZE));
+
+    decodeThread_.reset(new FFMPEGMovieDecodeThread(*this));
+    decodeThread_->start();
+}
+
+void FFMPEGMovie::stopDecodeThread()
+{
+    if (!decodeThread_)
+        return;
+
+    frameQueue_->stop();
+    decodeThread_->wait();
+}
+
+void FFMPEGMovie::decodeFrames()
+{
+    // A frame was already decoded by seeking or by a previous jumpTo()
+    bool frameDecoded = frameDecodingComplete_;
+    double seekPosition = 0.0;
+
+    while (true)
+    {
+        switch (frameQueue_->waitForRequest(seekPosition))
+        {
+        case MovieFrameQueue::STOP:
+            return;
+
+        case MovieFrameQueue::SEEK:
+            // Streamed movies can only seek to the last keyframe kept by the
+            // packet queue, which is enough to start a new loop or to decode
+            // the current frame again
+            if (streamed_)
+            {
+                packetQueue_->rewind();
+                frameDecoded = false;
+            }
+            else
+                frameDecoded = seek(seekPosition);
+            break;
+
+        case MovieFrameQueue::DECODE:
+        {
+            if (!frameDecoded && !readVideoFrame())
+            {
+                // Streamed movies wait for more packets from the master
+                if (!streamed_)
+                    frameQueue_->setEndOfStream();
+                break;
+            }
+            frameDecoded = false;
+
+            // Frames preceding the playback position would never be displayed
+            const double timestamp = getFrameTimestampInSeconds();
+            if (timestamp + frameDurationInSeconds_ <= frameQueue_->getPosition())
+                break;
+
+            // Only the part of the frame visible on this process is converted
+            QRect region = getVisibleRegion();
+            if (videoFrameConverter_->convert(avFrame_, frameQueue_->getWriteBuffer(), region))
+                frameQueue_->push(timestamp, region);
+            break;
+        }
+        }
+    }
+}
+
 void FFMPEGMovie::generateSeekingParameters()
 {
     // generate seeking parameters
-    den2_ = videoStream_->time_base.den * videoStream_->r_frame_rate.den;
-    num2_ = videoStream_->time_base.num * videoStream_->r_frame_rate.num;
+    den2_ = timeBase_.den * frameRate_.den;
+    num2_ = timeBase_.num * frameRate_.num;
 
-    numFrames_ = (videoStream_->duration > 0) ?
-                 av_rescale(videoStream_->duration, num2_, den2_) : 0;
+    numFrames_ = (streamDuration_ > 0) ? av_rescale(streamDuration_, num2_, den2_) : 0;
 
-    frameDurationInSeconds_ = (double)videoStream_->r_frame_rate.den /
-                              (double)videoStream_->r_frame_rate.num;
+    frameDurationInSeconds_ = (double)frameRate_.den / (double)frameRate_.num;
 
     put_flog(LOG_DEBUG, "seeking parameters: start_time = %i, duration_ = %i, numFrames_ = %i",
-             videoStream_->start_time, videoStream_->duration, numFrames_);
+             startTime_, streamDuration_, numFrames_);
     put_flog(LOG_DEBUG, "                    frame_rate = %f, time_base = %f",
-             (float)videoStream_->r_frame_rate.num/(float)videoStream_->r_frame_rate.den,
-             (float)videoStream_->time_base.num/(float)videoStream_->time_base.den);
+             (float)av_q2d(frameRate_), (float)av_q2d(timeBase_));
     put_flog(LOG_DEBUG, "                    frameDurationInSeconds_ = %f",
              (float)frameDurationInSeconds_);
 }
@@ -62,13 +62,40 @@ extern "C"
 }
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
+#include <QFuture>
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
 #include <QString>
 
 class FFMPEGVideoFrameConverter;
+class FFMPEGMovieDecodeThread;
+class MovieFrameQueue;
+class MovieKeyframeIndex;
+class MoviePacketQueue;
+struct MoviePackets;
+struct MovieStreamParameters;
 
 /**
  * Read and play movies using the FFMPEG library.
+ *
+ * Once playback has started with update(), the frames are decoded and
+ * converted ahead of time by a background thread into a MovieFrameQueue.
+ * The calling thread only selects the frame matching the playback position,
+ * so the duration of decoding does not add to the duration of a frame.
+ *
+ * Seeking uses an index of the keyframes of the file, which is built in the
+ * background when playback starts. The frames decoded between the keyframe
+ * and the target position are skipped when no other frame depends on them.
+ *
+ * In streamed mode, the movie file is not opened. The compressed packets and
+ * the playback position are received from the master application instead.
+ * @see addPackets()
  */
 class FFMPEGMovie
 {
@@ -76,12 +103,22 @@ public:
     /**
      * Constructor.
      * @param uri: the movie file to open.
+     * @param streamed: don't open the file, decode the packets given to
+     *        addPackets() instead.
      */
-    FFMPEGMovie(const QString& uri);
+    FFMPEGMovie(const QString& uri, const bool streamed = false);
 
     /** Destructor */
     ~FFMPEGMovie();
 
+    /**
+     * Streamed mode: add the packets received from the master application.
+     * The decoder is opened with the parameters of the first packets, and the
+     * playback position follows the position of the master.
+     * @param packets The packets and playback position of the master.
+     */
+    void addPackets(const MoviePackets& packets);
+
     /** Is the movie valid. */
     bool isValid() const;
 
@@ -93,21 +130,47 @@ public:
     /**
      * Get a pointer to the iamge data.
      * The buffer has format GL_RGBA, GL_UNSIGNED_BYTE and size getWidth()*getHeight() bytes.
-     * @return Pointer to the data of the last frame decoded.
+     * @return Pointer to the data of the current frame, valid until the next update().
      */
     const void* getData() const;
 
+    /**
+     * Get the region of the frame contained in the image data.
+     * The data has no padding between the rows of the region.
+     * @see setVisibleRegion()
+     */
+    QRect getDataRegion() const;
+
+    /**
+     * Set the region of the movie that needs to be decoded.
+     * The frames decoded after this call only contain this region.
+     * @param region The region in normalized coordinates, empty for the full frame.
+     */
+    void setVisibleRegion(const QRectF& region);
+
+    /** Get the memory used by the decoded frames, in bytes. */
+    size_t getMemoryUsage() const;
+
     /**
      * Update the internal timestamp to play the movie.
+     * The first call starts the background decoding thread.
      * @param timeSinceLastFrame Time increment.
-     * @param skipDecoding Only increment the timestamp, don't read/decode the movie yet.
+     * @param skipDecoding Only increment the timestamp, don't select a new frame yet.
      */
     void update(const boost::posix_time::time_duration timeSinceLastFrame, const bool skipDecoding);
 
+    /**
+     * Keep the current frame while the movie is paused.
+     * The frame is decoded again if it does not contain the visible region,
+     * and the frames are converted entirely until playback resumes.
+     * @see isNewFrameAvailable()
+     */
+    void refreshFrame();
+
     /**
      * Is there a new frame available.
      * @return true if a new frame was decoded as a result of the last call to
-     *         update() or jumpTo()
+     *         update(), refreshFrame() or jumpTo()
      * @see update()
      * @see jumpTo()
      */
@@ -121,20 +184,44 @@ public:
 
     /**
      * Jump to a random position in the movie.
+     * Once playback has started, the frame at the new position only becomes
+     * available after a later call to update().
      * @param timePosInSeconds The desired position in seconds
-     * @return true on success
+     * @return true on success, false in streamed mode
      */
     bool jumpTo(const double timePosInSeconds);
 
+    /**
+     * Decode the frame at a position directly into an image of a given size.
+     * The frame is converted and scaled in a single pass, without going
+     * through the full resolution buffer of getData().
+     * Only available before playback starts and not in streamed mode.
+     * @param timePosInSeconds The desired position in seconds
+     * @param size The size of the image
+     * @return The image, or a null image on failure
+     */
+    QImage decodeImage(const double timePosInSeconds, const QSize& size);
+
+    /** Init the global FFMPEG context. */
+    static void initGlobalState();
+
 private:
+    friend class FFMPEGMovieDecodeThread;
+
     // FFMPEG
     AVFormatContext * avFormatContext_;    // AV Format information from the file header
-    AVCodecContext * videoCodecContext_;   // shortcut to videostream_->codec; don't free
+    AVCodecContext * videoCodecContext_;   // shortcut to videostream_->codec; allocated in streamed mode
     AVFrame * avFrame_;                    // Frame for decoding
     AVStream * videoStream_;               // shortcut to avFormatContext_->streams[streamIdx_]; don't free
 
     FFMPEGVideoFrameConverter * videoFrameConverter_; // Convert decoded frames to RGBA format
 
+    // Video stream properties, from the file or from the master application
+    AVRational timeBase_;
+    AVRational frameRate_;
+    int64_t startTime_;
+    int64_t streamDuration_;
+
     // used for seeking
     int64_t den2_;
     int64_t num2_;
@@ -143,7 +230,17 @@ private:
 
     boost::posix_time::time_duration timePosition_;
 
+    // Keyframes of the file, loaded or built by the first update()
+    QString uri_;
+    boost::shared_ptr<MovieKeyframeIndex> keyframeIndex_;
+    QFuture<bool> keyframeIndexFuture_;
+
+    // The frames presented before this position are not displayed (seconds)
+    double seekTarget_;
+    bool endOfFile_;
+
     // Internal
+    const bool streamed_;
     bool loop_;
     int frameDecodingComplete_;
     bool isValid_;
@@ -152,10 +249,26 @@ private:
     // Public status
     bool newFrameAvailable_;
 
-    /** Init the global FFMPEG context. */
-    static void initGlobalState();
+    // Background decoding, created by the first update()
+    boost::scoped_ptr<MovieFrameQueue> frameQueue_;
+    boost::scoped_ptr<FFMPEGMovieDecodeThread> decodeThread_;
+
+    // Streamed mode: packets received from the master application
+    boost::scoped_ptr<MoviePacketQueue> packetQueue_;
+    uint32_t streamLoop_;
+    bool waitForKeyframe_;
+
+    // Region converted by the decoding thread, in pixels
+    mutable QMutex visibleRegionMutex_;
+    QRect visibleRegion_;
+    bool convertFullFrames_; // Paused or at the end of the movie
+
+    // The current frame is decoded again to contain the visible region
+    bool reconvertPending_;
 
     bool open(const QString& uri);
+    bool openStream(const MovieStreamParameters& parameters);
+    bool initDecoding();
 
     bool createAvFormatContext(const QString& uri);
     void releaseAvFormatContext();
@@ -165,13 +278,28 @@ private:
     bool openVideoStreamDecoder();
     void closeVideoStreamDecoder() const;
 
+    void startKeyframeIndexing();
+    void stopKeyframeIndexing();
+    void startDecodeThread();
+    void stopDecodeThread();
+    void decodeFrames(); // Run by the decoding thread
+    QRect getVisibleRegion() const;
+    void setConvertFullFrames(const bool convertFullFrames);
+    void reconvertCurrentFrame();
+
     bool readVideoFrame();
-    bool seekToNearestFullframe(const int64_t frameIndex);
+    bool readStreamedVideoFrame();
+    bool decodeFrameAt(const double timePosInSeconds);
+    bool seek(const double timePosInSeconds);
+    bool seekToKeyframe(const int64_t timestamp);
+    bool isInCurrentKeyframeInterval(const int64_t timestamp) const;
     void clampTimePosition();
+    double getTimePositionInSeconds() const;
     int64_t getTimestampForFrameIndex(const int64_t frameIndex) const;
+    double getFrameTimestampInSeconds() const;
+    double getPacketTimestampInSeconds(const AVPacket& packet) const;
     bool decodeVideoFrame(AVPacket& packet);
     bool convertVideoFrame();
-    void rewind();
     bool isVideoStream(const AVPacket& packet) const;
     void generateSeekingParameters();
 };
@@ -0,0 +1,173 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "FFMPEGMovieDemuxer.h"
+
+#include "FFMPEGMovie.h"
+
+#include "log.h"
+
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+FFMPEGMovieDemuxer::FFMPEGMovieDemuxer(const QString& uri)
+    : avFormatContext_(0)
+    , videoStream_(0)
+{
+    FFMPEGMovie::initGlobalState();
+
+    open(uri);
+}
+
+FFMPEGMovieDemuxer::~FFMPEGMovieDemuxer()
+{
+    avformat_close_input(&avFormatContext_);
+}
+
+bool FFMPEGMovieDemuxer::open(const QString& uri)
+{
+    if(avformat_open_input(&avFormatContext_, uri.toAscii(), NULL, NULL) != 0)
+    {
+        put_flog(LOG_ERROR, "could not open movie file %s", uri.toLocal8Bit().constData());
+        return false;
+    }
+
+    if(avformat_find_stream_info(avFormatContext_, NULL) < 0)
+    {
+        put_flog(LOG_ERROR, "could not find stream information");
+        return false;
+    }
+
+    for(unsigned int i=0; i<avFormatContext_->nb_streams && !videoStream_; ++i)
+    {
+        if(avFormatContext_->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+            videoStream_ = avFormatContext_->streams[i];
+    }
+
+    if(!videoStream_)
+    {
+        put_flog(LOG_ERROR, "could not find video stream");
+        return false;
+    }
+
+    const AVCodecContext* codecContext = videoStream_->codec;
+
+    parameters_.codecId = codecContext->codec_id;
+    parameters_.codecTag = codecContext->codec_tag;
+    parameters_.width = codecContext->width;
+    parameters_.height = codecContext->height;
+    parameters_.pixelFormat = codecContext->pix_fmt;
+    parameters_.bitsPerCodedSample = codecContext->bits_per_coded_sample;
+    if(codecContext->extradata_size > 0)
+        parameters_.extradata.assign(codecContext->extradata,
+                                     codecContext->extradata + codecContext->extradata_size);
+    parameters_.timeBaseNum = videoStream_->time_base.num;
+    parameters_.timeBaseDen = videoStream_->time_base.den;
+    parameters_.frameRateNum = videoStream_->r_frame_rate.num;
+    parameters_.frameRateDen = videoStream_->r_frame_rate.den;
+    parameters_.startTime = videoStream_->start_time;
+    parameters_.duration = videoStream_->duration;
+
+    return true;
+}
+
+bool FFMPEGMovieDemuxer::isValid() const
+{
+    return videoStream_ != 0;
+}
+
+const MovieStreamParameters& FFMPEGMovieDemuxer::getParameters() const
+{
+    return parameters_;
+}
+
+double FFMPEGMovieDemuxer::getFrameDuration() const
+{
+    if(!videoStream_ || videoStream_->r_frame_rate.num == 0)
+        return 0.0;
+    return av_q2d(av_inv_q(videoStream_->r_frame_rate));
+}
+
+bool FFMPEGMovieDemuxer::readPacket(MoviePacket& packet)
+{
+    if(!videoStream_)
+        return false;
+
+    AVPacket avPacket;
+    av_init_packet(&avPacket);
+
+    while(av_read_frame(avFormatContext_, &avPacket) >= 0)
+    {
+        if(avPacket.stream_index == videoStream_->index)
+        {
+            packet.pts = avPacket.pts;
+            packet.dts = avPacket.dts;
+            packet.timestamp = getTimestampInSeconds(avPacket);
+            packet.keyframe = avPacket.flags & AV_PKT_FLAG_KEY;
+            packet.data.assign(avPacket.data, avPacket.data + avPacket.size);
+
+            av_free_packet(&avPacket);
+            return true;
+        }
+        av_free_packet(&avPacket);
+    }
+    return false;
+}
+
+bool FFMPEGMovieDemuxer::rewind()
+{
+    if(!videoStream_)
+        return false;
+
+    return av_seek_frame(avFormatContext_, videoStream_->index, 0, AVSEEK_FLAG_BACKWARD) >= 0;
+}
+
+double FFMPEGMovieDemuxer::getTimestampInSeconds(const AVPacket& packet) const
+{
+    int64_t timestamp = packet.pts;
+    if(timestamp == (int64_t)AV_NOPTS_VALUE)
+        timestamp = packet.dts;
+    if(timestamp == (int64_t)AV_NOPTS_VALUE)
+        return 0.0;
+
+    if(videoStream_->start_time != (int64_t)AV_NOPTS_VALUE)
+        timestamp -= videoStream_->start_time;
+
+    return timestamp * av_q2d(videoStream_->time_base);
+}
@@ -0,0 +1,116 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef FFMPEGMOVIEDEMUXER_H
+#define FFMPEGMOVIEDEMUXER_H
+
+// required for FFMPEG includes below, specifically for the Linux build
+#ifdef __cplusplus
+    #ifndef __STDC_CONSTANT_MACROS
+        #define __STDC_CONSTANT_MACROS
+    #endif
+
+    #ifdef _STDINT_H
+        #undef _STDINT_H
+    #endif
+
+    #include <stdint.h>
+#endif
+
+extern "C"
+{
+    #include <libavformat/avformat.h>
+}
+
+#include "MoviePackets.h"
+
+#include <QString>
+
+#include <boost/noncopyable.hpp>
+
+/**
+ * Read the compressed packets of the video stream of a movie file.
+ *
+ * Used by the master application to stream movies to the wall processes,
+ * which decode the packets without opening the file.
+ */
+class FFMPEGMovieDemuxer : public boost::noncopyable
+{
+public:
+    /**
+     * Constructor.
+     * @param uri The movie file to open.
+     */
+    FFMPEGMovieDemuxer(const QString& uri);
+
+    /** Close the file. */
+    ~FFMPEGMovieDemuxer();
+
+    /** @return true if the file contains a video stream. */
+    bool isValid() const;
+
+    /** @return The parameters needed to decode the video stream. */
+    const MovieStreamParameters& getParameters() const;
+
+    /** @return The duration of a frame, in seconds. */
+    double getFrameDuration() const;
+
+    /**
+     * Read the next packet of the video stream.
+     * @param packet Set to the next packet. Its loop counter is not modified.
+     * @return false at the end of the file or on read error.
+     */
+    bool readPacket(MoviePacket& packet);
+
+    /**
+     * Go back to the beginning of the file.
+     * @return true on success.
+     */
+    bool rewind();
+
+private:
+    AVFormatContext* avFormatContext_;
+    AVStream* videoStream_; // shortcut to avFormatContext_->streams[i]; don't free
+    MovieStreamParameters parameters_;
+
+    bool open(const QString& uri);
+    double getTimestampInSeconds(const AVPacket& packet) const;
+};
+
+#endif // FFMPEGMOVIEDEMUXER_H
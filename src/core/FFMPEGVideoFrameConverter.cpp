@@ -41,58 +41,218 @@
 
 #include "log.h"
 
+extern "C"
+{
+    #include <libavutil/imgutils.h>
+}
+
+#include <algorithm>
+
+// Older FFMPEG versions only define the deprecated names
+#ifndef AV_PIX_FMT_FLAG_BITSTREAM
+#  define AV_PIX_FMT_FLAG_BITSTREAM PIX_FMT_BITSTREAM
+#  define AV_PIX_FMT_FLAG_HWACCEL PIX_FMT_HWACCEL
+#  define AV_PIX_FMT_FLAG_PLANAR PIX_FMT_PLANAR
+#endif
+
+// Extra pixels converted around the regions for the texture filtering
+#define REGION_MARGIN 2
+
 FFMPEGVideoFrameConverter::FFMPEGVideoFrameConverter(const AVCodecContext& videoCodecContext,
                                                      const PixelFormat targetFormat)
     : swsContext_(0)
+    , regionSwsContext_(0)
+    , scaledSwsContext_(0)
     , avFrameRGB_(0)
+    , sourceFormat_(videoCodecContext.pix_fmt)
+    , targetFormat_(targetFormat)
+    , width_(videoCodecContext.width)
+    , height_(videoCodecContext.height)
+{
+    initCroppingParameters();
+}
+
+FFMPEGVideoFrameConverter::~FFMPEGVideoFrameConverter()
+{
+    sws_freeContext(swsContext_);
+    sws_freeContext(regionSwsContext_);
+    sws_freeContext(scaledSwsContext_);
+
+    if (avFrameRGB_)
+    {
+        avpicture_free( (AVPicture *)avFrameRGB_ );
+        av_free(avFrameRGB_);
+    }
+}
+
+bool FFMPEGVideoFrameConverter::convert(const AVFrame* srcFrame)
+{
+    // The full frame buffer is only allocated when it is used
+    if (!avFrameRGB_ && !allocateFrame())
+        return false;
+
+    const int output_height = sws_scale(swsContext_, srcFrame->data,
+                                        srcFrame->linesize, 0, srcFrame->height,
+                                        avFrameRGB_->data,
+                                        avFrameRGB_->linesize);
+    return output_height == srcFrame->height;
+}
+
+bool FFMPEGVideoFrameConverter::convert(const AVFrame* srcFrame, uint8_t* dstData, QRect& region)
+{
+    region = alignRegion(region);
+    if (region.isEmpty())
+        return false;
+
+    // The context is only recreated when the size of the region changes
+    regionSwsContext_ = sws_getCachedContext(regionSwsContext_,
+                                             region.width(), region.height(), sourceFormat_,
+                                             region.width(), region.height(), targetFormat_,
+                                             SWS_FAST_BILINEAR, NULL, NULL, NULL);
+    if (!regionSwsContext_)
+    {
+        put_flog(LOG_ERROR, "Error allocating an SwsContext");
+        return false;
+    }
+
+    // Point to the first pixel of the region in each image plane, the
+    // other planes (such as palettes) are left untouched
+    const uint8_t* srcData[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 4; ++i)
+    {
+        srcData[i] = srcFrame->data[i];
+        if (!srcData[i] || i >= planeCount_)
+            continue;
+
+        const bool isChromaPlane = (i == 1 || i == 2);
+        const int x = isChromaPlane ? region.x() >> log2ChromaWidth_ : region.x();
+        const int y = isChromaPlane ? region.y() >> log2ChromaHeight_ : region.y();
+        srcData[i] += y * srcFrame->linesize[i] + x * pixelSteps_[i];
+    }
+
+    AVPicture dstPicture;
+    if (avpicture_fill(&dstPicture, dstData, targetFormat_, region.width(), region.height()) < 0)
+        return false;
+
+    const int output_height = sws_scale(regionSwsContext_, srcData,
+                                        srcFrame->linesize, 0, region.height(),
+                                        dstPicture.data,
+                                        dstPicture.linesize);
+    return output_height == region.height();
+}
+
+bool FFMPEGVideoFrameConverter::scale(const AVFrame* srcFrame, uint8_t* dstData, const QSize& size)
+{
+    if (size.isEmpty())
+        return false;
+
+    // Area averaging keeps the details of frames which are scaled down a lot
+    scaledSwsContext_ = sws_getCachedContext(scaledSwsContext_,
+                                             width_, height_, sourceFormat_,
+                                             size.width(), size.height(), targetFormat_,
+                                             SWS_AREA, NULL, NULL, NULL);
+    if (!scaledSwsContext_)
+    {
+        put_flog(LOG_ERROR, "Error allocating an SwsContext");
+        return false;
+    }
+
+    AVPicture dstPicture;
+    if (avpicture_fill(&dstPicture, dstData, targetFormat_, size.width(), size.height()) < 0)
+        return false;
+
+    const int output_height = sws_scale(scaledSwsContext_, srcFrame->data,
+                                        srcFrame->linesize, 0, srcFrame->height,
+                                        dstPicture.data,
+                                        dstPicture.linesize);
+    return output_height == size.height();
+}
+
+const uint8_t* FFMPEGVideoFrameConverter::getData() const
+{
+    return avFrameRGB_ ? avFrameRGB_->data[0] : 0;
+}
+
+bool FFMPEGVideoFrameConverter::allocateFrame()
 {
     // allocate video frame for RGB conversion
-    avFrameRGB_ = avcodec_alloc_frame();
+    AVFrame* frame = avcodec_alloc_frame();
 
-    if( !avFrameRGB_ )
+    if( !frame )
     {
         put_flog(LOG_ERROR, "Error allocating frame");
-        return;
+        return false;
     }
 
-    // alloc buffer for avFrameRGB_
-    if (avpicture_alloc( (AVPicture *)avFrameRGB_, targetFormat,
-                         videoCodecContext.width, videoCodecContext.height ) != 0)
+    // alloc buffer for the frame
+    if (avpicture_alloc( (AVPicture *)frame, targetFormat_, width_, height_ ) != 0)
     {
         put_flog(LOG_ERROR, "Error allocating frame");
-        return;
+        av_free(frame);
+        return false;
     }
 
     // create sws scaler context
-    swsContext_ = sws_getContext(videoCodecContext.width, videoCodecContext.height,
-                                 videoCodecContext.pix_fmt, videoCodecContext.width,
-                                 videoCodecContext.height, targetFormat, SWS_FAST_BILINEAR,
+    swsContext_ = sws_getContext(width_, height_, sourceFormat_,
+                                 width_, height_, targetFormat_, SWS_FAST_BILINEAR,
                                  NULL, NULL, NULL);
     if( !swsContext_ )
     {
         put_flog(LOG_ERROR, "Error allocating an SwsContext");
-        return;
+        avpicture_free( (AVPicture *)frame );
+        av_free(frame);
+        return false;
     }
+
+    avFrameRGB_ = frame;
+    return true;
 }
 
-FFMPEGVideoFrameConverter::~FFMPEGVideoFrameConverter()
+void FFMPEGVideoFrameConverter::initCroppingParameters()
 {
-    sws_freeContext(swsContext_);
+    canCropRows_ = false;
+    canCropColumns_ = false;
+    log2ChromaWidth_ = 0;
+    log2ChromaHeight_ = 0;
+    planeCount_ = 0;
+    std::fill(pixelSteps_, pixelSteps_ + 4, 0);
 
-    avpicture_free( (AVPicture *)avFrameRGB_ );
-    av_free(avFrameRGB_);
-}
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(sourceFormat_);
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL))
+        return;
 
-bool FFMPEGVideoFrameConverter::convert(const AVFrame* srcFrame)
-{
-    const int output_height = sws_scale(swsContext_, srcFrame->data,
-                                        srcFrame->linesize, 0, srcFrame->height,
-                                        avFrameRGB_->data,
-                                        avFrameRGB_->linesize);
-    return output_height == srcFrame->height;
+    log2ChromaWidth_ = desc->log2_chroma_w;
+    log2ChromaHeight_ = desc->log2_chroma_h;
+
+    for (int i = 0; i < desc->nb_components; ++i)
+        planeCount_ = std::max(planeCount_, desc->comp[i].plane + 1);
+
+    av_image_fill_max_pixsteps(pixelSteps_, NULL, desc);
+
+    // Packed formats with horizontal chroma subsampling, like YUYV, store
+    // several pixels per step; bitstream formats several pixels per byte
+    canCropRows_ = true;
+    canCropColumns_ = !(desc->flags & AV_PIX_FMT_FLAG_BITSTREAM) &&
+                      ((desc->flags & AV_PIX_FMT_FLAG_PLANAR) || log2ChromaWidth_ == 0);
 }
 
-const uint8_t* FFMPEGVideoFrameConverter::getData() const
+QRect FFMPEGVideoFrameConverter::alignRegion(const QRect& region) const
 {
-    return avFrameRGB_->data[0];
+    const QRect frame(0, 0, width_, height_);
+    if (region.isEmpty() || !canCropRows_)
+        return frame;
+
+    const QRect extendedRegion = region.adjusted(-REGION_MARGIN, -REGION_MARGIN,
+                                                 REGION_MARGIN, REGION_MARGIN) & frame;
+    if (extendedRegion.isEmpty())
+        return QRect();
+
+    // Start on a full chroma sample
+    const int alignX = (1 << log2ChromaWidth_) - 1;
+    const int alignY = (1 << log2ChromaHeight_) - 1;
+    const int left = canCropColumns_ ? extendedRegion.left() & ~alignX : 0;
+    const int top = extendedRegion.top() & ~alignY;
+    const int right = canCropColumns_ ? extendedRegion.right() : width_ - 1;
+
+    return QRect(QPoint(left, top), QPoint(right, extendedRegion.bottom()));
 }
@@ -57,9 +57,13 @@ extern "C"
 {
     #include <libavcodec/avcodec.h>
     #include <libavutil/mem.h>
+    #include <libavutil/pixdesc.h>
     #include <libswscale/swscale.h>
 }
 
+#include <QRect>
+#include <QSize>
+
 /**
  * Converts FFMPEG's AVFrame format to a data buffer of user-defined format
  */
@@ -84,15 +88,59 @@ public:
      */
     bool convert(const AVFrame* srcFrame);
 
+    /**
+     * Convert a region of an AVFrame to the target data format into an external buffer.
+     *
+     * Only the pixels of the region are read and converted. The region is
+     * extended to the chroma subsampling of the source format. Source
+     * formats which can not be cropped are converted on the full width or
+     * on the full frame.
+     * @param srcFrame The source frame
+     * @param dstData The destination buffer, large enough for a full frame.
+     *        It receives the region without padding between the rows.
+     * @param region The region to convert, in pixels. Updated to the region
+     *        which was effectively converted.
+     * @return true on success
+     */
+    bool convert(const AVFrame* srcFrame, uint8_t* dstData, QRect& region);
+
+    /**
+     * Convert an AVFrame to the target data format and scale it in a single pass.
+     * @param srcFrame The source frame
+     * @param dstData The destination buffer, without padding between the rows
+     * @param size The size of the destination image, in pixels
+     * @return true on success
+     */
+    bool scale(const AVFrame* srcFrame, uint8_t* dstData, const QSize& size);
+
     /**
      * Get the converted data in the target format
+     * @return The data of the last convert() of a full frame, or 0 before it
      * @see convert()
      */
     const uint8_t* getData() const;
 
 private:
     SwsContext * swsContext_;           // Scaling context
+    SwsContext * regionSwsContext_;     // Scaling context for the last region size
+    SwsContext * scaledSwsContext_;     // Scaling context for the last scaled size
     AVFrame * avFrameRGB_;
+    const PixelFormat sourceFormat_;
+    const PixelFormat targetFormat_;
+    const int width_;
+    const int height_;
+
+    // Cropping parameters of the source format
+    bool canCropRows_;
+    bool canCropColumns_;
+    int log2ChromaWidth_;
+    int log2ChromaHeight_;
+    int planeCount_;
+    int pixelSteps_[4];
+
+    bool allocateFrame();
+    void initCroppingParameters();
+    QRect alignRegion(const QRect& region) const;
 };
 
 #endif // FFMPEGVIDEOFRAMECONVERTER_H
@@ -40,9 +40,30 @@
 #include "Factories.h"
 
 #include "Content.h"
+#include "GLWindow.h"
+#include "configuration/WallConfiguration.h"
 
-Factories::Factories(RenderContext& renderContext)
-    : frameIndex_(0)
+#include <QElapsedTimer>
+
+namespace
+{
+const size_t MEGABYTE = 1024 * 1024;
+const qint64 FINISH_PENDING_OBJECTS_TIME_BUDGET_MS = 5;
+
+// The tile texture pool takes a fixed part of the GPU memory budget
+size_t getGPUMemoryBudget(RenderContext& renderContext,
+                          const WallConfiguration& configuration)
+{
+    const size_t budget = configuration.getGPUMemoryBudget() * MEGABYTE;
+    const size_t tilePool = renderContext.getTileTexturePool().getCapacityBytes();
+    return budget > tilePool ? budget - tilePool : 0;
+}
+}
+
+Factories::Factories(RenderContext& renderContext,
+                     const WallConfiguration& configuration)
+    : renderContext_(renderContext)
+    , frameIndex_(0)
     , textureFactory_(renderContext)
     , dynamicTextureFactory_(renderContext)
 #if ENABLE_PDF_SUPPORT
@@ -51,23 +72,81 @@ Factories::Factories(RenderContext& renderContext)
     , svgFactory_(renderContext)
     , movieFactory_(renderContext)
     , pixelStreamFactory_(renderContext)
+    , residencyManager_(configuration.getHostMemoryBudget() * MEGABYTE,
+                        getGPUMemoryBudget(renderContext, configuration))
 {
 }
 
 void Factories::clearStaleFactoryObjects()
 {
-    textureFactory_.clearStaleObjects(frameIndex_);
-    dynamicTextureFactory_.clearStaleObjects(frameIndex_);
+    pixelStreamFactory_.clearStaleObjects(frameIndex_);
+
+    // Footprints change as objects load their data asynchronously
+    updateResidency(textureFactory_, CONTENT_TYPE_TEXTURE);
+    updateResidency(dynamicTextureFactory_, CONTENT_TYPE_DYNAMIC_TEXTURE);
 #if ENABLE_PDF_SUPPORT
-    pdfFactory_.clearStaleObjects(frameIndex_);
+    updateResidency(pdfFactory_, CONTENT_TYPE_PDF);
 #endif
-    svgFactory_.clearStaleObjects(frameIndex_);
-    movieFactory_.clearStaleObjects(frameIndex_);
-    pixelStreamFactory_.clearStaleObjects(frameIndex_);
+    updateResidency(svgFactory_, CONTENT_TYPE_SVG);
+    updateResidency(movieFactory_, CONTENT_TYPE_MOVIE);
+
+    const ResidencyKeys evicted = residencyManager_.collect(frameIndex_);
+    for(ResidencyKeys::const_iterator it = evicted.begin(); it != evicted.end(); ++it)
+        removeObject(*it);
+
+    // Cancel the loading of tiles which were not requested in this frame
+    renderContext_.getTileLoadScheduler().nextFrame();
+    renderContext_.getTileTexturePool().nextFrame();
 
     ++frameIndex_;
 }
 
+const ResidencyManager& Factories::getResidencyManager() const
+{
+    return residencyManager_;
+}
+
+template <class T>
+void Factories::updateResidency(Factory<T>& factory, const CONTENT_TYPE type)
+{
+    typedef std::map<QString, boost::shared_ptr<T> > ObjectMap;
+    const ObjectMap objects = factory.getMap();
+
+    for(typename ObjectMap::const_iterator it = objects.begin(); it != objects.end(); ++it)
+    {
+        residencyManager_.update(ResidencyKey(type, it->first),
+                                 it->second->getHostMemoryUsage(),
+                                 it->second->getGPUMemoryUsage(),
+                                 it->second->getFrameIndex());
+    }
+}
+
+void Factories::removeObject(const ResidencyKey& key)
+{
+    switch (key.first)
+    {
+    case CONTENT_TYPE_TEXTURE:
+        textureFactory_.removeObject(key.second);
+        break;
+    case CONTENT_TYPE_DYNAMIC_TEXTURE:
+        dynamicTextureFactory_.removeObject(key.second);
+        break;
+#if ENABLE_PDF_SUPPORT
+    case CONTENT_TYPE_PDF:
+        pdfFactory_.removeObject(key.second);
+        break;
+#endif
+    case CONTENT_TYPE_SVG:
+        svgFactory_.removeObject(key.second);
+        break;
+    case CONTENT_TYPE_MOVIE:
+        movieFactory_.removeObject(key.second);
+        break;
+    default:
+        break;
+    }
+}
+
 void Factories::clear()
 {
     textureFactory_.clear();
@@ -78,6 +157,8 @@ void Factories::clear()
     svgFactory_.clear();
     movieFactory_.clear();
     pixelStreamFactory_.clear();
+
+    residencyManager_.clear();
 }
 
 FactoryObjectPtr Factories::getFactoryObject(ContentPtr content)
@@ -109,10 +190,63 @@ FactoryObjectPtr Factories::getFactoryObject(ContentPtr content)
         return FactoryObjectPtr();
         break;
     }
-    object->setFrameIndex(frameIndex_);
+    touch(content, object);
+    return object;
+}
+
+FactoryObjectPtr Factories::requestFactoryObject(ContentPtr content)
+{
+    FactoryObjectPtr object;
+    switch (content->getType())
+    {
+    case CONTENT_TYPE_TEXTURE:
+        object = textureFactory_.requestObject(content->getURI());
+        break;
+    case CONTENT_TYPE_DYNAMIC_TEXTURE:
+        object = dynamicTextureFactory_.requestObject(content->getURI());
+        break;
+#if ENABLE_PDF_SUPPORT
+    case CONTENT_TYPE_PDF:
+        object = pdfFactory_.requestObject(content->getURI());
+        break;
+#endif
+    default:
+        // SVG (QObject-based renderer) and PixelStream objects are cheap to
+        // create and must be constructed in the render thread. Movies are
+        // created by MovieContent::advance() on all processes in the same
+        // frame, so that they all play from the same position.
+        return getFactoryObject(content);
+    }
+
+    if (object)
+        touch(content, object);
     return object;
 }
 
+void Factories::finishPendingObjects()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Objects may upload their textures, which are shared by all GLWindows
+    renderContext_.getGLWindow()->makeCurrent();
+
+    const qint64 budget = FINISH_PENDING_OBJECTS_TIME_BUDGET_MS;
+    textureFactory_.finishPendingObjects(timer, budget);
+    dynamicTextureFactory_.finishPendingObjects(timer, budget);
+#if ENABLE_PDF_SUPPORT
+    pdfFactory_.finishPendingObjects(timer, budget);
+#endif
+}
+
+void Factories::touch(ContentPtr content, FactoryObjectPtr object)
+{
+    object->setFrameIndex(frameIndex_);
+
+    if (content->getType() != CONTENT_TYPE_PIXEL_STREAM)
+        residencyManager_.touch(ResidencyKey(content->getType(), content->getURI()), frameIndex_);
+}
+
 Factory<Texture> & Factories::getTextureFactory()
 {
     return textureFactory_;
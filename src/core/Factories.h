@@ -50,40 +50,75 @@
 #include "SVG.h"
 #include "Movie.h"
 #include "PixelStream.h"
+#include "ResidencyManager.h"
+
+class WallConfiguration;
 
 /**
  * A set of Factory<T> for all valid ContentTypes.
  *
  * It is used on Wall processes to map Content objects received from the
  * master application to FactoryObjects which hold the actual data.
- * It implements a basic garbage collection strategy for FactoryObjects
- * that are no longer referenced/accessed.
+ * FactoryObjects that are no longer referenced/accessed are kept in memory
+ * until the budget set in the WallConfiguration is exceeded, at which point
+ * the least recently used ones are deleted. PixelStreams can not be reloaded,
+ * so they are deleted as soon as they are no longer accessed.
+ * @see ResidencyManager
  */
 class Factories
 {
 public:
-    /** Constructor */
-    Factories(RenderContext& renderContext);
+    /**
+     * Constructor.
+     * @param renderContext The render context for the FactoryObjects.
+     * @param configuration Provides the memory budget for the FactoryObjects.
+     */
+    Factories(RenderContext& renderContext,
+              const WallConfiguration& configuration);
 
     /**
      * Get the factory object associated to a given Content.
      *
-     * If the object does not exist, it is created.
-     * Objects not accessed during two consecutive frames are deleted using
-     * a garbage collection mechanism.
+     * If the object does not exist, it is created. This call blocks until the
+     * object is available.
+     * Objects not accessed recently are deleted using a garbage collection
+     * mechanism.
      * @see clearStaleFactoryObjects()
      */
     FactoryObjectPtr getFactoryObject(ContentPtr content);
 
+    /**
+     * Get the factory object associated to a given Content for rendering.
+     *
+     * Unlike getFactoryObject(), this call does not block. Objects which are
+     * expensive to create are constructed in a background thread and a null
+     * pointer is returned until they are finished.
+     * @see finishPendingObjects()
+     */
+    FactoryObjectPtr requestFactoryObject(ContentPtr content);
+
+    /**
+     * Make the objects constructed in the background available for rendering.
+     *
+     * Call this function once per frame, before rendering. It returns when
+     * its time budget is exhausted, leaving the remaining objects for the
+     * next frames.
+     */
+    void finishPendingObjects();
+
     /**
      * Garbarge-collect unused objects.
      *
      * Only call this function once per frame.
-     * This will delete all FactoryObjects which have not been accessed since
-     * this method was last called.
+     * This will delete all PixelStreams which have not been accessed since
+     * this method was last called, as well as the least recently accessed
+     * FactoryObjects if the memory budget is exceeded.
      */
     void clearStaleFactoryObjects();
 
+    /** Get the residency information (memory usage, hit/miss counters). */
+    const ResidencyManager& getResidencyManager() const;
+
     /** Clear all Factories (useful on shutdown). */
     void clear();
 
@@ -100,6 +135,7 @@ public:
     //@}
 
 private:
+    RenderContext& renderContext_;
     uint64_t frameIndex_;
 
     Factory<Texture> textureFactory_;
@@ -110,6 +146,14 @@ private:
     Factory<SVG> svgFactory_;
     Factory<Movie> movieFactory_;
     Factory<PixelStream> pixelStreamFactory_;
+
+    ResidencyManager residencyManager_;
+
+    template <class T>
+    void updateResidency(Factory<T>& factory, const CONTENT_TYPE type);
+
+    void removeObject(const ResidencyKey& key);
+    void touch(ContentPtr content, FactoryObjectPtr object);
 };
 
 #endif // FACTORIES_H
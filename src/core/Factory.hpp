@@ -43,6 +43,9 @@
 #include <boost/shared_ptr.hpp>
 #include <QString>
 #include <QMutex>
+#include <QFuture>
+#include <QElapsedTimer>
+#include <QtConcurrentRun>
 
 #include "RenderContext.h"
 
@@ -54,10 +57,31 @@ public:
         : renderContext_(renderContext)
     {}
 
+    ~Factory()
+    {
+        waitForPendingObjects();
+    }
+
+    /**
+     * Get an object, constructing it if needed.
+     * Blocks until an object which is being constructed in the background
+     * is available.
+     */
     boost::shared_ptr<T> getObject(const QString& uri)
     {
         QMutexLocker locker(&mapMutex_);
 
+        typename PendingMap::iterator pending = pending_.find(uri);
+        if(pending != pending_.end())
+        {
+            pending->second.waitForFinished();
+            boost::shared_ptr<T> t = pending->second.result();
+            pending_.erase(pending);
+
+            t->setRenderContext(&renderContext_);
+            map_[uri] = t;
+        }
+
         if(!map_.count(uri))
         {
             boost::shared_ptr<T> t(new T(uri));
@@ -69,6 +93,80 @@ public:
         return map_[uri];
     }
 
+    /**
+     * Get an object without blocking.
+     * If the object does not exist, it is constructed in a background thread.
+     * A null pointer is returned until finishPendingObjects() has made it
+     * available.
+     */
+    boost::shared_ptr<T> requestObject(const QString& uri)
+    {
+        QMutexLocker locker(&mapMutex_);
+
+        typename std::map<QString, boost::shared_ptr<T> >::iterator it = map_.find(uri);
+        if(it != map_.end())
+            return it->second;
+
+        if(!pending_.count(uri))
+            pending_[uri] = QtConcurrent::run(&Factory<T>::createObject, uri);
+
+        return boost::shared_ptr<T>();
+    }
+
+    /**
+     * Get an existing object without constructing it.
+     * @return The object, or a null pointer if it does not exist or is still
+     *         being constructed.
+     */
+    boost::shared_ptr<T> findObject(const QString& uri)
+    {
+        QMutexLocker locker(&mapMutex_);
+
+        typename std::map<QString, boost::shared_ptr<T> >::iterator it = map_.find(uri);
+        if(it != map_.end())
+            return it->second;
+
+        return boost::shared_ptr<T>();
+    }
+
+    /**
+     * Make the objects constructed in the background available.
+     *
+     * Must be called from the render thread with a current GL context, since
+     * FactoryObject::finishLoading() may upload data to the GPU.
+     * @param timer Measures the time already spent in the current frame.
+     * @param timeBudget No more objects are finished once the timer exceeds
+     *        this duration (ms). At least one object is finished per call.
+     * @return The number of objects finished.
+     */
+    size_t finishPendingObjects(const QElapsedTimer& timer, const qint64 timeBudget)
+    {
+        QMutexLocker locker(&mapMutex_);
+
+        size_t finished = 0;
+        typename PendingMap::iterator it = pending_.begin();
+        while(it != pending_.end())
+        {
+            if(finished > 0 && timer.elapsed() > timeBudget)
+                break;
+
+            if(!it->second.isFinished())
+            {
+                ++it;
+                continue;
+            }
+
+            boost::shared_ptr<T> t = it->second.result();
+            t->setRenderContext(&renderContext_);
+            t->finishLoading();
+
+            map_[it->first] = t;
+            pending_.erase(it++);
+            ++finished;
+        }
+        return finished;
+    }
+
     void removeObject(const QString& uri)
     {
         QMutexLocker locker(&mapMutex_);
@@ -85,6 +183,8 @@ public:
 
     void clear()
     {
+        waitForPendingObjects();
+
         QMutexLocker locker(&mapMutex_);
 
         map_.clear();
@@ -111,6 +211,8 @@ public:
     }
 
 private:
+    typedef std::map<QString, QFuture<boost::shared_ptr<T> > > PendingMap;
+
     // Render context for the FactoryObjects
     RenderContext& renderContext_;
 
@@ -119,6 +221,23 @@ private:
 
     // all existing objects
     std::map<QString, boost::shared_ptr<T> > map_;
+
+    // objects being constructed in the background
+    PendingMap pending_;
+
+    static boost::shared_ptr<T> createObject(const QString uri)
+    {
+        return boost::shared_ptr<T>(new T(uri));
+    }
+
+    void waitForPendingObjects()
+    {
+        QMutexLocker locker(&mapMutex_);
+
+        for(typename PendingMap::iterator it = pending_.begin(); it != pending_.end(); ++it)
+            it->second.waitForFinished();
+        pending_.clear();
+    }
 };
 
 #endif
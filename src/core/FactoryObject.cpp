@@ -41,6 +41,7 @@
 
 FactoryObject::FactoryObject()
     : renderContext_(0)
+    , frameIndex_(0)
 {
 }
 
@@ -48,6 +49,24 @@ FactoryObject::~FactoryObject()
 {
 }
 
+void FactoryObject::finishLoading()
+{
+}
+
+void FactoryObject::prefetch(const QRectF&)
+{
+}
+
+size_t FactoryObject::getHostMemoryUsage() const
+{
+    return 0;
+}
+
+size_t FactoryObject::getGPUMemoryUsage() const
+{
+    return 0;
+}
+
 void FactoryObject::setRenderContext(RenderContext* renderContext)
 {
     renderContext_ = renderContext;
@@ -40,6 +40,7 @@
 #define FACTORY_OBJECT_H
 
 #include <stdint.h>
+#include <cstddef>
 class QRectF;
 class RenderContext;
 
@@ -70,6 +71,35 @@ public:
      */
     virtual void render(const QRectF& textCoord) = 0;
 
+    /**
+     * Start loading the data needed to render a region in the next frames.
+     * Called after render(), with the same GL transformation. The default
+     * implementation does nothing.
+     * @param textCoord The region of the texture expected to be rendered
+     */
+    virtual void prefetch(const QRectF& textCoord);
+
+    /**
+     * Finish the initialization of an object constructed in a background thread.
+     * Called from the render thread with a current GL context, before the
+     * object is first rendered. The default implementation does nothing.
+     */
+    virtual void finishLoading();
+
+    /**
+     * Get the host memory currently used by the object.
+     * Used by the Factories to keep the resident objects within budget.
+     * @return The memory footprint in bytes (default: 0).
+     */
+    virtual size_t getHostMemoryUsage() const;
+
+    /**
+     * Get the GPU memory currently used by the object.
+     * @return The memory footprint in bytes (default: 0).
+     * @see getHostMemoryUsage()
+     */
+    virtual size_t getGPUMemoryUsage() const;
+
     /**
      * Set the render context to render the object on Rank 1-N
      * @param renderContext The render context
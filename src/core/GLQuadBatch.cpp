@@ -0,0 +1,130 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "GLQuadBatch.h"
+
+GLQuadBatch::GLQuadBatch(const GLenum mode)
+    : mode_(mode == GL_LINES ? GL_LINES : GL_QUADS)
+    , enableTexture_(false)
+{
+}
+
+void GLQuadBatch::append(const QRectF& rect, const float z, const QRectF& texCoords)
+{
+    const float x0 = rect.left();
+    const float y0 = rect.top();
+    const float x1 = rect.left() + rect.width();
+    const float y1 = rect.top() + rect.height();
+
+    const float s0 = texCoords.left();
+    const float t0 = texCoords.top();
+    const float s1 = texCoords.left() + texCoords.width();
+    const float t1 = texCoords.top() + texCoords.height();
+
+    if (mode_ == GL_QUADS)
+    {
+        appendVertex(x0, y0, z, s0, t0);
+        appendVertex(x1, y0, z, s1, t0);
+        appendVertex(x1, y1, z, s1, t1);
+        appendVertex(x0, y1, z, s0, t1);
+    }
+    else
+    {
+        // An outline is made of four independent segments
+        appendVertex(x0, y0, z, s0, t0);
+        appendVertex(x1, y0, z, s1, t0);
+        appendVertex(x1, y0, z, s1, t0);
+        appendVertex(x1, y1, z, s1, t1);
+        appendVertex(x1, y1, z, s1, t1);
+        appendVertex(x0, y1, z, s0, t1);
+        appendVertex(x0, y1, z, s0, t1);
+        appendVertex(x0, y0, z, s0, t0);
+    }
+}
+
+void GLQuadBatch::render()
+{
+    if (isEmpty())
+        return;
+
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    if (enableTexture_)
+    {
+        glEnable(GL_TEXTURE_2D);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, 0, texCoords_.data());
+    }
+    else
+        glDisable(GL_TEXTURE_2D);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vertices_.data());
+
+    glDrawArrays(mode_, 0, vertices_.size() / 3);
+
+    glPopClientAttrib();
+}
+
+void GLQuadBatch::clear()
+{
+    vertices_.clear();
+    texCoords_.clear();
+}
+
+bool GLQuadBatch::isEmpty() const
+{
+    return vertices_.empty();
+}
+
+void GLQuadBatch::setEnableTexture(const bool enable)
+{
+    enableTexture_ = enable;
+}
+
+void GLQuadBatch::appendVertex(const float x, const float y, const float z,
+                               const float s, const float t)
+{
+    vertices_.push_back(x);
+    vertices_.push_back(y);
+    vertices_.push_back(z);
+
+    texCoords_.push_back(s);
+    texCoords_.push_back(t);
+}
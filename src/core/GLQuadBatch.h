@@ -0,0 +1,98 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef GLQUADBATCH_H
+#define GLQUADBATCH_H
+
+#include <QRectF>
+#include <QtOpenGL/qgl.h>
+
+#include <vector>
+
+/**
+ * A batch of quads sharing the same OpenGL state, drawn in a single call.
+ *
+ * Quads are accumulated on the CPU with their final coordinates and submitted
+ * together from client-side vertex arrays. This avoids the per-quad matrix and
+ * attribute stack changes of GLQuad when rendering many similar objects such
+ * as window borders, markers or stream segment outlines.
+ */
+class GLQuadBatch
+{
+public:
+    /**
+     * Construct an empty batch.
+     * @param mode The primitive mode [GL_QUADS|GL_LINES] (default: GL_QUADS)
+     *        In GL_LINES mode, each appended quad is drawn as an outline.
+     */
+    GLQuadBatch(const GLenum mode = GL_QUADS);
+
+    /**
+     * Add a quad to the batch.
+     * @param rect The quad coordinates in the current GL coordinate system.
+     * @param z The depth of the quad.
+     * @param texCoords The texture coordinates of the quad.
+     */
+    void append(const QRectF& rect, const float z = 0.f,
+                const QRectF& texCoords = QRectF(0.f, 0.f, 1.f, 1.f));
+
+    /** Draw all the quads of the batch. */
+    void render();
+
+    /** Remove all the quads from the batch, keeping the allocated memory. */
+    void clear();
+
+    /** @return true if the batch does not contain any quad. */
+    bool isEmpty() const;
+
+    /** Enable or disable texturing. (default: OFF) */
+    void setEnableTexture(const bool enable);
+
+private:
+    GLenum mode_;
+    bool enableTexture_;
+
+    std::vector<GLfloat> vertices_;
+    std::vector<GLfloat> texCoords_;
+
+    void appendVertex(const float x, const float y, const float z,
+                      const float s, const float t);
+};
+
+#endif // GLQUADBATCH_H
@@ -43,6 +43,7 @@
 
 GLTexture2D::GLTexture2D()
     : textureId_(0)
+    , mipmaps_(false)
 {
 }
 
@@ -77,6 +78,7 @@ bool GLTexture2D::init(const QImage image, const GLenum format, bool mipmaps)
                  0, format, GL_UNSIGNED_BYTE, image.bits());
 
     size_ = image.size();
+    mipmaps_ = mipmaps;
 
     return true;
 }
@@ -88,6 +90,7 @@ void GLTexture2D::free()
         glDeleteTextures(1, &textureId_);
         textureId_ = 0;
         size_ = QSize();
+        mipmaps_ = false;
     }
 }
 
@@ -113,6 +116,13 @@ void GLTexture2D::update(const void* data, const GLenum format)
                     format, GL_UNSIGNED_BYTE, data);
 }
 
+void GLTexture2D::update(const void* data, const QRect& region, const GLenum format)
+{
+    glBindTexture(GL_TEXTURE_2D, textureId_);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, region.x(), region.y(), region.width(), region.height(),
+                    format, GL_UNSIGNED_BYTE, data);
+}
+
 QSize GLTexture2D::getSize() const
 {
     return size_;
@@ -127,3 +137,10 @@ bool GLTexture2D::isValid() const
 {
     return textureId_ != 0;
 }
+
+size_t GLTexture2D::getMemoryUsage() const
+{
+    // GL_RGBA internal format; a full mipmap chain adds one third
+    const size_t size = (size_t)size_.width() * size_.height() * 4;
+    return mipmaps_ ? size * 4 / 3 : size;
+}
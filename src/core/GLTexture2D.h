@@ -41,6 +41,7 @@
 #define GLTEXTURE2D_H
 
 #include <QtOpenGL/qgl.h>
+#include <QRect>
 #include <boost/noncopyable.hpp>
 
 /**
@@ -69,6 +70,14 @@ public:
      */
     void update(const void* data, const GLenum format = GL_RGBA);
 
+    /**
+     * Update a region of the texture
+     * @param data A buffer of region dimensions with "format" bytes per pixels
+     * @param region The region of the texture to update
+     * @param format The image format of the data buffer
+     */
+    void update(const void* data, const QRect& region, const GLenum format = GL_RGBA);
+
     /** Get the texture size. */
     QSize getSize() const;
 
@@ -78,12 +87,16 @@ public:
     /** Is the texture valid. */
     bool isValid() const;
 
+    /** Get the GPU memory used by the texture and its mipmaps, in bytes. */
+    size_t getMemoryUsage() const;
+
     /** Free the GLTexture. */
     void free();
 
 private:
     GLuint textureId_;
     QSize size_;
+    bool mipmaps_;
 };
 
 #endif // GLTEXTURE2D_H
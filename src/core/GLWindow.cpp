@@ -46,6 +46,7 @@
 
 #include <QtOpenGL>
 #include <boost/shared_ptr.hpp>
+#include <cassert>
 
 #ifdef __APPLE__
     #include <OpenGL/glu.h>
@@ -170,6 +171,12 @@ void GLWindow::setOrthographicView()
 
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
+
+    // The model view is the identity: the unit rectangle covers the Wall
+    const QRectF wallRect(0., 0., 1., 1.);
+    const Transform identity = { wallRect, projectToPixels(wallRect) };
+    transforms_.clear();
+    transforms_.push_back(identity);
 }
 
 bool GLWindow::isRegionVisible(const QRectF& region) const
@@ -197,49 +204,62 @@ void GLWindow::drawFps()
     glPopAttrib();
 }
 
-QRectF GLWindow::getProjectedPixelRect(const bool clampToViewportBorders)
+void GLWindow::pushTransform(const QRectF& rect)
 {
-    // get four corners in object space (recall we're in normalized 0->1 dimensions)
-    const double corners[4][3] =
-    {
-        {0.,0.,0.},
-        {1.,0.,0.},
-        {1.,1.,0.},
-        {0.,1.,0.}
-    };
+    assert(!transforms_.empty());
 
-    // get four corners in screen space
-    GLdouble modelview[16];
-    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+    glPushMatrix();
+    glTranslatef(rect.x(), rect.y(), 0.f);
+    glScalef(rect.width(), rect.height(), 1.f);
 
-    GLdouble projection[16];
-    glGetDoublev(GL_PROJECTION_MATRIX, projection);
+    const QRectF& parent = transforms_.back().wallRect;
+    const QRectF wallRect(parent.x() + rect.x() * parent.width(),
+                          parent.y() + rect.y() * parent.height(),
+                          rect.width() * parent.width(),
+                          rect.height() * parent.height());
 
-    GLint viewport[4];
-    glGetIntegerv(GL_VIEWPORT, viewport);
+    const Transform transform = { wallRect, projectToPixels(wallRect) };
+    transforms_.push_back(transform);
+}
 
-    GLdouble xWin[4][3];
+void GLWindow::popTransform()
+{
+    assert(transforms_.size() > 1);
 
-    for(size_t i=0; i<4; i++)
-    {
-        gluProject(corners[i][0], corners[i][1], corners[i][2], modelview, projection, viewport, &xWin[i][0], &xWin[i][1], &xWin[i][2]);
+    transforms_.pop_back();
+    glPopMatrix();
+}
 
-        const GLdouble viewportWidth = (GLdouble)viewport[2];
-        const GLdouble viewportHeight = (GLdouble)viewport[3];
+QRectF GLWindow::projectToPixels(const QRectF& wallRect) const
+{
+    // The orthographic projection maps [left_, right_] x [top_, bottom_] to
+    // the viewport, which always covers the whole window (see resizeGL()).
+    // For the QRect, the origin is at the top of the viewport with the y-axis
+    // pointing downwards.
+    const double scaleX = (double)width() / (right_ - left_);
+    const double scaleY = (double)height() / (bottom_ - top_);
+
+    return QRectF((wallRect.x() - left_) * scaleX,
+                  (wallRect.y() - top_) * scaleY,
+                  wallRect.width() * scaleX,
+                  wallRect.height() * scaleY);
+}
+
+QRectF GLWindow::getProjectedPixelRect(const bool clampToViewportBorders) const
+{
+    assert(!transforms_.empty());
 
-        // The GL coordinates system origin is at the bottom-left corner with
-        // the y-axis pointing upwards. For the QRect, we want the origin at
-        // the top of the viewport with the y-axis pointing downwards.
-        xWin[i][1] = viewportHeight - xWin[i][1];
+    const QRectF& pixelRect = transforms_.back().pixelRect;
 
-        if( clampToViewportBorders )
-        {
-            xWin[i][0] = std::min( std::max( xWin[i][0], 0. ), viewportWidth );
-            xWin[i][1] = std::min( std::max( xWin[i][1], 0. ), viewportHeight );
-        }
-    }
+    if(!clampToViewportBorders)
+        return pixelRect;
+
+    const double viewportWidth = width();
+    const double viewportHeight = height();
 
-    const QPointF topleft( xWin[0][0], xWin[0][1] );
-    const QPointF bottomright( xWin[2][0], xWin[2][1] );
-    return QRectF( topleft, bottomright );
+    const QPointF topleft(std::min(std::max(pixelRect.left(), 0.), viewportWidth),
+                          std::min(std::max(pixelRect.top(), 0.), viewportHeight));
+    const QPointF bottomright(std::min(std::max(pixelRect.right(), 0.), viewportWidth),
+                              std::min(std::max(pixelRect.bottom(), 0.), viewportHeight));
+    return QRectF(topleft, bottomright);
 }
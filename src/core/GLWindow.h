@@ -41,6 +41,7 @@
 
 #include <QGLWidget>
 #include <QList>
+#include <vector>
 
 #include "types.h"
 #include "FpsCounter.h"
@@ -80,15 +81,30 @@ public:
      */
     bool isRegionVisible(const QRectF& region) const;
 
+    /**
+     * Apply a transformation to the current model view.
+     *
+     * The unit rectangle {(0;0),(1;1)} of the current coordinate system is
+     * mapped to the given rectangle. The transformation is applied to the GL
+     * modelview matrix and mirrored on a CPU-side stack, so that the projected
+     * region can be computed without querying the GL state.
+     * @param rect The rectangle in the current coordinate system.
+     * @see popTransform()
+     */
+    void pushTransform(const QRectF& rect);
+
+    /** Restore the model view to its state before the last pushTransform(). */
+    void popTransform();
+
     /**
      * Get the region spanned by a unit rectangle {(0;0),(1;1)} in the current
-     * GL view.
+     * GL view, as defined by the pushTransform() calls.
      * The region is in screen coordinates with the origin at the viewport's
      * top-left corner.
      * @param clampToViewportBorders Clamp to the visible part of the region.
      * @return The region in pixel units.
      */
-    static QRectF getProjectedPixelRect(const bool clampToViewportBorders);
+    QRectF getProjectedPixelRect(const bool clampToViewportBorders) const;
 
 protected:
     ///@{
@@ -114,8 +130,18 @@ private:
     QList<RenderablePtr> renderables_;
     RenderablePtr testPattern_;
 
+    // CPU-side model view: the unit rectangle in normalized Wall coordinates
+    // and its projection in pixel units for each level of the stack
+    struct Transform
+    {
+        QRectF wallRect;
+        QRectF pixelRect;
+    };
+    std::vector<Transform> transforms_;
+
     void clear(const QColor& clearColor);
     void setOrthographicView();
+    QRectF projectToPixels(const QRectF& wallRect) const;
     void drawFps();
 };
 
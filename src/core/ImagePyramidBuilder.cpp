@@ -0,0 +1,568 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ImagePyramidBuilder.h"
+
+#include "DynamicTexture.h"
+#include "ImagePyramidContainer.h"
+#include "log.h"
+#include "config.h"
+
+#if ENABLE_TIFF_SUPPORT
+#  include "TiffPyramidReader.h"
+#endif
+
+#include <QDir>
+#include <QFile>
+#include <QImageReader>
+#include <QRunnable>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <jpeglib.h>
+}
+
+#define DEFAULT_MAX_STRIP_SIZE (512 * 1024 * 1024)
+
+/** Read consecutive horizontal strips of an image, from top to bottom. */
+class ImageStripReader : public boost::noncopyable
+{
+public:
+    virtual ~ImageStripReader() {}
+
+    /**
+     * Read the next strip.
+     * @param rect The strip, below the previous one.
+     * @return The strip, null on error.
+     */
+    virtual QImage read(const QRect& rect) = 0;
+};
+
+namespace
+{
+struct JpegErrorManager
+{
+    jpeg_error_mgr manager;
+    jmp_buf jump;
+};
+
+void jumpOnJpegError(j_common_ptr cinfo)
+{
+    longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+}
+
+/**
+ * Decode the scanlines of a JPEG image in a single pass.
+ * Qt decodes a clip rect from the first row of the image, so reading a JPEG
+ * image in strips with QImageReader takes a time quadratic in its height.
+ */
+class JpegStripReader : public ImageStripReader
+{
+public:
+    JpegStripReader()
+        : file_(0)
+    {
+        cinfo_.err = jpeg_std_error(&errorManager_.manager);
+        errorManager_.manager.error_exit = jumpOnJpegError;
+        jpeg_create_decompress(&cinfo_);
+    }
+
+    ~JpegStripReader()
+    {
+        jpeg_destroy_decompress(&cinfo_);
+        if(file_)
+            fclose(file_);
+    }
+
+    bool open(const QString& filename)
+    {
+        file_ = fopen(QFile::encodeName(filename).constData(), "rb");
+        if(!file_)
+            return false;
+
+        if(setjmp(errorManager_.jump))
+        {
+            logError(filename);
+            return false;
+        }
+
+        jpeg_stdio_src(&cinfo_, file_);
+        jpeg_read_header(&cinfo_, TRUE);
+
+        // CMYK images cannot be converted to RGB by libjpeg
+        if(cinfo_.jpeg_color_space == JCS_CMYK || cinfo_.jpeg_color_space == JCS_YCCK)
+            return false;
+
+        cinfo_.out_color_space = JCS_RGB;
+        jpeg_start_decompress(&cinfo_);
+        filename_ = filename;
+        return true;
+    }
+
+    QImage read(const QRect& rect) override
+    {
+        if(rect.top() < int(cinfo_.output_scanline) ||
+           rect.bottom() >= int(cinfo_.output_height))
+        {
+            put_flog(LOG_ERROR, "rows %i to %i of %s cannot be read after row %i",
+                     rect.top(), rect.bottom(), filename_.toLocal8Bit().constData(),
+                     cinfo_.output_scanline);
+            return QImage();
+        }
+
+        QImage strip(cinfo_.output_width, rect.height(), QImage::Format_RGB888);
+        if(strip.isNull() || !readScanlines(rect.top(), strip))
+            return QImage();
+
+        if(rect.x() == 0 && rect.width() == strip.width())
+            return strip;
+        return strip.copy(rect.x(), 0, rect.width(), rect.height());
+    }
+
+private:
+    jpeg_decompress_struct cinfo_;
+    JpegErrorManager errorManager_;
+    FILE* file_;
+    QString filename_;
+
+    bool readScanlines(const int top, QImage& strip)
+    {
+        if(setjmp(errorManager_.jump))
+        {
+            logError(filename_);
+            return false;
+        }
+
+        // Rows between two strips are decoded into the first row of the strip
+        JSAMPROW row = strip.scanLine(0);
+        while(int(cinfo_.output_scanline) < top)
+            jpeg_read_scanlines(&cinfo_, &row, 1);
+
+        for(int y = 0; y < strip.height(); ++y)
+        {
+            row = strip.scanLine(y);
+            jpeg_read_scanlines(&cinfo_, &row, 1);
+        }
+        return true;
+    }
+
+    void logError(const QString& filename)
+    {
+        char message[JMSG_LENGTH_MAX];
+        errorManager_.manager.format_message(reinterpret_cast<j_common_ptr>(&cinfo_), message);
+        put_flog(LOG_ERROR, "could not decode %s: %s", filename.toLocal8Bit().constData(), message);
+    }
+};
+
+#if ENABLE_TIFF_SUPPORT
+/** Decode only the tiles of a tiled TIFF image which overlap each strip. */
+class TiffStripReader : public ImageStripReader
+{
+public:
+    bool open(const QString& filename)
+    {
+        return reader_.open(filename);
+    }
+
+    QImage read(const QRect& rect) override
+    {
+        return reader_.readRegion(rect, rect.size());
+    }
+
+private:
+    TiffPyramidReader reader_;
+};
+#endif
+
+/** Read strips with the clip rect option of the Qt image handler. */
+class ClipRectStripReader : public ImageStripReader
+{
+public:
+    ClipRectStripReader(const QString& filename)
+        : filename_(filename)
+    {}
+
+    QImage read(const QRect& rect) override
+    {
+        QImageReader reader(filename_);
+        reader.setClipRect(rect);
+        const QImage strip = reader.read();
+        if(strip.isNull())
+            put_flog(LOG_ERROR, "could not read region of %s: %s",
+                     filename_.toLocal8Bit().constData(),
+                     reader.errorString().toLocal8Bit().constData());
+        return strip;
+    }
+
+private:
+    QString filename_;
+};
+
+/** Read an image which fits in a single strip. */
+class FullImageStripReader : public ImageStripReader
+{
+public:
+    FullImageStripReader(const QString& filename)
+        : filename_(filename)
+    {}
+
+    QImage read(const QRect& rect) override
+    {
+        QImageReader reader(filename_);
+        const QImage image = reader.read();
+        if(image.isNull())
+        {
+            put_flog(LOG_ERROR, "could not read %s: %s", filename_.toLocal8Bit().constData(),
+                     reader.errorString().toLocal8Bit().constData());
+            return QImage();
+        }
+        return image.copy(rect);
+    }
+
+private:
+    QString filename_;
+};
+}
+
+/** Save a tile in the encoding thread pool. */
+class TileEncodingJob : public QRunnable
+{
+public:
+    TileEncodingJob(ImagePyramidBuilder& builder, const QImage& tile, const QString& filename)
+        : builder_(builder)
+        , tile_(tile)
+        , filename_(filename)
+    {}
+
+    void run() override
+    {
+        const bool success = tile_.save(filename_, DynamicTexture::pyramidImageExtension.toAscii());
+        if(!success)
+            put_flog(LOG_ERROR, "could not save %s", filename_.toLocal8Bit().constData());
+        builder_.encodingFinished(success);
+    }
+
+private:
+    ImagePyramidBuilder& builder_;
+    QImage tile_;
+    QString filename_;
+};
+
+ImagePyramidBuilder::ImagePyramidBuilder(const QString& imageFilename, const QString& pyramidFolder)
+    : imageFilename_(imageFilename)
+    , pyramidFolder_(pyramidFolder)
+    , maxStripSize_(DEFAULT_MAX_STRIP_SIZE)
+    , depth_(0)
+    , encodingSlotCount_(0)
+    , encodingError_(false)
+{
+    if(!pyramidFolder_.endsWith('/'))
+        pyramidFolder_.append('/');
+
+    setEncodingThreadCount(QThread::idealThreadCount());
+}
+
+ImagePyramidBuilder::~ImagePyramidBuilder()
+{
+}
+
+void ImagePyramidBuilder::setEncodingThreadCount(const int count)
+{
+    encodingThreadPool_.setMaxThreadCount(std::max(count, 1));
+
+    // Bound the number of tiles waiting to be encoded
+    encodingSlotCount_ = 2 * encodingThreadPool_.maxThreadCount();
+}
+
+void ImagePyramidBuilder::setMaxStripSize(const size_t bytes)
+{
+    maxStripSize_ = bytes;
+}
+
+bool ImagePyramidBuilder::build()
+{
+    if(!readImageSize() || !openStripReader() || !makePyramidFolder() || !writeMetadataFiles())
+        return false;
+
+    depth_ = ImagePyramidContainer::getLevelCount(imageSize_, DynamicTexture::pyramidTileSize) - 1;
+
+    levelRows_.clear();
+    for(int depth = 0; depth < depth_; ++depth)
+        levelRows_.push_back(std::vector<QImage>(1 << depth));
+
+    const qint64 tilesPerSide = 1 << depth_;
+    const int regionWidth = std::max(imageSize_.width() / (1 << depth_), 1);
+    const int regionHeight = std::max(imageSize_.height() / (1 << depth_), 1);
+
+    const size_t rowSize = size_t(imageSize_.width()) * regionHeight * 4;
+    const int rowsPerStrip = std::max(int(maxStripSize_ / rowSize), 1);
+
+    put_flog(LOG_INFO, "building pyramid of %i levels for %s in %s",
+             depth_ + 1, imageFilename_.toLocal8Bit().constData(),
+             pyramidFolder_.toLocal8Bit().constData());
+
+    encodingError_ = false;
+    encodingSlots_.release(encodingSlotCount_);
+
+    bool success = true;
+    for(int stripBegin = 0; success && stripBegin < tilesPerSide; stripBegin += rowsPerStrip)
+    {
+        const int stripEnd = std::min<qint64>(stripBegin + rowsPerStrip, tilesPerSide);
+        const int stripTop = qint64(stripBegin) * imageSize_.height() / tilesPerSide;
+        const int stripBottom = qint64(stripEnd - 1) * imageSize_.height() / tilesPerSide + regionHeight;
+
+        put_flog(LOG_DEBUG, "reading rows %i to %i of %i", stripTop, stripBottom, imageSize_.height());
+
+        const QImage strip = stripReader_->read(QRect(0, stripTop, imageSize_.width(), stripBottom - stripTop));
+        if(strip.isNull())
+        {
+            success = false;
+            break;
+        }
+
+        for(int row = stripBegin; row < stripEnd; ++row)
+        {
+            const int top = qint64(row) * imageSize_.height() / tilesPerSide - stripTop;
+            for(int column = 0; column < tilesPerSide; ++column)
+            {
+                const int left = qint64(column) * imageSize_.width() / tilesPerSide;
+                const QImage region = strip.copy(left, top, regionWidth, regionHeight);
+                addTile(depth_, row, column, region.scaled(getTileSize(depth_),
+                                                           Qt::IgnoreAspectRatio,
+                                                           Qt::SmoothTransformation));
+            }
+            finishRow(depth_, row);
+        }
+    }
+
+    // Wait for all the tiles to be encoded
+    encodingSlots_.acquire(encodingSlotCount_);
+
+    levelRows_.clear();
+    stripReader_.reset();
+
+    return success && !encodingError_;
+}
+
+bool ImagePyramidBuilder::readImageSize()
+{
+    QImageReader reader(imageFilename_);
+    imageSize_ = reader.size();
+
+    // Decoding the image to get its size would defeat reading it in strips
+    if(imageSize_.isEmpty())
+    {
+        put_flog(LOG_ERROR, "could not read the size of %s: %s",
+                 imageFilename_.toLocal8Bit().constData(),
+                 reader.errorString().toLocal8Bit().constData());
+        return false;
+    }
+    return true;
+}
+
+bool ImagePyramidBuilder::openStripReader()
+{
+    QImageReader reader(imageFilename_);
+    const QByteArray format = reader.format();
+
+    if(format == "jpeg" || format == "jpg")
+    {
+        JpegStripReader* jpegReader = new JpegStripReader;
+        stripReader_.reset(jpegReader);
+        if(jpegReader->open(imageFilename_))
+            return true;
+    }
+#if ENABLE_TIFF_SUPPORT
+    else if(format == "tiff" || format == "tif")
+    {
+        TiffStripReader* tiffReader = new TiffStripReader;
+        stripReader_.reset(tiffReader);
+        if(tiffReader->open(imageFilename_))
+            return true;
+    }
+#endif
+    else if(reader.supportsOption(QImageIOHandler::ClipRect))
+    {
+        stripReader_.reset(new ClipRectStripReader(imageFilename_));
+        return true;
+    }
+
+    if(qint64(imageSize_.width()) * imageSize_.height() * 4 <= qint64(maxStripSize_))
+    {
+        stripReader_.reset(new FullImageStripReader(imageFilename_));
+        return true;
+    }
+
+    stripReader_.reset();
+    put_flog(LOG_ERROR, "%s (%ix%i) cannot be read in strips and is larger than the "
+             "maximum strip size of %lu bytes, convert it to JPEG or tiled TIFF",
+             imageFilename_.toLocal8Bit().constData(), imageSize_.width(),
+             imageSize_.height(), (unsigned long)maxStripSize_);
+    return false;
+}
+
+bool ImagePyramidBuilder::makePyramidFolder() const
+{
+    if(!QDir(pyramidFolder_).exists() && !QDir().mkpath(pyramidFolder_))
+    {
+        put_flog(LOG_ERROR, "error creating directory %s",
+                 pyramidFolder_.toLocal8Bit().constData());
+        return false;
+    }
+    return true;
+}
+
+bool ImagePyramidBuilder::writeMetadataFile(const QString& filename) const
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        put_flog(LOG_WARN, "could not write metadata file %s",
+                 filename.toLocal8Bit().constData());
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "\"" << pyramidFolder_ << "\" " << imageSize_.width()
+        << " " << imageSize_.height();
+    return true;
+}
+
+bool ImagePyramidBuilder::writeMetadataFiles() const
+{
+    if(!writeMetadataFile(pyramidFolder_ + DynamicTexture::pyramidMetadataFilename))
+        return false;
+
+    // Second more conveniently named metadata file next to the source image
+    if(!pyramidFolder_.endsWith(DynamicTexture::pyramidFolderSuffix))
+        return true;
+
+    QString secondMetadataFilename = pyramidFolder_;
+    secondMetadataFilename.chop(DynamicTexture::pyramidFolderSuffix.size());
+    secondMetadataFilename.append(".").append(DynamicTexture::pyramidFileExtension);
+
+    return writeMetadataFile(secondMetadataFilename);
+}
+
+QSize ImagePyramidBuilder::getTileSize(const int depth) const
+{
+    const QSize regionSize(std::max(imageSize_.width() / (1 << depth), 1),
+                           std::max(imageSize_.height() / (1 << depth), 1));
+    return regionSize.scaled(DynamicTexture::pyramidTileSize, DynamicTexture::pyramidTileSize,
+                             Qt::KeepAspectRatio);
+}
+
+QString ImagePyramidBuilder::getTileFilename(const int depth, const int row, const int column) const
+{
+    return pyramidFolder_ + ImagePyramidContainer::getTileFilename(depth, row, column);
+}
+
+void ImagePyramidBuilder::addTile(const int depth, const int row, const int column, const QImage& tile)
+{
+    encodeTile(tile, getTileFilename(depth, row, column));
+
+    if(depth == 0)
+        return;
+
+    // Downsample the tile into its quadrant of the parent tile
+    QImage& parent = levelRows_[depth - 1][column / 2];
+    if(parent.isNull())
+    {
+        parent = QImage(getTileSize(depth - 1), QImage::Format_RGB32);
+        parent.fill(0);
+    }
+
+    const bool right = column % 2;
+    const bool bottom = row % 2;
+    const int halfWidth = parent.width() / 2;
+    const int halfHeight = parent.height() / 2;
+    const QRect quadrant(right ? halfWidth : 0, bottom ? halfHeight : 0,
+                         right ? parent.width() - halfWidth : halfWidth,
+                         bottom ? parent.height() - halfHeight : halfHeight);
+    if(quadrant.isEmpty())
+        return;
+
+    const QImage scaledTile = tile.scaled(quadrant.size(), Qt::IgnoreAspectRatio,
+                                          Qt::SmoothTransformation).convertToFormat(QImage::Format_RGB32);
+
+    for(int y = 0; y < quadrant.height(); ++y)
+        memcpy(parent.scanLine(quadrant.y() + y) + quadrant.x() * 4,
+               scaledTile.constScanLine(y), quadrant.width() * 4);
+}
+
+void ImagePyramidBuilder::finishRow(const int depth, const int row)
+{
+    // A row of parent tiles is complete after its second row of children
+    if(depth == 0 || row % 2 == 0)
+        return;
+
+    std::vector<QImage>& parentRow = levelRows_[depth - 1];
+    const int parentRowIndex = row / 2;
+
+    for(size_t column = 0; column < parentRow.size(); ++column)
+    {
+        const QImage parent = parentRow[column];
+        parentRow[column] = QImage();
+        addTile(depth - 1, parentRowIndex, column, parent);
+    }
+
+    finishRow(depth - 1, parentRowIndex);
+}
+
+void ImagePyramidBuilder::encodeTile(const QImage& tile, const QString& filename)
+{
+    encodingSlots_.acquire();
+    encodingThreadPool_.start(new TileEncodingJob(*this, tile, filename));
+}
+
+void ImagePyramidBuilder::encodingFinished(const bool success)
+{
+    if(!success)
+    {
+        QMutexLocker locker(&errorMutex_);
+        encodingError_ = true;
+    }
+    encodingSlots_.release();
+}
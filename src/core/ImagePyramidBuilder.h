@@ -0,0 +1,133 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef IMAGEPYRAMIDBUILDER_H
+#define IMAGEPYRAMIDBUILDER_H
+
+#include <QImage>
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+
+class ImageStripReader;
+
+/**
+ * Build an image pyramid for DynamicTexture with a bounded memory usage.
+ *
+ * The source image is read in horizontal strips, from top to bottom in a
+ * single pass for JPEG and tiled TIFF files. Other formats are only accepted
+ * if the full image fits in one strip. The leaf tiles are cut from
+ * each strip, and every level above is downsampled from the level below one
+ * row of tiles at a time, so that only one row of tiles per level is kept in
+ * memory. Tiles are encoded on a pool of threads.
+ *
+ * The output is the same as DynamicTexture::generateImagePyramid(): a
+ * "pyramid.pyr" metadata file and one "0-1-2.jpg" image per tile, each tile
+ * having the size of its region of the source image scaled to fit 512x512.
+ */
+class ImagePyramidBuilder : public boost::noncopyable
+{
+public:
+    /**
+     * Constructor.
+     * @param imageFilename The source image.
+     * @param pyramidFolder The folder in which to create the metadata and
+     *        pyramid images. Usually imageFilename + DynamicTexture::pyramidFolderSuffix.
+     */
+    ImagePyramidBuilder(const QString& imageFilename, const QString& pyramidFolder);
+
+    /** Destructor. */
+    ~ImagePyramidBuilder();
+
+    /** Set the number of threads used to encode the tiles. */
+    void setEncodingThreadCount(const int count);
+
+    /**
+     * Set the maximum size of a strip of the source image.
+     * The build fails if the image cannot be read in strips and is larger.
+     * @param bytes The maximum size, at least one row of tiles is read at once.
+     */
+    void setMaxStripSize(const size_t bytes);
+
+    /**
+     * Build the pyramid.
+     * @return true on success.
+     */
+    bool build();
+
+private:
+    QString imageFilename_;
+    QString pyramidFolder_;
+    size_t maxStripSize_;
+
+    QSize imageSize_;
+    int depth_;
+
+    boost::scoped_ptr<ImageStripReader> stripReader_;
+    std::vector< std::vector<QImage> > levelRows_;
+
+    QThreadPool encodingThreadPool_;
+    QSemaphore encodingSlots_;
+    int encodingSlotCount_;
+    QMutex errorMutex_;
+    bool encodingError_;
+
+    bool readImageSize();
+    bool openStripReader();
+    bool makePyramidFolder() const;
+    bool writeMetadataFile(const QString& filename) const;
+    bool writeMetadataFiles() const;
+
+    QSize getTileSize(const int depth) const;
+    QString getTileFilename(const int depth, const int row, const int column) const;
+
+    void addTile(const int depth, const int row, const int column, const QImage& tile);
+    void finishRow(const int depth, const int row);
+    void encodeTile(const QImage& tile, const QString& filename);
+
+    friend class TileEncodingJob;
+    void encodingFinished(const bool success);
+};
+
+#endif // IMAGEPYRAMIDBUILDER_H
@@ -0,0 +1,345 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ImagePyramidContainer.h"
+
+#include "DynamicTexture.h"
+#include "log.h"
+
+#include <QDataStream>
+#include <QFileInfo>
+#include <QImageReader>
+
+#define CONTAINER_MAGIC       "DCPYRMD1"
+#define CONTAINER_MAGIC_SIZE  8
+#define CONTAINER_VERSION     1
+#define CONTAINER_HEADER_SIZE 32
+#define TILE_ENTRY_SIZE       16
+
+ImagePyramidContainer::ImagePyramidContainer()
+    : mappedData_(0)
+    , levelCount_(0)
+    , tileFormat_(TILES_JPEG)
+{
+}
+
+ImagePyramidContainer::~ImagePyramidContainer()
+{
+    close();
+}
+
+bool ImagePyramidContainer::isContainer(const QString& filename)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return file.read(CONTAINER_MAGIC_SIZE) == QByteArray(CONTAINER_MAGIC);
+}
+
+bool ImagePyramidContainer::convert(const QString& metadataFilename, const QString& containerFilename,
+                                    const TileFormat tileFormat)
+{
+    QString pyramidFolder;
+    QSize imageSize;
+    if(!DynamicTexture::readPyramidMetadata(metadataFilename, pyramidFolder, imageSize))
+        return false;
+
+    const int levelCount = getLevelCount(imageSize, DynamicTexture::pyramidTileSize);
+    const size_t tileCount = getTileIndex(levelCount, 0, 0);
+
+    // Stat all the tiles first to write the index
+    std::vector<TileEntry> index(tileCount);
+    std::vector<QString> tileFilenames(tileCount);
+    quint64 offset = CONTAINER_HEADER_SIZE + TILE_ENTRY_SIZE * tileCount;
+
+    for(int depth = 0; depth < levelCount; ++depth)
+    {
+        for(int row = 0; row < (1 << depth); ++row)
+        {
+            for(int column = 0; column < (1 << depth); ++column)
+            {
+                const size_t i = getTileIndex(depth, row, column);
+                tileFilenames[i] = pyramidFolder + '/' + getTileFilename(depth, row, column);
+
+                const QFileInfo tileInfo(tileFilenames[i]);
+                if(!tileInfo.exists())
+                {
+                    put_flog(LOG_ERROR, "missing pyramid tile %s",
+                             tileFilenames[i].toLocal8Bit().constData());
+                    return false;
+                }
+                index[i].offset = offset;
+                if(tileFormat == TILES_JPEG)
+                    index[i].size = tileInfo.size();
+                else
+                {
+                    const QSize tileSize = QImageReader(tileFilenames[i]).size();
+                    if(!tileSize.isValid())
+                    {
+                        put_flog(LOG_ERROR, "invalid pyramid tile %s",
+                                 tileFilenames[i].toLocal8Bit().constData());
+                        return false;
+                    }
+                    index[i].size = CompressedImage::getDataSize(tileSize, CompressedImage::Format(tileFormat));
+                }
+                offset += index[i].size;
+            }
+        }
+    }
+
+    // Write to a temporary file, the metadata file may be replaced
+    const QString tmpFilename = containerFilename + ".tmp";
+    QFile file(tmpFilename);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        put_flog(LOG_ERROR, "could not create %s", tmpFilename.toLocal8Bit().constData());
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData(CONTAINER_MAGIC, CONTAINER_MAGIC_SIZE);
+    out << quint32(CONTAINER_VERSION) << quint32(imageSize.width())
+        << quint32(imageSize.height()) << quint32(levelCount)
+        << quint32(tileCount) << quint32(tileFormat);
+
+    for(size_t i = 0; i < tileCount; ++i)
+        out << index[i].offset << index[i].size;
+
+    bool success = out.status() == QDataStream::Ok;
+    for(size_t i = 0; success && i < tileCount; ++i)
+    {
+        QFile tile(tileFilenames[i]);
+        QByteArray data = tile.open(QIODevice::ReadOnly) ? tile.readAll() : QByteArray();
+
+        if(tileFormat != TILES_JPEG)
+        {
+            const QImage image = QImage::fromData(data);
+            data = CompressedImage(image, CompressedImage::Format(tileFormat)).toData();
+        }
+        success = quint64(data.size()) == index[i].size &&
+                  file.write(data) == data.size();
+    }
+    file.close();
+
+    if(!success)
+    {
+        put_flog(LOG_ERROR, "could not write %s", tmpFilename.toLocal8Bit().constData());
+        QFile::remove(tmpFilename);
+        return false;
+    }
+
+    QFile::remove(containerFilename);
+    return QFile::rename(tmpFilename, containerFilename);
+}
+
+int ImagePyramidContainer::getLevelCount(const QSize& imageSize, const int tileSize)
+{
+    int depth = 0;
+    while(imageSize.width() / (1 << depth) > tileSize ||
+          imageSize.height() / (1 << depth) > tileSize)
+        ++depth;
+
+    return depth + 1;
+}
+
+QString ImagePyramidContainer::getTileFilename(const int depth, const int row, const int column)
+{
+    QString filename("0");
+
+    // Child quadrants are numbered clockwise from the top-left one
+    for(int level = depth - 1; level >= 0; --level)
+    {
+        const bool right = (column >> level) & 1;
+        const bool bottom = (row >> level) & 1;
+        const int childIndex = bottom ? (right ? 2 : 3) : (right ? 1 : 0);
+        filename.append("-").append(QString::number(childIndex));
+    }
+
+    return filename.append(".").append(DynamicTexture::pyramidImageExtension);
+}
+
+bool ImagePyramidContainer::open(const QString& filename)
+{
+    close();
+
+    file_.setFileName(filename);
+    if(!file_.open(QIODevice::ReadOnly))
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.toLocal8Bit().constData());
+        return false;
+    }
+
+    if(!readHeader())
+    {
+        put_flog(LOG_ERROR, "invalid pyramid container %s", filename.toLocal8Bit().constData());
+        close();
+        return false;
+    }
+
+    // Reading falls back to seek() + read() if the file cannot be mapped
+    mappedData_ = file_.map(0, file_.size());
+    if(!mappedData_)
+        put_flog(LOG_DEBUG, "could not map %s", filename.toLocal8Bit().constData());
+
+    return true;
+}
+
+bool ImagePyramidContainer::isOpen() const
+{
+    return file_.isOpen();
+}
+
+const QSize& ImagePyramidContainer::getImageSize() const
+{
+    return imageSize_;
+}
+
+int ImagePyramidContainer::getLevelCount() const
+{
+    return levelCount_;
+}
+
+ImagePyramidContainer::TileFormat ImagePyramidContainer::getTileFormat() const
+{
+    return tileFormat_;
+}
+
+QByteArray ImagePyramidContainer::readTile(const std::vector<int>& treePath) const
+{
+    if(treePath.empty())
+        return QByteArray();
+
+    // The first element is the root tile
+    int row = 0;
+    int column = 0;
+    for(size_t i = 1; i < treePath.size(); ++i)
+    {
+        const int childIndex = treePath[i];
+        row = 2 * row + (childIndex >= 2 ? 1 : 0);
+        column = 2 * column + (childIndex == 1 || childIndex == 2 ? 1 : 0);
+    }
+    return readTile(treePath.size() - 1, row, column);
+}
+
+QByteArray ImagePyramidContainer::readTile(const int depth, const int row, const int column) const
+{
+    if(depth < 0 || depth >= levelCount_ || row < 0 || row >= (1 << depth) ||
+       column < 0 || column >= (1 << depth))
+        return QByteArray();
+
+    const TileEntry& entry = index_[getTileIndex(depth, row, column)];
+
+    if(mappedData_)
+        return QByteArray(reinterpret_cast<const char*>(mappedData_ + entry.offset), entry.size);
+
+    QMutexLocker locker(&fileMutex_);
+    if(!file_.seek(entry.offset))
+        return QByteArray();
+    return file_.read(entry.size);
+}
+
+QImage ImagePyramidContainer::readTileImage(const int depth, const int row, const int column) const
+{
+    const QByteArray data = readTile(depth, row, column);
+
+    if(tileFormat_ == TILES_JPEG)
+        return QImage::fromData(data);
+
+    return CompressedImage::fromData(data).decompress();
+}
+
+void ImagePyramidContainer::close()
+{
+    if(mappedData_)
+        file_.unmap(const_cast<uchar*>(mappedData_));
+    mappedData_ = 0;
+
+    file_.close();
+    index_.clear();
+    imageSize_ = QSize();
+    levelCount_ = 0;
+    tileFormat_ = TILES_JPEG;
+}
+
+bool ImagePyramidContainer::readHeader()
+{
+    const QByteArray header = file_.read(CONTAINER_HEADER_SIZE);
+    if(header.size() != CONTAINER_HEADER_SIZE || !header.startsWith(CONTAINER_MAGIC))
+        return false;
+
+    QDataStream in(header.mid(CONTAINER_MAGIC_SIZE));
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 version, width, height, levelCount, tileCount, tileFormat;
+    in >> version >> width >> height >> levelCount >> tileCount >> tileFormat;
+
+    if(version != CONTAINER_VERSION || levelCount == 0 || levelCount > 16 ||
+       tileCount != getTileIndex(levelCount, 0, 0) ||
+       (tileFormat != TILES_JPEG && tileFormat != TILES_BC1 && tileFormat != TILES_BC3))
+        return false;
+
+    const QByteArray indexData = file_.read(TILE_ENTRY_SIZE * tileCount);
+    if(quint64(indexData.size()) != quint64(TILE_ENTRY_SIZE) * tileCount)
+        return false;
+
+    QDataStream indexStream(indexData);
+    indexStream.setByteOrder(QDataStream::LittleEndian);
+
+    index_.resize(tileCount);
+    for(size_t i = 0; i < tileCount; ++i)
+    {
+        indexStream >> index_[i].offset >> index_[i].size;
+        if(index_[i].offset + index_[i].size > quint64(file_.size()))
+            return false;
+    }
+
+    imageSize_ = QSize(width, height);
+    levelCount_ = levelCount;
+    tileFormat_ = TileFormat(tileFormat);
+    return true;
+}
+
+size_t ImagePyramidContainer::getTileIndex(const int depth, const int row, const int column)
+{
+    // Sum of the tile counts of the levels above, 4^0 + ... + 4^(depth-1)
+    const size_t levelOffset = ((size_t(1) << (2 * depth)) - 1) / 3;
+    return levelOffset + size_t(row) * (size_t(1) << depth) + column;
+}
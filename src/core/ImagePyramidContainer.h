@@ -0,0 +1,177 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef IMAGEPYRAMIDCONTAINER_H
+#define IMAGEPYRAMIDCONTAINER_H
+
+#include "CompressedImage.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+class ImagePyramidContainer;
+typedef boost::shared_ptr<ImagePyramidContainer> ImagePyramidContainerPtr;
+
+/**
+ * An image pyramid stored in a single file.
+ *
+ * Loading a pyramid stored as a folder of tiles requires opening each tile
+ * file separately, which is slow on network file systems. The container
+ * stores all the tiles in a single file which is memory mapped:
+ *
+ * - header: magic "DCPYRMD1", then version, image width, image height,
+ *   level count, tile count and tile format as little endian 32 bit integers;
+ * - index: for each tile, its offset and size as little endian 64 bit
+ *   integers. Tiles are ordered by level, then row, then column;
+ * - the concatenated tiles, either JPEG images or serialized CompressedImages
+ *   which can be uploaded to the GPU without decoding.
+ *
+ * Containers use the same ".pyr" extension as pyramid metadata files and are
+ * recognized by their header.
+ */
+class ImagePyramidContainer : public boost::noncopyable
+{
+public:
+    /** Constructor. */
+    ImagePyramidContainer();
+
+    /** Close the file. */
+    ~ImagePyramidContainer();
+
+    /** The format of the tiles. */
+    enum TileFormat
+    {
+        TILES_JPEG = 0,
+        TILES_BC1 = CompressedImage::BC1,
+        TILES_BC3 = CompressedImage::BC3
+    };
+
+    /** @return true if the file is an image pyramid container. */
+    static bool isContainer(const QString& filename);
+
+    /**
+     * Convert a pyramid folder to a container file.
+     * @param metadataFilename The pyramid metadata file of the folder.
+     * @param containerFilename The container file to create. It may be the
+     *        same as the metadataFilename.
+     * @param tileFormat The format of the tiles in the container. The JPEG
+     *        tiles of the folder are compressed if needed.
+     * @return true on success.
+     */
+    static bool convert(const QString& metadataFilename, const QString& containerFilename,
+                        const TileFormat tileFormat = TILES_JPEG);
+
+    /**
+     * Get the number of levels of the pyramid of an image.
+     * Tiles are subdivided until they are no larger than tileSize.
+     */
+    static int getLevelCount(const QSize& imageSize, const int tileSize);
+
+    /** Get the name of a tile in a pyramid folder, for instance "0-1-2.jpg". */
+    static QString getTileFilename(const int depth, const int row, const int column);
+
+    /**
+     * Open a container file.
+     * @return true on success.
+     */
+    bool open(const QString& filename);
+
+    /** @return true if a container file is open. */
+    bool isOpen() const;
+
+    /** @return The size of the full resolution image. */
+    const QSize& getImageSize() const;
+
+    /** @return The number of levels of the pyramid. */
+    int getLevelCount() const;
+
+    /** @return The format of the tiles. */
+    TileFormat getTileFormat() const;
+
+    /**
+     * Read a tile.
+     * This function is thread safe.
+     * @param treePath The path of the tile from the root tile, as used by DynamicTexture.
+     * @return The data of the tile in the container's format, empty if not found.
+     */
+    QByteArray readTile(const std::vector<int>& treePath) const;
+
+    /**
+     * Read a tile.
+     * This function is thread safe.
+     * @return The data of the tile in the container's format, empty if not found.
+     */
+    QByteArray readTile(const int depth, const int row, const int column) const;
+
+    /**
+     * Read and decode a tile.
+     * This function is thread safe.
+     * @return The tile image, null if not found.
+     */
+    QImage readTileImage(const int depth, const int row, const int column) const;
+
+private:
+    struct TileEntry
+    {
+        quint64 offset;
+        quint64 size;
+    };
+
+    mutable QFile file_;
+    mutable QMutex fileMutex_;
+    const uchar* mappedData_;
+
+    QSize imageSize_;
+    int levelCount_;
+    TileFormat tileFormat_;
+    std::vector<TileEntry> index_;
+
+    void close();
+    bool readHeader();
+    static size_t getTileIndex(const int depth, const int row, const int column);
+};
+
+#endif // IMAGEPYRAMIDCONTAINER_H
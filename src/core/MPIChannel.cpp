@@ -41,6 +41,7 @@
 
 #include "MessageHeader.h"
 #include "DisplayGroupManager.h"
+#include "MoviePackets.h"
 #include "Options.h"
 #include "PixelStreamFrame.h"
 
@@ -219,6 +220,10 @@ void MPIChannel::receiveMessages()
             {
                 receivePixelStreams(mh);
             }
+            else if(mh.type == MESSAGE_TYPE_MOVIE_PACKETS)
+            {
+                emit(received(receiveMoviePackets(mh)));
+            }
             else if(mh.type == MESSAGE_TYPE_QUIT)
             {
                 QApplication::instance()->quit();
@@ -283,6 +288,36 @@ void MPIChannel::send(OptionsPtr options)
     MPI_Bcast((void *)serializedString.data(), size, MPI_BYTE, 0, MPI_COMM_WORLD);
 }
 
+void MPIChannel::send(MoviePacketsPtr packets)
+{
+    if(mpiRank_ != 0)
+    {
+        put_flog(LOG_WARN, "called on rank %i != 0", mpiRank_);
+        return;
+    }
+
+    std::ostringstream oss(std::ostringstream::binary);
+    {
+        // brace this so destructor is called on archive before we use the stream
+        boost::archive::binary_oarchive oa(oss);
+        oa << *packets;
+    }
+
+    const std::string serializedString = oss.str();
+    const int size = serializedString.size();
+
+    MessageHeader mh;
+    mh.size = size;
+    mh.type = MESSAGE_TYPE_MOVIE_PACKETS;
+
+    // Send header via a send so we can probe it on the render processes
+    for(int i=1; i<mpiSize_; ++i)
+        MPI_Send((void *)&mh, sizeof(MessageHeader), MPI_BYTE, i, 0, MPI_COMM_WORLD);
+
+    // Broadcast the message
+    MPI_Bcast((void *)serializedString.data(), size, MPI_BYTE, 0, MPI_COMM_WORLD);
+}
+
 void MPIChannel::sendContentsDimensionsRequest(ContentWindowManagerPtrs contentWindows)
 {
     if(mpiSize_ < 2)
@@ -330,9 +365,12 @@ void MPIChannel::sendContentsDimensionsRequest(ContentWindowManagerPtrs contentW
     boost::archive::binary_iarchive ia(iss);
     ia >> dimensions;
 
-    // overwrite old dimensions
+    // overwrite old dimensions, unless rank1 does not know them (streamed movies)
     for(size_t i=0; i<dimensions.size() && i<contentWindows.size(); ++i)
-        contentWindows[i]->getContent()->setDimensions(dimensions[i].first, dimensions[i].second);
+    {
+        if(dimensions[i].first > 0 && dimensions[i].second > 0)
+            contentWindows[i]->getContent()->setDimensions(dimensions[i].first, dimensions[i].second);
+    }
 }
 
 void MPIChannel::setFactories(FactoriesPtr factories)
@@ -622,3 +660,33 @@ void MPIChannel::receivePixelStreams(const MessageHeader& messageHeader)
 
     emit received(frame);
 }
+
+MoviePacketsPtr MPIChannel::receiveMoviePackets(const MessageHeader& messageHeader)
+{
+    if(mpiRank_ < 1)
+    {
+        put_flog(LOG_WARN, "called on rank %i < 1", mpiRank_);
+        return MoviePacketsPtr();
+    }
+
+    // receive serialized data
+    std::vector<char> buffer(messageHeader.size);
+
+    // read message into the buffer
+    MPI_Bcast((void *)buffer.data(), messageHeader.size, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    // de-serialize...
+    std::istringstream iss(std::istringstream::binary);
+
+    if(iss.rdbuf()->pubsetbuf(buffer.data(), messageHeader.size) == NULL)
+    {
+        put_flog(LOG_FATAL, "rank %i: error setting stream buffer", mpiRank_);
+        return MoviePacketsPtr();
+    }
+
+    boost::archive::binary_iarchive ia(iss);
+    MoviePacketsPtr packets(new MoviePackets);
+    ia >> *packets;
+
+    return packets;
+}
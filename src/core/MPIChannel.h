@@ -93,6 +93,7 @@ public:
      * Will emit a signal if an object was reveived.
      * @see received(DisplayGroupManagerPtr)
      * @see received(OptionsPtr)
+     * @see received(MoviePacketsPtr)
      */
     void receiveMessages();
 
@@ -136,6 +137,12 @@ public slots:
      */
     void send(PixelStreamFramePtr frame);
 
+    /**
+     * Rank 0: Send compressed movie packets to ranks 1-N
+     * @param packets The packets to send
+     */
+    void send(MoviePacketsPtr packets);
+
 signals:
     /**
      * Rank 1-N: Emitted when a displayGroup was recieved
@@ -158,6 +165,13 @@ signals:
      */
     void received(PixelStreamFramePtr frame);
 
+    /**
+     * Rank 1-N: Emitted when new movie packets were recieved
+     * @see receiveMessages()
+     * @param packets The packets that were received
+     */
+    void received(MoviePacketsPtr packets);
+
 private:
     int mpiRank_;
     int mpiSize_;
@@ -173,6 +187,7 @@ private:
     DisplayGroupManagerPtr receiveDisplayGroup(const MessageHeader& messageHeader);
     OptionsPtr receiveOptions(const MessageHeader& messageHeader);
     void receivePixelStreams(const MessageHeader& messageHeader);
+    MoviePacketsPtr receiveMoviePackets(const MessageHeader& messageHeader);
 
     // TODO remove content dimension requests (DISCL-21)
     void receiveContentsDimensionsRequest();
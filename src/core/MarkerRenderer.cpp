@@ -53,36 +53,41 @@
 
 MarkerRenderer::MarkerRenderer()
 {
+    quads_.setEnableTexture(true);
 }
 
-void MarkerRenderer::render(MarkerPtr marker)
+void MarkerRenderer::render(const MarkerPtrs& markers)
 {
-    if (!texture_.isValid() && !generateTexture())
-        return;
-
-    float x, y;
-    marker->getPosition(x, y);
+    quads_.clear();
 
     // marker height needs to be scaled by the tiled display aspect ratio
     const float tiledDisplayAspect = g_configuration->getAspectRatio();
     const float markerHeight = MARKER_WIDTH * tiledDisplayAspect;
 
+    for(MarkerPtrs::const_iterator it = markers.begin(); it != markers.end(); ++it)
+    {
+        // only render recently active markers
+        if(!(*it)->isActive())
+            continue;
+
+        float x, y;
+        (*it)->getPosition(x, y);
+
+        quads_.append(QRectF(x - 0.5f*MARKER_WIDTH, y - 0.5f*markerHeight,
+                             MARKER_WIDTH, markerHeight));
+    }
+
+    if (quads_.isEmpty() || (!texture_.isValid() && !generateTexture()))
+        return;
+
     glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
 
     glDisable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glPushMatrix();
-
-    glTranslatef(x, y, 0);
-    glScalef(MARKER_WIDTH, markerHeight, 1.f);
-    glTranslatef(-0.5f*MARKER_WIDTH, -0.5f*markerHeight, 0); // Center unit quad
-
     texture_.bind();
-    quad_.render();
-
-    glPopMatrix();
+    quads_.render();
 
     glPopAttrib();
 }
@@ -42,7 +42,7 @@
 
 #include "types.h"
 #include "GLTexture2D.h"
-#include "GLQuad.h"
+#include "GLQuadBatch.h"
 
 /**
  * Renderer for Marker objects.
@@ -53,12 +53,15 @@ public:
     /** Constructor */
     MarkerRenderer();
 
-    /** Render a Marker */
-    void render(MarkerPtr marker);
+    /**
+     * Render the active Markers.
+     * All the markers share the same texture and are drawn in a single call.
+     */
+    void render(const MarkerPtrs& markers);
 
 private:
     GLTexture2D texture_;
-    GLQuad quad_;
+    GLQuadBatch quads_;
 
     bool generateTexture();
 };
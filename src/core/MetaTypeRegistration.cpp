@@ -60,6 +60,7 @@ struct MetaTypeRegistration
         qRegisterMetaType<ContentWindowManagerPtr>("ContentWindowManagerPtr");
         qRegisterMetaType<PixelStreamSegment>("PixelStreamSegment");
         qRegisterMetaType<PixelStreamFramePtr>("PixelStreamFramePtr");
+        qRegisterMetaType<MoviePacketsPtr>("MoviePacketsPtr");
         qRegisterMetaType<ContentWindowInterface::WindowState>("ContentWindowInterface::WindowState");
 #if ENABLE_SKELETON_SUPPORT
         qRegisterMetaType<SkeletonStatePtrs("SkeletonStatePtrs");
@@ -39,9 +39,13 @@
 #include "Movie.h"
 
 #include "FFMPEGMovie.h"
+#include "RenderContext.h"
+#include "GLWindow.h"
+#include "globals.h"
+#include "configuration/Configuration.h"
 
 Movie::Movie(QString uri)
-    : ffmpegMovie_(new FFMPEGMovie(uri))
+    : ffmpegMovie_(new FFMPEGMovie(uri, g_configuration->getStreamMoviesFromMaster()))
     , uri_(uri)
     , paused_(false)
 {}
@@ -59,13 +63,28 @@ void Movie::getDimensions(int &width, int &height) const
 
 void Movie::nextFrame(const boost::posix_time::time_duration timeSinceLastFrame, const bool skipDecoding)
 {
-    if(paused_)
-        return;
+    // Only decode the part of the movie visible on this process
+    if(!visibleRegion_.isEmpty())
+        ffmpegMovie_->setVisibleRegion(visibleRegion_);
+    visibleRegion_ = QRectF();
 
-    ffmpegMovie_->update(timeSinceLastFrame, skipDecoding);
+    // A paused movie decodes its current frame again if the visible region grows
+    if(paused_)
+    {
+        if(skipDecoding)
+            return;
+        ffmpegMovie_->refreshFrame();
+    }
+    else
+        ffmpegMovie_->update(timeSinceLastFrame, skipDecoding);
 
     if (ffmpegMovie_->isNewFrameAvailable())
-        texture_.update(ffmpegMovie_->getData(), GL_RGBA);
+        texture_.update(ffmpegMovie_->getData(), ffmpegMovie_->getDataRegion(), GL_RGBA);
+}
+
+void Movie::addPackets(const MoviePackets& packets)
+{
+    ffmpegMovie_->addPackets(packets);
 }
 
 bool Movie::generateTexture()
@@ -76,8 +95,32 @@ bool Movie::generateTexture()
     return texture_.init(image);
 }
 
+void Movie::finishLoading()
+{
+    if(!texture_.isValid() && ffmpegMovie_->isValid())
+        generateTexture();
+}
+
+size_t Movie::getHostMemoryUsage() const
+{
+    if(!ffmpegMovie_->isValid())
+        return 0;
+
+    // Decoded RGBA frame buffers
+    return ffmpegMovie_->getMemoryUsage();
+}
+
+size_t Movie::getGPUMemoryUsage() const
+{
+    return texture_.getMemoryUsage();
+}
+
 void Movie::render(const QRectF& texCoords)
 {
+    // Streamed movies are only valid once their first packets are received
+    if(!ffmpegMovie_->isValid())
+        return;
+
     if(!texture_.isValid() && !generateTexture())
         return;
 
@@ -89,6 +132,26 @@ void Movie::render(const QRectF& texCoords)
     quad_.render();
 
     glPopAttrib();
+
+    addVisibleRegion(texCoords);
+}
+
+void Movie::addVisibleRegion(const QRectF& texCoords)
+{
+    GLWindowPtr glWindow = getRenderContext()->getActiveGLWindow();
+    const QRectF windowRect = glWindow->getProjectedPixelRect(false);
+    const QRectF visibleRect = glWindow->getProjectedPixelRect(true);
+
+    if(windowRect.isEmpty() || visibleRect.isEmpty())
+        return;
+
+    // The part of the texture shown in the visible part of the window
+    const QRectF region(texCoords.x() + (visibleRect.x() - windowRect.x()) / windowRect.width() * texCoords.width(),
+                        texCoords.y() + (visibleRect.y() - windowRect.y()) / windowRect.height() * texCoords.height(),
+                        visibleRect.width() / windowRect.width() * texCoords.width(),
+                        visibleRect.height() / windowRect.height() * texCoords.height());
+
+    visibleRegion_ |= region.intersected(QRectF(0., 0., 1., 1.));
 }
 
 void Movie::setPause(const bool pause)
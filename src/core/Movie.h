@@ -46,6 +46,7 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 class FFMPEGMovie;
+struct MoviePackets;
 
 class Movie : public FactoryObject
 {
@@ -55,10 +56,14 @@ public:
 
     void getDimensions(int &width, int &height) const override;
     void render(const QRectF& texCoords) override;
+    void finishLoading() override;
+    size_t getHostMemoryUsage() const override;
+    size_t getGPUMemoryUsage() const override;
 
     void nextFrame(const boost::posix_time::time_duration timeSinceLastFrame, const bool skipDecoding);
     void setPause(const bool pause);
     void setLoop(const bool loop);
+    void addPackets(const MoviePackets& packets);
 
 private:
     FFMPEGMovie* ffmpegMovie_;
@@ -69,7 +74,11 @@ private:
 
     bool paused_;
 
+    // Union of the parts of the movie rendered in the current frame
+    QRectF visibleRegion_;
+
     bool generateTexture();
+    void addVisibleRegion(const QRectF& texCoords);
 };
 
 #endif
@@ -73,13 +73,20 @@ const QStringList& MovieContent::getSupportedExtensions()
 
 void MovieContent::advance(FactoriesPtr factories, ContentWindowManagerPtr window, const boost::posix_time::time_duration timeSinceLastFrame)
 {
+    // The playback position of a Movie starts when it is created. It is created
+    // synchronously by all processes in the same frame and kept alive while
+    // its window is open, including where it is culled, so that all processes
+    // play it at the same position.
+    boost::shared_ptr< Movie > movie =
+            boost::static_pointer_cast< Movie >( factories->getFactoryObject( window->getContent( )));
+    if( !movie )
+        return;
+
     // Stop decoding when the window is moving to avoid saccades when reaching a new GLWindow
     // The decoding resumes when the movement is finished
     if( blockAdvance_ )
         return;
 
-    boost::shared_ptr< Movie > movie = factories->getMovieFactory().getObject(getURI());
-
     // skip a frame if the Content rectangle is not visible in any window; otherwise decode normally
     const bool skipDecoding = !movie->getRenderContext()->isRegionVisible(window->getCoordinates());
 
@@ -0,0 +1,215 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "MovieFrameQueue.h"
+
+MovieFrameQueue::MovieFrameQueue(const size_t frameBytes, const size_t capacity)
+    : frames_(capacity + 2) // Including the current frame and the frame being decoded
+    , currentFrame_(-1)
+    , writeFrame_(-1)
+    , position_(0.0)
+    , seekPending_(false)
+    , endOfStream_(false)
+    , stopped_(false)
+    , generation_(0)
+    , decoderGeneration_(0)
+{
+    for(size_t i = 0; i < frames_.size(); ++i)
+    {
+        frames_[i].data.resize(frameBytes);
+        frames_[i].timestamp = 0.0;
+        freeFrames_.push_back(i);
+    }
+}
+
+bool MovieFrameQueue::update(const double position)
+{
+    QMutexLocker locker(&mutex_);
+
+    position_ = position;
+
+    bool changed = false;
+    while(!queue_.empty() && frames_[queue_.front()].timestamp <= position)
+    {
+        releaseFrame(currentFrame_);
+        currentFrame_ = queue_.front();
+        queue_.pop_front();
+        changed = true;
+    }
+
+    if(changed)
+        requestCondition_.wakeAll();
+
+    return changed;
+}
+
+const uint8_t* MovieFrameQueue::getCurrentFrame() const
+{
+    QMutexLocker locker(&mutex_);
+    return currentFrame_ < 0 ? 0 : &frames_[currentFrame_].data[0];
+}
+
+void MovieFrameQueue::seek(const double position)
+{
+    QMutexLocker locker(&mutex_);
+
+    while(!queue_.empty())
+    {
+        releaseFrame(queue_.front());
+        queue_.pop_front();
+    }
+
+    position_ = position;
+    seekPending_ = true;
+    endOfStream_ = false;
+    ++generation_;
+
+    requestCondition_.wakeAll();
+}
+
+bool MovieFrameQueue::isEndOfStream() const
+{
+    QMutexLocker locker(&mutex_);
+    return endOfStream_ && !seekPending_ && queue_.empty();
+}
+
+void MovieFrameQueue::stop()
+{
+    QMutexLocker locker(&mutex_);
+    stopped_ = true;
+    requestCondition_.wakeAll();
+}
+
+MovieFrameQueue::Request MovieFrameQueue::waitForRequest(double& seekPosition)
+{
+    QMutexLocker locker(&mutex_);
+
+    while(!stopped_ && !seekPending_ &&
+          (endOfStream_ || (writeFrame_ < 0 && freeFrames_.empty())))
+    {
+        requestCondition_.wait(&mutex_);
+    }
+
+    if(stopped_)
+        return STOP;
+
+    if(seekPending_)
+    {
+        seekPending_ = false;
+        decoderGeneration_ = generation_;
+        seekPosition = position_;
+        return SEEK;
+    }
+
+    // The buffer is kept if the previous frame was not pushed
+    if(writeFrame_ < 0)
+    {
+        writeFrame_ = freeFrames_.back();
+        freeFrames_.pop_back();
+    }
+    return DECODE;
+}
+
+uint8_t* MovieFrameQueue::getWriteBuffer()
+{
+    QMutexLocker locker(&mutex_);
+    return writeFrame_ < 0 ? 0 : &frames_[writeFrame_].data[0];
+}
+
+QRect MovieFrameQueue::getCurrentFrameRegion() const
+{
+    QMutexLocker locker(&mutex_);
+    return currentFrame_ < 0 ? QRect() : frames_[currentFrame_].region;
+}
+
+double MovieFrameQueue::getCurrentFrameTimestamp() const
+{
+    QMutexLocker locker(&mutex_);
+    return currentFrame_ < 0 ? 0.0 : frames_[currentFrame_].timestamp;
+}
+
+double MovieFrameQueue::getPosition() const
+{
+    QMutexLocker locker(&mutex_);
+    return position_;
+}
+
+void MovieFrameQueue::push(const double timestamp, const QRect& region)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(writeFrame_ < 0)
+        return;
+
+    // The frame was decoded before a seek that has not been processed yet
+    if(decoderGeneration_ != generation_)
+    {
+        releaseFrame(writeFrame_);
+        return;
+    }
+
+    frames_[writeFrame_].timestamp = timestamp;
+    frames_[writeFrame_].region = region;
+    queue_.push_back(writeFrame_);
+    writeFrame_ = -1;
+}
+
+void MovieFrameQueue::setEndOfStream()
+{
+    QMutexLocker locker(&mutex_);
+
+    releaseFrame(writeFrame_);
+
+    if(decoderGeneration_ == generation_)
+        endOfStream_ = true;
+}
+
+size_t MovieFrameQueue::getMemoryUsage() const
+{
+    return frames_.size() * (frames_.empty() ? 0 : frames_[0].data.size());
+}
+
+void MovieFrameQueue::releaseFrame(int& index)
+{
+    if(index < 0)
+        return;
+
+    freeFrames_.push_back(index);
+    index = -1;
+}
@@ -0,0 +1,172 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef MOVIEFRAMEQUEUE_H
+#define MOVIEFRAMEQUEUE_H
+
+#include <QMutex>
+#include <QRect>
+#include <QWaitCondition>
+
+#include <boost/noncopyable.hpp>
+#include <deque>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A ring of decoded movie frames, filled ahead of time by a decoding thread
+ * and consumed by the render thread.
+ *
+ * The decoding thread waits for requests with waitForRequest(), converts
+ * each frame into getWriteBuffer() and commits it with push(). The render
+ * thread selects the frame matching the playback position with update().
+ * The current frame stays valid until the next call to update(), the
+ * decoding thread never writes into it.
+ *
+ * A seek() discards the queued frames. Frames pushed by the decoding thread
+ * before it has processed the seek request are dropped.
+ */
+class MovieFrameQueue : public boost::noncopyable
+{
+public:
+    /** The requests for the decoding thread. */
+    enum Request
+    {
+        DECODE,  // Decode the next frame into getWriteBuffer()
+        SEEK,    // Move to the given position
+        STOP     // Exit the decoding thread
+    };
+
+    /**
+     * Constructor.
+     * @param frameBytes The size of a converted frame, in bytes.
+     * @param capacity The maximum number of frames decoded ahead.
+     */
+    MovieFrameQueue(const size_t frameBytes, const size_t capacity);
+
+    /**
+     * Select the most recent frame whose timestamp is before the position.
+     * Older frames are discarded. Call from the render thread.
+     * @param position The playback position, in seconds.
+     * @return true if the current frame changed.
+     */
+    bool update(const double position);
+
+    /** @return The current frame, null until the first frame is selected. */
+    const uint8_t* getCurrentFrame() const;
+
+    /** @return The region of the movie stored in the current frame. */
+    QRect getCurrentFrameRegion() const;
+
+    /** @return The timestamp of the current frame, in seconds. */
+    double getCurrentFrameTimestamp() const;
+
+    /**
+     * Discard the queued frames and restart decoding from a new position.
+     * The current frame is kept until a new frame is selected.
+     * @param position The new playback position, in seconds.
+     */
+    void seek(const double position);
+
+    /** @return true if all the frames until the end of the movie were consumed. */
+    bool isEndOfStream() const;
+
+    /** Make the decoding thread exit. */
+    void stop();
+
+    /**
+     * Wait for the next request. Call from the decoding thread.
+     * @param seekPosition Set to the requested position on SEEK.
+     * @return The request.
+     */
+    Request waitForRequest(double& seekPosition);
+
+    /** @return The buffer to decode into after a DECODE request. */
+    uint8_t* getWriteBuffer();
+
+    /**
+     * @return The last playback position, in seconds. Frames older than
+     *         this position are not going to be displayed.
+     */
+    double getPosition() const;
+
+    /**
+     * Commit the frame written in getWriteBuffer().
+     * @param timestamp The timestamp of the frame, in seconds.
+     * @param region The region of the movie written in the buffer, which
+     *        may contain only the part of the frame that is visible.
+     */
+    void push(const double timestamp, const QRect& region);
+
+    /** Signal that the decoding thread reached the end of the movie. */
+    void setEndOfStream();
+
+    /** @return The memory used by the frame buffers, in bytes. */
+    size_t getMemoryUsage() const;
+
+private:
+    struct Frame
+    {
+        std::vector<uint8_t> data;
+        double timestamp;
+        QRect region;
+    };
+    std::vector<Frame> frames_;
+
+    mutable QMutex mutex_;
+    QWaitCondition requestCondition_;
+
+    std::deque<int> queue_; // Decoded frames, ordered by timestamp
+    std::vector<int> freeFrames_;
+    int currentFrame_; // Owned by the render thread, -1 if none
+    int writeFrame_; // Owned by the decoding thread, -1 if none
+
+    double position_;
+    bool seekPending_;
+    bool endOfStream_;
+    bool stopped_;
+
+    // Incremented by seek() to drop the frames decoded before the seek
+    unsigned int generation_;
+    unsigned int decoderGeneration_;
+
+    void releaseFrame(int& index);
+};
+
+#endif // MOVIEFRAMEQUEUE_H
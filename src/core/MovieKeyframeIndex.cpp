@@ -0,0 +1,300 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "MovieKeyframeIndex.h"
+
+#include "FFMPEGMovie.h"
+
+#include "log.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostInfo>
+
+#include <algorithm>
+
+#define INDEX_MAGIC       "DCKEYIX1"
+#define INDEX_MAGIC_SIZE  8
+#define INDEX_VERSION     1
+
+#define INDEX_CACHE_FOLDER "movieindex"
+
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+namespace
+{
+bool comparePts(const int64_t pts, const MovieKeyframeIndex::Keyframe& keyframe)
+{
+    return pts < keyframe.pts;
+}
+}
+
+MovieKeyframeIndex::MovieKeyframeIndex()
+    : ready_(false)
+    , aborted_(false)
+{
+}
+
+bool MovieKeyframeIndex::loadOrBuild(const QString& uri, const int streamIndex)
+{
+    const QString filename = getCacheFilename(uri);
+
+    if(load(filename, uri, streamIndex))
+        return true;
+
+    if(!build(uri, streamIndex))
+        return false;
+
+    if(!save(filename, uri, streamIndex))
+        put_flog(LOG_WARN, "could not save keyframe index: %s", filename.toLocal8Bit().constData());
+    return true;
+}
+
+bool MovieKeyframeIndex::build(const QString& uri, const int streamIndex)
+{
+    FFMPEGMovie::initGlobalState();
+
+    // Use a separate context, the decoder keeps reading from its own
+    AVFormatContext* avFormatContext = 0;
+    if(avformat_open_input(&avFormatContext, uri.toAscii(), NULL, NULL) != 0)
+    {
+        put_flog(LOG_ERROR, "could not open movie file %s", uri.toLocal8Bit().constData());
+        return false;
+    }
+
+    if(avformat_find_stream_info(avFormatContext, NULL) < 0 ||
+       streamIndex < 0 || streamIndex >= (int)avFormatContext->nb_streams)
+    {
+        put_flog(LOG_ERROR, "could not find video stream %i", streamIndex);
+        avformat_close_input(&avFormatContext);
+        return false;
+    }
+
+    AVPacket packet;
+    av_init_packet(&packet);
+
+    // Only the packet headers are used, the packets are not decoded
+    int avReadStatus = 0;
+    while(!isAborted() && (avReadStatus = av_read_frame(avFormatContext, &packet)) >= 0)
+    {
+        if(packet.stream_index == streamIndex && (packet.flags & AV_PKT_FLAG_KEY))
+        {
+            Keyframe keyframe;
+            keyframe.dts = packet.dts;
+            keyframe.pts = (packet.pts != (int64_t)AV_NOPTS_VALUE) ? packet.pts : packet.dts;
+            keyframe.position = packet.pos;
+
+            if(keyframe.pts != (int64_t)AV_NOPTS_VALUE)
+                addKeyframe(keyframe);
+        }
+        av_free_packet(&packet);
+    }
+
+    avformat_close_input(&avFormatContext);
+
+    if(isAborted() || avReadStatus != AVERROR_EOF)
+        return false;
+
+    setReady();
+    put_flog(LOG_DEBUG, "indexed %i keyframes in %s", (int)getKeyframeCount(),
+             uri.toLocal8Bit().constData());
+    return true;
+}
+
+bool MovieKeyframeIndex::load(const QString& filename, const QString& uri, const int streamIndex)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QFileInfo movieFile(uri);
+
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    char magic[INDEX_MAGIC_SIZE];
+    if(in.readRawData(magic, INDEX_MAGIC_SIZE) != INDEX_MAGIC_SIZE ||
+       QByteArray(magic, INDEX_MAGIC_SIZE) != QByteArray(INDEX_MAGIC))
+        return false;
+
+    quint32 version = 0, stream = 0;
+    qint64 movieSize = 0, movieModified = 0, count = 0;
+    in >> version >> stream >> movieSize >> movieModified >> count;
+
+    if(in.status() != QDataStream::Ok || version != INDEX_VERSION ||
+       (int)stream != streamIndex || movieSize != movieFile.size() ||
+       movieModified != movieFile.lastModified().toMSecsSinceEpoch() ||
+       count < 0 || count * 3 * sizeof(qint64) > (quint64)file.size())
+        return false;
+
+    std::vector<Keyframe> keyframes(count);
+    for(qint64 i = 0; i < count; ++i)
+    {
+        qint64 pts, dts, position;
+        in >> pts >> dts >> position;
+        keyframes[i].pts = pts;
+        keyframes[i].dts = dts;
+        keyframes[i].position = position;
+    }
+
+    if(in.status() != QDataStream::Ok)
+        return false;
+
+    QMutexLocker locker(&mutex_);
+    keyframes_.swap(keyframes);
+    ready_ = true;
+    return true;
+}
+
+bool MovieKeyframeIndex::save(const QString& filename, const QString& uri, const int streamIndex) const
+{
+    const QFileInfo movieFile(uri);
+    if(!movieFile.exists())
+        return false;
+
+    QDir().mkpath(QFileInfo(filename).absolutePath());
+
+    // Written aside, other processes may be reading the same index. The cache
+    // folder may be shared by several hosts, which can have the same PIDs.
+    const QString tmpFilename = filename + QString(".%1.%2.tmp").arg(QHostInfo::localHostName())
+                                                               .arg(QCoreApplication::applicationPid());
+    QFile file(tmpFilename);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData(INDEX_MAGIC, INDEX_MAGIC_SIZE);
+    {
+        QMutexLocker locker(&mutex_);
+
+        out << quint32(INDEX_VERSION) << quint32(streamIndex)
+            << qint64(movieFile.size()) << qint64(movieFile.lastModified().toMSecsSinceEpoch())
+            << qint64(keyframes_.size());
+
+        for(size_t i = 0; i < keyframes_.size(); ++i)
+            out << qint64(keyframes_[i].pts) << qint64(keyframes_[i].dts) << qint64(keyframes_[i].position);
+    }
+    file.close();
+
+    if(out.status() != QDataStream::Ok || file.error() != QFile::NoError)
+    {
+        QFile::remove(tmpFilename);
+        return false;
+    }
+
+    // Another process may have written the index in the meantime
+    QFile::remove(filename);
+    if(!QFile::rename(tmpFilename, filename))
+    {
+        QFile::remove(tmpFilename);
+        return false;
+    }
+    return true;
+}
+
+void MovieKeyframeIndex::abort()
+{
+    QMutexLocker locker(&mutex_);
+    aborted_ = true;
+}
+
+bool MovieKeyframeIndex::isAborted() const
+{
+    QMutexLocker locker(&mutex_);
+    return aborted_;
+}
+
+bool MovieKeyframeIndex::isReady() const
+{
+    QMutexLocker locker(&mutex_);
+    return ready_;
+}
+
+void MovieKeyframeIndex::addKeyframe(const Keyframe& keyframe)
+{
+    QMutexLocker locker(&mutex_);
+    keyframes_.push_back(keyframe);
+}
+
+void MovieKeyframeIndex::setReady()
+{
+    QMutexLocker locker(&mutex_);
+    ready_ = true;
+}
+
+bool MovieKeyframeIndex::findKeyframe(const int64_t pts, Keyframe& keyframe) const
+{
+    QMutexLocker locker(&mutex_);
+
+    if(!ready_)
+        return false;
+
+    // The keyframes are never reordered, their pts increase with the dts
+    std::vector<Keyframe>::const_iterator it =
+            std::upper_bound(keyframes_.begin(), keyframes_.end(), pts, comparePts);
+    if(it == keyframes_.begin())
+        return false;
+
+    keyframe = *(--it);
+    return true;
+}
+
+size_t MovieKeyframeIndex::getKeyframeCount() const
+{
+    QMutexLocker locker(&mutex_);
+    return keyframes_.size();
+}
+
+QString MovieKeyframeIndex::getCacheFilename(const QString& uri)
+{
+    const QString path = QFileInfo(uri).absoluteFilePath();
+    const QByteArray hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5);
+
+    const QDir cacheDir(QDesktopServices::storageLocation(QDesktopServices::CacheLocation));
+    return cacheDir.absoluteFilePath(QString("%1/%2.idx").arg(INDEX_CACHE_FOLDER)
+                                     .arg(QString(hash.toHex())));
+}
@@ -0,0 +1,159 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef MOVIEKEYFRAMEINDEX_H
+#define MOVIEKEYFRAMEINDEX_H
+
+#include <QMutex>
+#include <QString>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <stdint.h>
+#include <vector>
+
+class MovieKeyframeIndex;
+typedef boost::shared_ptr<MovieKeyframeIndex> MovieKeyframeIndexPtr;
+
+/**
+ * The keyframes of the video stream of a movie file.
+ *
+ * Seeking with the timestamp of a keyframe lands exactly on the group of
+ * pictures containing the target position, which avoids the approximate
+ * seeking of some demuxers and the decoding of unneeded groups.
+ *
+ * The index is built by reading the packet headers of the whole file, which
+ * is done once in the background. It is then saved in a cache directory:
+ * - header: magic "DCKEYIX1", then version and stream index as little endian
+ *   32 bit integers, then the size and modification time of the movie file
+ *   and the keyframe count as little endian 64 bit integers;
+ * - for each keyframe, its presentation and decoding timestamps and its byte
+ *   position in the file as little endian 64 bit integers.
+ * An index is discarded when the movie file was modified since it was saved.
+ */
+class MovieKeyframeIndex : public boost::noncopyable
+{
+public:
+    /** A keyframe of the video stream. */
+    struct Keyframe
+    {
+        /** Presentation timestamp, in the stream time base. */
+        int64_t pts;
+        /** Decoding timestamp, in the stream time base. */
+        int64_t dts;
+        /** Position in the file, in bytes. */
+        int64_t position;
+    };
+
+    /** Constructor. */
+    MovieKeyframeIndex();
+
+    /**
+     * Load the index of a movie from the cache, or build it if needed.
+     * @param uri The movie file.
+     * @param streamIndex The index of the video stream in the file.
+     * @return true if the index is complete.
+     */
+    bool loadOrBuild(const QString& uri, const int streamIndex);
+
+    /**
+     * Build the index by reading the file.
+     * @param uri The movie file.
+     * @param streamIndex The index of the video stream in the file.
+     * @return true if the whole file was read.
+     */
+    bool build(const QString& uri, const int streamIndex);
+
+    /**
+     * Load the index from a file.
+     * @param filename The index file.
+     * @param uri The movie file, which must not have changed since save().
+     * @param streamIndex The index of the video stream in the movie file.
+     * @return true on success.
+     */
+    bool load(const QString& filename, const QString& uri, const int streamIndex);
+
+    /**
+     * Save the index to a file.
+     * @param filename The index file.
+     * @param uri The movie file.
+     * @param streamIndex The index of the video stream in the movie file.
+     * @return true on success.
+     */
+    bool save(const QString& filename, const QString& uri, const int streamIndex) const;
+
+    /** Interrupt a build() running in another thread. */
+    void abort();
+
+    /** @return true once the index is complete. */
+    bool isReady() const;
+
+    /** Append a keyframe. Keyframes must be added in decoding order. */
+    void addKeyframe(const Keyframe& keyframe);
+
+    /** Mark the index as complete. */
+    void setReady();
+
+    /**
+     * Find the last keyframe presented before a timestamp.
+     * @param pts The presentation timestamp, in the stream time base.
+     * @param keyframe Set to the keyframe.
+     * @return false if the index is not ready or if no keyframe precedes pts.
+     */
+    bool findKeyframe(const int64_t pts, Keyframe& keyframe) const;
+
+    /** @return The number of keyframes. */
+    size_t getKeyframeCount() const;
+
+    /**
+     * Get the file in which the index of a movie is cached.
+     * @param uri The movie file.
+     */
+    static QString getCacheFilename(const QString& uri);
+
+private:
+    mutable QMutex mutex_;
+    std::vector<Keyframe> keyframes_;
+    bool ready_;
+    bool aborted_;
+
+    bool isAborted() const;
+};
+
+#endif // MOVIEKEYFRAMEINDEX_H
@@ -0,0 +1,164 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "MoviePacketQueue.h"
+
+#include <algorithm>
+
+MoviePacketQueue::MoviePacketQueue()
+    : next_(0)
+    , loop_(0)
+    , discontinuity_(false)
+{
+}
+
+void MoviePacketQueue::push(const std::vector<MoviePacket>& packets)
+{
+    QMutexLocker locker(&mutex_);
+
+    for(size_t i = 0; i < packets.size(); ++i)
+    {
+        if(packets[i].loop >= loop_)
+            packets_.push_back(packets[i]);
+    }
+
+    if(!packets_.empty())
+        condition_.wakeAll();
+}
+
+void MoviePacketQueue::setLoop(const uint32_t loop)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(loop == loop_)
+        return;
+
+    loop_ = loop;
+    dropPreviousLoops();
+
+    // The decoder continues with the first keyframe of the new loop
+    discontinuity_ = true;
+}
+
+void MoviePacketQueue::trim(const double position)
+{
+    QMutexLocker locker(&mutex_);
+
+    // Find the last keyframe of the current loop before the position
+    size_t keyframe = 0;
+    for(size_t i = 0; i < packets_.size(); ++i)
+    {
+        const MoviePacket& packet = packets_[i];
+        if(packet.loop != loop_ || packet.timestamp > position)
+            break;
+        if(packet.keyframe)
+            keyframe = i;
+    }
+
+    if(keyframe == 0)
+        return;
+
+    // Only dropping packets that were not popped yet breaks the decoding
+    if(next_ < keyframe)
+        discontinuity_ = true;
+    next_ = std::max(next_, keyframe) - keyframe;
+
+    packets_.erase(packets_.begin(), packets_.begin() + keyframe);
+}
+
+bool MoviePacketQueue::pop(MoviePacket& packet, bool& discontinuity, const unsigned long timeoutMs)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(!hasPacket())
+        condition_.wait(&mutex_, timeoutMs);
+
+    if(!hasPacket())
+        return false;
+
+    packet = packets_[next_++];
+
+    discontinuity = discontinuity_;
+    discontinuity_ = false;
+    return true;
+}
+
+void MoviePacketQueue::rewind()
+{
+    QMutexLocker locker(&mutex_);
+
+    next_ = 0;
+    discontinuity_ = true;
+}
+
+bool MoviePacketQueue::isEndOfLoop() const
+{
+    QMutexLocker locker(&mutex_);
+    return next_ < packets_.size() && packets_[next_].loop > loop_;
+}
+
+size_t MoviePacketQueue::getSize() const
+{
+    QMutexLocker locker(&mutex_);
+    return packets_.size() - next_;
+}
+
+void MoviePacketQueue::dropPreviousLoops()
+{
+    const size_t next = next_;
+    size_t index = 0; // In the queue before the erasures
+    std::deque<MoviePacket>::iterator it = packets_.begin();
+    while(it != packets_.end())
+    {
+        if(it->loop < loop_)
+        {
+            if(index < next)
+                --next_;
+            it = packets_.erase(it);
+        }
+        else
+            ++it;
+        ++index;
+    }
+}
+
+bool MoviePacketQueue::hasPacket() const
+{
+    return next_ < packets_.size() && packets_[next_].loop == loop_;
+}
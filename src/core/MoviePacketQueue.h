@@ -0,0 +1,127 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef MOVIEPACKETQUEUE_H
+#define MOVIEPACKETQUEUE_H
+
+#include "MoviePackets.h"
+
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <boost/noncopyable.hpp>
+#include <deque>
+
+/**
+ * The compressed packets of a movie received from the master application,
+ * waiting to be decoded.
+ *
+ * The packets are pushed by the render thread and popped by the decoding
+ * thread. The queue only keeps the packets which are needed to decode the
+ * frames after the playback position: packets of the previous loops of the
+ * movie and packets preceding the last keyframe before the position are
+ * dropped. The decoder is notified of the dropped packets to restart from
+ * the next keyframe.
+ *
+ * The popped packets are kept until they are trimmed, so that the decoder
+ * can rewind() to the last keyframe and decode the current frame again.
+ */
+class MoviePacketQueue : public boost::noncopyable
+{
+public:
+    /** Constructor. */
+    MoviePacketQueue();
+
+    /**
+     * Append packets to the queue.
+     * @param packets The packets, ordered by decoding timestamp.
+     */
+    void push(const std::vector<MoviePacket>& packets);
+
+    /**
+     * Start a new loop of the movie, dropping the packets of the previous loops.
+     * @param loop The number of times the movie was restarted.
+     */
+    void setLoop(const uint32_t loop);
+
+    /**
+     * Drop the packets which are not needed to decode the frames following
+     * a playback position.
+     * @param position The playback position in the current loop, in seconds.
+     */
+    void trim(const double position);
+
+    /**
+     * Pop the next packet of the current loop.
+     * The packets of the following loops are kept until setLoop() is called.
+     * @param packet Set to the next packet.
+     * @param discontinuity Set to true if packets were dropped since the
+     *        previous call, in which case the decoder must be flushed.
+     * @param timeoutMs The maximum time to wait for a packet.
+     * @return false if no packet was available before the timeout.
+     */
+    bool pop(MoviePacket& packet, bool& discontinuity, const unsigned long timeoutMs);
+
+    /**
+     * Pop the packets again from the first packet kept, which is the last
+     * keyframe before the position given to trim().
+     * The next call to pop() reports a discontinuity.
+     */
+    void rewind();
+
+    /** @return true if all the packets of the current loop were popped. */
+    bool isEndOfLoop() const;
+
+    /** @return The number of packets in the queue which were not popped. */
+    size_t getSize() const;
+
+private:
+    mutable QMutex mutex_;
+    QWaitCondition condition_;
+
+    std::deque<MoviePacket> packets_;
+    size_t next_; // Index of the next packet to pop
+    uint32_t loop_;
+    bool discontinuity_;
+
+    void dropPreviousLoops();
+    bool hasPacket() const;
+};
+
+#endif // MOVIEPACKETQUEUE_H
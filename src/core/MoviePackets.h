@@ -0,0 +1,153 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef MOVIEPACKETS_H
+#define MOVIEPACKETS_H
+
+#include "serializationHelpers.h"
+
+#include <QString>
+
+#include <boost/serialization/vector.hpp>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * The parameters needed to decode a video stream without opening its file.
+ */
+struct MovieStreamParameters
+{
+    MovieStreamParameters()
+        : codecId(0), codecTag(0), width(0), height(0), pixelFormat(-1),
+          bitsPerCodedSample(0), timeBaseNum(0), timeBaseDen(1),
+          frameRateNum(0), frameRateDen(1), startTime(0), duration(0)
+    {}
+
+    /** @return true if the parameters describe a video stream. */
+    bool isValid() const { return codecId != 0 && width > 0 && height > 0; }
+
+    int32_t codecId;
+    uint32_t codecTag;
+    int32_t width;
+    int32_t height;
+    int32_t pixelFormat;
+    int32_t bitsPerCodedSample;
+    std::vector<uint8_t> extradata;
+    int32_t timeBaseNum;
+    int32_t timeBaseDen;
+    int32_t frameRateNum;
+    int32_t frameRateDen;
+    int64_t startTime;
+    int64_t duration;
+
+    template< class Archive >
+    void serialize( Archive & ar, const unsigned int )
+    {
+        ar & codecId & codecTag & width & height & pixelFormat;
+        ar & bitsPerCodedSample & extradata;
+        ar & timeBaseNum & timeBaseDen & frameRateNum & frameRateDen;
+        ar & startTime & duration;
+    }
+};
+
+/**
+ * A compressed packet of a video stream.
+ */
+struct MoviePacket
+{
+    MoviePacket() : pts(0), dts(0), timestamp(0.0), keyframe(false), loop(0) {}
+
+    /** Presentation and decoding timestamps, in the stream time base. */
+    int64_t pts;
+    int64_t dts;
+
+    /** Presentation time relative to the start of the movie, in seconds. */
+    double timestamp;
+
+    /** The packet can be decoded without the previous ones. */
+    bool keyframe;
+
+    /** Number of times the movie was restarted before this packet. */
+    uint32_t loop;
+
+    /** The compressed data. */
+    std::vector<uint8_t> data;
+
+    template< class Archive >
+    void serialize( Archive & ar, const unsigned int )
+    {
+        ar & pts & dts & timestamp & keyframe & loop & data;
+    }
+};
+
+/**
+ * The packets of a movie demuxed by the master application since the
+ * previous batch, along with the playback position of the master.
+ *
+ * Wall processes decode the packets without opening the movie file.
+ * They all receive the same batch in the same frame, which keeps their
+ * playback positions identical.
+ */
+struct MoviePackets
+{
+    MoviePackets() : position(0.0), loop(0) {}
+
+    /** The movie uri. */
+    QString uri;
+
+    /** The decoding parameters of the stream. */
+    MovieStreamParameters parameters;
+
+    /** Playback position of the master in the current loop, in seconds. */
+    double position;
+
+    /** Number of times the master restarted the movie. */
+    uint32_t loop;
+
+    /** The new packets, ordered by decoding timestamp. */
+    std::vector<MoviePacket> packets;
+
+    template< class Archive >
+    void serialize( Archive & ar, const unsigned int )
+    {
+        ar & uri & parameters & position & loop & packets;
+    }
+};
+
+#endif // MOVIEPACKETS_H
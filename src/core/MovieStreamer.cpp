@@ -0,0 +1,235 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "MovieStreamer.h"
+
+#include "Content.h"
+#include "ContentWindowManager.h"
+#include "DisplayGroupManager.h"
+#include "FFMPEGMovieDemuxer.h"
+#include "MoviePackets.h"
+
+#include "log.h"
+
+#include <boost/foreach.hpp>
+
+// Interval between two dispatches of packets
+#define UPDATE_INTERVAL_MS 20
+
+// The packets are dispatched this long before they are displayed
+#define LOOKAHEAD_SECONDS 1.0
+
+struct MovieStreamer::StreamedMovie
+{
+    StreamedMovie(const QString& uri)
+        : demuxer(uri)
+        , position(0.0)
+        , loop(0)
+        , readLoop(0)
+        , duration(0.0)
+        , lastTimestamp(0.0)
+        , hasNextPacket(false)
+        , endOfFile(false)
+    {}
+
+    FFMPEGMovieDemuxer demuxer;
+
+    // Playback position in the current loop, in seconds
+    double position;
+    uint32_t loop;
+
+    // The loop being read, at most one ahead of the playback
+    uint32_t readLoop;
+
+    // Known once the end of the file was reached
+    double duration;
+    double lastTimestamp;
+
+    // The next packet, read but not dispatched yet
+    bool hasNextPacket;
+    MoviePacket nextPacket;
+    bool endOfFile;
+};
+
+MovieStreamer::MovieStreamer(DisplayGroupManagerPtr displayGroup)
+    : displayGroup_(displayGroup)
+{
+    connect(&timer_, SIGNAL(timeout()), this, SLOT(update()));
+    timer_.start(UPDATE_INTERVAL_MS);
+}
+
+MovieStreamer::~MovieStreamer()
+{
+}
+
+void MovieStreamer::update()
+{
+    const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+    const double elapsedTime = lastUpdateTime_.is_not_a_date_time() ? 0.0 :
+                               (now - lastUpdateTime_).total_microseconds() / 1000000.0;
+    lastUpdateTime_ = now;
+
+    // Movies displayed in several windows are only updated once
+    StreamedMovies updatedMovies;
+
+    BOOST_FOREACH(ContentWindowManagerPtr window, displayGroup_->getContentWindowManagers())
+    {
+        updateMovie(window, elapsedTime, updatedMovies);
+    }
+
+    ContentWindowManagerPtr backgroundWindow = displayGroup_->getBackgroundContentWindow();
+    if (backgroundWindow)
+        updateMovie(backgroundWindow, elapsedTime, updatedMovies);
+
+    // Close the movies which are not displayed anymore
+    movies_.swap(updatedMovies);
+}
+
+void MovieStreamer::updateMovie(ContentWindowManagerPtr window, const double elapsedTime,
+                                StreamedMovies& updatedMovies)
+{
+    ContentPtr content = window->getContent();
+    if (content->getType() != CONTENT_TYPE_MOVIE)
+        return;
+
+    const QString& uri = content->getURI();
+    if (updatedMovies.count(uri))
+        return;
+
+    StreamedMoviePtr movie = movies_[uri];
+    if (!movie)
+    {
+        movie.reset(new StreamedMovie(uri));
+
+        // The wall processes only know the dimensions once they receive packets
+        const MovieStreamParameters& parameters = movie->demuxer.getParameters();
+        int width, height;
+        content->getDimensions(width, height);
+        if (movie->demuxer.isValid() && (width != parameters.width || height != parameters.height))
+            content->setDimensions(parameters.width, parameters.height);
+    }
+    updatedMovies[uri] = movie;
+
+    if (!movie->demuxer.isValid())
+        return;
+
+    const double previousPosition = movie->position;
+    const uint32_t previousLoop = movie->loop;
+
+    // Same conditions as MovieContent::advance() on the wall processes
+    const ControlState state = window->getControlState();
+    if (!(state & STATE_PAUSED) && !content->isAdvanceBlocked())
+        movie->position += elapsedTime;
+
+    // The next loop starts once all the frames of the current one were displayed
+    if (movie->readLoop > movie->loop && movie->position >= movie->duration)
+    {
+        movie->position = std::max(movie->position - movie->duration, 0.0);
+        ++movie->loop;
+    }
+
+    MoviePacketsPtr packets(new MoviePackets);
+
+    while (movie->hasNextPacket || readNextPacket(*movie, state & STATE_LOOP))
+    {
+        movie->hasNextPacket = true;
+
+        const double timestamp = movie->nextPacket.timestamp +
+                                 (movie->readLoop - movie->loop) * movie->duration;
+        if (timestamp > movie->position + LOOKAHEAD_SECONDS)
+            break;
+
+        packets->packets.push_back(movie->nextPacket);
+        movie->hasNextPacket = false;
+    }
+
+    // Stop at the end of the movie when not looping
+    if (movie->endOfFile && movie->readLoop == movie->loop)
+        movie->position = std::min(movie->position, movie->duration);
+
+    if (packets->packets.empty() && movie->position == previousPosition &&
+            movie->loop == previousLoop)
+        return;
+
+    packets->uri = uri;
+    packets->parameters = movie->demuxer.getParameters();
+    packets->position = movie->position;
+    packets->loop = movie->loop;
+
+    emit sendPackets(packets);
+}
+
+bool MovieStreamer::readNextPacket(StreamedMovie& movie, const bool loop) const
+{
+    if (!movie.endOfFile)
+    {
+        if (movie.demuxer.readPacket(movie.nextPacket))
+        {
+            movie.nextPacket.loop = movie.readLoop;
+            movie.lastTimestamp = std::max(movie.lastTimestamp, movie.nextPacket.timestamp);
+            return true;
+        }
+
+        movie.endOfFile = true;
+        movie.duration = movie.lastTimestamp + movie.demuxer.getFrameDuration();
+    }
+
+    // Read the next loop, but not before the playback has reached the current one
+    if (!loop || movie.readLoop > movie.loop)
+        return false;
+
+    if (!movie.demuxer.rewind())
+    {
+        put_flog(LOG_WARN, "could not rewind movie");
+        return false;
+    }
+
+    ++movie.readLoop;
+    movie.lastTimestamp = 0.0;
+    movie.endOfFile = false;
+
+    if (!movie.demuxer.readPacket(movie.nextPacket))
+    {
+        movie.endOfFile = true;
+        return false;
+    }
+    movie.nextPacket.loop = movie.readLoop;
+    movie.lastTimestamp = movie.nextPacket.timestamp;
+    return true;
+}
@@ -0,0 +1,102 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef MOVIESTREAMER_H
+#define MOVIESTREAMER_H
+
+#include "types.h"
+
+#include <QObject>
+#include <QTimer>
+
+#ifndef Q_MOC_RUN
+#include <boost/date_time/posix_time/posix_time.hpp>
+#endif
+#include <boost/shared_ptr.hpp>
+#include <map>
+
+/**
+ * Demux the movies of the DisplayGroup on the master application and
+ * dispatch their compressed packets to the wall processes.
+ *
+ * The master keeps the playback position of each movie. The packets are read
+ * slightly ahead of this position, so that the wall processes can decode them
+ * before they are displayed. When looping, the packets of the next loop are
+ * read before the playback position reaches the end of the movie.
+ */
+class MovieStreamer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Construct a streamer and start dispatching packets.
+     * @param displayGroup The DisplayGroup containing the movies.
+     */
+    MovieStreamer(DisplayGroupManagerPtr displayGroup);
+
+    /** Destructor. */
+    ~MovieStreamer();
+
+signals:
+    /**
+     * Dispatch the packets read for a movie since the previous update.
+     * @param packets The packets, along with the playback position.
+     */
+    void sendPackets(MoviePacketsPtr packets);
+
+private slots:
+    void update();
+
+private:
+    struct StreamedMovie;
+    typedef boost::shared_ptr<StreamedMovie> StreamedMoviePtr;
+    typedef std::map<QString, StreamedMoviePtr> StreamedMovies;
+
+    DisplayGroupManagerPtr displayGroup_;
+    StreamedMovies movies_;
+    QTimer timer_;
+    boost::posix_time::ptime lastUpdateTime_;
+
+    void updateMovie(ContentWindowManagerPtr window, const double elapsedTime,
+                     StreamedMovies& updatedMovies);
+    bool readNextPacket(StreamedMovie& movie, const bool loop) const;
+};
+
+#endif // MOVIESTREAMER_H
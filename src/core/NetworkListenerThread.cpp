@@ -41,8 +41,11 @@
 // increment this every time the network protocol changes in a major way
 #include "NetworkProtocol.h"
 #include "PixelStream.h"
+#include "SharedFrameRing.h"
 #include "log.h"
 
+#include <QtNetwork/QHostAddress>
+#include <cstring>
 #include <stdint.h>
 
 #define RECEIVE_TIMEOUT_MS  3000
@@ -202,6 +205,14 @@ void NetworkListenerThread::handleMessage(const MessageHeader& messageHeader, co
         handlePixelStreamMessage(uri, byteArray);
         break;
 
+    case MESSAGE_TYPE_PIXELSTREAM_SHARED_OPEN:
+        openSharedFrames(byteArray);
+        break;
+
+    case MESSAGE_TYPE_PIXELSTREAM_SHARED:
+        handleSharedPixelStreamMessage(uri, byteArray);
+        break;
+
     case MESSAGE_TYPE_COMMAND:
         emit receivedCommand(QString(byteArray.data()), uri);
         break;
@@ -246,6 +257,81 @@ void NetworkListenerThread::handlePixelStreamMessage(const QString& uri, const Q
     }
 }
 
+void NetworkListenerThread::handleSharedPixelStreamMessage(const QString& uri, const QByteArray& byteArray)
+{
+    if (!sharedFrames_ || byteArray.size() < (int)sizeof(uint32_t))
+    {
+        put_flog(LOG_WARN, "received shared PixelStreamSegments without a shared frame ring");
+        return;
+    }
+
+    uint32_t slot = 0;
+    memcpy(&slot, byteArray.constData(), sizeof(uint32_t));
+
+    const unsigned char* data = sharedFrames_->getSlotData(slot);
+    if (!data)
+    {
+        put_flog(LOG_WARN, "received shared PixelStreamSegments for invalid slot: %u", slot);
+        return;
+    }
+
+    if (pixelStreamUri_ != uri)
+    {
+        put_flog(LOG_INFO, "received PixelStreamSegement from incorrect uri: %s", uri.toLocal8Bit().constData());
+        sharedFrames_->releaseSlot(slot);
+        return;
+    }
+
+    const size_t slotSize = sharedFrames_->getSlotSize();
+    const size_t count = (byteArray.size() - sizeof(uint32_t)) / sizeof(dc::SharedSegmentReference);
+    const char* references = byteArray.constData() + sizeof(uint32_t);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        dc::SharedSegmentReference reference;
+        memcpy(&reference, references + i * sizeof(dc::SharedSegmentReference), sizeof(dc::SharedSegmentReference));
+
+        if (size_t(reference.offset) + reference.size > slotSize)
+        {
+            put_flog(LOG_WARN, "shared PixelStreamSegement out of the slot bounds");
+            continue;
+        }
+
+        PixelStreamSegment segment;
+        segment.parameters = reference.parameters;
+
+        // The segments are queued until the frame is dispatched to the wall,
+        // but the slot is reused by the Stream as soon as it is released.
+        segment.imageData = QByteArray((const char*)data + reference.offset, reference.size);
+
+        emit(receivedPixelStreamSegement(uri, socketDescriptor_, segment));
+    }
+
+    sharedFrames_->releaseSlot(slot);
+}
+
+void NetworkListenerThread::openSharedFrames(const QByteArray& name)
+{
+    // A remote Stream may send the name of an unrelated segment on this host
+    if (!isLocalPeer())
+    {
+        put_flog(LOG_WARN, "ignoring shared frame ring of a remote stream");
+        return;
+    }
+
+    sharedFrames_.reset(new dc::SharedFrameRing(std::string(name.constData(), name.size())));
+    if (!sharedFrames_->isOpen())
+        sharedFrames_.reset();
+}
+
+bool NetworkListenerThread::isLocalPeer() const
+{
+    const QHostAddress peer = tcpSocket_->peerAddress();
+    return peer == QHostAddress::LocalHost ||
+           peer == QHostAddress::LocalHostIPv6 ||
+           peer == tcpSocket_->localAddress();
+}
+
 void NetworkListenerThread::pixelStreamerClosed(QString uri)
 {
     if (uri == pixelStreamUri_)
@@ -47,6 +47,13 @@
 #include <QtNetwork/QTcpSocket>
 #include <QQueue>
 
+#include <boost/scoped_ptr.hpp>
+
+namespace dc
+{
+class SharedFrameRing;
+}
+
 using dc::Event;
 using dc::PixelStreamSegment;
 using dc::PixelStreamSegmentParameters;
@@ -99,11 +106,16 @@ private:
     bool registeredToEvents_;
     QQueue<Event> events_;
 
+    boost::scoped_ptr<dc::SharedFrameRing> sharedFrames_;
+
     MessageHeader receiveMessageHeader();
     QByteArray receiveMessageBody(const int size);
 
     void handleMessage(const MessageHeader& messageHeader, const QByteArray& byteArray);
     void handlePixelStreamMessage(const QString& uri, const QByteArray& byteArray);
+    void handleSharedPixelStreamMessage(const QString& uri, const QByteArray& byteArray);
+    void openSharedFrames(const QByteArray& name);
+    bool isLocalPeer() const;
 
     void sendProtocolVersion();
     void sendBindReply(const bool successful);
@@ -54,12 +54,51 @@
 #include "GLWindow.h"
 #include "log.h"
 
+#include <QMutex>
+
+#include <boost/bind.hpp>
+
 #define INVALID_PAGE_NUMBER -1
 
+// Rasterized tiles kept for the current page, 1 MB each
+#define PDF_TILE_CACHE_SIZE 96
+
+/** A Poppler document. Poppler does not support concurrent rendering. */
+struct PDF::PopplerDocument
+{
+    PopplerDocument(Poppler::Document* document_) : document(document_) {}
+
+    boost::scoped_ptr<Poppler::Document> document;
+    QMutex mutex;
+};
+
+/** A page of a Poppler document, which keeps the document alive. */
+struct PDF::PopplerPage
+{
+    PopplerPage(boost::shared_ptr<PopplerDocument> document_, Poppler::Page* page_)
+        : document(document_), page(page_) {}
+
+    QImage render(const QSize& size, const QRect& region) const
+    {
+        // The page size is given in points, rendered at 72 dpi
+        const QSizeF pageSize = page->pageSizeF();
+        if(pageSize.isEmpty() || size.isEmpty() || region.isEmpty())
+            return QImage();
+
+        const double resX = 72.0 * size.width() / pageSize.width();
+        const double resY = 72.0 * size.height() / pageSize.height();
+
+        QMutexLocker locker(&document->mutex);
+        return page->renderToImage(resX, resY, region.x(), region.y(),
+                                   region.width(), region.height());
+    }
+
+    boost::shared_ptr<PopplerDocument> document;
+    boost::scoped_ptr<Poppler::Page> page;
+};
+
 PDF::PDF(const QString& uri)
     : uri_(uri)
-    , pdfDoc_(0)
-    , pdfPage_(0)
     , pageNumber_(INVALID_PAGE_NUMBER)
 {
     openDocument(uri_);
@@ -72,17 +111,17 @@ PDF::~PDF()
 
 bool PDF::isValid() const
 {
-    return (pdfDoc_ != 0);
+    return (pdfDoc_.get() != 0);
 }
 
 void PDF::closePage()
 {
     if (pdfPage_)
     {
-        delete pdfPage_;
-        pdfPage_ = 0;
+        // Tiles being rasterized keep their own reference to the page
+        tileCache_.reset();
+        pdfPage_.reset();
         pageNumber_ = INVALID_PAGE_NUMBER;
-        textureRect_ = QRect();
     }
 }
 
@@ -91,8 +130,7 @@ void PDF::closeDocument()
     if (pdfDoc_)
     {
         closePage();
-        delete pdfDoc_;
-        pdfDoc_ = 0;
+        pdfDoc_.reset();
     }
 }
 
@@ -100,22 +138,23 @@ void PDF::openDocument(const QString& filename)
 {
     closeDocument();
 
-    pdfDoc_ = Poppler::Document::load(filename);
-    if (!pdfDoc_ || pdfDoc_->isLocked())
+    Poppler::Document* document = Poppler::Document::load(filename);
+    if (!document || document->isLocked())
     {
         put_flog(LOG_DEBUG, "Could not open document %s", filename.toLocal8Bit().constData());
-        closeDocument();
+        delete document;
         return;
     }
 
-    pdfDoc_->setRenderHint(Poppler::Document::TextAntialiasing);
+    document->setRenderHint(Poppler::Document::TextAntialiasing);
+    pdfDoc_.reset(new PopplerDocument(document));
 
     setPage(0);
 }
 
 bool PDF::isValid(const int pageNumber) const
 {
-    return pageNumber >=0 && pageNumber < pdfDoc_->numPages();
+    return pageNumber >=0 && pageNumber < pdfDoc_->document->numPages();
 }
 
 void PDF::setPage(const int pageNumber)
@@ -125,30 +164,44 @@ void PDF::setPage(const int pageNumber)
 
     closePage();
 
-    pdfPage_ = pdfDoc_->page(pageNumber); // Document starts at page 0
-    if (!pdfPage_)
+    Poppler::Page* page = 0;
+    {
+        QMutexLocker locker(&pdfDoc_->mutex);
+        page = pdfDoc_->document->page(pageNumber); // Document starts at page 0
+    }
+    if (!page)
     {
         put_flog(LOG_DEBUG, "Could not open page %d", pageNumber);
         return;
     }
 
+    pdfPage_.reset(new PopplerPage(pdfDoc_, page));
     pageNumber_ = pageNumber;
 }
 
 int PDF::getPageCount() const
 {
-    return pdfDoc_->numPages();
+    return pdfDoc_->document->numPages();
 }
 
-QImage PDF::renderToImage() const
+QImage PDF::renderToImage(const QSize& size) const
 {
-    return pdfPage_->renderToImage();
+    if (!pdfPage_)
+        return QImage();
+
+    return pdfPage_->render(size, QRect(QPoint(0, 0), size));
 }
 
 void PDF::getDimensions(int &width, int &height) const
 {
-    width = pdfPage_ ? pdfPage_->pageSize().width() : 0;
-    height = pdfPage_ ? pdfPage_->pageSize().height() : 0;
+    width = pdfPage_ ? pdfPage_->page->pageSize().width() : 0;
+    height = pdfPage_ ? pdfPage_->page->pageSize().height() : 0;
+}
+
+size_t PDF::getHostMemoryUsage() const
+{
+    // The textures are accounted for by the TileTexturePool
+    return tileCache_ ? tileCache_->getMemoryUsage() : 0;
 }
 
 void PDF::render(const QRectF& texCoords)
@@ -157,81 +210,103 @@ void PDF::render(const QRectF& texCoords)
         return;
 
     // get on-screen and full rectangle corresponding to the window
-    const QRectF screenRect = renderContext_->getGLWindow()->getProjectedPixelRect(true);
-    const QRectF fullRect = renderContext_->getGLWindow()->getProjectedPixelRect(false);
+    GLWindowPtr glWindow = renderContext_->getActiveGLWindow();
+    const QRectF windowRect = glWindow->getProjectedPixelRect(false);
+    const QRectF visibleRect = glWindow->getProjectedPixelRect(true);
 
-    // if we're not visible or we don't have a valid SVG, we're done...
-    if(screenRect.isEmpty())
-    {
-        // TODO clear existing FBO for this OpenGL window
+    // if we're not visible, we're done...
+    if (windowRect.isEmpty() || visibleRect.isEmpty() || texCoords.isEmpty())
         return;
+
+    if (!tileCache_)
+    {
+        const PDFRenderFunction renderFunction =
+                boost::bind(&PopplerPage::render, pdfPage_, _1, _2);
+        tileCache_.reset(new PDFTileCache(pdfPage_->page->pageSizeF(), renderFunction,
+                                          renderContext_->getTileLoadScheduler(),
+                                          &renderContext_->getTileTexturePool()));
     }
 
-    // generate texture corresponding to the visible part of these texture coordinates
-    generateTexture(screenRect, fullRect, texCoords);
+    // The part of the page shown in the visible part of the window
+    const QRectF region(texCoords.x() + (visibleRect.x() - windowRect.x()) / windowRect.width() * texCoords.width(),
+                        texCoords.y() + (visibleRect.y() - windowRect.y()) / windowRect.height() * texCoords.height(),
+                        visibleRect.width() / windowRect.width() * texCoords.width(),
+                        visibleRect.height() / windowRect.height() * texCoords.height());
 
-    if(!texture_.isValid())
-        return;
+    // Size of the whole page on screen, in pixels
+    const QSizeF pageSize(windowRect.width() / texCoords.width(),
+                          windowRect.height() / texCoords.height());
 
-    // figure out what visible region is for screenRect, a subregion of [0, 0, 1, 1]
-    const float xp = (screenRect.x() - fullRect.x()) / fullRect.width();
-    const float yp = (screenRect.y() - fullRect.y()) / fullRect.height();
-    const float wp = screenRect.width() / fullRect.width();
-    const float hp = screenRect.height() / fullRect.height();
+    // The coarsest tile is the fallback for all the others, always load it
+    const uint64_t frameIndex = getFrameIndex();
+    tileCache_->request(PDFTileId(), TilePriority(0, 0.), frameIndex);
 
-    // Render the entire texture on a (scaled) unit textured quad
-    glPushMatrix();
+    const int level = tileCache_->getLevel(pageSize);
+    const std::vector<PDFTileId> ids = tileCache_->getTileIds(level, region);
 
-    glTranslatef(xp, yp, 0);
-    glScalef(wp, hp, 1.f);
+    for (std::vector<PDFTileId>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+    {
+        const QRectF tileRegion = tileCache_->getTileCoordinates(*it).intersected(region);
+        const double coverage = tileRegion.width() * pageSize.width() *
+                                tileRegion.height() * pageSize.height();
 
-    drawUnitTexturedQuad();
+        PDFTilePtr tile = tileCache_->request(*it, TilePriority(level, coverage), frameIndex);
 
-    glPopMatrix();
+        // Show a coarser tile until this one is rasterized
+        if (!updateTexture(*tile))
+        {
+            tile = tileCache_->findCoarserTile(*it);
+            if (!tile || !updateTexture(*tile))
+                continue;
+        }
+
+        renderTile(*tile, tileRegion, texCoords);
+    }
+
+    tileCache_->trim(PDF_TILE_CACHE_SIZE);
 }
 
-void PDF::drawUnitTexturedQuad()
+bool PDF::updateTexture(PDFTile& tile)
 {
-    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
+    TileTexturePool& tileTexturePool = renderContext_->getTileTexturePool();
+    TileTextureHandle& handle = tile.getTextureHandle();
 
-    texture_.bind();
-    quad_.render();
+    if (tileTexturePool.isValid(handle))
+        return true;
 
-    glPopAttrib();
+    // Upload the tile, or upload it again if the pool recycled its texture
+    const QImage image = tile.getImage();
+    if (image.isNull())
+        return false;
+
+    handle = tileTexturePool.upload(image);
+    return handle.slot >= 0;
 }
 
-void PDF::generateTexture(const QRectF& screenRect, const QRectF& fullRect, const QRectF& texCoords)
+void PDF::renderTile(PDFTile& tile, const QRectF& region, const QRectF& texCoords)
 {
-    // figure out the coordinates of the topLeft corner of the texture in the PDF page
-    const double tXp = texCoords.x()/texCoords.width()*fullRect.width()  + (screenRect.x() - fullRect.x());
-    const double tYp = texCoords.y()/texCoords.height()*fullRect.height() + (screenRect.y() - fullRect.y());
-
-    // Compute the actual texture dimensions
-    const QRect textureRect(tXp, tYp, screenRect.width(), screenRect.height());
+    // The part of the tile image corresponding to the region of the page
+    const QRectF& bounds = tile.getCoordinates();
+    const QRectF tileTexCoords((region.x() - bounds.x()) / bounds.width(),
+                               (region.y() - bounds.y()) / bounds.height(),
+                               region.width() / bounds.width(),
+                               region.height() / bounds.height());
 
-    // TODO The instance of this class is shared between GLWindows, so the
-    // texture is constantly regenerated because the size changes...
-    if(textureRect == textureRect_)
-        return; // no need to regenerate texture
+    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
 
-    // Adjust the quality to match the actual displayed size
-    // Multiply resolution by the zoom factor (1/t[W,H])
-    const double resFactorX = fullRect.width() / pdfPage_->pageSize().width() / texCoords.width();
-    const double resFactorY = fullRect.height() / pdfPage_->pageSize().height() / texCoords.height();
+    const QRectF textureRegion =
+            renderContext_->getTileTexturePool().bind(tile.getTextureHandle(), tileTexCoords);
 
-    // Generate a QImage of the rendered page
-    QImage image = pdfPage_->renderToImage(72.0*resFactorX , 72.0*resFactorY,
-                                            textureRect.x(), textureRect.y(),
-                                            textureRect.width(), textureRect.height()
-                                            );
+    // Position the region in the unit quad of the window
+    glPushMatrix();
+    glTranslatef((region.x() - texCoords.x()) / texCoords.width(),
+                 (region.y() - texCoords.y()) / texCoords.height(), 0.f);
+    glScalef(region.width() / texCoords.width(),
+             region.height() / texCoords.height(), 1.f);
 
-    if (image.isNull())
-    {
-        put_flog(LOG_DEBUG, "Could not render pdf to image");
-        return;
-    }
+    quad_.setTexCoords(textureRegion);
+    quad_.render();
 
-    texture_.update(image, GL_BGRA);
-    textureRect_ = textureRect; // keep rendered texture information so we know when to rerender
+    glPopMatrix();
+    glPopAttrib();
 }
-
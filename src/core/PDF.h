@@ -41,16 +41,21 @@
 #define PDF_H
 
 #include "FactoryObject.h"
-#include "GLTexture2D.h"
 #include "GLQuad.h"
+#include "PDFTileCache.h"
 
 #include <QString>
 
-namespace Poppler {
-    class Document;
-    class Page;
-}
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
+/**
+ * A PDF document, rendered one page at a time.
+ *
+ * The current page is rasterized as a pyramid of tiles by the
+ * TileLoadScheduler of the RenderContext. Coarser tiles are displayed until
+ * the tiles matching the screen resolution are ready.
+ */
 class PDF : public FactoryObject
 {
 public:
@@ -61,30 +66,40 @@ public:
 
     void getDimensions(int &width, int &height) const override;
     void render(const QRectF& texCoords) override;
+    size_t getHostMemoryUsage() const override;
 
     void setPage(const int pageNumber);
     int getPageCount() const;
 
-    QImage renderToImage() const;
+    /**
+     * Render the current page at the resolution of an image.
+     * @param size The size of the image, which is not required to have the
+     *        aspect ratio of the page.
+     * @return The rendered page, or a null image on failure.
+     */
+    QImage renderToImage(const QSize& size) const;
 
 private:
+    struct PopplerDocument;
+    struct PopplerPage;
+
     QString uri_;
 
-    Poppler::Document* pdfDoc_;
-    Poppler::Page* pdfPage_;
+    // Shared with the threads rasterizing the tiles
+    boost::shared_ptr<PopplerDocument> pdfDoc_;
+    boost::shared_ptr<PopplerPage> pdfPage_;
     int pageNumber_;
 
-    GLTexture2D texture_;
+    boost::scoped_ptr<PDFTileCache> tileCache_; // Tiles of the current page
     GLQuad quad_;
-    QRect textureRect_;
 
     void openDocument(const QString& filename);
     void closeDocument();
     void closePage();
     bool isValid(const int pageNumber) const;
 
-    void drawUnitTexturedQuad();
-    void generateTexture(const QRectF& screenRect, const QRectF& fullRect, const QRectF& texCoords);
+    bool updateTexture(PDFTile& tile);
+    void renderTile(PDFTile& tile, const QRectF& region, const QRectF& texCoords);
 };
 
 #endif // PDF_H
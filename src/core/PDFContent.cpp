@@ -104,5 +104,7 @@ void PDFContent::previousPage()
 
 void PDFContent::advance(FactoriesPtr factories, ContentWindowManagerPtr, const boost::posix_time::time_duration)
 {
-    factories->getPDFFactory().getObject(getURI())->setPage(pageNumber_);
+    boost::shared_ptr< PDF > pdf = factories->getPDFFactory().findObject(getURI());
+    if( pdf )
+        pdf->setPage(pageNumber_);
 }
@@ -0,0 +1,270 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "PDFTileCache.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define PDF_TILE_SIZE          512 // At most the size of the TileTexturePool textures
+#define PDF_MAX_LEVEL_COUNT    9 // Up to 131072 pixels for the longest side
+
+const int PDFTileCache::tileSize = PDF_TILE_SIZE;
+
+PDFTile::PDFTile(const PDFRenderFunction& renderFunction,
+                 const QSize& levelSize, const QRect& rect)
+    : renderFunction_(renderFunction)
+    , levelSize_(levelSize)
+    , rect_(rect)
+    , coordinates_(double(rect.x()) / levelSize.width(),
+                   double(rect.y()) / levelSize.height(),
+                   double(rect.width()) / levelSize.width(),
+                   double(rect.height()) / levelSize.height())
+    , lastUsedFrame_(0)
+{
+}
+
+QByteArray PDFTile::readTileData()
+{
+    return QByteArray();
+}
+
+void PDFTile::decodeTileData(const QByteArray&)
+{
+    image_ = renderFunction_(levelSize_, rect_);
+    if(image_.isNull())
+        put_flog(LOG_DEBUG, "Could not render pdf tile");
+}
+
+const QRectF& PDFTile::getCoordinates() const
+{
+    return coordinates_;
+}
+
+bool PDFTile::isRendered() const
+{
+    return request_ && request_->isFinished() && !request_->isCancelled();
+}
+
+void PDFTile::waitForImage() const
+{
+    if(request_)
+        request_->waitForFinished();
+}
+
+QImage PDFTile::getImage() const
+{
+    return isRendered() ? image_ : QImage();
+}
+
+TileTextureHandle& PDFTile::getTextureHandle()
+{
+    return textureHandle_;
+}
+
+PDFTileCache::PDFTileCache(const QSizeF& pageSize,
+                           const PDFRenderFunction& renderFunction,
+                           TileLoadScheduler& scheduler,
+                           TileTexturePool* texturePool)
+    : renderFunction_(renderFunction)
+    , scheduler_(scheduler)
+    , texturePool_(texturePool)
+    , frameIndex_(0)
+{
+    // Fit the page in a single tile; the size of the following levels is an
+    // exact multiple of it so that the tiles of all levels are aligned.
+    const double longestSide = std::max(pageSize.width(), pageSize.height());
+    const double scale = longestSide > 0. ? PDF_TILE_SIZE / longestSide : 0.;
+    baseLevelSize_ = QSize(std::max(1, (int)std::ceil(pageSize.width() * scale)),
+                           std::max(1, (int)std::ceil(pageSize.height() * scale)));
+}
+
+PDFTileCache::~PDFTileCache()
+{
+    for(Tiles::iterator it = tiles_.begin(); it != tiles_.end(); ++it)
+        release(*it->second);
+}
+
+int PDFTileCache::getLevelCount() const
+{
+    return PDF_MAX_LEVEL_COUNT;
+}
+
+int PDFTileCache::getLevel(const QSizeF& pageSizeOnScreen) const
+{
+    const double zoom = std::max(pageSizeOnScreen.width() / baseLevelSize_.width(),
+                                 pageSizeOnScreen.height() / baseLevelSize_.height());
+    if(zoom <= 1.)
+        return 0;
+
+    const int level = (int)std::ceil(std::log(zoom) / std::log(2.) - 1e-6);
+    return std::min(level, getLevelCount() - 1);
+}
+
+QSize PDFTileCache::getLevelSize(const int level) const
+{
+    return baseLevelSize_ * (1 << level);
+}
+
+std::vector<PDFTileId> PDFTileCache::getTileIds(const int level, const QRectF& region) const
+{
+    std::vector<PDFTileId> ids;
+
+    const QRectF visibleRegion = region.intersected(QRectF(0., 0., 1., 1.));
+    if(visibleRegion.isEmpty())
+        return ids;
+
+    const QSize levelSize = getLevelSize(level);
+    const int columns = (levelSize.width() + PDF_TILE_SIZE - 1) / PDF_TILE_SIZE;
+    const int rows = (levelSize.height() + PDF_TILE_SIZE - 1) / PDF_TILE_SIZE;
+
+    const double tileWidth = double(PDF_TILE_SIZE) / levelSize.width();
+    const double tileHeight = double(PDF_TILE_SIZE) / levelSize.height();
+
+    const int x0 = std::max(0, (int)std::floor(visibleRegion.left() / tileWidth));
+    const int y0 = std::max(0, (int)std::floor(visibleRegion.top() / tileHeight));
+    const int x1 = std::min(columns, (int)std::ceil(visibleRegion.right() / tileWidth));
+    const int y1 = std::min(rows, (int)std::ceil(visibleRegion.bottom() / tileHeight));
+
+    for(int y = y0; y < y1; ++y)
+        for(int x = x0; x < x1; ++x)
+            ids.push_back(PDFTileId(level, x, y));
+
+    return ids;
+}
+
+QRectF PDFTileCache::getTileCoordinates(const PDFTileId& id) const
+{
+    const QSize levelSize = getLevelSize(id.level);
+    const QRect rect = QRect(id.x * PDF_TILE_SIZE, id.y * PDF_TILE_SIZE,
+                             PDF_TILE_SIZE, PDF_TILE_SIZE) & QRect(QPoint(0, 0), levelSize);
+
+    return QRectF(double(rect.x()) / levelSize.width(),
+                  double(rect.y()) / levelSize.height(),
+                  double(rect.width()) / levelSize.width(),
+                  double(rect.height()) / levelSize.height());
+}
+
+PDFTilePtr PDFTileCache::request(const PDFTileId& id, const TilePriority& priority,
+                                 const uint64_t frameIndex)
+{
+    PDFTilePtr& tile = tiles_[id];
+    if(!tile)
+    {
+        const QSize levelSize = getLevelSize(id.level);
+        const QRect rect = QRect(id.x * PDF_TILE_SIZE, id.y * PDF_TILE_SIZE,
+                                 PDF_TILE_SIZE, PDF_TILE_SIZE) & QRect(QPoint(0, 0), levelSize);
+        tile.reset(new PDFTile(renderFunction_, levelSize, rect));
+    }
+
+    tile->lastUsedFrame_ = frameIndex;
+    frameIndex_ = std::max(frameIndex_, frameIndex);
+
+    // Requests which are not renewed every frame get cancelled by the scheduler
+    if(tile->request_ && !tile->request_->isCancelled())
+    {
+        if(!tile->request_->isFinished())
+            scheduler_.renew(tile->request_, priority);
+    }
+    else
+        tile->request_ = scheduler_.request(tile, priority);
+
+    return tile;
+}
+
+PDFTilePtr PDFTileCache::find(const PDFTileId& id) const
+{
+    const Tiles::const_iterator it = tiles_.find(id);
+    return it != tiles_.end() ? it->second : PDFTilePtr();
+}
+
+PDFTilePtr PDFTileCache::findCoarserTile(const PDFTileId& id) const
+{
+    for(int level = id.level - 1; level >= 0; --level)
+    {
+        const int shift = id.level - level;
+        const PDFTilePtr tile = find(PDFTileId(level, id.x >> shift, id.y >> shift));
+        if(tile && !tile->getImage().isNull())
+            return tile;
+    }
+    return PDFTilePtr();
+}
+
+size_t PDFTileCache::getTileCount() const
+{
+    return tiles_.size();
+}
+
+size_t PDFTileCache::getMemoryUsage() const
+{
+    size_t usage = 0;
+    for(Tiles::const_iterator it = tiles_.begin(); it != tiles_.end(); ++it)
+        usage += it->second->getImage().byteCount();
+    return usage;
+}
+
+void PDFTileCache::trim(const size_t maxTileCount)
+{
+    if(tiles_.size() <= maxTileCount)
+        return;
+
+    std::vector<std::pair<uint64_t, PDFTileId> > candidates;
+    for(Tiles::const_iterator it = tiles_.begin(); it != tiles_.end(); ++it)
+    {
+        if(it->second->lastUsedFrame_ < frameIndex_)
+            candidates.push_back(std::make_pair(it->second->lastUsedFrame_, it->first));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // A tile which is still being rasterized keeps running, its result is dropped
+    for(size_t i = 0; i < candidates.size() && tiles_.size() > maxTileCount; ++i)
+    {
+        const Tiles::iterator it = tiles_.find(candidates[i].second);
+        release(*it->second);
+        tiles_.erase(it);
+    }
+}
+
+void PDFTileCache::release(PDFTile& tile)
+{
+    if(texturePool_)
+        texturePool_->release(tile.textureHandle_);
+}
@@ -0,0 +1,263 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef PDFTILECACHE_H
+#define PDFTILECACHE_H
+
+#include "TileLoadScheduler.h"
+#include "TileTexturePool.h"
+
+#include <QImage>
+#include <QRect>
+#include <QRectF>
+#include <QSizeF>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <vector>
+
+/**
+ * Rasterize a region of a page.
+ * The first argument is the size of the whole page in pixels, the second one
+ * the region to render in these pixel coordinates. Called from the
+ * TileLoadScheduler threads.
+ */
+typedef boost::function<QImage(const QSize&, const QRect&)> PDFRenderFunction;
+
+/**
+ * The position of a tile in the pyramid of a page.
+ */
+struct PDFTileId
+{
+    PDFTileId(const int level_ = 0, const int x_ = 0, const int y_ = 0)
+        : level(level_), x(x_), y(y_) {}
+
+    /** The level in the pyramid, 0 being the coarsest one. */
+    int level;
+
+    /** The column of the tile in its level. */
+    int x;
+
+    /** The row of the tile in its level. */
+    int y;
+
+    bool operator<(const PDFTileId& other) const
+    {
+        if(level != other.level)
+            return level < other.level;
+        if(y != other.y)
+            return y < other.y;
+        return x < other.x;
+    }
+
+    bool operator==(const PDFTileId& other) const
+    {
+        return level == other.level && x == other.x && y == other.y;
+    }
+};
+
+/**
+ * A tile of a PDF page, rasterized by the TileLoadScheduler.
+ */
+class PDFTile : public TileSource, public boost::noncopyable
+{
+public:
+    /**
+     * Constructor.
+     * @param renderFunction The function which rasterizes the page.
+     * @param levelSize The size of the page at the level of the tile.
+     * @param rect The area of the tile, in pixels of its level.
+     */
+    PDFTile(const PDFRenderFunction& renderFunction, const QSize& levelSize,
+            const QRect& rect);
+
+    /**
+     * No data to read, pages are rasterized in the decoding stage.
+     * @internal TileLoadScheduler I/O stage
+     */
+    QByteArray readTileData() override;
+
+    /**
+     * Rasterize the tile.
+     * @internal TileLoadScheduler decoding stage
+     */
+    void decodeTileData(const QByteArray& data) override;
+
+    /** @return The area of the page covered by the tile, in [0,1] units. */
+    const QRectF& getCoordinates() const;
+
+    /** @return true when the image is available, see getImage(). */
+    bool isRendered() const;
+
+    /** Block until the tile is rendered, if it was requested. */
+    void waitForImage() const;
+
+    /**
+     * Get the rasterized tile.
+     * @return The image, null if not rendered yet or if rendering failed.
+     */
+    QImage getImage() const;
+
+    /** @return The texture of the tile in the TileTexturePool. */
+    TileTextureHandle& getTextureHandle();
+
+private:
+    friend class PDFTileCache;
+
+    PDFRenderFunction renderFunction_;
+    QSize levelSize_;
+    QRect rect_;
+    QRectF coordinates_;
+
+    QImage image_; // Written by the loading thread
+    TileLoadRequestPtr request_;
+    TileTextureHandle textureHandle_;
+    uint64_t lastUsedFrame_;
+};
+
+typedef boost::shared_ptr<PDFTile> PDFTilePtr;
+
+/**
+ * The tiles of a PDF page at all the zoom levels.
+ *
+ * Level 0 fits the page in a single tile, and the resolution doubles with each
+ * following level. Tiles are rasterized in the background by the
+ * TileLoadScheduler; requests which are not renewed in the next frame are
+ * cancelled by the scheduler when the view moves away. Rendered tiles are
+ * kept until trim() evicts the least recently used ones, so that zooming back
+ * does not rasterize the page again.
+ */
+class PDFTileCache : public boost::noncopyable
+{
+public:
+    /** The maximum size of the tiles, in pixels. */
+    static const int tileSize;
+
+    /**
+     * Constructor.
+     * @param pageSize The size of the page, in points.
+     * @param renderFunction The function which rasterizes the page.
+     * @param scheduler The scheduler rasterizing the tiles.
+     * @param texturePool The pool of the tile textures, to release them when
+     *        tiles are evicted. Optional.
+     */
+    PDFTileCache(const QSizeF& pageSize, const PDFRenderFunction& renderFunction,
+                 TileLoadScheduler& scheduler, TileTexturePool* texturePool = 0);
+
+    /** Destructor. Releases the textures of the tiles. */
+    ~PDFTileCache();
+
+    /** @return The number of levels in the pyramid. */
+    int getLevelCount() const;
+
+    /**
+     * Get the coarsest level with enough resolution for a display size.
+     * @param pageSizeOnScreen The size of the whole page on screen, in pixels.
+     * @return The level, at most getLevelCount() - 1.
+     */
+    int getLevel(const QSizeF& pageSizeOnScreen) const;
+
+    /** @return The size of the whole page at a level, in pixels. */
+    QSize getLevelSize(const int level) const;
+
+    /**
+     * Get the tiles covering a region of the page.
+     * @param level The level of the tiles.
+     * @param region The region of the page, in [0,1] units.
+     * @return The identifiers of the tiles, ordered by rows.
+     */
+    std::vector<PDFTileId> getTileIds(const int level, const QRectF& region) const;
+
+    /** @return The area of the page covered by a tile, in [0,1] units. */
+    QRectF getTileCoordinates(const PDFTileId& id) const;
+
+    /**
+     * Request the rasterization of a tile in the current frame.
+     * The tile is created if needed, and its request is made or renewed
+     * unless it is already rendered.
+     * @param id The tile.
+     * @param priority The priority of the request.
+     * @param frameIndex The current frame, used to evict unused tiles.
+     * @return The tile.
+     */
+    PDFTilePtr request(const PDFTileId& id, const TilePriority& priority,
+                       const uint64_t frameIndex);
+
+    /** @return A tile in the cache, or a null pointer. */
+    PDFTilePtr find(const PDFTileId& id) const;
+
+    /**
+     * Find the closest coarser tile which is rendered, to be displayed while
+     * a tile is being rasterized.
+     * @param id The tile.
+     * @return The rendered tile of a lower level covering the tile, or a null
+     *         pointer.
+     */
+    PDFTilePtr findCoarserTile(const PDFTileId& id) const;
+
+    /** @return The number of tiles in the cache. */
+    size_t getTileCount() const;
+
+    /** @return The memory used by the rendered tiles, in bytes. */
+    size_t getMemoryUsage() const;
+
+    /**
+     * Evict the least recently used tiles.
+     * Tiles requested in the last frame are never evicted.
+     * @param maxTileCount The number of tiles to keep.
+     */
+    void trim(const size_t maxTileCount);
+
+private:
+    typedef std::map<PDFTileId, PDFTilePtr> Tiles;
+
+    PDFRenderFunction renderFunction_;
+    TileLoadScheduler& scheduler_;
+    TileTexturePool* texturePool_;
+
+    QSize baseLevelSize_;
+    Tiles tiles_;
+    uint64_t frameIndex_;
+
+    void release(PDFTile& tile);
+};
+
+#endif // PDFTILECACHE_H
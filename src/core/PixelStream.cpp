@@ -57,6 +57,7 @@ PixelStream::PixelStream(const QString &uri)
     , width_(0)
     , height_ (0)
     , buffersSwapped_(false)
+    , segmentBorders_(GL_LINES)
 {
 }
 
@@ -169,18 +170,40 @@ void PixelStream::render(const QRectF&)
     const bool showSegmentBorders = g_configuration->getOptions()->getShowStreamingSegments();
     const bool showSegmentStatistics = g_configuration->getOptions()->getShowStreamingStatistics();
 
+    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT | GL_LINE_BIT);
     glPushMatrix();
     glScalef(1.f/(float)width_, 1.f/(float)height_, 0.f);
 
+    segmentBorders_.clear();
+
     for(std::vector<PixelStreamSegmentRendererPtr>::iterator it=segmentRenderers_.begin(); it != segmentRenderers_.end(); ++it)
     {
-        if (isVisible( (*it)->getRect(), contentWindowRect_ ))
+        if (isVisible( (*it)->getRect(), contentWindowRect_ ) && (*it)->render() && showSegmentBorders)
+            segmentBorders_.append((*it)->getRect());
+    }
+
+    // Overlays are drawn after all the segments to minimize state changes
+    if(showSegmentBorders)
+    {
+        glColor4f(1.,1.,1.,1.);
+        glLineWidth(2);
+        segmentBorders_.render();
+    }
+
+    if(showSegmentStatistics)
+    {
+        glDisable(GL_DEPTH_TEST);
+        glColor4f(1.,0.,0.,1.);
+
+        for(std::vector<PixelStreamSegmentRendererPtr>::iterator it=segmentRenderers_.begin(); it != segmentRenderers_.end(); ++it)
         {
-            (*it)->render(showSegmentBorders, showSegmentStatistics);
+            if (isVisible( (*it)->getRect(), contentWindowRect_ ))
+                (*it)->renderStatistics();
         }
     }
 
     glPopMatrix();
+    glPopAttrib();
 }
 
 void PixelStream::adjustFrameDecodersCount(const size_t count)
@@ -40,6 +40,7 @@
 #define PIXEL_STREAM_H
 
 #include "FactoryObject.h"
+#include "GLQuadBatch.h"
 #include "PixelStreamSegment.h"
 #include "types.h"
 
@@ -88,6 +89,9 @@ private:
     // The coordinates of the ContentWindow of this PixelStream
     QRectF contentWindowRect_;
 
+    // The outlines of the visible segments, drawn in a single call
+    GLQuadBatch segmentBorders_;
+
     void updateRenderers(const PixelStreamSegments& segments);
     void updateVisibleTextures(const QRectF& windowRect);
     void swapBuffers();
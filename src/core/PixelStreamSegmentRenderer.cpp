@@ -51,6 +51,7 @@ PixelStreamSegmentRenderer::PixelStreamSegmentRenderer(RenderContext* renderCont
     , segmentStatistics(new FpsCounter())
     , textureNeedsUpdate_(true)
 {
+    quad_.setEnableTexture(true);
 }
 
 PixelStreamSegmentRenderer::~PixelStreamSegmentRenderer()
@@ -87,80 +88,28 @@ void PixelStreamSegmentRenderer::setParameters(const unsigned int x, const unsig
     y_ = y;
     width_ = width;
     height_ = height;
+
+    // The segment geometry only changes with its parameters
+    quad_.clear();
+    quad_.append(QRectF(x_, y_, width_, height_));
 }
 
-bool PixelStreamSegmentRenderer::render(bool showSegmentBorders, bool showSegmentStatistics)
+bool PixelStreamSegmentRenderer::render()
 {
     if(!texture_.isValid())
         return false;
 
-    // OpenGL transformation
-    glPushMatrix();
-    glTranslatef(x_, y_, 0.);
-
-    // The following draw calls assume normalized coordinates, so we must pre-multiply by this segment's dimensions
-    glScalef(width_, height_, 0.);
-
-    drawUnitTexturedQuad();
-
-    if(showSegmentBorders || showSegmentStatistics)
-    {
-        glPushAttrib(GL_CURRENT_BIT | GL_LINE_BIT | GL_DEPTH_BUFFER_BIT);
-        glLineWidth(2);
-
-        glPushMatrix();
-        glTranslatef(0.,0.,0.05);
-
-        // render segment borders
-        if(showSegmentBorders)
-        {
-            drawSegmentBorders();
-        }
-
-        // render segment statistics
-        if(showSegmentStatistics)
-        {
-            drawSegmentStatistics();
-        }
-
-        glPopMatrix();
-        glPopAttrib();
-    }
-
-    glPopMatrix();
-
-    return true;
-}
-
-void PixelStreamSegmentRenderer::drawUnitTexturedQuad()
-{
-    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
-
     texture_.bind();
-    quad_.setEnableTexture(true);
-    quad_.setRenderMode(GL_QUADS);
-    quad_.render();
-
-    glPopAttrib();
-}
-
-void PixelStreamSegmentRenderer::drawSegmentBorders()
-{
-    glColor4f(1.,1.,1.,1.);
-
-    quad_.setEnableTexture(false);
-    quad_.setRenderMode(GL_LINE_LOOP);
     quad_.render();
 
-    glEnd();
+    return true;
 }
 
-void PixelStreamSegmentRenderer::drawSegmentStatistics()
+void PixelStreamSegmentRenderer::renderStatistics()
 {
     QFont font;
     font.setPixelSize(48);
 
-    glDisable(GL_DEPTH_TEST);
-    glColor4f(1.,0.,0.,1.);
-    renderContext_->getActiveGLWindow()->renderText(0.1, 0.95, 0., segmentStatistics->toString(), font);
+    renderContext_->getActiveGLWindow()->renderText(x_ + 0.1 * width_, y_ + 0.95 * height_, 0.,
+                                                    segmentStatistics->toString(), font);
 }
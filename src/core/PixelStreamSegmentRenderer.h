@@ -40,7 +40,7 @@
 #define PIXEL_STREAM_SEGMENT_RENDERER_H
 
 #include "GLTexture2D.h"
-#include "GLQuad.h"
+#include "GLQuadBatch.h"
 
 #include <boost/noncopyable.hpp>
 
@@ -93,19 +93,27 @@ public:
     /**
      * Render the current texture.
      *
-     * Assume that the GL matrices have been set to the normalized dimensions of the stream.
-     * @param showSegmentBorders Show the segment boders
-     * @param showStatistics Show the statistics for this segment
+     * Assume that the GL matrices have been set to the pixel dimensions of the
+     * stream and that the caller saved the GL_ENABLE_BIT and GL_TEXTURE_BIT
+     * attributes, so that all the segments of a stream can be rendered without
+     * intermediate matrix and attribute changes.
      * @return true on successful render; false if no texture available.
      */
-    bool render(bool showSegmentBorders, bool showSegmentStatistics);
+    bool render();
+
+    /**
+     * Render the statistics for this segment.
+     *
+     * Assume that the GL matrices have been set to the pixel dimensions of the stream.
+     */
+    void renderStatistics();
 
 private:
     /** A reference to the render context. */
     RenderContext* renderContext_;
 
     GLTexture2D texture_;
-    GLQuad quad_;
+    GLQuadBatch quad_;
 
     // Segment position
     unsigned int x_, y_;
@@ -117,11 +125,6 @@ private:
 
     // Status
     bool textureNeedsUpdate_;
-
-    // Rendering
-    void drawUnitTexturedQuad();
-    void drawSegmentBorders();
-    void drawSegmentStatistics();
 };
 
 #endif
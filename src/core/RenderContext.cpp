@@ -39,17 +39,56 @@
 #include "RenderContext.h"
 
 #include "configuration/WallConfiguration.h"
+#include "DynamicTexture.h"
 #include "GLWindow.h"
+#include "SharedTileCache.h"
 
 #include <boost/foreach.hpp>
+#include <algorithm>
+#include <unistd.h>
+
+namespace
+{
+const size_t MEGABYTE = 1024 * 1024;
+const size_t MIN_TILE_TEXTURES = 16;
+
+size_t getTileTextureCount(const WallConfiguration* configuration)
+{
+    const size_t tileBytes = DynamicTexture::pyramidTileSize * DynamicTexture::pyramidTileSize * 4;
+    const size_t budget = configuration->getGPUMemoryBudget() * MEGABYTE / 4;
+    return std::max(budget / tileBytes, MIN_TILE_TEXTURES);
+}
+
+QString getSharedTileCacheName()
+{
+    // One cache per user and host
+    return QString("/displaycluster-tiles-%1").arg(getuid());
+}
+}
 
 RenderContext::RenderContext(const WallConfiguration* configuration)
+    : tileTexturePool_(getTileTextureCount(configuration), DynamicTexture::pyramidTileSize)
 {
     setupOpenGLWindows(configuration);
+
+    if(configuration->getSharedTileCacheBudget() > 0)
+    {
+        sharedTileCache_.reset(new SharedTileCache(getSharedTileCacheName(),
+                                                   configuration->getSharedTileCacheBudget() * MEGABYTE,
+                                                   DynamicTexture::pyramidTileSize));
+        if(!sharedTileCache_->isOpen())
+            sharedTileCache_.reset();
+    }
 }
 
 RenderContext::~RenderContext()
 {
+    // The textures must be deleted with a current GL context
+    if(!glWindows_.empty())
+    {
+        glWindows_[0]->makeCurrent();
+        tileTexturePool_.clear();
+    }
 }
 
 void RenderContext::setupOpenGLWindows(const WallConfiguration* configuration)
@@ -115,3 +154,18 @@ void RenderContext::swapBuffers()
         glWindow->swapBuffers();
     }
 }
+
+TileLoadScheduler& RenderContext::getTileLoadScheduler()
+{
+    return tileLoadScheduler_;
+}
+
+TileTexturePool& RenderContext::getTileTexturePool()
+{
+    return tileTexturePool_;
+}
+
+SharedTileCache* RenderContext::getSharedTileCache()
+{
+    return sharedTileCache_.get();
+}
@@ -40,9 +40,13 @@
 #define RENDERCONTEXT_H
 
 #include "types.h"
+#include "TileLoadScheduler.h"
+#include "TileTexturePool.h"
 
 #include <QRectF>
+#include <boost/scoped_ptr.hpp>
 
+class SharedTileCache;
 class WallConfiguration;
 
 class RenderContext
@@ -60,11 +64,30 @@ public:
     void updateGLWindows();
     void swapBuffers();
 
+    /** The scheduler shared by all the DynamicTextures of this process. */
+    TileLoadScheduler& getTileLoadScheduler();
+
+    /**
+     * The tile textures shared by all the DynamicTextures of this process.
+     * It uses a quarter of the GPU memory budget of the WallConfiguration.
+     */
+    TileTexturePool& getTileTexturePool();
+
+    /**
+     * The decoded tiles shared with the other processes of this host.
+     * @return The cache, or null if it is disabled in the WallConfiguration.
+     */
+    SharedTileCache* getSharedTileCache();
+
 private:
     void setupOpenGLWindows(const WallConfiguration* configuration);
 
     GLWindowPtrs glWindows_;
     GLWindowPtr activeGLWindow_;
+
+    TileLoadScheduler tileLoadScheduler_;
+    TileTexturePool tileTexturePool_;
+    boost::scoped_ptr<SharedTileCache> sharedTileCache_;
 };
 
 #endif
@@ -0,0 +1,205 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ResidencyManager.h"
+
+#include "log.h"
+
+#include <algorithm>
+
+namespace
+{
+typedef std::pair<uint64_t, ResidencyKey> LastUse;
+}
+
+ResidencyManager::ResidencyManager(const size_t hostMemoryBudget,
+                                   const size_t gpuMemoryBudget,
+                                   const float lowWatermark)
+    : hostMemoryBudget_(hostMemoryBudget)
+    , gpuMemoryBudget_(gpuMemoryBudget)
+    , lowWatermark_(std::min(std::max(lowWatermark, 0.f), 1.f))
+    , hostMemoryUsage_(0)
+    , gpuMemoryUsage_(0)
+    , hitCount_(0)
+    , missCount_(0)
+    , evictionCount_(0)
+    , budgetExceeded_(false)
+{
+}
+
+void ResidencyManager::touch(const ResidencyKey& key, const uint64_t frameIndex)
+{
+    Entries::iterator it = entries_.find(key);
+    if(it == entries_.end())
+    {
+        ++missCount_;
+        Entry& entry = entries_[key];
+        entry.frameIndex = frameIndex;
+        return;
+    }
+
+    // Objects are used several times per frame, count residency once per frame
+    if(it->second.frameIndex < frameIndex)
+    {
+        ++hitCount_;
+        it->second.frameIndex = frameIndex;
+    }
+}
+
+void ResidencyManager::update(const ResidencyKey& key, const size_t hostMemory,
+                              const size_t gpuMemory, const uint64_t frameIndex)
+{
+    Entries::iterator it = entries_.find(key);
+    if(it == entries_.end())
+    {
+        ++missCount_;
+        it = entries_.insert(std::make_pair(key, Entry())).first;
+    }
+
+    Entry& entry = it->second;
+
+    hostMemoryUsage_ = hostMemoryUsage_ - entry.hostMemory + hostMemory;
+    gpuMemoryUsage_ = gpuMemoryUsage_ - entry.gpuMemory + gpuMemory;
+
+    entry.hostMemory = hostMemory;
+    entry.gpuMemory = gpuMemory;
+    entry.frameIndex = std::max(entry.frameIndex, frameIndex);
+}
+
+void ResidencyManager::remove(const ResidencyKey& key)
+{
+    Entries::iterator it = entries_.find(key);
+    if(it == entries_.end())
+        return;
+
+    hostMemoryUsage_ -= it->second.hostMemory;
+    gpuMemoryUsage_ -= it->second.gpuMemory;
+    entries_.erase(it);
+}
+
+ResidencyKeys ResidencyManager::collect(const uint64_t currentFrameIndex)
+{
+    ResidencyKeys evicted;
+
+    if(!isOverBudget(1.f))
+    {
+        budgetExceeded_ = false;
+        return evicted;
+    }
+
+    // Candidates are the objects not used in the current frame, oldest first
+    std::vector<LastUse> candidates;
+    for(Entries::const_iterator it = entries_.begin(); it != entries_.end(); ++it)
+    {
+        if(it->second.frameIndex < currentFrameIndex)
+            candidates.push_back(LastUse(it->second.frameIndex, it->first));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for(std::vector<LastUse>::const_iterator it = candidates.begin();
+        it != candidates.end() && isOverBudget(lowWatermark_); ++it)
+    {
+        remove(it->second);
+        evicted.push_back(it->second);
+    }
+    evictionCount_ += evicted.size();
+
+    // Only warn once until the usage is back within the budgets
+    const bool budgetExceeded = isOverBudget(1.f);
+    if(budgetExceeded && !budgetExceeded_)
+        put_flog(LOG_WARN, "visible contents exceed the memory budget: host %lu/%lu MB, GPU %lu/%lu MB",
+                 hostMemoryUsage_ >> 20, hostMemoryBudget_ >> 20,
+                 gpuMemoryUsage_ >> 20, gpuMemoryBudget_ >> 20);
+    budgetExceeded_ = budgetExceeded;
+
+    return evicted;
+}
+
+void ResidencyManager::clear()
+{
+    entries_.clear();
+    hostMemoryUsage_ = 0;
+    gpuMemoryUsage_ = 0;
+}
+
+size_t ResidencyManager::getObjectCount() const
+{
+    return entries_.size();
+}
+
+size_t ResidencyManager::getHostMemoryUsage() const
+{
+    return hostMemoryUsage_;
+}
+
+size_t ResidencyManager::getGPUMemoryUsage() const
+{
+    return gpuMemoryUsage_;
+}
+
+size_t ResidencyManager::getHostMemoryBudget() const
+{
+    return hostMemoryBudget_;
+}
+
+size_t ResidencyManager::getGPUMemoryBudget() const
+{
+    return gpuMemoryBudget_;
+}
+
+size_t ResidencyManager::getHitCount() const
+{
+    return hitCount_;
+}
+
+size_t ResidencyManager::getMissCount() const
+{
+    return missCount_;
+}
+
+size_t ResidencyManager::getEvictionCount() const
+{
+    return evictionCount_;
+}
+
+bool ResidencyManager::isOverBudget(const float fraction) const
+{
+    return hostMemoryUsage_ > fraction * hostMemoryBudget_ ||
+           gpuMemoryUsage_ > fraction * gpuMemoryBudget_;
+}
@@ -0,0 +1,169 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef RESIDENCYMANAGER_H
+#define RESIDENCYMANAGER_H
+
+#include "ContentType.h"
+
+#include <QString>
+#include <map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+/** Identifies a FactoryObject by the type and the URI of its Content. */
+typedef std::pair<CONTENT_TYPE, QString> ResidencyKey;
+typedef std::vector<ResidencyKey> ResidencyKeys;
+
+/**
+ * Decide which FactoryObjects can stay in memory.
+ *
+ * Objects are tracked with their host and GPU memory footprint and the index
+ * of the last frame in which they were used. When one of the memory budgets is
+ * exceeded (high watermark), the least recently used objects are evicted until
+ * the usage drops below a fraction of the budget (low watermark). The gap
+ * between the two watermarks avoids evicting and reloading the same objects on
+ * every frame when the usage is close to the budget.
+ *
+ * Objects used in the current frame are never evicted, so the budget may be
+ * exceeded if the visible Contents alone do not fit in it.
+ */
+class ResidencyManager
+{
+public:
+    /**
+     * Constructor.
+     * @param hostMemoryBudget The host memory budget in bytes.
+     * @param gpuMemoryBudget The GPU memory budget in bytes.
+     * @param lowWatermark The fraction of the budgets to go down to when
+     *        evicting objects, in the range [0;1].
+     */
+    ResidencyManager(const size_t hostMemoryBudget,
+                     const size_t gpuMemoryBudget,
+                     const float lowWatermark = 0.8f);
+
+    /**
+     * Mark an object as used in the given frame.
+     *
+     * Counts as a hit if the object is already resident, as a miss otherwise.
+     * Repeated calls within the same frame only refresh the object.
+     * @param key The object's identifier.
+     * @param frameIndex The current frame index.
+     */
+    void touch(const ResidencyKey& key, const uint64_t frameIndex);
+
+    /**
+     * Update the footprint of an object.
+     *
+     * Objects which are not yet tracked are added and count as a miss.
+     * @param key The object's identifier.
+     * @param hostMemory The host memory used by the object, in bytes.
+     * @param gpuMemory The GPU memory used by the object, in bytes.
+     * @param frameIndex The last frame in which the object was used.
+     */
+    void update(const ResidencyKey& key, const size_t hostMemory,
+                const size_t gpuMemory, const uint64_t frameIndex);
+
+    /** Stop tracking an object which was removed by other means. */
+    void remove(const ResidencyKey& key);
+
+    /**
+     * Select the objects to evict to remain within the budgets.
+     *
+     * The selected objects are no longer tracked after this call.
+     * @param currentFrameIndex Objects used in this frame are not evicted.
+     * @return The objects to evict, least recently used first.
+     */
+    ResidencyKeys collect(const uint64_t currentFrameIndex);
+
+    /** Stop tracking all objects. */
+    void clear();
+
+    /** @return The number of tracked objects. */
+    size_t getObjectCount() const;
+
+    //@{
+    /** Memory usage of all tracked objects, in bytes. */
+    size_t getHostMemoryUsage() const;
+    size_t getGPUMemoryUsage() const;
+    //@}
+
+    //@{
+    /** Memory budgets, in bytes. */
+    size_t getHostMemoryBudget() const;
+    size_t getGPUMemoryBudget() const;
+    //@}
+
+    //@{
+    /** Statistics since the creation of the manager. */
+    size_t getHitCount() const;
+    size_t getMissCount() const;
+    size_t getEvictionCount() const;
+    //@}
+
+private:
+    struct Entry
+    {
+        Entry() : hostMemory(0), gpuMemory(0), frameIndex(0) {}
+
+        size_t hostMemory;
+        size_t gpuMemory;
+        uint64_t frameIndex;
+    };
+    typedef std::map<ResidencyKey, Entry> Entries;
+
+    const size_t hostMemoryBudget_;
+    const size_t gpuMemoryBudget_;
+    const float lowWatermark_;
+
+    Entries entries_;
+    size_t hostMemoryUsage_;
+    size_t gpuMemoryUsage_;
+
+    size_t hitCount_;
+    size_t missCount_;
+    size_t evictionCount_;
+
+    bool budgetExceeded_;
+
+    bool isOverBudget(const float fraction) const;
+};
+
+#endif // RESIDENCYMANAGER_H
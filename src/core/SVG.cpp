@@ -101,11 +101,30 @@ bool SVG::setImageData(QByteArray imageData)
     return true;
 }
 
+size_t SVG::getHostMemoryUsage() const
+{
+    return 0;
+}
+
+size_t SVG::getGPUMemoryUsage() const
+{
+    size_t usage = 0;
+
+    // One RGBA framebuffer object per GLWindow
+    for(std::map<int, SVGTextureData>::const_iterator it = textureData_.begin(); it != textureData_.end(); ++it)
+    {
+        if(it->second.fbo)
+            usage += (size_t)it->second.fbo->size().width() * it->second.fbo->size().height() * 4;
+    }
+
+    return usage;
+}
+
 void SVG::render(const QRectF& texCoords)
 {
     // get on-screen and full rectangle corresponding to the window in pixel units
-    const QRectF screenRect = renderContext_->getGLWindow()->getProjectedPixelRect(true);
-    const QRectF fullRect = renderContext_->getGLWindow()->getProjectedPixelRect(false); // maps to [tX, tY, tW, tH]
+    const QRectF screenRect = renderContext_->getActiveGLWindow()->getProjectedPixelRect(true);
+    const QRectF fullRect = renderContext_->getActiveGLWindow()->getProjectedPixelRect(false); // maps to [tX, tY, tW, tH]
 
     // If we're not visible or we don't have a valid SVG, we're done.
     if(screenRect.isEmpty() || !svgRenderer_.isValid())
@@ -71,6 +71,8 @@ public:
 
     void getDimensions(int &width, int &height) const override;
     void render(const QRectF& texCoords) override;
+    size_t getHostMemoryUsage() const override;
+    size_t getGPUMemoryUsage() const override;
 
 private:
     // image location
@@ -0,0 +1,526 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "SharedTileCache.h"
+
+#include "log.h"
+
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHARED_TILE_CACHE_MAGIC   "DCTILES1"
+#define SHARED_TILE_CACHE_VERSION 2
+
+namespace
+{
+const int PROBE_COUNT = 8;
+const int ATTACH_TIMEOUT_MS = 1000;
+const qint64 STALE_CLAIM_MS = 10000;
+const int POLL_INTERVAL_US = 1000;
+
+const int MAX_ACQUIRE_ATTEMPTS = 4;
+
+const int NO_SLOT = -1;
+const int RETRY = -2;
+const int DECODING = -3;
+
+const uint64_t FNV_PRIME = 1099511628211ULL;
+const uint64_t FNV_OFFSET_BASIS_1 = 14695981039346656037ULL;
+const uint64_t FNV_OFFSET_BASIS_2 = 9650029242287828579ULL;
+
+uint64_t hashBytes(const QByteArray& bytes, uint64_t hash)
+{
+    for(int i = 0; i < bytes.size(); ++i)
+    {
+        hash ^= static_cast<uchar>(bytes[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+size_t alignTo64(const size_t size)
+{
+    return (size + 63) & ~size_t(63);
+}
+
+// Atomic read with a full memory barrier, available in all Qt versions
+int readAtomic(QAtomicInt& value)
+{
+    return value.fetchAndAddOrdered(0);
+}
+}
+
+struct SharedTileCache::Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotBytes;
+    uint32_t tileSize;
+    QAtomicInt initialized;
+    QAtomicInt attachCount;
+    QAtomicInt clock;
+};
+
+struct SharedTileCache::Slot
+{
+    QAtomicInt sequence; // Odd while the slot is claimed by a writer
+    QAtomicInt lastUsed;
+    uint64_t hash1;
+    uint64_t hash2;
+    int32_t width;
+    int32_t height;
+    int32_t bytesPerLine;
+    int32_t format;
+};
+
+SharedTileCache::Key SharedTileCache::makeKey(const QString& tileName)
+{
+    const QByteArray bytes = tileName.toUtf8();
+
+    Key key;
+    // Zero is reserved for empty slots
+    key.hash1 = hashBytes(bytes, FNV_OFFSET_BASIS_1) | 1;
+    key.hash2 = hashBytes(bytes, FNV_OFFSET_BASIS_2);
+    return key;
+}
+
+SharedTileCache::SharedTileCache(const QString& name, const size_t capacity, const int tileSize)
+    : name_(name)
+    , fd_(-1)
+    , mapping_(0)
+    , mappingSize_(0)
+    , header_(0)
+    , slots_(0)
+    , data_(0)
+{
+    if(!create(capacity, tileSize) && !attach())
+    {
+        put_flog(LOG_WARN, "could not open the shared tile cache %s", name_.toLocal8Bit().constData());
+        detach();
+        return;
+    }
+
+    if(header_->tileSize != (uint32_t)tileSize)
+    {
+        put_flog(LOG_WARN, "the shared tile cache %s has a different tile size", name_.toLocal8Bit().constData());
+        detach();
+        return;
+    }
+
+    observedClaims_.resize(header_->slotCount);
+
+    put_flog(LOG_INFO, "shared tile cache %s: %u tiles of %u bytes", name_.toLocal8Bit().constData(),
+             header_->slotCount, header_->slotBytes);
+}
+
+SharedTileCache::~SharedTileCache()
+{
+    detach();
+}
+
+bool SharedTileCache::isOpen() const
+{
+    return header_ != 0;
+}
+
+size_t SharedTileCache::getSlotCount() const
+{
+    return header_ ? header_->slotCount : 0;
+}
+
+bool SharedTileCache::create(const size_t capacity, const int tileSize)
+{
+    const QByteArray name = name_.toLocal8Bit();
+
+    fd_ = shm_open(name.constData(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if(fd_ < 0)
+        return false;
+
+    const size_t slotBytes = size_t(tileSize) * tileSize * 4;
+    const size_t slotCount = std::max(capacity / slotBytes, size_t(1));
+    const size_t slotsOffset = alignTo64(sizeof(Header));
+    const size_t dataOffset = slotsOffset + alignTo64(slotCount * sizeof(Slot));
+    const size_t size = dataOffset + slotCount * slotBytes;
+
+    // The new segment is zero-filled, which is the initial state of the slots
+    if(ftruncate(fd_, size) != 0)
+    {
+        put_flog(LOG_ERROR, "could not allocate %lu bytes of shared memory", (unsigned long)size);
+        close(fd_);
+        fd_ = -1;
+        shm_unlink(name.constData());
+        return false;
+    }
+
+    mapping_ = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(mapping_ == MAP_FAILED)
+    {
+        mapping_ = 0;
+        close(fd_);
+        fd_ = -1;
+        shm_unlink(name.constData());
+        return false;
+    }
+    mappingSize_ = size;
+
+    header_ = new(mapping_) Header;
+    memcpy(header_->magic, SHARED_TILE_CACHE_MAGIC, sizeof(header_->magic));
+    header_->version = SHARED_TILE_CACHE_VERSION;
+    header_->slotCount = slotCount;
+    header_->slotBytes = slotBytes;
+    header_->tileSize = tileSize;
+    header_->attachCount.fetchAndStoreOrdered(1);
+
+    slots_ = reinterpret_cast<Slot*>(static_cast<uchar*>(mapping_) + slotsOffset);
+    data_ = static_cast<uchar*>(mapping_) + dataOffset;
+
+    // Other processes wait for this flag before using the segment
+    header_->initialized.fetchAndStoreOrdered(1);
+    return true;
+}
+
+bool SharedTileCache::attach()
+{
+    const QByteArray name = name_.toLocal8Bit();
+
+    fd_ = shm_open(name.constData(), O_RDWR, S_IRUSR | S_IWUSR);
+    if(fd_ < 0)
+        return false;
+
+    // Wait for the creator to allocate and initialize the segment
+    QElapsedTimer timer;
+    timer.start();
+
+    struct stat status;
+    while(fstat(fd_, &status) == 0 && (size_t)status.st_size < sizeof(Header))
+    {
+        if(timer.elapsed() > ATTACH_TIMEOUT_MS)
+            return false;
+        usleep(POLL_INTERVAL_US);
+    }
+    if((size_t)status.st_size < sizeof(Header))
+        return false;
+
+    mapping_ = mmap(0, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(mapping_ == MAP_FAILED)
+    {
+        mapping_ = 0;
+        return false;
+    }
+    mappingSize_ = status.st_size;
+
+    Header* header = static_cast<Header*>(mapping_);
+    while(readAtomic(header->initialized) == 0)
+    {
+        if(timer.elapsed() > ATTACH_TIMEOUT_MS)
+            return false;
+        usleep(POLL_INTERVAL_US);
+    }
+
+    if(memcmp(header->magic, SHARED_TILE_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+       header->version != SHARED_TILE_CACHE_VERSION)
+        return false;
+
+    const size_t slotsOffset = alignTo64(sizeof(Header));
+    const size_t dataOffset = slotsOffset + alignTo64(header->slotCount * sizeof(Slot));
+    if(dataOffset + size_t(header->slotCount) * header->slotBytes > mappingSize_)
+        return false;
+
+    // A segment without users is being unlinked, do not resurrect it
+    int count = readAtomic(header->attachCount);
+    while(count > 0 && !header->attachCount.testAndSetOrdered(count, count + 1))
+        count = readAtomic(header->attachCount);
+    if(count <= 0)
+        return false;
+
+    header_ = header;
+    slots_ = reinterpret_cast<Slot*>(static_cast<uchar*>(mapping_) + slotsOffset);
+    data_ = static_cast<uchar*>(mapping_) + dataOffset;
+    return true;
+}
+
+void SharedTileCache::detach()
+{
+    if(header_ && header_->attachCount.fetchAndAddOrdered(-1) == 1)
+        shm_unlink(name_.toLocal8Bit().constData());
+
+    if(mapping_)
+        munmap(mapping_, mappingSize_);
+    if(fd_ >= 0)
+        close(fd_);
+
+    fd_ = -1;
+    mapping_ = 0;
+    mappingSize_ = 0;
+    header_ = 0;
+    slots_ = 0;
+    data_ = 0;
+}
+
+SharedTileCache::Status SharedTileCache::acquire(const Key& key, QImage& image,
+                                                 Claim& claim)
+{
+    claim = Claim();
+    if(!isOpen())
+        return UNCACHED;
+
+    // The races with the other processes are resolved immediately
+    for(int attempt = 0; attempt < MAX_ACQUIRE_ATTEMPTS; ++attempt)
+    {
+        const LookupResult result = lookup(key, image);
+        if(result == LOOKUP_FOUND)
+            return HIT;
+
+        // Claiming also takes over tiles abandoned by a dead process
+        const int slot = this->claim(key, claim.sequence);
+        if(slot >= 0)
+        {
+            claim.slot = slot;
+            return CLAIMED;
+        }
+        if(slot == NO_SLOT)
+            return UNCACHED;
+        if(slot == DECODING)
+            return PENDING;
+    }
+    return PENDING;
+}
+
+bool SharedTileCache::find(const Key& key, QImage& image)
+{
+    return isOpen() && lookup(key, image) == LOOKUP_FOUND;
+}
+
+void SharedTileCache::publish(Claim& claim, const QImage& image)
+{
+    if(!isOpen() || claim.slot < 0)
+        return;
+
+    QImage tile = image;
+    if(tile.depth() != 32)
+        tile = tile.convertToFormat(tile.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+    const size_t size = size_t(tile.bytesPerLine()) * tile.height();
+    if(tile.isNull() || size > header_->slotBytes)
+    {
+        abandon(claim);
+        return;
+    }
+
+    // The claim was stolen by another process, which now owns the slot
+    if(!isClaimed(claim))
+    {
+        claim = Claim();
+        return;
+    }
+
+    Slot& slot = slots_[claim.slot];
+    memcpy(getSlotData(claim.slot), tile.constBits(), size);
+    slot.width = tile.width();
+    slot.height = tile.height();
+    slot.bytesPerLine = tile.bytesPerLine();
+    slot.format = tile.format();
+    slot.lastUsed.fetchAndStoreRelaxed(header_->clock.fetchAndAddRelaxed(1));
+
+    // Even sequence: the tile is visible to the readers. A claim stolen
+    // during the copy keeps the sequence of its new owner.
+    slot.sequence.testAndSetOrdered(claim.sequence, claim.sequence + 1);
+    claim = Claim();
+}
+
+void SharedTileCache::abandon(Claim& claim)
+{
+    if(!isOpen() || claim.slot < 0)
+        return;
+
+    if(isClaimed(claim))
+    {
+        Slot& slot = slots_[claim.slot];
+        slot.hash1 = 0;
+        slot.hash2 = 0;
+        slot.sequence.testAndSetOrdered(claim.sequence, claim.sequence + 1);
+    }
+    claim = Claim();
+}
+
+bool SharedTileCache::isClaimed(const Claim& claim)
+{
+    return readAtomic(slots_[claim.slot].sequence) == claim.sequence;
+}
+
+SharedTileCache::LookupResult SharedTileCache::lookup(const Key& key, QImage& image)
+{
+    bool pending = false;
+
+    for(int probe = 0; probe < PROBE_COUNT; ++probe)
+    {
+        const int index = (key.hash1 + probe) % header_->slotCount;
+        Slot& slot = slots_[index];
+
+        const int sequence = readAtomic(slot.sequence);
+        if(slot.hash1 != key.hash1 || slot.hash2 != key.hash2)
+            continue;
+
+        if(sequence & 1)
+        {
+            pending = true;
+            continue;
+        }
+
+        // The fields may be modified concurrently, validate them before use
+        const int width = slot.width;
+        const int height = slot.height;
+        const int bytesPerLine = slot.bytesPerLine;
+        const QImage::Format format = static_cast<QImage::Format>(slot.format);
+        if(width <= 0 || height <= 0 || bytesPerLine <= 0 ||
+           size_t(bytesPerLine) * height > header_->slotBytes ||
+           (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32 &&
+            format != QImage::Format_ARGB32_Premultiplied))
+            continue;
+
+        QImage tile(width, height, format);
+        if(tile.isNull() || tile.bytesPerLine() != bytesPerLine)
+            continue;
+        memcpy(tile.bits(), getSlotData(index), size_t(bytesPerLine) * height);
+
+        // The slot was modified during the copy
+        if(readAtomic(slot.sequence) != sequence)
+            continue;
+
+        slot.lastUsed.fetchAndStoreRelaxed(header_->clock.fetchAndAddRelaxed(1));
+        image = tile;
+        return LOOKUP_FOUND;
+    }
+
+    return pending ? LOOKUP_PENDING : LOOKUP_MISSING;
+}
+
+int SharedTileCache::claim(const Key& key, int& claimedSequence)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const int clock = readAtomic(header_->clock);
+
+    int candidate = NO_SLOT;
+    int candidateSequence = 0;
+    int candidateAge = -1;
+
+    for(int probe = 0; probe < PROBE_COUNT; ++probe)
+    {
+        const int index = (key.hash1 + probe) % header_->slotCount;
+        Slot& slot = slots_[index];
+
+        const int sequence = readAtomic(slot.sequence);
+        const bool sameKey = slot.hash1 == key.hash1 && slot.hash2 == key.hash2;
+
+        if(sequence & 1)
+        {
+            // Steal the claim of a process which probably died while decoding
+            if(isStaleClaim(index, sequence, now))
+            {
+                candidate = index;
+                candidateSequence = sequence;
+                candidateAge = INT_MAX;
+            }
+            else if(sameKey)
+                return DECODING;
+            continue;
+        }
+
+        // The tile was published after the lookup
+        if(sameKey)
+            return RETRY;
+
+        // Prefer empty slots, then the least recently used tile
+        const int age = slot.hash1 == 0 ? INT_MAX
+                                        : int(unsigned(clock) - unsigned(readAtomic(slot.lastUsed)));
+        if(age > candidateAge)
+        {
+            candidate = index;
+            candidateSequence = sequence;
+            candidateAge = age;
+        }
+    }
+
+    if(candidate == NO_SLOT)
+        return NO_SLOT;
+
+    // Odd sequence: the slot belongs to this writer until published. A
+    // stolen claim gets a new sequence, which invalidates the previous one.
+    claimedSequence = candidateSequence + ((candidateSequence & 1) ? 2 : 1);
+    if(!slots_[candidate].sequence.testAndSetOrdered(candidateSequence, claimedSequence))
+        return RETRY;
+
+    Slot& slot = slots_[candidate];
+    slot.hash1 = key.hash1;
+    slot.hash2 = key.hash2;
+    return candidate;
+}
+
+bool SharedTileCache::isStaleClaim(const int index, const int sequence, const qint64 now)
+{
+    // A claim is stale once the same odd sequence was seen for long enough.
+    // Each claim gets a new sequence, so it is timed from when it was first
+    // seen rather than from a claim time which is written after the claim.
+    QMutexLocker locker(&observedClaimsMutex_);
+
+    ObservedClaim& observed = observedClaims_[index];
+    if(observed.sequence != sequence)
+    {
+        observed.sequence = sequence;
+        observed.time = now;
+        return false;
+    }
+    return now - observed.time > STALE_CLAIM_MS;
+}
+
+uchar* SharedTileCache::getSlotData(const int index) const
+{
+    return data_ + size_t(index) * header_->slotBytes;
+}
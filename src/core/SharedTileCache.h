@@ -0,0 +1,194 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef SHAREDTILECACHE_H
+#define SHAREDTILECACHE_H
+
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+#include <boost/noncopyable.hpp>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A cache of decoded tiles in POSIX shared memory, shared by all the wall
+ * processes running on the same host.
+ *
+ * When several processes of a host display the same image, the first one to
+ * need a tile decodes it and publishes it to the cache; the other processes
+ * copy the decoded pixels instead of reading and decoding the file again.
+ *
+ * The cache has a fixed number of tile-sized slots, addressed by open hashing
+ * with a short probe sequence. Lookups are lock-free: each slot is protected
+ * by a sequence counter which is odd while the slot is being written, and
+ * readers validate their copy against it. Writers claim a slot by
+ * incrementing its counter with an atomic compare-and-swap, evicting the
+ * least recently used tile of the probe sequence.
+ *
+ * The shared memory segment is created by the first process and unlinked
+ * when the last process detaches from it. All methods are thread-safe.
+ */
+class SharedTileCache : public boost::noncopyable
+{
+public:
+    /** The 128 bits identifier of a tile. */
+    struct Key
+    {
+        Key() : hash1(0), hash2(0) {}
+
+        uint64_t hash1;
+        uint64_t hash2;
+    };
+
+    /** @return The key of a tile, from a unique tile name. */
+    static Key makeKey(const QString& tileName);
+
+    /** The right to write a tile in a slot of the cache. */
+    struct Claim
+    {
+        Claim() : slot(-1), sequence(0) {}
+
+        int slot;     // -1 if none
+        int sequence; // The odd sequence of the slot when it was claimed
+    };
+
+    /** The result of acquire(). */
+    enum Status
+    {
+        HIT,        // The image was found in the cache
+        CLAIMED,    // The caller must decode the tile and publish() it
+        PENDING,    // Another process is decoding the tile, try again later
+        UNCACHED    // The caller must decode the tile and not publish it
+    };
+
+    /**
+     * Open the cache, creating the shared memory segment if needed.
+     * If the segment already exists, its capacity is used instead.
+     * @param name The name of the shared memory segment, starting with '/'.
+     * @param capacity The maximum memory used by the tiles, in bytes.
+     * @param tileSize The maximum size of the tiles, in pixels.
+     */
+    SharedTileCache(const QString& name, const size_t capacity, const int tileSize);
+
+    /** Detach from the cache, unlinking the segment if it is no longer used. */
+    ~SharedTileCache();
+
+    /** @return true if the shared memory segment could be opened. */
+    bool isOpen() const;
+
+    /** @return The number of tile slots. */
+    size_t getSlotCount() const;
+
+    /**
+     * Get a tile from the cache, or claim the right to decode it.
+     *
+     * This function does not wait for other processes. If one of them is
+     * decoding the tile, the caller should try again later rather than
+     * decoding it too.
+     * @param key The tile.
+     * @param image Set to the cached image on HIT.
+     * @param claim Set to the claim to publish or abandon on CLAIMED.
+     * @return The status of the tile.
+     */
+    Status acquire(const Key& key, QImage& image, Claim& claim);
+
+    /** @return true and copy the tile to image if it is in the cache. */
+    bool find(const Key& key, QImage& image);
+
+    /**
+     * Store the decoded tile of a claim and make it visible to all processes.
+     * Images which are larger than the tile size are not stored, nor are
+     * the tiles of claims which were stolen by another process.
+     * @param claim The claim obtained from acquire(), reset.
+     * @param image The decoded tile.
+     */
+    void publish(Claim& claim, const QImage& image);
+
+    /**
+     * Give up a claim, for instance if the tile could not be decoded.
+     * @param claim The claim obtained from acquire(), reset.
+     */
+    void abandon(Claim& claim);
+
+private:
+    struct Header;
+    struct Slot;
+
+    enum LookupResult
+    {
+        LOOKUP_FOUND,
+        LOOKUP_PENDING,
+        LOOKUP_MISSING
+    };
+
+    /** An odd sequence of a slot, and when this process first saw it. */
+    struct ObservedClaim
+    {
+        ObservedClaim() : sequence(0), time(0) {}
+
+        int sequence;
+        qint64 time;
+    };
+
+    const QString name_;
+    int fd_;
+    void* mapping_;
+    size_t mappingSize_;
+
+    Header* header_;
+    Slot* slots_;
+    uchar* data_;
+
+    QMutex observedClaimsMutex_;
+    std::vector<ObservedClaim> observedClaims_;
+
+    bool create(const size_t capacity, const int tileSize);
+    bool attach();
+    void detach();
+
+    LookupResult lookup(const Key& key, QImage& image);
+    int claim(const Key& key, int& claimedSequence);
+    bool isClaimed(const Claim& claim);
+    bool isStaleClaim(const int index, const int sequence, const qint64 now);
+    uchar* getSlotData(const int index) const;
+};
+
+#endif // SHAREDTILECACHE_H
@@ -39,19 +39,97 @@
 #include "Texture.h"
 #include "log.h"
 
+#include "RenderContext.h"
+#include "GLWindow.h"
+
+#include <QImageReader>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+// maximum dimension of the preview of the full image
+#define PREVIEW_SIZE                512
+// maximum dimension of the decoded region (GL texture size limit)
+#define MAX_REGION_SIZE             8192
+// fraction of the visible region added on each side when decoding it
+#define REGION_MARGIN               0.25
+// decode again when the required resolution grows by this factor...
+#define RESOLUTION_INCREASE_FACTOR  1.25f
+// ...or shrinks by this factor
+#define RESOLUTION_DECREASE_FACTOR  4.f
+
+namespace
+{
+const QRectF UNIT_RECT(0., 0., 1., 1.);
+
+QImage readImage(const QString uri, const QRect clipRect, const QSize scaledSize)
+{
+    QImageReader reader(uri);
+
+    // The clip rectangle is applied first, then the scaling
+    if(clipRect.isValid())
+        reader.setClipRect(clipRect);
+    if(scaledSize.isValid())
+        reader.setScaledSize(scaledSize);
+
+    const QImage image = reader.read();
+    if(image.isNull())
+        put_flog(LOG_ERROR, "error reading %s: %s", uri.toLocal8Bit().constData(),
+                 reader.errorString().toLocal8Bit().constData());
+
+    // Textures are uploaded as GL_BGRA
+    if(image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32)
+        return image.convertToFormat(QImage::Format_ARGB32);
+    return image;
+}
+
+QRectF addMargin(const QRectF& region, const qreal margin)
+{
+    const qreal dx = region.width() * margin;
+    const qreal dy = region.height() * margin;
+    return region.adjusted(-dx, -dy, dx, dy) & UNIT_RECT;
+}
+}
+
 Texture::Texture(QString uri)
     : uri_( uri )
+    , imageWidth_( 0 )
+    , imageHeight_( 0 )
+    , previewScale_( 0.f )
+    , textureScale_( 0.f )
+    , requestedScale_( 0.f )
+    , requestFrameIndex_( 0 )
+    , decoding_( false )
+    , decodeFailed_( false )
+    , decodeScale_( 0.f )
 {
-    const QImage image(uri_);
-    if(image.isNull())
+    // Read the image dimensions from the header
+    QSize imageSize = QImageReader(uri_).size();
+
+    // Some image formats do not provide the size without decoding the image
+    if(!imageSize.isValid())
+    {
+        previewImage_ = readImage(uri_, QRect(), QSize());
+        imageSize = previewImage_.size();
+    }
+
+    if(imageSize.isEmpty())
     {
         put_flog(LOG_ERROR, "error loading %s", uri_.toLocal8Bit().constData());
         return;
     }
 
     // save image dimensions
-    imageWidth_ = image.width();
-    imageHeight_ = image.height();
+    imageWidth_ = imageSize.width();
+    imageHeight_ = imageSize.height();
+
+    const QSize previewSize = imageSize.boundedTo(QSize(PREVIEW_SIZE, PREVIEW_SIZE));
+    if(previewImage_.isNull())
+        previewImage_ = readImage(uri_, QRect(), imageSize.scaled(previewSize, Qt::KeepAspectRatio));
+    else
+        previewImage_ = previewImage_.scaled(previewSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    previewScale_ = (float)previewImage_.width() / (float)imageWidth_;
 }
 
 Texture::~Texture()
@@ -64,29 +142,193 @@ void Texture::getDimensions(int &width, int &height) const
     height = imageHeight_;
 }
 
-bool Texture::generateTexture()
+void Texture::finishLoading()
 {
-    const QImage image(uri_);
-    if(image.isNull())
+    uploadPreview();
+}
+
+size_t Texture::getHostMemoryUsage() const
+{
+    return previewImage_.byteCount();
+}
+
+size_t Texture::getGPUMemoryUsage() const
+{
+    return previewTexture_.getMemoryUsage() + texture_.getMemoryUsage();
+}
+
+void Texture::render(const QRectF& texCoords)
+{
+    if(!previewTexture_.isValid() && !uploadPreview())
+        return;
+
+    float scale = 0.f;
+    const QRectF visibleRegion = getVisibleRegion(texCoords, scale);
+
+    updateRequestedRegion(visibleRegion, scale);
+
+    if(visibleRegion.isEmpty())
+        return;
+
+    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // The preview fills the parts which are not covered by the decoded region
+    const bool regionCoversView = texture_.isValid() &&
+                                  textureRegion_.contains(visibleRegion);
+    if(!regionCoversView)
+        renderTexture(previewTexture_, UNIT_RECT, texCoords);
+
+    if(texture_.isValid())
     {
-        put_flog(LOG_ERROR, "error loading %s", uri_.toLocal8Bit().constData());
+        glDepthFunc(GL_LEQUAL);
+        renderTexture(texture_, textureRegion_, texCoords);
+    }
+
+    glPopAttrib();
+}
+
+bool Texture::uploadPreview()
+{
+    if(previewImage_.isNull())
         return false;
+
+    const bool success = previewTexture_.init(previewImage_, GL_BGRA);
+    previewImage_ = QImage();
+    return success;
+}
+
+QRectF Texture::getVisibleRegion(const QRectF& texCoords, float& scale) const
+{
+    GLWindowPtr glWindow = renderContext_->getActiveGLWindow();
+    const QRectF screenRect = glWindow->getProjectedPixelRect(true);
+    const QRectF fullRect = glWindow->getProjectedPixelRect(false);
+
+    if(screenRect.isEmpty())
+        return QRectF();
+
+    // screen pixels per image pixel
+    scale = fullRect.width() / (texCoords.width() * imageWidth_);
+
+    // visible part of the rendered unit quad, then of the image
+    const QRectF visibleQuad((screenRect.x() - fullRect.x()) / fullRect.width(),
+                             (screenRect.y() - fullRect.y()) / fullRect.height(),
+                             screenRect.width() / fullRect.width(),
+                             screenRect.height() / fullRect.height());
+
+    const QRectF region(texCoords.x() + visibleQuad.x() * texCoords.width(),
+                        texCoords.y() + visibleQuad.y() * texCoords.height(),
+                        visibleQuad.width() * texCoords.width(),
+                        visibleQuad.height() * texCoords.height());
+
+    return region & UNIT_RECT;
+}
+
+void Texture::updateRequestedRegion(const QRectF& visibleRegion, float scale)
+{
+    // The regions rendered by all the GLWindows of the previous frame are
+    // known on the first render of a new frame
+    if(getFrameIndex() != requestFrameIndex_)
+    {
+        if(decoding_ && decodeThread_.isFinished())
+            finishDecoding();
+
+        if(!decoding_ && needsDecoding())
+            startDecoding();
+
+        requestedRegion_ = QRectF();
+        requestedScale_ = 0.f;
+        requestFrameIndex_ = getFrameIndex();
     }
 
-    return texture_.init(image, GL_BGRA, true);
+    // Decoding beyond the full resolution of the image is useless
+    scale = std::min(scale, 1.f);
+
+    // The preview is sufficient when the image is small on screen
+    if(visibleRegion.isEmpty() || scale <= previewScale_)
+        return;
+
+    requestedRegion_ |= visibleRegion;
+    requestedScale_ = std::max(requestedScale_, scale);
 }
 
-void Texture::render(const QRectF& texCoords)
+bool Texture::needsDecoding() const
 {
-    if(!texture_.isValid() && !generateTexture())
+    if(decodeFailed_ || requestedRegion_.isEmpty())
+        return false;
+
+    if(!texture_.isValid() || !textureRegion_.contains(requestedRegion_))
+        return true;
+
+    return requestedScale_ > textureScale_ * RESOLUTION_INCREASE_FACTOR ||
+           requestedScale_ * RESOLUTION_DECREASE_FACTOR < textureScale_;
+}
+
+void Texture::startDecoding()
+{
+    const QRectF region = addMargin(requestedRegion_, REGION_MARGIN);
+    const QRect clipRect = QRectF(region.x() * imageWidth_, region.y() * imageHeight_,
+                                  region.width() * imageWidth_, region.height() * imageHeight_)
+                           .toAlignedRect() & QRect(0, 0, imageWidth_, imageHeight_);
+
+    QSize scaledSize(std::max(1, (int)(clipRect.width() * requestedScale_ + 0.5f)),
+                     std::max(1, (int)(clipRect.height() * requestedScale_ + 0.5f)));
+    if(scaledSize.width() > MAX_REGION_SIZE || scaledSize.height() > MAX_REGION_SIZE)
+        scaledSize.scale(MAX_REGION_SIZE, MAX_REGION_SIZE, Qt::KeepAspectRatio);
+
+    decodeRegion_ = QRectF((qreal)clipRect.x() / imageWidth_, (qreal)clipRect.y() / imageHeight_,
+                           (qreal)clipRect.width() / imageWidth_, (qreal)clipRect.height() / imageHeight_);
+    decodeScale_ = requestedScale_;
+
+    decodeThread_ = QtConcurrent::run(readImage, uri_, clipRect, scaledSize);
+    decoding_ = true;
+}
+
+void Texture::finishDecoding()
+{
+    decoding_ = false;
+
+    const QImage image = decodeThread_.result();
+    decodeThread_ = QFuture<QImage>();
+
+    if(image.isNull())
+    {
+        // Do not try again on every frame, the preview remains available
+        decodeFailed_ = true;
         return;
+    }
 
-    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
+    texture_.free();
+    texture_.init(image, GL_BGRA, true);
+    textureRegion_ = decodeRegion_;
+    textureScale_ = decodeScale_;
+}
 
-    texture_.bind();
+void Texture::renderTexture(GLTexture2D& texture, const QRectF& region,
+                            const QRectF& texCoords)
+{
+    // part of the texture coordinates covered by the texture's image region
+    const QRectF coveredRegion = texCoords & region;
+    if(coveredRegion.isEmpty())
+        return;
 
-    quad_.setTexCoords(texCoords);
+    const QRectF quadRect((coveredRegion.x() - texCoords.x()) / texCoords.width(),
+                          (coveredRegion.y() - texCoords.y()) / texCoords.height(),
+                          coveredRegion.width() / texCoords.width(),
+                          coveredRegion.height() / texCoords.height());
+
+    const QRectF regionTexCoords((coveredRegion.x() - region.x()) / region.width(),
+                                 (coveredRegion.y() - region.y()) / region.height(),
+                                 coveredRegion.width() / region.width(),
+                                 coveredRegion.height() / region.height());
+
+    glPushMatrix();
+    glTranslatef(quadRect.x(), quadRect.y(), 0.f);
+    glScalef(quadRect.width(), quadRect.height(), 1.f);
+
+    texture.bind();
+
+    quad_.setTexCoords(regionTexCoords);
     quad_.render();
 
-    glPopAttrib();
+    glPopMatrix();
 }
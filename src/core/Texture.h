@@ -43,6 +43,19 @@
 #include "GLTexture2D.h"
 #include "GLQuad.h"
 
+#include <QImage>
+#include <QFuture>
+#include <QRectF>
+
+/**
+ * A static image, such as a jpeg or png file.
+ *
+ * Only the image header is read on construction, along with a low resolution
+ * preview of the image. When rendering, the part of the image which is
+ * visible on the screens of the process is decoded in the background at the
+ * resolution needed for display. It is decoded again only when the view
+ * leaves the decoded region or the resolution changes significantly.
+ */
 class Texture : public FactoryObject
 {
 public:
@@ -51,6 +64,9 @@ public:
 
     void getDimensions(int &width, int &height) const override;
     void render(const QRectF& texCoords) override;
+    void finishLoading() override;
+    size_t getHostMemoryUsage() const override;
+    size_t getGPUMemoryUsage() const override;
 
 private:
     // image location
@@ -60,10 +76,38 @@ private:
     int imageWidth_;
     int imageHeight_;
 
+    // low resolution version of the full image, kept until uploaded to the GPU
+    QImage previewImage_;
+    GLTexture2D previewTexture_;
+    float previewScale_;
+
+    // region of the image, in normalized coordinates, and the resolution it
+    // was decoded for, in screen pixels per image pixel
     GLTexture2D texture_;
+    QRectF textureRegion_;
+    float textureScale_;
+
+    // union of the regions rendered in the current frame
+    QRectF requestedRegion_;
+    float requestedScale_;
+    uint64_t requestFrameIndex_;
+
+    QFuture<QImage> decodeThread_;
+    bool decoding_;
+    bool decodeFailed_;
+    QRectF decodeRegion_;
+    float decodeScale_;
+
     GLQuad quad_;
 
-    bool generateTexture();
+    bool uploadPreview();
+    QRectF getVisibleRegion(const QRectF& texCoords, float& scale) const;
+    void updateRequestedRegion(const QRectF& visibleRegion, float scale);
+    bool needsDecoding() const;
+    void startDecoding();
+    void finishDecoding();
+    void renderTexture(GLTexture2D& texture, const QRectF& region,
+                       const QRectF& texCoords);
 };
 
 #endif
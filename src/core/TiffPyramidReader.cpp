@@ -0,0 +1,345 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "TiffPyramidReader.h"
+
+#include "log.h"
+
+#include <QFileInfo>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+namespace
+{
+// Regions of a level larger than this factor of the target size are
+// averaged into the target image while their tiles are decoded
+const int MAX_DIRECT_SCALE_FACTOR = 2;
+
+/** Average the pixels of a region into a smaller image, one row segment at a time. */
+class AveragingBuffer
+{
+public:
+    AveragingBuffer(const QSize& regionSize, const QSize& targetSize)
+        : regionSize_(regionSize)
+        , targetSize_(targetSize)
+        , sums_(size_t(targetSize.width()) * targetSize.height() * 4, 0)
+        , counts_(size_t(targetSize.width()) * targetSize.height(), 0)
+        , columns_(regionSize.width())
+    {
+        for(int x = 0; x < regionSize.width(); ++x)
+            columns_[x] = int(qint64(x) * targetSize.width() / regionSize.width());
+    }
+
+    /** Add the RGBA pixels of a row segment starting at (x, y) in the region. */
+    void add(const int x, const int y, const uint32_t* pixels, const int count)
+    {
+        const size_t row = size_t(qint64(y) * targetSize_.height() / regionSize_.height()) * targetSize_.width();
+        for(int i = 0; i < count; ++i)
+        {
+            const size_t index = row + columns_[x + i];
+            uint64_t* sum = &sums_[4 * index];
+            sum[0] += TIFFGetR(pixels[i]);
+            sum[1] += TIFFGetG(pixels[i]);
+            sum[2] += TIFFGetB(pixels[i]);
+            sum[3] += TIFFGetA(pixels[i]);
+            ++counts_[index];
+        }
+    }
+
+    QImage toImage() const
+    {
+        QImage image(targetSize_, QImage::Format_ARGB32);
+        for(int y = 0; y < targetSize_.height(); ++y)
+        {
+            QRgb* out = reinterpret_cast<QRgb*>(image.scanLine(y));
+            for(int x = 0; x < targetSize_.width(); ++x)
+            {
+                const size_t index = size_t(y) * targetSize_.width() + x;
+                const uint64_t count = std::max(counts_[index], uint64_t(1));
+                const uint64_t* sum = &sums_[4 * index];
+                out[x] = qRgba(sum[0] / count, sum[1] / count, sum[2] / count, sum[3] / count);
+            }
+        }
+        return image;
+    }
+
+private:
+    const QSize regionSize_;
+    const QSize targetSize_;
+    std::vector<uint64_t> sums_;
+    std::vector<uint64_t> counts_;
+    std::vector<int> columns_; // The target column of each column of the region
+};
+}
+
+TiffPyramidReader::TiffPyramidReader()
+{
+}
+
+TiffPyramidReader::~TiffPyramidReader()
+{
+    close();
+}
+
+bool TiffPyramidReader::hasTiffExtension(const QString& filename)
+{
+    const QString extension = QFileInfo(filename).suffix().toLower();
+    return extension == "tif" || extension == "tiff";
+}
+
+bool TiffPyramidReader::open(const QString& filename)
+{
+    close();
+
+    TIFF* tiff = TIFFOpen(filename.toLocal8Bit().constData(), "r");
+    if(!tiff)
+        return false;
+
+    if(!TIFFIsTiled(tiff))
+    {
+        put_flog(LOG_DEBUG, "%s is not a tiled TIFF file", filename.toLocal8Bit().constData());
+        TIFFClose(tiff);
+        return false;
+    }
+
+    // The first image is the full resolution, followed by optional overviews
+    do
+    {
+        uint32_t width = 0, height = 0, tileWidth = 0, tileHeight = 0, subfileType = 0;
+        TIFFGetField(tiff, TIFFTAG_SUBFILETYPE, &subfileType);
+
+        if(!TIFFIsTiled(tiff) ||
+           !TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width) ||
+           !TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height) ||
+           !TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tileWidth) ||
+           !TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tileHeight))
+            continue;
+
+        if(!levels_.empty() && (!(subfileType & FILETYPE_REDUCEDIMAGE) ||
+                                width >= uint32_t(levels_[0].size.width())))
+            continue;
+
+        const Level level = { TIFFCurrentDirectory(tiff), QSize(width, height),
+                              QSize(tileWidth, tileHeight) };
+        levels_.push_back(level);
+    }
+    while(TIFFReadDirectory(tiff));
+
+    if(levels_.empty())
+    {
+        TIFFClose(tiff);
+        return false;
+    }
+
+    std::sort(levels_.begin() + 1, levels_.end(), isLarger);
+
+    filename_ = filename;
+    freeHandles_.push_back(tiff);
+
+    put_flog(LOG_INFO, "tiled TIFF %s: %ix%i pixels, %i levels", filename.toLocal8Bit().constData(),
+             getImageSize().width(), getImageSize().height(), getLevelCount());
+    return true;
+}
+
+QSize TiffPyramidReader::getImageSize() const
+{
+    return levels_.empty() ? QSize() : levels_[0].size;
+}
+
+int TiffPyramidReader::getLevelCount() const
+{
+    return levels_.size();
+}
+
+QImage TiffPyramidReader::readRegion(const QRect& region, const QSize& maxSize) const
+{
+    const QRect imageRect(QPoint(0, 0), getImageSize());
+    const QRect clippedRegion = region & imageRect;
+    if(clippedRegion.isEmpty())
+        return QImage();
+
+    const QSize targetSize = clippedRegion.size().scaled(maxSize, Qt::KeepAspectRatio);
+    if(targetSize.isEmpty())
+        return QImage();
+
+    const Level& level = selectLevel(clippedRegion, targetSize);
+
+    // The region in the coordinates of the level
+    const double scaleX = double(level.size.width()) / imageRect.width();
+    const double scaleY = double(level.size.height()) / imageRect.height();
+    const int x0 = std::floor(clippedRegion.x() * scaleX);
+    const int y0 = std::floor(clippedRegion.y() * scaleY);
+    const int x1 = std::max(x0 + 1, std::min(level.size.width(),
+                                             int(std::ceil((clippedRegion.x() + clippedRegion.width()) * scaleX))));
+    const int y1 = std::max(y0 + 1, std::min(level.size.height(),
+                                             int(std::ceil((clippedRegion.y() + clippedRegion.height()) * scaleY))));
+
+    // Without a suitable overview, the region of the level can be gigapixels.
+    // It is then averaged into the target size instead of being copied.
+    const QSize levelRegionSize(x1 - x0, y1 - y0);
+    const bool averaging = levelRegionSize.width() >= targetSize.width() &&
+                           levelRegionSize.height() >= targetSize.height() &&
+                           (levelRegionSize.width() > MAX_DIRECT_SCALE_FACTOR * targetSize.width() ||
+                            levelRegionSize.height() > MAX_DIRECT_SCALE_FACTOR * targetSize.height());
+
+    QImage image;
+    boost::scoped_ptr<AveragingBuffer> averagingBuffer;
+    if(averaging)
+        averagingBuffer.reset(new AveragingBuffer(levelRegionSize, targetSize));
+    else
+        image = QImage(levelRegionSize, QImage::Format_ARGB32);
+
+    const int tileWidth = level.tileSize.width();
+    const int tileHeight = level.tileSize.height();
+    std::vector<uint32_t> raster(size_t(tileWidth) * tileHeight);
+
+    TIFF* tiff = acquireHandle();
+    if(!tiff)
+        return QImage();
+
+    bool success = TIFFSetDirectory(tiff, level.directory);
+
+    // Decode only the tiles which overlap the region
+    for(int tileY = y0 - y0 % tileHeight; success && tileY < y1; tileY += tileHeight)
+    {
+        for(int tileX = x0 - x0 % tileWidth; success && tileX < x1; tileX += tileWidth)
+        {
+            success = TIFFReadRGBATile(tiff, tileX, tileY, &raster[0]);
+
+            const int left = std::max(tileX, x0);
+            const int right = std::min(tileX + tileWidth, x1);
+            const int top = std::max(tileY, y0);
+            const int bottom = std::min(tileY + tileHeight, y1);
+
+            for(int y = top; success && y < bottom; ++y)
+            {
+                // The raster of a tile is stored bottom-up
+                const uint32_t* in = &raster[size_t(tileHeight - 1 - (y - tileY)) * tileWidth];
+                if(averagingBuffer)
+                {
+                    averagingBuffer->add(left - x0, y - y0, in + (left - tileX), right - left);
+                    continue;
+                }
+
+                QRgb* out = reinterpret_cast<QRgb*>(image.scanLine(y - y0));
+
+                for(int x = left; x < right; ++x)
+                {
+                    const uint32_t pixel = in[x - tileX];
+                    out[x - x0] = qRgba(TIFFGetR(pixel), TIFFGetG(pixel),
+                                        TIFFGetB(pixel), TIFFGetA(pixel));
+                }
+            }
+        }
+    }
+
+    releaseHandle(tiff);
+
+    if(!success)
+    {
+        put_flog(LOG_ERROR, "could not read the tiles of %s", filename_.toLocal8Bit().constData());
+        return QImage();
+    }
+
+    if(averagingBuffer)
+        return averagingBuffer->toImage();
+
+    return image.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+void TiffPyramidReader::close()
+{
+    QMutexLocker locker(&handlesMutex_);
+
+    for(size_t i = 0; i < freeHandles_.size(); ++i)
+        TIFFClose(freeHandles_[i]);
+    freeHandles_.clear();
+
+    levels_.clear();
+    filename_.clear();
+}
+
+bool TiffPyramidReader::isLarger(const Level& level1, const Level& level2)
+{
+    return level1.size.width() > level2.size.width();
+}
+
+TIFF* TiffPyramidReader::acquireHandle() const
+{
+    {
+        QMutexLocker locker(&handlesMutex_);
+        if(!freeHandles_.empty())
+        {
+            TIFF* tiff = freeHandles_.back();
+            freeHandles_.pop_back();
+            return tiff;
+        }
+    }
+
+    TIFF* tiff = TIFFOpen(filename_.toLocal8Bit().constData(), "r");
+    if(!tiff)
+        put_flog(LOG_ERROR, "could not open %s", filename_.toLocal8Bit().constData());
+    return tiff;
+}
+
+void TiffPyramidReader::releaseHandle(TIFF* tiff) const
+{
+    QMutexLocker locker(&handlesMutex_);
+    freeHandles_.push_back(tiff);
+}
+
+const TiffPyramidReader::Level& TiffPyramidReader::selectLevel(const QRect& region,
+                                                               const QSize& targetSize) const
+{
+    const QSize& imageSize = levels_[0].size;
+
+    // The coarsest level which does not need upscaling
+    for(size_t i = levels_.size() - 1; i > 0; --i)
+    {
+        const Level& level = levels_[i];
+        if(qint64(region.width()) * level.size.width() >= qint64(targetSize.width()) * imageSize.width() &&
+           qint64(region.height()) * level.size.height() >= qint64(targetSize.height()) * imageSize.height())
+            return level;
+    }
+    return levels_[0];
+}
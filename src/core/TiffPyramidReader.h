@@ -0,0 +1,120 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef TIFFPYRAMIDREADER_H
+#define TIFFPYRAMIDREADER_H
+
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+#include <tiffio.h>
+
+/**
+ * Read regions of a tiled (Big)TIFF image, using its reduced resolution
+ * images as the levels of an image pyramid.
+ *
+ * Gigapixel microscopy and satellite images are commonly stored as tiled
+ * TIFF files with internal overviews. Only the tiles which overlap the
+ * requested region are decoded, from the coarsest level which has enough
+ * resolution, so the files can be displayed by DynamicTexture without
+ * generating an image pyramid first.
+ */
+class TiffPyramidReader : public boost::noncopyable
+{
+public:
+    /** Constructor. */
+    TiffPyramidReader();
+
+    /** Close the file. */
+    ~TiffPyramidReader();
+
+    /** @return true if the file has a TIFF extension. */
+    static bool hasTiffExtension(const QString& filename);
+
+    /**
+     * Open a tiled TIFF file.
+     * @return true if the file is a TIFF file whose full resolution image is tiled.
+     */
+    bool open(const QString& filename);
+
+    /** @return The size of the full resolution image. */
+    QSize getImageSize() const;
+
+    /** @return The number of resolution levels, including the full resolution. */
+    int getLevelCount() const;
+
+    /**
+     * Read a region of the image.
+     * The memory used is proportional to maxSize, even if the image has no
+     * level close to it. This function is thread safe.
+     * @param region The region in full resolution image coordinates.
+     * @param maxSize The region is scaled to fit this size, keeping its aspect ratio.
+     * @return The scaled region, null on error.
+     */
+    QImage readRegion(const QRect& region, const QSize& maxSize) const;
+
+private:
+    struct Level
+    {
+        tdir_t directory;
+        QSize size;
+        QSize tileSize;
+    };
+
+    QString filename_;
+    std::vector<Level> levels_; // Ordered from the full resolution
+
+    // libtiff handles are not thread safe, each reading thread uses its own
+    mutable QMutex handlesMutex_;
+    mutable std::vector<TIFF*> freeHandles_;
+
+    void close();
+    static bool isLarger(const Level& level1, const Level& level2);
+    TIFF* acquireHandle() const;
+    void releaseHandle(TIFF* tiff) const;
+    const Level& selectLevel(const QRect& region, const QSize& targetSize) const;
+};
+
+#endif // TIFFPYRAMIDREADER_H
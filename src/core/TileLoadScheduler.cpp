@@ -0,0 +1,346 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "TileLoadScheduler.h"
+
+#include "log.h"
+
+#include <QRunnable>
+
+#include <algorithm>
+
+/** Read the data of a tile in the I/O thread pool. */
+class TileReadJob : public QRunnable
+{
+public:
+    TileReadJob(TileLoadScheduler& scheduler, TileLoadRequestPtr request)
+        : scheduler_(scheduler)
+        , request_(request)
+    {}
+
+    void run() override
+    {
+        // The tile is loaded by someone else, retry in the next frame
+        if(!request_->prepareRead())
+        {
+            scheduler_.readPostponed(request_);
+            return;
+        }
+        request_->read();
+        scheduler_.readFinished(request_);
+    }
+
+private:
+    TileLoadScheduler& scheduler_;
+    TileLoadRequestPtr request_;
+};
+
+/** Decode a tile in the decoding thread pool. */
+class TileDecodeJob : public QRunnable
+{
+public:
+    TileDecodeJob(TileLoadRequestPtr request)
+        : request_(request)
+    {}
+
+    void run() override
+    {
+        // The tile may already have been decoded by a waiting thread
+        if(request_->changeState(TileLoadRequest::STATE_DECODE_QUEUED,
+                                 TileLoadRequest::STATE_DECODING))
+            request_->decode();
+    }
+
+private:
+    TileLoadRequestPtr request_;
+};
+
+TileLoadRequest::TileLoadRequest(boost::shared_ptr<TileSource> source,
+                                 const TilePriority& priority,
+                                 const uint64_t frameIndex)
+    : source_(source)
+    , priority_(priority)
+    , frameIndex_(frameIndex)
+    , postponed_(false)
+    , prefetched_(priority.prefetch)
+    , state_(STATE_QUEUED)
+{
+}
+
+bool TileLoadRequest::isFinished() const
+{
+    QMutexLocker locker(&mutex_);
+    return state_ == STATE_FINISHED || state_ == STATE_CANCELLED;
+}
+
+bool TileLoadRequest::isCancelled() const
+{
+    QMutexLocker locker(&mutex_);
+    return state_ == STATE_CANCELLED;
+}
+
+void TileLoadRequest::waitForFinished()
+{
+    // Load the tile in this thread rather than waiting for a pool thread.
+    // The tile is needed now, it is read even if its reading was postponed.
+    if(changeState(STATE_QUEUED, STATE_READING))
+    {
+        prepareRead();
+        read();
+        changeState(STATE_READING, STATE_DECODING);
+        decode();
+        return;
+    }
+
+    if(changeState(STATE_DECODE_QUEUED, STATE_DECODING))
+    {
+        decode();
+        return;
+    }
+
+    QMutexLocker locker(&mutex_);
+    while(state_ != STATE_FINISHED && state_ != STATE_CANCELLED)
+        finishedCondition_.wait(&mutex_);
+}
+
+bool TileLoadRequest::changeState(const State from, const State to)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(state_ != from)
+        return false;
+
+    state_ = to;
+
+    if(state_ == STATE_FINISHED || state_ == STATE_CANCELLED)
+        finishedCondition_.wakeAll();
+
+    return true;
+}
+
+bool TileLoadRequest::prepareRead()
+{
+    boost::shared_ptr<TileSource> source = source_.lock();
+    return !source || source->prepareTileRead();
+}
+
+void TileLoadRequest::read()
+{
+    boost::shared_ptr<TileSource> source = source_.lock();
+    if(source)
+        data_ = source->readTileData();
+}
+
+void TileLoadRequest::decode()
+{
+    boost::shared_ptr<TileSource> source = source_.lock();
+    if(source)
+        source->decodeTileData(data_);
+    data_.clear();
+
+    changeState(STATE_DECODING, STATE_FINISHED);
+}
+
+TileLoadScheduler::TileLoadScheduler(const int ioThreadCount,
+                                     const int decodeThreadCount)
+    : readingCount_(0)
+    , maxReadingCount_(2 * std::max(ioThreadCount, 1))
+    , frameIndex_(0)
+{
+    ioThreadPool_.setMaxThreadCount(std::max(ioThreadCount, 1));
+    decodeThreadPool_.setMaxThreadCount(std::max(decodeThreadCount, 1));
+}
+
+TileLoadScheduler::~TileLoadScheduler()
+{
+    {
+        QMutexLocker locker(&mutex_);
+
+        for(std::list<TileLoadRequestPtr>::iterator it = queue_.begin(); it != queue_.end(); ++it)
+            (*it)->changeState(TileLoadRequest::STATE_QUEUED, TileLoadRequest::STATE_CANCELLED);
+        queue_.clear();
+    }
+
+    // Reading jobs start decoding jobs, so wait for them first
+    ioThreadPool_.waitForDone();
+    decodeThreadPool_.waitForDone();
+
+    if(prefetchStatistics_.requested > 0)
+        put_flog(LOG_INFO, "tile prefetching: %llu requested, %llu used, %llu in time, %llu cancelled",
+                 (unsigned long long)prefetchStatistics_.requested,
+                 (unsigned long long)prefetchStatistics_.used,
+                 (unsigned long long)prefetchStatistics_.usedReady,
+                 (unsigned long long)prefetchStatistics_.cancelled);
+}
+
+TileLoadRequestPtr TileLoadScheduler::request(boost::shared_ptr<TileSource> source,
+                                              const TilePriority& priority)
+{
+    QMutexLocker locker(&mutex_);
+
+    TileLoadRequestPtr request(new TileLoadRequest(source, priority, frameIndex_));
+    queue_.push_back(request);
+
+    if(priority.prefetch)
+        ++prefetchStatistics_.requested;
+
+    dispatch();
+
+    return request;
+}
+
+void TileLoadScheduler::renew(TileLoadRequestPtr request, const TilePriority& priority)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(request->prefetched_ && !priority.prefetch)
+    {
+        request->prefetched_ = false;
+        ++prefetchStatistics_.used;
+        if(request->isFinished())
+            ++prefetchStatistics_.usedReady;
+    }
+
+    const bool renewedForRendering = request->frameIndex_ == frameIndex_ &&
+                                     !request->priority_.prefetch;
+    if(!(renewedForRendering && priority.prefetch))
+        request->priority_ = priority;
+    request->frameIndex_ = frameIndex_;
+}
+
+void TileLoadScheduler::nextFrame()
+{
+    QMutexLocker locker(&mutex_);
+
+    std::list<TileLoadRequestPtr>::iterator it = queue_.begin();
+    while(it != queue_.end())
+    {
+        TileLoadRequestPtr request = *it;
+
+        // Requests may also have been started by a waiting thread
+        const bool outdated = request->frameIndex_ < frameIndex_;
+        if(outdated && request->changeState(TileLoadRequest::STATE_QUEUED,
+                                            TileLoadRequest::STATE_CANCELLED))
+        {
+            if(request->prefetched_)
+                ++prefetchStatistics_.cancelled;
+            it = queue_.erase(it);
+        }
+        else if(request->isFinished())
+            it = queue_.erase(it);
+        else
+        {
+            request->postponed_ = false;
+            ++it;
+        }
+    }
+
+    ++frameIndex_;
+
+    // Start the postponed requests
+    dispatch();
+}
+
+size_t TileLoadScheduler::getQueuedCount() const
+{
+    QMutexLocker locker(&mutex_);
+    return queue_.size();
+}
+
+TilePrefetchStatistics TileLoadScheduler::getPrefetchStatistics() const
+{
+    QMutexLocker locker(&mutex_);
+    return prefetchStatistics_;
+}
+
+void TileLoadScheduler::dispatch()
+{
+    while(readingCount_ < maxReadingCount_)
+    {
+        std::list<TileLoadRequestPtr>::iterator best = queue_.end();
+        for(std::list<TileLoadRequestPtr>::iterator it = queue_.begin(); it != queue_.end(); ++it)
+        {
+            if((*it)->postponed_)
+                continue;
+            if(best == queue_.end() || (*best)->priority_ < (*it)->priority_)
+                best = it;
+        }
+        if(best == queue_.end())
+            return;
+
+        TileLoadRequestPtr request = *best;
+        queue_.erase(best);
+
+        // Skip requests which were loaded by a waiting thread
+        if(!request->changeState(TileLoadRequest::STATE_QUEUED,
+                                 TileLoadRequest::STATE_READING))
+            continue;
+
+        ++readingCount_;
+        ioThreadPool_.start(new TileReadJob(*this, request));
+    }
+}
+
+void TileLoadScheduler::readFinished(TileLoadRequestPtr request)
+{
+    if(request->changeState(TileLoadRequest::STATE_READING,
+                            TileLoadRequest::STATE_DECODE_QUEUED))
+        decodeThreadPool_.start(new TileDecodeJob(request));
+
+    QMutexLocker locker(&mutex_);
+
+    --readingCount_;
+    dispatch();
+}
+
+void TileLoadScheduler::readPostponed(TileLoadRequestPtr request)
+{
+    QMutexLocker locker(&mutex_);
+
+    // Queued again, the request is cancelled if it is not renewed
+    if(request->changeState(TileLoadRequest::STATE_READING,
+                            TileLoadRequest::STATE_QUEUED))
+    {
+        request->postponed_ = true;
+        queue_.push_back(request);
+    }
+
+    --readingCount_;
+    dispatch();
+}
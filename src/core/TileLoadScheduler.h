@@ -0,0 +1,274 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef TILELOADSCHEDULER_H
+#define TILELOADSCHEDULER_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <list>
+#include <stdint.h>
+
+/**
+ * An image tile which can be loaded by the TileLoadScheduler.
+ *
+ * Loading is split in two stages which run in separate thread pools, so that
+ * slow file systems do not starve the decoding threads and vice versa.
+ */
+class TileSource
+{
+public:
+    virtual ~TileSource() {}
+
+    /**
+     * Prepare the reading of the tile (I/O stage), before readTileData().
+     * @return false to postpone the reading to a later frame, for instance
+     *         while another process is loading the same tile.
+     */
+    virtual bool prepareTileRead() { return true; }
+
+    /**
+     * Read the encoded tile data (I/O stage).
+     * @return The data, or an empty array if the tile is not stored in a file.
+     */
+    virtual QByteArray readTileData() = 0;
+
+    /**
+     * Decode the tile (decoding stage).
+     * @param data The data returned by readTileData().
+     */
+    virtual void decodeTileData(const QByteArray& data) = 0;
+};
+
+/**
+ * The priority of a tile load request.
+ *
+ * Coarse tiles are loaded first, so that all visible images are refined
+ * level by level. Within a level, the tiles covering most pixels on screen
+ * are loaded first. Prefetched tiles, which are not visible yet, come after
+ * all the visible ones.
+ */
+struct TilePriority
+{
+    TilePriority(const int depth_ = 0, const double coverage_ = 0.,
+                 const bool prefetch_ = false)
+        : depth(depth_), coverage(coverage_), prefetch(prefetch_) {}
+
+    /** Depth of the tile in its image pyramid. */
+    int depth;
+
+    /** Area covered by the tile on screen, in pixels. */
+    double coverage;
+
+    /** The tile is expected to become visible in the next frames. */
+    bool prefetch;
+
+    /** @return true if this request must be served after the other one. */
+    bool operator<(const TilePriority& other) const
+    {
+        if(prefetch != other.prefetch)
+            return prefetch;
+        if(depth != other.depth)
+            return depth > other.depth;
+        return coverage < other.coverage;
+    }
+};
+
+/**
+ * A request to load a tile, as returned by the TileLoadScheduler.
+ */
+class TileLoadRequest : public boost::noncopyable
+{
+public:
+    /** @return true when the tile is loaded or the request was cancelled. */
+    bool isFinished() const;
+
+    /** @return true if the request was cancelled before the tile was loaded. */
+    bool isCancelled() const;
+
+    /**
+     * Block until the request is finished.
+     * If the tile is waiting to be loaded, it is loaded in the calling thread.
+     */
+    void waitForFinished();
+
+private:
+    friend class TileLoadScheduler;
+    friend class TileReadJob;
+    friend class TileDecodeJob;
+
+    enum State
+    {
+        STATE_QUEUED,
+        STATE_READING,
+        STATE_DECODE_QUEUED,
+        STATE_DECODING,
+        STATE_FINISHED,
+        STATE_CANCELLED
+    };
+
+    TileLoadRequest(boost::shared_ptr<TileSource> source,
+                    const TilePriority& priority, const uint64_t frameIndex);
+
+    boost::weak_ptr<TileSource> source_;
+    TilePriority priority_;
+    uint64_t frameIndex_;
+    bool postponed_; // Not dispatched again before the next frame
+    bool prefetched_; // Requested as a prefetch and not rendered yet
+
+    State state_;
+    QByteArray data_;
+    mutable QMutex mutex_;
+    QWaitCondition finishedCondition_;
+
+    bool changeState(const State from, const State to);
+    bool prepareRead();
+    void read();
+    void decode();
+};
+
+typedef boost::shared_ptr<TileLoadRequest> TileLoadRequestPtr;
+
+/**
+ * Statistics about prefetched tiles.
+ */
+struct TilePrefetchStatistics
+{
+    TilePrefetchStatistics()
+        : requested(0), used(0), usedReady(0), cancelled(0) {}
+
+    /** Number of prefetch requests. */
+    uint64_t requested;
+
+    /** Number of prefetched tiles which became visible. */
+    uint64_t used;
+
+    /** Number of prefetched tiles which were loaded when they became visible. */
+    uint64_t usedReady;
+
+    /** Number of prefetch requests cancelled before being served. */
+    uint64_t cancelled;
+
+    /** @return The fraction of prefetched tiles which were loaded in time. */
+    double getHitRate() const
+    {
+        return requested > 0 ? double(usedReady) / double(requested) : 0.;
+    }
+};
+
+/**
+ * Load image tiles for all the DynamicTextures of a process.
+ *
+ * Requests are kept in a queue ordered by TilePriority. A bounded number of
+ * them is handed to the I/O threads; the data read is then decoded by a
+ * separate pool of threads. Requests must be renewed every frame, those which
+ * are not (because the tile left the view or is no longer predicted to enter
+ * it) are cancelled if they have not started yet. Tiles which postpone their
+ * reading are queued again until the next frame.
+ */
+class TileLoadScheduler : public boost::noncopyable
+{
+public:
+    /**
+     * Constructor.
+     * @param ioThreadCount The number of threads reading tiles from files.
+     * @param decodeThreadCount The number of threads decoding tiles.
+     */
+    TileLoadScheduler(const int ioThreadCount = 2,
+                      const int decodeThreadCount = QThread::idealThreadCount());
+
+    /** Cancel all queued requests and wait for the running ones. */
+    ~TileLoadScheduler();
+
+    /**
+     * Request the loading of a tile in the current frame.
+     * @param source The tile to load.
+     * @param priority The priority of the request.
+     * @return The new request.
+     */
+    TileLoadRequestPtr request(boost::shared_ptr<TileSource> source,
+                               const TilePriority& priority);
+
+    /**
+     * Renew a request in the current frame, updating its priority.
+     * The new priority has no effect if the request has already started.
+     * A request renewed for rendering in the current frame keeps its priority
+     * if it is also renewed as a prefetch.
+     */
+    void renew(TileLoadRequestPtr request, const TilePriority& priority);
+
+    /**
+     * Start a new frame.
+     * The queued requests which were not made or renewed since the previous
+     * call are cancelled. Call this function once per frame.
+     */
+    void nextFrame();
+
+    /** @return The number of requests waiting to be dispatched. */
+    size_t getQueuedCount() const;
+
+    /** @return The statistics about prefetch requests. */
+    TilePrefetchStatistics getPrefetchStatistics() const;
+
+private:
+    friend class TileReadJob;
+
+    QThreadPool ioThreadPool_;
+    QThreadPool decodeThreadPool_;
+
+    mutable QMutex mutex_;
+    std::list<TileLoadRequestPtr> queue_;
+    size_t readingCount_;
+    const size_t maxReadingCount_;
+    uint64_t frameIndex_;
+    TilePrefetchStatistics prefetchStatistics_;
+
+    void dispatch();
+    void readFinished(TileLoadRequestPtr request);
+    void readPostponed(TileLoadRequestPtr request);
+};
+
+#endif // TILELOADSCHEDULER_H
@@ -0,0 +1,290 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "TileTexturePool.h"
+
+#include "log.h"
+
+#include <QImage>
+
+#include <cstring>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace
+{
+GLenum getInternalFormat(const CompressedImage::Format format)
+{
+    return format == CompressedImage::BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+                                          : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+}
+
+TileTexturePool::TileTexturePool(const size_t capacity, const int tileSize)
+    : capacity_(capacity)
+    , tileSize_(tileSize)
+    , frameIndex_(0)
+    , compressionSupported_(-1)
+{
+}
+
+TileTexturePool::~TileTexturePool()
+{
+    if(!slots_.empty())
+        put_flog(LOG_WARN, "%i tile textures were not freed", slots_.size());
+}
+
+TileTextureHandle TileTexturePool::upload(const QImage& image)
+{
+    TileTextureHandle handle;
+
+    if(image.isNull() || image.width() > tileSize_ || image.height() > tileSize_)
+    {
+        put_flog(LOG_ERROR, "invalid tile size: %ix%i", image.width(), image.height());
+        return handle;
+    }
+
+    QMutexLocker locker(&mutex_);
+
+    const int slot = beginUpload(image.size(), GL_RGBA);
+    if(slot < 0)
+        return handle;
+
+    const QImage tile = image.depth() == 32 ? image : image.convertToFormat(QImage::Format_RGB32);
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tile.width(), tile.height(),
+                    GL_BGRA, GL_UNSIGNED_BYTE, tile.bits());
+
+    handle.slot = slot;
+    handle.generation = slots_[slot].generation;
+    return handle;
+}
+
+TileTextureHandle TileTexturePool::upload(const CompressedImage& image)
+{
+    TileTextureHandle handle;
+
+    if(image.isNull() || image.size().width() > tileSize_ || image.size().height() > tileSize_)
+    {
+        put_flog(LOG_ERROR, "invalid tile size: %ix%i", image.size().width(), image.size().height());
+        return handle;
+    }
+
+    if(!isCompressionSupported())
+        return upload(image.decompress());
+
+    QMutexLocker locker(&mutex_);
+
+    const GLenum internalFormat = getInternalFormat(image.format());
+    const int slot = beginUpload(image.size(), internalFormat);
+    if(slot < 0)
+        return handle;
+
+    // The blocks cover the tile rounded up to a multiple of 4 pixels
+    const int width = (image.size().width() + 3) & ~3;
+    const int height = (image.size().height() + 3) & ~3;
+
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, internalFormat,
+                              image.blocks().size(), image.blocks().constData());
+
+    handle.slot = slot;
+    handle.generation = slots_[slot].generation;
+    return handle;
+}
+
+bool TileTexturePool::isValid(const TileTextureHandle& handle) const
+{
+    QMutexLocker locker(&mutex_);
+
+    return handle.slot >= 0 && size_t(handle.slot) < slots_.size() &&
+           slots_[handle.slot].generation == handle.generation;
+}
+
+QRectF TileTexturePool::bind(const TileTextureHandle& handle, const QRectF& texCoords)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(handle.slot < 0 || size_t(handle.slot) >= slots_.size() ||
+       slots_[handle.slot].generation != handle.generation)
+        return QRectF();
+
+    Slot& texture = slots_[handle.slot];
+    texture.lastUsedFrame = frameIndex_;
+
+    glBindTexture(GL_TEXTURE_2D, texture.textureId);
+
+    // The tile occupies the top-left part of the texture. Map the tile borders
+    // to the centers of the border texels to avoid sampling outside of it.
+    const double scaleX = (texture.tileSize.width() - 1.) / tileSize_;
+    const double scaleY = (texture.tileSize.height() - 1.) / tileSize_;
+    const double offset = 0.5 / tileSize_;
+
+    return QRectF(offset + texCoords.x() * scaleX, offset + texCoords.y() * scaleY,
+                  texCoords.width() * scaleX, texCoords.height() * scaleY);
+}
+
+void TileTexturePool::release(TileTextureHandle& handle)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(handle.slot >= 0 && size_t(handle.slot) < slots_.size() &&
+       slots_[handle.slot].generation == handle.generation)
+    {
+        slots_[handle.slot].used = false;
+    }
+    handle = TileTextureHandle();
+}
+
+void TileTexturePool::nextFrame()
+{
+    QMutexLocker locker(&mutex_);
+    ++frameIndex_;
+}
+
+size_t TileTexturePool::getCapacityBytes() const
+{
+    return capacity_ * tileSize_ * tileSize_ * 4;
+}
+
+size_t TileTexturePool::getTextureCount() const
+{
+    QMutexLocker locker(&mutex_);
+    return slots_.size();
+}
+
+void TileTexturePool::clear()
+{
+    QMutexLocker locker(&mutex_);
+
+    for(size_t i = 0; i < slots_.size(); ++i)
+        glDeleteTextures(1, &slots_[i].textureId);
+    slots_.clear();
+}
+
+int TileTexturePool::findSlot()
+{
+    // Reuse a released texture
+    for(size_t i = 0; i < slots_.size(); ++i)
+    {
+        if(!slots_[i].used)
+            return i;
+    }
+
+    // Create a new texture, allocated by beginUpload()
+    if(slots_.size() < capacity_)
+    {
+        Slot slot = { 0, 0, QSize(), 0, 0, false };
+
+        glGenTextures(1, &slot.textureId);
+        glBindTexture(GL_TEXTURE_2D, slot.textureId);
+        glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        slots_.push_back(slot);
+        return slots_.size() - 1;
+    }
+
+    // Evict the least recently rendered tile, except those of the current frame
+    int lruSlot = -1;
+    for(size_t i = 0; i < slots_.size(); ++i)
+    {
+        if(slots_[i].lastUsedFrame < frameIndex_ &&
+           (lruSlot < 0 || slots_[i].lastUsedFrame < slots_[lruSlot].lastUsedFrame))
+            lruSlot = i;
+    }
+    return lruSlot;
+}
+
+int TileTexturePool::beginUpload(const QSize& tileSize, const GLenum internalFormat)
+{
+    const int slot = findSlot();
+    if(slot < 0)
+        return slot;
+
+    Slot& texture = slots_[slot];
+    ++texture.generation;
+    texture.tileSize = tileSize;
+    texture.lastUsedFrame = frameIndex_;
+    texture.used = true;
+
+    glBindTexture(GL_TEXTURE_2D, texture.textureId);
+
+    if(texture.internalFormat != internalFormat)
+        allocateTexture(texture, internalFormat);
+
+    return slot;
+}
+
+void TileTexturePool::allocateTexture(Slot& texture, const GLenum internalFormat)
+{
+    if(internalFormat == GL_RGBA)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tileSize_, tileSize_,
+                     0, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    }
+    else
+    {
+        const CompressedImage::Format format = internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ?
+                                               CompressedImage::BC3 : CompressedImage::BC1;
+        const QByteArray blocks(CompressedImage::getBlocksSize(QSize(tileSize_, tileSize_), format), 0);
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, tileSize_, tileSize_,
+                               0, blocks.size(), blocks.constData());
+    }
+    texture.internalFormat = internalFormat;
+}
+
+bool TileTexturePool::isCompressionSupported()
+{
+    if(compressionSupported_ < 0)
+    {
+        const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+        compressionSupported_ = extensions && strstr(extensions, "GL_EXT_texture_compression_s3tc");
+        if(!compressionSupported_)
+            put_flog(LOG_WARN, "S3TC texture compression is not supported, compressed tiles are decoded on the CPU");
+    }
+    return compressionSupported_;
+}
@@ -0,0 +1,171 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef TILETEXTUREPOOL_H
+#define TILETEXTUREPOOL_H
+
+#include "CompressedImage.h"
+
+#include <QtOpenGL/qgl.h>
+#include <QMutex>
+#include <QRectF>
+#include <QSize>
+
+#include <boost/noncopyable.hpp>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A reference to a tile uploaded in the TileTexturePool.
+ *
+ * The reference becomes invalid when the pool recycles the texture for
+ * another tile.
+ */
+struct TileTextureHandle
+{
+    TileTextureHandle() : slot(-1), generation(0) {}
+
+    /** Index of the texture in the pool, -1 if none. */
+    int slot;
+
+    /** Use count of the slot at upload time. */
+    uint64_t generation;
+};
+
+/**
+ * A fixed-capacity pool of tile-sized textures shared by all the
+ * DynamicTextures of a process.
+ *
+ * Textures are allocated once and tiles are uploaded into recycled textures
+ * with glTexSubImage2D, which avoids a constant stream of texture creations
+ * and deletions while navigating large images. When the pool is full, the
+ * least recently rendered tile is evicted, independently of which
+ * DynamicTexture it belongs to.
+ *
+ * Block compressed tiles are uploaded with glCompressedTexSubImage2D into
+ * textures of the same compressed format, which use 4 to 8 times less GPU
+ * memory. A recycled texture is reallocated if the format changes.
+ *
+ * Except for release(), all methods must be called from the OpenGL thread.
+ */
+class TileTexturePool : public boost::noncopyable
+{
+public:
+    /**
+     * Constructor.
+     * @param capacity The maximum number of textures.
+     * @param tileSize The size of the square textures, in pixels.
+     */
+    TileTexturePool(const size_t capacity, const int tileSize);
+
+    /** Destructor. The textures must have been freed with clear(). */
+    ~TileTexturePool();
+
+    /**
+     * Upload a tile.
+     * @param image The tile, at most tileSize x tileSize pixels.
+     * @return The handle of the tile, with slot -1 if all the textures
+     *         are used by tiles rendered in the current frame.
+     */
+    TileTextureHandle upload(const QImage& image);
+
+    /**
+     * Upload a block compressed tile.
+     * The tile is decompressed on the CPU if the GPU does not support S3TC.
+     * @param image The tile, at most tileSize x tileSize pixels.
+     * @return The handle of the tile, see upload(const QImage&).
+     */
+    TileTextureHandle upload(const CompressedImage& image);
+
+    /** @return true if the tile is still in the pool. */
+    bool isValid(const TileTextureHandle& handle) const;
+
+    /**
+     * Bind the texture of a tile and mark it as used in the current frame.
+     * @param handle The tile.
+     * @param texCoords The region of the tile to render.
+     * @return The corresponding region of the texture. Empty if the tile is
+     *         no longer in the pool.
+     */
+    QRectF bind(const TileTextureHandle& handle, const QRectF& texCoords);
+
+    /**
+     * Give back the texture of a tile to the pool.
+     * This method is thread-safe and does not call OpenGL.
+     */
+    void release(TileTextureHandle& handle);
+
+    /** Start a new frame. Call this function once per frame. */
+    void nextFrame();
+
+    /** @return The maximum memory used by the pool, in bytes. */
+    size_t getCapacityBytes() const;
+
+    /** @return The number of allocated textures. */
+    size_t getTextureCount() const;
+
+    /** Free all the textures. */
+    void clear();
+
+private:
+    struct Slot
+    {
+        GLuint textureId;
+        GLenum internalFormat;
+        QSize tileSize;
+        uint64_t generation;
+        uint64_t lastUsedFrame;
+        bool used;
+    };
+
+    const size_t capacity_;
+    const int tileSize_;
+    uint64_t frameIndex_;
+    int compressionSupported_; // -1 until checked with a current GL context
+
+    mutable QMutex mutex_;
+    std::vector<Slot> slots_;
+
+    int findSlot();
+    int beginUpload(const QSize& tileSize, const GLenum internalFormat);
+    void allocateTexture(Slot& texture, const GLenum internalFormat);
+    bool isCompressionSupported();
+};
+
+#endif // TILETEXTUREPOOL_H
@@ -0,0 +1,116 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ViewPredictor.h"
+
+#include <cmath>
+
+#define SAMPLE_COUNT     3
+#define MIN_MOTION       1e-4
+
+ViewPredictor::ViewPredictor(const unsigned int lookAheadFrames)
+    : lookAheadFrames_(lookAheadFrames)
+{
+}
+
+void ViewPredictor::addView(const uint64_t frameIndex, const QRectF& view)
+{
+    if(!samples_.empty())
+    {
+        const uint64_t lastFrameIndex = samples_.back().frameIndex;
+        if(frameIndex == lastFrameIndex)
+            return;
+        if(frameIndex != lastFrameIndex + 1)
+            samples_.clear();
+    }
+
+    if(view.width() <= 0. || view.height() <= 0.)
+    {
+        samples_.clear();
+        return;
+    }
+
+    const Sample sample = { frameIndex, view };
+    samples_.push_back(sample);
+
+    if(samples_.size() > SAMPLE_COUNT)
+        samples_.pop_front();
+}
+
+bool ViewPredictor::predict(QRectF& view) const
+{
+    if(samples_.size() < SAMPLE_COUNT)
+        return false;
+
+    const Motion previous = getMotion(samples_[0].view, samples_[1].view);
+    const Motion current = getMotion(samples_[1].view, samples_[2].view);
+
+    const double currentNorm = current.dx * current.dx + current.dy * current.dy +
+            current.dLogWidth * current.dLogWidth + current.dLogHeight * current.dLogHeight;
+    if(currentNorm < MIN_MOTION * MIN_MOTION)
+        return false;
+
+    // The motion changed direction (or started), wait until it is steady
+    const double dot = previous.dx * current.dx + previous.dy * current.dy +
+            previous.dLogWidth * current.dLogWidth + previous.dLogHeight * current.dLogHeight;
+    if(dot <= 0.)
+        return false;
+
+    const QRectF& last = samples_.back().view;
+    const double width = last.width() * std::exp(lookAheadFrames_ * current.dLogWidth);
+    const double height = last.height() * std::exp(lookAheadFrames_ * current.dLogHeight);
+    const QPointF center = last.center() + lookAheadFrames_ * QPointF(current.dx, current.dy);
+
+    view = QRectF(center.x() - 0.5 * width, center.y() - 0.5 * height, width, height);
+    return true;
+}
+
+uint64_t ViewPredictor::getLastFrameIndex() const
+{
+    return samples_.empty() ? 0 : samples_.back().frameIndex;
+}
+
+ViewPredictor::Motion ViewPredictor::getMotion(const QRectF& from, const QRectF& to)
+{
+    const Motion motion = { to.center().x() - from.center().x(),
+                            to.center().y() - from.center().y(),
+                            std::log(to.width() / from.width()),
+                            std::log(to.height() / from.height()) };
+    return motion;
+}
@@ -0,0 +1,105 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef VIEWPREDICTOR_H
+#define VIEWPREDICTOR_H
+
+#include <QRectF>
+
+#include <deque>
+#include <stdint.h>
+
+/**
+ * Extrapolate the region of a Content shown by a ContentWindow.
+ *
+ * The views of the last frames, as defined by the ContentWindow's center and
+ * zoom, are used to estimate the pan and zoom velocity. A prediction is only
+ * made while the motion is steady: it is dropped as soon as the window stops
+ * or the motion changes direction.
+ */
+class ViewPredictor
+{
+public:
+    /**
+     * Constructor.
+     * @param lookAheadFrames The number of frames to extrapolate.
+     */
+    ViewPredictor(const unsigned int lookAheadFrames = 5);
+
+    /**
+     * Add the view of a frame.
+     * Only the first view of each frame is used. The history is restarted if
+     * the previous frame was skipped, for instance if the window was hidden.
+     * @param frameIndex The index of the frame.
+     * @param view The region of the Content shown, in normalized texture coordinates.
+     */
+    void addView(const uint64_t frameIndex, const QRectF& view);
+
+    /**
+     * Predict the view in lookAheadFrames.
+     * @param view Returned predicted region.
+     * @return false if no prediction can be made.
+     */
+    bool predict(QRectF& view) const;
+
+    /** @return The index of the last frame added. */
+    uint64_t getLastFrameIndex() const;
+
+private:
+    struct Sample
+    {
+        uint64_t frameIndex;
+        QRectF view;
+    };
+
+    struct Motion
+    {
+        double dx;
+        double dy;
+        double dLogWidth;
+        double dLogHeight;
+    };
+
+    unsigned int lookAheadFrames_;
+    std::deque<Sample> samples_;
+
+    static Motion getMotion(const QRectF& from, const QRectF& to);
+};
+
+#endif // VIEWPREDICTOR_H
@@ -55,6 +55,7 @@ Configuration::Configuration(const QString &filename)
     , mullionWidth_(0)
     , mullionHeight_(0)
     , fullscreen_(false)
+    , streamMoviesFromMaster_(false)
     , backgroundColor_(Qt::black)
 {
     load();
@@ -106,6 +107,11 @@ void Configuration::load()
 
     put_flog(LOG_INFO, "dimensions: numTilesWidth = %i, numTilesHeight = %i, screenWidth = %i, screenHeight = %i, mullionWidth = %i, mullionHeight = %i. fullscreen = %i", totalScreenCountX_, totalScreenCountY_, screenWidth_, screenHeight_, mullionWidth_, mullionHeight_, fullscreen_);
 
+    // Movie playback mode
+    query.setQuery("string(/configuration/movies/@streamFromMaster)");
+    if(query.evaluateTo(&queryResult))
+        streamMoviesFromMaster_ = queryResult.toInt() != 0;
+
     // Background content URI
     query.setQuery("string(/configuration/background/@uri)");
     if(query.evaluateTo(&queryResult))
@@ -198,6 +204,11 @@ bool Configuration::getFullscreen() const
     return fullscreen_;
 }
 
+bool Configuration::getStreamMoviesFromMaster() const
+{
+    return streamMoviesFromMaster_;
+}
+
 const QString &Configuration::getBackgroundUri() const
 {
     return backgroundUri_;
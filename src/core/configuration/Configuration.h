@@ -141,6 +141,14 @@ public:
      */
     bool getFullscreen() const;
 
+    /**
+     * @brief getStreamMoviesFromMaster Demux the movies on the master process
+     *        and send the compressed packets to the wall processes, instead of
+     *        letting each wall process read the movie files
+     * @return defaults to false if unspecified
+     */
+    bool getStreamMoviesFromMaster() const;
+
     /**
      * @brief getBackgroundUri Get the URI to the Content to be used as background
      * @return empty string if unspecified
@@ -195,6 +203,7 @@ private:
     int mullionWidth_;
     int mullionHeight_;
     bool fullscreen_;
+    bool streamMoviesFromMaster_;
 
     QString backgroundUri_;
     QColor backgroundColor_;
@@ -43,9 +43,16 @@
 
 #include "log.h"
 
+#define DEFAULT_HOST_MEMORY_BUDGET_MB 2048
+#define DEFAULT_GPU_MEMORY_BUDGET_MB 1024
+#define DEFAULT_SHARED_TILE_CACHE_BUDGET_MB 0
+
 WallConfiguration::WallConfiguration(const QString &filename, const int processIndex)
     : Configuration(filename)
     , screenCountForCurrentProcess_(0)
+    , hostMemoryBudget_(DEFAULT_HOST_MEMORY_BUDGET_MB)
+    , gpuMemoryBudget_(DEFAULT_GPU_MEMORY_BUDGET_MB)
+    , sharedTileCacheBudget_(DEFAULT_SHARED_TILE_CACHE_BUDGET_MB)
 {
     loadWallSettings(processIndex);
 }
@@ -115,6 +122,29 @@ void WallConfiguration::loadWallSettings(const int processIndex)
 
         put_flog(LOG_INFO, "  screen parameters: posX = %i, posY = %i, indexX = %i, indexY = %i", screenPosition.x(), screenPosition.y(), screenIndex.x(), screenIndex.y());
     }
+
+    loadMemorySettings(query);
+}
+
+void WallConfiguration::loadMemorySettings(QXmlQuery& query)
+{
+    QString queryResult;
+
+    // memory budgets (optional attributes)
+    query.setQuery("string(/configuration/memory/@host)");
+    if(query.evaluateTo(&queryResult) && queryResult.toInt() > 0)
+        hostMemoryBudget_ = queryResult.toInt();
+
+    query.setQuery("string(/configuration/memory/@gpu)");
+    if(query.evaluateTo(&queryResult) && queryResult.toInt() > 0)
+        gpuMemoryBudget_ = queryResult.toInt();
+
+    query.setQuery("string(/configuration/memory/@sharedTileCache)");
+    if(query.evaluateTo(&queryResult) && queryResult.toInt() > 0)
+        sharedTileCacheBudget_ = queryResult.toInt();
+
+    put_flog(LOG_INFO, "memory budget: host = %i MB, gpu = %i MB, shared tile cache = %i MB",
+             hostMemoryBudget_, gpuMemoryBudget_, sharedTileCacheBudget_);
 }
 
 const QString &WallConfiguration::getHost() const
@@ -141,3 +171,18 @@ const QPoint &WallConfiguration::getGlobalScreenIndex(int screenIndex) const
 {
     return screenGlobalIndex_.at(screenIndex);
 }
+
+int WallConfiguration::getHostMemoryBudget() const
+{
+    return hostMemoryBudget_;
+}
+
+int WallConfiguration::getGPUMemoryBudget() const
+{
+    return gpuMemoryBudget_;
+}
+
+int WallConfiguration::getSharedTileCacheBudget() const
+{
+    return sharedTileCacheBudget_;
+}
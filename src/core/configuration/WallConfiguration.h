@@ -43,6 +43,8 @@
 #include "Configuration.h"
 #include <QPoint>
 
+class QXmlQuery;
+
 /**
  * @brief The WallConfiguration class manages all the parameters needed
  * to setup a Wall process.
@@ -90,6 +92,25 @@ public:
      */
     const QPoint& getGlobalScreenIndex(int screenIndex) const;
 
+    /**
+     * @brief getHostMemoryBudget Get the host memory available for caching Contents
+     * @return memory budget in MB
+     */
+    int getHostMemoryBudget() const;
+
+    /**
+     * @brief getGPUMemoryBudget Get the GPU memory available for caching Contents
+     * @return memory budget in MB
+     */
+    int getGPUMemoryBudget() const;
+
+    /**
+     * @brief getSharedTileCacheBudget Get the shared memory used to cache
+     *        decoded image tiles between the processes of the same host
+     * @return memory budget in MB, 0 if the cache is disabled
+     */
+    int getSharedTileCacheBudget() const;
+
 private:
 
     QString host_;
@@ -99,7 +120,12 @@ private:
     std::vector<QPoint> screenPosition_;
     std::vector<QPoint> screenGlobalIndex_;
 
+    int hostMemoryBudget_;
+    int gpuMemoryBudget_;
+    int sharedTileCacheBudget_;
+
     void loadWallSettings(const int processIndex);
+    void loadMemorySettings(QXmlQuery& query);
 };
 
 #endif // WALLCONFIGURATION_H
@@ -42,49 +42,122 @@
 #include "thumbnail/ThumbnailGeneratorFactory.h"
 #include "thumbnail/ThumbnailGenerator.h"
 
-#include <QFileInfo>
-#include <QDateTime>
+#include <QtCore/QMetaObject>
+#include <QtCore/QRunnable>
 
-#define USE_CACHE
-#define CACHE_MAX_SIZE 100
-#define MODIFICATION_DATE_KEY "lastModificationDate"
+/** Process the requests of an AsyncImageLoader until its queue is empty. */
+class ImageLoadJob : public QRunnable
+{
+public:
+    ImageLoadJob(AsyncImageLoader& loader, const QSize& size)
+        : loader_(loader)
+        , size_(size)
+    {}
+
+    void run() override
+    {
+        AsyncImageLoader::ImageRequest request;
+        int generation = 0;
+        while( loader_.takeRequest( request, generation ))
+        {
+            const QString& filename = request.second;
+            const QImage image = ThumbnailGeneratorFactory::getGenerator( filename, size_ )->generate( filename );
+            loader_.finishRequest( request, generation, image );
+        }
+    }
 
-AsyncImageLoader::AsyncImageLoader(const QSize& defaultSize)
+private:
+    AsyncImageLoader& loader_;
+    const QSize size_;
+};
+
+AsyncImageLoader::AsyncImageLoader(const QSize& defaultSize, const int threadCount)
     : defaultSize_(defaultSize)
+    , activeJobs_(0)
+    , generation_(0)
+{
+    threadPool_.setMaxThreadCount( threadCount );
+}
+
+AsyncImageLoader::~AsyncImageLoader()
+{
+    cancelAll();
+    threadPool_.waitForDone();
+}
+
+void AsyncImageLoader::loadImages( const QList<ImageRequest>& requests )
+{
+    QMutexLocker locker( &mutex_ );
+
+    queue_.clear();
+    foreach( const ImageRequest& request, requests )
+    {
+        if( !running_.contains( request.first ))
+            queue_.append( request );
+    }
+    startJobs();
+}
+
+void AsyncImageLoader::cancelAll()
 {
-    cache_.setMaxCost(CACHE_MAX_SIZE);
+    QMutexLocker locker( &mutex_ );
+
+    queue_.clear();
+    running_.clear();
+    ++generation_;
 }
 
-void AsyncImageLoader::loadImage( const QString& filename, const int index )
+void AsyncImageLoader::onImageLoaded( int generation, int index, QImage image )
 {
-#ifdef USE_CACHE
-    if (imageInCache(filename))
     {
-        emit imageLoaded(index, *cache_[filename]);
-        return;
+        QMutexLocker locker( &mutex_ );
+        if( generation != generation_ )
+            return;
     }
-#endif
+    emit imageLoaded( index, image );
+}
 
-    QImage image = ThumbnailGeneratorFactory::getGenerator(filename, defaultSize_)->generate(filename);
-    if (!image.isNull())
+bool AsyncImageLoader::takeRequest( ImageRequest& request, int& generation )
+{
+    QMutexLocker locker( &mutex_ );
+
+    if( queue_.isEmpty( ))
     {
-#ifdef USE_CACHE
-        // QCache requires a <T>* and takes ownership, so we have to create new QImage
-        QImage* cacheImage = new QImage(image);
-        cacheImage->setText(MODIFICATION_DATE_KEY, QFileInfo(filename).lastModified().toString());
-        cache_.insert(filename, cacheImage);
-#endif
-        emit imageLoaded(index, image);
+        --activeJobs_;
+        return false;
     }
 
-    emit imageLoadingFinished();
+    request = queue_.takeFirst();
+    generation = generation_;
+    running_.insert( request.first );
+    return true;
 }
 
-bool AsyncImageLoader::imageInCache(const QString& filename) const
+void AsyncImageLoader::finishRequest( const ImageRequest& request, const int generation,
+                                      const QImage& image )
 {
-    if (!cache_.contains(filename))
-        return false;
+    {
+        QMutexLocker locker( &mutex_ );
+        if( generation != generation_ )
+            return;
+        running_.remove( request.first );
+    }
+
+    // The result is delivered in the thread of the loader, where cancelAll()
+    // may have been called since it was generated
+    if( !image.isNull( ))
+        QMetaObject::invokeMethod( this, "onImageLoaded", Qt::QueuedConnection,
+                                   Q_ARG( int, generation ),
+                                   Q_ARG( int, request.first ),
+                                   Q_ARG( QImage, image ));
+}
 
-    const QFileInfo info(filename);
-    return info.lastModified().toString() == cache_.object(filename)->text(MODIFICATION_DATE_KEY);
+void AsyncImageLoader::startJobs()
+{
+    // Called with the mutex locked
+    while( activeJobs_ < threadPool_.maxThreadCount() && activeJobs_ < queue_.size( ))
+    {
+        ++activeJobs_;
+        threadPool_.start( new ImageLoadJob( *this, defaultSize_ ));
+    }
 }
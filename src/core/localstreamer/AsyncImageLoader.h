@@ -40,57 +40,85 @@
 #ifndef ASYNIMAGELOADER_H
 #define ASYNIMAGELOADER_H
 
+#include <QtCore/QList>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
-#include <QtCore/QCache>
+#include <QtCore/QPair>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
 #include <QtGui/QImage>
 
 /**
  * Load image thumbnails for supported content types.
  *
- * The AsyncImageLoader is designed to be moved to a worker thread.
- * It maintain a cache with the 100 latest images for performance.
+ * The thumbnails are generated by a pool of worker threads. Each worker takes
+ * the first request of the queue when it starts, so the queue can be
+ * reordered or trimmed at any time to follow the user. Requests which are
+ * already being processed can not be interrupted, but their thumbnails are
+ * still kept in the ThumbnailCache shared by all generators.
  */
 class AsyncImageLoader : public QObject
 {
     Q_OBJECT
 
 public:
+    /** A thumbnail to load: a user-defined index and the path to the content file. */
+    typedef QPair<int, QString> ImageRequest;
+
     /**
      * Constructor.
      *
      * @param defaultSize The desired size for the thumbnails.
+     * @param threadCount The number of worker threads.
      */
-    AsyncImageLoader(const QSize &defaultSize);
+    AsyncImageLoader(const QSize &defaultSize, const int threadCount);
+
+    /** Cancel the queued requests and wait for the running ones. */
+    ~AsyncImageLoader();
 
-public slots:
     /**
-     * Load an image thumbnail.
+     * Replace the queued requests.
      *
-     * This method is blocking; it designed to be call via a QSignal after the
-     * AsyncImageLoader has been moved to a worker thread.
-     * @param filename The path to the content file.
-     * @param index A user-defined index that will be passed back with imageLoaded().
-     *        Used by DockPixelStreamer.
+     * The requests which are not in the new list are cancelled, unless they
+     * are already being processed.
+     * @param requests The thumbnails to load, in decreasing priority.
      */
-    void loadImage( const QString& filename, const int index );
+    void loadImages( const QList<ImageRequest>& requests );
+
+    /**
+     * Cancel all the requests.
+     * The thumbnails of the requests being processed are not emitted.
+     */
+    void cancelAll();
 
 signals:
     /**
-     * Emitted when an image could be successfully loaded by loadImage().
+     * Emitted when an image could be successfully loaded.
      *
-     * @param index The user-defined index passed in loadImage().
+     * @param index The user-defined index of the request.
      * @param image The thumbnail image.
      */
     void imageLoaded(int index, QImage image);
 
-    /** Emitted whenever loadImage() has finished (successful or not). */
-    void imageLoadingFinished();
+private slots:
+    void onImageLoaded(int generation, int index, QImage image);
 
 private:
+    friend class ImageLoadJob;
+
     QSize defaultSize_;
-    QCache<QString, QImage> cache_;
+    QThreadPool threadPool_;
+
+    QMutex mutex_;
+    QList<ImageRequest> queue_;
+    QSet<int> running_;
+    int activeJobs_;
+    int generation_;
 
-    bool imageInCache(const QString& filename) const;
+    bool takeRequest( ImageRequest& request, int& generation );
+    void finishRequest( const ImageRequest& request, const int generation,
+                        const QImage& image );
+    void startJobs();
 };
 
 
@@ -57,6 +57,9 @@
 
 #define COVERFLOW_SPEED_FACTOR   0.1
 
+#define LOADER_THREAD_COUNT      4
+#define MAX_CACHED_SLIDES        4096
+
 #define WEBBROWSER_ICON ":/img/browser-icon.png"
 #define CLEARALL_ICON ":/img/clearall-icon.png"
 
@@ -82,7 +85,8 @@ DockPixelStreamer::DockPixelStreamer(const QSize& desiredDockSize, const QString
     createToolbar(dockSize.width(), dockSize.height()*0.15);
     createImageLoader();
 
-    loadThread_.start();
+    directoryListings_.setMaxCost(MAX_CACHED_SLIDES);
+    scrollTimer_.start();
 
     if (rootDir.isEmpty() || !setRootDir(rootDir))
         setRootDir(QDir::homePath());
@@ -90,10 +94,8 @@ DockPixelStreamer::DockPixelStreamer(const QSize& desiredDockSize, const QString
 
 DockPixelStreamer::~DockPixelStreamer()
 {
-    loadThread_.quit();
-    loadThread_.wait();
-    delete flow_;
     delete loader_;
+    delete flow_;
     delete toolbar_;
 }
 
@@ -195,32 +197,27 @@ void DockPixelStreamer::update(const QImage& image)
 
 void DockPixelStreamer::loadThumbnails(int newCenterIndex)
 {
-    const int nbThumbnails = 2;
-
-    slideImagesToLoad_.clear();
+    prefetchWindow_.setCenter(newCenterIndex, scrollTimer_.elapsed() / 1000.0);
 
-    int imin = std::max(newCenterIndex-nbThumbnails, 0);
-    int imax = std::min(newCenterIndex+nbThumbnails, slideImagesLoaded_.size()-1);
-    for (int i=imin; i<=imax; i++)
+    // The requests which are no longer in the window are cancelled
+    QList<AsyncImageLoader::ImageRequest> requests;
+    const std::vector<int> slides = prefetchWindow_.getSlides(slideImagesLoaded_.size());
+    for (size_t i = 0; i < slides.size(); ++i)
     {
-        slideImagesToLoad_.append(i);
+        const SlideImageLoadingStatus& status = slideImagesLoaded_[slides[i]];
+        if (!status.first)
+            requests.append(qMakePair(slides[i], status.second));
     }
-    loadNextThumbnailInList();
+    loader_->loadImages(requests);
 }
 
-void DockPixelStreamer::loadNextThumbnailInList()
+void DockPixelStreamer::setThumbnail(int index, QImage image)
 {
-    while(!slideImagesToLoad_.empty())
-    {
-        int i = slideImagesToLoad_.front();
-        slideImagesToLoad_.pop_front();
-        if (!slideImagesLoaded_[i].first)
-        {
-            slideImagesLoaded_[i].first = true;
-            emit renderPreview( slideImagesLoaded_[i].second, i );
-            return;
-        }
-    }
+    if (index < 0 || index >= slideImagesLoaded_.size())
+        return;
+
+    slideImagesLoaded_[index].first = true;
+    flow_->setSlide(index, image);
 }
 
 void DockPixelStreamer::createFlow(const QSize& dockSize)
@@ -249,34 +246,78 @@ void DockPixelStreamer::createToolbar(const unsigned int width, const unsigned i
 
 void DockPixelStreamer::createImageLoader()
 {
-    loader_ = new AsyncImageLoader(flow_->slideSize());
-    loader_->moveToThread( &loadThread_ );
+    loader_ = new AsyncImageLoader(flow_->slideSize(), LOADER_THREAD_COUNT);
     connect( loader_, SIGNAL(imageLoaded(int, QImage)),
-             flow_, SLOT(setSlide( int, QImage )));
-    connect( this, SIGNAL(renderPreview( const QString&, const int )),
-             loader_, SLOT(loadImage( const QString&, const int )));
-    connect( loader_, SIGNAL(imageLoadingFinished()),
-             this, SLOT(loadNextThumbnailInList()));
+             this, SLOT(setThumbnail( int, QImage )));
 }
 
 void DockPixelStreamer::changeDirectory( const QString& dir )
 {
     slideIndex_[currentDir_.path()] = flow_->centerIndex();
+    saveDirectoryListing();
 
+    loader_->cancelAll();
     flow_->clear();
-    slideImagesToLoad_.clear();
     slideImagesLoaded_.clear();
+    currentCaptions_.clear();
 
     currentDir_ = QDir(dir);
-    if (dir != rootDir_)
+    if (!restoreDirectoryListing())
     {
-        addRootDirToFlow();
+        if (dir != rootDir_)
+        {
+            addRootDirToFlow();
+        }
+        addFilesToFlow();
+        addFoldersToFlow();
     }
-    addFilesToFlow();
-    addFoldersToFlow();
 
-    flow_->setCenterIndex( slideIndex_[currentDir_.path()] );
-    loadThumbnails( slideIndex_[currentDir_.path()] );
+    const int centerIndex = slideIndex_[currentDir_.path()];
+    flow_->setCenterIndex( centerIndex );
+    prefetchWindow_.reset( centerIndex );
+    loadThumbnails( centerIndex );
+}
+
+void DockPixelStreamer::saveDirectoryListing()
+{
+    if (slideImagesLoaded_.isEmpty())
+        return;
+
+    DirectoryListing* listing = new DirectoryListing;
+    listing->lastModified = QFileInfo(currentDir_.path()).lastModified();
+    for (int i = 0; i < flow_->slideCount(); ++i)
+        listing->images.append(flow_->slide(i));
+    listing->captions = currentCaptions_;
+    listing->slides = slideImagesLoaded_;
+
+    directoryListings_.insert(currentDir_.path(), listing, listing->slides.size());
+}
+
+bool DockPixelStreamer::restoreDirectoryListing()
+{
+    // Files added to or removed from the directory change its modification time
+    const DirectoryListing* listing = directoryListings_.object(currentDir_.path());
+    if (!listing || listing->lastModified != QFileInfo(currentDir_.path()).lastModified())
+        return false;
+
+    for (int i = 0; i < listing->slides.size(); ++i)
+    {
+        // The thumbnails are shown immediately and refreshed from the
+        // ThumbnailCache, in case the files were modified
+        SlideImageLoadingStatus status = listing->slides[i];
+        if (!status.second.isEmpty())
+            status.first = false;
+        addSlide(listing->images[i], listing->captions[i], status);
+    }
+    return true;
+}
+
+void DockPixelStreamer::addSlide( const QImage& image, const QString& caption,
+                                  const SlideImageLoadingStatus& status )
+{
+    flow_->addSlide( image, caption );
+    currentCaptions_.append( caption );
+    slideImagesLoaded_.append( status );
 }
 
 void DockPixelStreamer::addRootDirToFlow()
@@ -289,8 +330,7 @@ void DockPixelStreamer::addRootDirToFlow()
         FolderThumbnailGeneratorPtr folderGenerator = ThumbnailGeneratorFactory::getFolderGenerator(flow_->slideSize());
 
         QImage img = folderGenerator->generateUpFolderImage(rootDir);
-        flow_->addSlide( img, "UP: " + rootDir.path() );
-        slideImagesLoaded_.append(qMakePair(true, QString()));
+        addSlide( img, "UP: " + rootDir.path(), qMakePair(true, QString( )));
     }
 }
 
@@ -309,8 +349,7 @@ void DockPixelStreamer::addFilesToFlow()
         const QFileInfo& fileInfo = fileList.at( i );
         const QString& fileName = currentDir_.absoluteFilePath( fileInfo.fileName( ));
         QImage img = defaultGenerator->generate(fileName);
-        flow_->addSlide( img, fileInfo.fileName( ));
-        slideImagesLoaded_.append(qMakePair(false, fileName));
+        addSlide( img, fileInfo.fileName(), qMakePair(false, fileName));
     }
 }
 
@@ -329,8 +368,7 @@ void DockPixelStreamer::addFoldersToFlow()
         if( !fileName.endsWith( ".pyramid" ))
         {
             QImage img = folderGenerator->generatePlaceholderImage(QDir(fileName));
-            flow_->addSlide( img, fileInfo.fileName( ));
-            slideImagesLoaded_.append(qMakePair(false, fileName));
+            addSlide( img, fileInfo.fileName(), qMakePair(false, fileName));
         }
     }
 }
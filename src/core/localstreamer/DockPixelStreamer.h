@@ -41,13 +41,16 @@
 #define DOCKPIXELSTREAMER_H
 
 #include "PixelStreamer.h"
+#include "DockPrefetchWindow.h"
 
+#include <QtCore/QCache>
+#include <QtCore/QDateTime>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
-#include <QtCore/QThread>
 #include <QtCore/QHash>
+#include <QtCore/QStringList>
 #include <QtCore/QVector>
-#include <QtCore/QLinkedList>
 #include <QtGui/QImage>
 
 class PictureFlow;
@@ -77,25 +80,33 @@ public slots:
 private slots:
     void update(const QImage &image);
     void loadThumbnails(int newCenterIndex);
-    void loadNextThumbnailInList();
-
-signals:
-    void renderPreview( const QString& fileName, const int index );
+    void setThumbnail(int index, QImage image);
 
 private:
     PictureFlow* flow_;
     AsyncImageLoader* loader_;
     DockToolbar* toolbar_;
 
-    QThread loadThread_;
-
     QString rootDir_;
     QDir currentDir_;
     QHash< QString, int > slideIndex_;
 
     typedef QPair<bool, QString> SlideImageLoadingStatus;
     QVector<SlideImageLoadingStatus> slideImagesLoaded_;
-    QLinkedList<int> slideImagesToLoad_;
+
+    DockPrefetchWindow prefetchWindow_;
+    QElapsedTimer scrollTimer_;
+
+    // The slides of the directories visited, shown again when going back
+    struct DirectoryListing
+    {
+        QDateTime lastModified;
+        QVector<QImage> images;
+        QStringList captions;
+        QVector<SlideImageLoadingStatus> slides;
+    };
+    QCache< QString, DirectoryListing > directoryListings_;
+    QStringList currentCaptions_;
 
     void createFlow(const QSize& dockSize);
     void createToolbar(const unsigned int width, const unsigned int height);
@@ -104,6 +115,10 @@ private:
     void processClickEvent(const Event& clickEvent);
     void onItem();
     void changeDirectory( const QString& dir );
+    void saveDirectoryListing();
+    bool restoreDirectoryListing();
+    void addSlide( const QImage& image, const QString& caption,
+                   const SlideImageLoadingStatus& status );
     void addRootDirToFlow();
     void addFilesToFlow();
     void addFoldersToFlow();
@@ -0,0 +1,124 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "DockPrefetchWindow.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// The motion is forgotten when the flow is not moved for this long
+#define IDLE_TIME_SECONDS 1.0
+
+// Minimum time between two moves, when events arrive in bursts
+#define MIN_MOVE_SECONDS 0.01
+
+DockPrefetchWindow::DockPrefetchWindow(const int radius, const int maxRadius,
+                                       const double lookAheadSeconds)
+    : radius_(radius)
+    , maxRadius_(std::max(radius, maxRadius))
+    , lookAheadSeconds_(lookAheadSeconds)
+    , center_(0)
+    , direction_(0)
+    , speed_(0.0)
+    , lastTime_(0.0)
+{
+}
+
+void DockPrefetchWindow::setCenter(const int centerIndex, const double timeInSeconds)
+{
+    const int offset = centerIndex - center_;
+    const double elapsed = timeInSeconds - lastTime_;
+
+    const int direction = (offset > 0) - (offset < 0);
+    const double speed = std::abs(offset) / std::max(elapsed, MIN_MOVE_SECONDS);
+
+    // Average the speed over consecutive moves in the same direction
+    if (direction == 0 || elapsed > IDLE_TIME_SECONDS || direction != direction_)
+        speed_ = direction == 0 ? 0.0 : speed;
+    else
+        speed_ = 0.5 * (speed_ + speed);
+
+    direction_ = direction;
+    center_ = centerIndex;
+    lastTime_ = timeInSeconds;
+}
+
+void DockPrefetchWindow::reset(const int centerIndex)
+{
+    center_ = centerIndex;
+    direction_ = 0;
+    speed_ = 0.0;
+}
+
+int DockPrefetchWindow::getCenter() const
+{
+    return center_;
+}
+
+int DockPrefetchWindow::getLookAheadRadius() const
+{
+    const int lookAhead = (int)std::floor(speed_ * lookAheadSeconds_ + 0.5);
+    return std::min(radius_ + lookAhead, maxRadius_);
+}
+
+std::vector<int> DockPrefetchWindow::getSlides(const int slideCount) const
+{
+    std::vector<int> slides;
+    if (slideCount <= 0)
+        return slides;
+
+    const int center = std::min(std::max(center_, 0), slideCount - 1);
+    const int forward = direction_ < 0 ? -1 : 1;
+    const int lookAheadRadius = getLookAheadRadius();
+
+    // Alternate between both sides, starting ahead of the motion
+    slides.push_back(center);
+    for (int distance = 1; distance <= lookAheadRadius; ++distance)
+    {
+        const int ahead = center + forward * distance;
+        if (ahead >= 0 && ahead < slideCount)
+            slides.push_back(ahead);
+
+        const int behind = center - forward * distance;
+        if (distance <= radius_ && behind >= 0 && behind < slideCount)
+            slides.push_back(behind);
+    }
+    return slides;
+}
@@ -0,0 +1,99 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DOCKPREFETCHWINDOW_H
+#define DOCKPREFETCHWINDOW_H
+
+#include <vector>
+
+/**
+ * Select the slides of the Dock whose thumbnails should be loaded.
+ *
+ * The slides around the center are loaded by increasing distance from it.
+ * While the user scrolls, the window is extended ahead of the motion in
+ * proportion to the scrolling speed, so that thumbnails are ready when the
+ * flow stops.
+ */
+class DockPrefetchWindow
+{
+public:
+    /**
+     * Constructor.
+     * @param radius The number of slides loaded on each side of the center.
+     * @param maxRadius The maximum number of slides loaded ahead of the motion.
+     * @param lookAheadSeconds The scrolling time covered by the prefetching.
+     */
+    DockPrefetchWindow(const int radius = 2, const int maxRadius = 16,
+                       const double lookAheadSeconds = 0.5);
+
+    /**
+     * Move the center of the window.
+     * @param centerIndex The index of the slide which becomes the center.
+     * @param timeInSeconds The current time, used to estimate the speed.
+     */
+    void setCenter(const int centerIndex, const double timeInSeconds);
+
+    /** Forget the motion, for instance when the slides change. */
+    void reset(const int centerIndex);
+
+    /** @return The current center. */
+    int getCenter() const;
+
+    /** @return The number of slides loaded ahead of the motion. */
+    int getLookAheadRadius() const;
+
+    /**
+     * Get the slides to load.
+     * @param slideCount The number of slides in the flow.
+     * @return The indices of the slides, in decreasing priority.
+     */
+    std::vector<int> getSlides(const int slideCount) const;
+
+private:
+    const int radius_;
+    const int maxRadius_;
+    const double lookAheadSeconds_;
+
+    int center_;
+    int direction_;
+    double speed_; // Slides per second
+    double lastTime_;
+};
+
+#endif // DOCKPREFETCHWINDOW_H
@@ -26,6 +26,7 @@
 */
 
 #include "Pictureflow.h"
+#include "PixelBlending.h"
 
 // detect Qt version
 #if QT_VERSION >= 0x040000
@@ -46,10 +47,12 @@
 #include <QKeyEvent>
 #include <QPainter>
 #include <QPixmap>
+#include <QThread>
 #include <QTimer>
 #include <QVector>
 #include <QWidget>
 #include <QGLWidget>
+#include <QtConcurrentMap>
 #endif
 
 #ifdef PICTUREFLOW_QT3
@@ -107,6 +110,11 @@ typedef long PFreal;
 #define IANGLE_MAX 1024
 #define IANGLE_MASK 1023
 
+// Minimum number of columns rendered by each thread
+#define MIN_BAND_WIDTH 64
+// Memory budget of the slide surfaces, in bytes
+#define SURFACE_CACHE_SIZE (64 * 1024 * 1024)
+
 inline PFreal fmul(PFreal a, PFreal b)
 {
   return ((long long)(a))*((long long)(b)) >> PFREAL_SHIFT;
@@ -225,13 +233,14 @@ public:
 class PictureFlowAbstractRenderer
 {
 public:
-  PictureFlowAbstractRenderer(): state(0), dirty(false), widget(0) {}
+  PictureFlowAbstractRenderer(): state(0), dirty(false), widget(0), threadCount(1) {}
   virtual ~PictureFlowAbstractRenderer() {}
 
   PictureFlowState* state;
   bool dirty;
   QWidget* widget;
   PictureFlowAnimator* animator;
+  int threadCount;
 
   virtual void init() = 0;
   virtual void paint() = 0;
@@ -247,15 +256,33 @@ public:
   void paint() override;
 
 private:
+  // A column of the buffer covered by a slide
+  struct SlideColumn
+  {
+    const QRgb* pixels; // The surface row to sample, 0 for the background
+    int center;
+    int dy;
+    int blend;
+  };
+
+  // A range of columns rendered by a thread
+  struct ColumnBand
+  {
+    PictureFlowSoftwareRenderer* renderer;
+    QRgb* bits;
+    int col1;
+    int col2;
+  };
+
   QSize size;
   QRgb bgcolor;
   int effect;
   QImage buffer;
   QVector<PFreal> rays;
+  QVector<SlideColumn> columns;
   QImage* blankSurface;
 #ifdef PICTUREFLOW_QT4
-  QCache<int,QImage> surfaceCache;
-  QHash<int,QImage*> imageHash;
+  QCache<qint64,QImage> surfaceCache; // Keyed by the cacheKey() of the slides
 #endif
 #ifdef PICTUREFLOW_QT3
   QCache<QImage> surfaceCache;
@@ -268,6 +295,8 @@ private:
 
   void render();
   void renderSlides();
+  void renderColumns(QRgb* bits, int col1, int col2);
+  static void renderColumnBand(ColumnBand& band);
   void renderCaption();
   QRect renderSlide(const SlideInfo &slide, int col1 = -1, int col2 = -1);
   QImage* surface(int slideIndex);
@@ -518,12 +547,16 @@ void PictureFlowSoftwareRenderer::paint()
   {
     bgcolor = state->backgroundColor;
     surfaceCache.clear();
+    delete blankSurface;
+    blankSurface = 0;
   }
 
   if((int)(state->reflectionEffect) != effect)
   {
     effect = (int)state->reflectionEffect;
     surfaceCache.clear();
+    delete blankSurface;
+    blankSurface = 0;
   }
 
   if(dirty)
@@ -539,6 +572,7 @@ void PictureFlowSoftwareRenderer::init()
     return;
 
   surfaceCache.clear();
+  delete blankSurface;
   blankSurface = 0;
 
   size = widget->size();
@@ -554,6 +588,7 @@ void PictureFlowSoftwareRenderer::init()
   buffer.create(ww, wh, 32);
 #endif
   buffer.fill(bgcolor);
+  columns.resize(ww);
 
   rays.resize(w*2);
   for(int i = 0; i < w; i++)
@@ -566,13 +601,18 @@ void PictureFlowSoftwareRenderer::init()
   dirty = true;
 }
 
-// TODO: optimize this with lookup tables
-static QRgb blendColor(QRgb c1, QRgb c2, int blend)
+// Copy a 32 bits image into the rows of a surface, starting at column hofs
+static void copyTransposed(const QImage& img, QImage* result, int hofs)
 {
-  int r = qRed(c1) * blend/256 + qRed(c2)*(256-blend)/256;
-  int g = qGreen(c1) * blend/256 + qGreen(c2)*(256-blend)/256;
-  int b = qBlue(c1) * blend/256 + qBlue(c2)*(256-blend)/256;
-  return qRgb(r, g, b);
+  QRgb* dst = (QRgb*)result->bits();
+  const int stride = result->bytesPerLine() / sizeof(QRgb);
+
+  for(int y = 0; y < img.height(); y++)
+  {
+    const QRgb* line = (const QRgb*)img.scanLine(y);
+    for(int x = 0; x < img.width(); x++)
+      dst[x * stride + hofs + y] = line[x];
+  }
 }
 
 
@@ -582,6 +622,7 @@ PictureFlow::ReflectionEffect reflectionEffect)
 #ifdef PICTUREFLOW_QT4
   Qt::TransformationMode mode = Qt::SmoothTransformation;
   QImage img = slideImage->scaled(w, h, Qt::IgnoreAspectRatio, mode);
+  img = img.convertToFormat(QImage::Format_RGB32);
 #endif
 #if defined(PICTUREFLOW_QT3) || defined(PICTUREFLOW_QT2)
   QImage img = slideImage->smoothScale(w, h);
@@ -604,21 +645,22 @@ PictureFlow::ReflectionEffect reflectionEffect)
   // transpose the image, this is to speed-up the rendering
   // because we process one column at a time
   // (and much better and faster to work row-wise, i.e in one scanline)
-  for(int x = 0; x < w; x++)
-    for(int y = 0; y < h; y++)
-      result->setPixel(hofs + y, x, img.pixel(x, y));
+  copyTransposed(img, result, hofs);
 
   if(reflectionEffect != PictureFlow::NoReflection)
   {
     // create the reflection
     int ht = hs - h - hofs;
     int hte = ht;
-    for(int x = 0; x < w; x++)
-      for(int y = 0; y < ht; y++)
-      {
-        QRgb color = img.pixel(x, img.height()-y-1);
-        result->setPixel(h+hofs+y, x, blendColor(color,bgcolor,128*(hte-y)/hte));
-      }
+    QRgb* dst = (QRgb*)result->bits();
+    const int stride = result->bytesPerLine() / sizeof(QRgb);
+    for(int y = 0; y < ht; y++)
+    {
+      const QRgb* line = (const QRgb*)img.scanLine(img.height()-y-1);
+      const int blend = 128*(hte-y)/hte;
+      for(int x = 0; x < w; x++)
+        dst[x * stride + h+hofs+y] = blendPixel(line[x], bgcolor, blend);
+    }
 
     if(reflectionEffect == PictureFlow::BlurredReflection)
     {
@@ -690,9 +732,7 @@ PictureFlow::ReflectionEffect reflectionEffect)
       }
 
       // overdraw to leave only the reflection blurred (but not the actual image)
-      for(int x = 0; x < w; x++)
-        for(int y = 0; y < h; y++)
-          result->setPixel(hofs + y, x, img.pixel(x, y));
+      copyTransposed(img, result, hofs);
     }
   }
 
@@ -708,9 +748,6 @@ QImage* PictureFlowSoftwareRenderer::surface(int slideIndex)
   if(slideIndex >= (int)state->slideImages.count())
     return 0;
 
-#ifdef PICTUREFLOW_QT4
-  int key = slideIndex;
-#endif
 #if defined(PICTUREFLOW_QT3) || defined(PICTUREFLOW_QT2)
   QString key = QString::number(slideIndex);
 #endif
@@ -719,8 +756,10 @@ QImage* PictureFlowSoftwareRenderer::surface(int slideIndex)
   bool empty = img ? img->isNull() : true;
   if(empty)
   {
+#if defined(PICTUREFLOW_QT3) || defined(PICTUREFLOW_QT2)
     surfaceCache.remove(key);
     imageHash.remove(slideIndex);
+#endif
     if(!blankSurface)
     {
       int sw = state->slideWidth;
@@ -758,9 +797,15 @@ QImage* PictureFlowSoftwareRenderer::surface(int slideIndex)
   }
 
 #ifdef PICTUREFLOW_QT4
-  bool exist = imageHash.contains(slideIndex);
-  if(exist)
-  if(img == imageHash.find(slideIndex).value())
+  // The slides which show the same image share their surface, including
+  // after the flow is cleared and filled again
+  const qint64 key = img->cacheKey();
+  if(QImage* cached = surfaceCache.object(key))
+    return cached;
+
+  QImage* sr = prepareSurface(img, state->slideWidth, state->slideHeight, bgcolor, state->reflectionEffect);
+  surfaceCache.insert(key, sr, sr->byteCount() / 1024 + 1);
+  return sr;
 #endif
 #ifdef PICTUREFLOW_QT3
   bool exist = imageHash.find(slideIndex) != imageHash.end();
@@ -770,6 +815,7 @@ QImage* PictureFlowSoftwareRenderer::surface(int slideIndex)
 #ifdef PICTUREFLOW_QT2
   if(img == imageHash[slideIndex])
 #endif
+#if defined(PICTUREFLOW_QT3) || defined(PICTUREFLOW_QT2)
     if(surfaceCache.contains(key))
         return surfaceCache[key];
 
@@ -778,9 +824,11 @@ QImage* PictureFlowSoftwareRenderer::surface(int slideIndex)
   imageHash.insert(slideIndex, img);
 
   return sr;
+#endif
 }
 
-// Renders a slide to offscreen buffer. Returns a rect of the rendered area.
+// Computes the columns of the offscreen buffer covered by a slide.
+// Returns a rect of the rendered area.
 // col1 and col2 limit the column for rendering.
 QRect PictureFlowSoftwareRenderer::renderSlide(const SlideInfo &slide, int col1, int col2)
 {
@@ -854,45 +902,12 @@ QRect PictureFlowSoftwareRenderer::renderSlide(const SlideInfo &slide, int col1,
       rect.setLeft(x);
     flag = true;
 
-    int y1 = h/2;
-    int y2 = y1+ 1;
-    QRgb* pixel1 = (QRgb*)(buffer.scanLine(y1)) + x;
-    QRgb* pixel2 = (QRgb*)(buffer.scanLine(y2)) + x;
-    QRgb pixelstep = pixel2 - pixel1;
-
-    int center = (sh/2);
-    int dy = dist / h;
-    int p1 = center*PFREAL_ONE - dy/2;
-    int p2 = center*PFREAL_ONE + dy/2;
-
-    const QRgb *ptr = (const QRgb*)(src->scanLine(column));
-    if(blend == 256)
-      while((y1 >= 0) && (y2 < h) && (p1 >= 0))
-      {
-        *pixel1 = ptr[p1 >> PFREAL_SHIFT];
-        *pixel2 = ptr[p2 >> PFREAL_SHIFT];
-        p1 -= dy;
-        p2 += dy;
-        y1--;
-        y2++;
-        pixel1 -= pixelstep;
-        pixel2 += pixelstep;
-      }
-    else
-      while((y1 >= 0) && (y2 < h) && (p1 >= 0))
-      {
-        QRgb c1 = ptr[p1 >> PFREAL_SHIFT];
-        QRgb c2 = ptr[p2 >> PFREAL_SHIFT];
-        *pixel1 = blendColor(c1, bgcolor, blend);
-        *pixel2 = blendColor(c2, bgcolor, blend);
-        p1 -= dy;
-        p2 += dy;
-        y1--;
-        y2++;
-        pixel1 -= pixelstep;
-        pixel2 += pixelstep;
-     }
-   }
+    SlideColumn& target = columns[x];
+    target.pixels = (const QRgb*)(src->scanLine(column));
+    target.center = sh/2;
+    target.dy = dist / h;
+    target.blend = blend;
+  }
 
    rect.setTop(0);
    rect.setBottom(h-1);
@@ -904,6 +919,15 @@ void PictureFlowSoftwareRenderer::renderSlides()
   int nleft = state->leftSlides.count();
   int nright = state->rightSlides.count();
 
+#ifdef PICTUREFLOW_QT4
+  // The surfaces of all the slides must stay in the cache during the frame
+  const int surfaceCost = 2 * state->slideWidth * state->slideHeight * sizeof(QRgb) / 1024 + 1;
+  surfaceCache.setMaxCost(qMax(SURFACE_CACHE_SIZE / 1024, 2 * (1 + nleft + nright) * surfaceCost));
+#endif
+
+  const SlideColumn background = { 0, 0, 0, 0 };
+  columns.fill(background);
+
   QRect r = renderSlide(state->centerSlide);
   int c1 = r.left();
   int c2 = r.right();
@@ -920,6 +944,106 @@ void PictureFlowSoftwareRenderer::renderSlides()
     if(!rs.isEmpty())
       c2 = rs.right();
   }
+
+  // Each column is covered by one slide at most, so that they can be
+  // rendered in parallel. bits() is called only once since it may detach.
+  QRgb* bits = (QRgb*)buffer.bits();
+  const int w = buffer.width();
+#ifdef PICTUREFLOW_QT4
+  const int bandCount = qBound(1, w / MIN_BAND_WIDTH, threadCount);
+#else
+  const int bandCount = 1;
+#endif
+  if(bandCount == 1)
+  {
+    renderColumns(bits, 0, w-1);
+    return;
+  }
+
+#ifdef PICTUREFLOW_QT4
+  QVector<ColumnBand> bands(bandCount);
+  for(int i = 0; i < bandCount; i++)
+  {
+    bands[i].renderer = this;
+    bands[i].bits = bits;
+    bands[i].col1 = i * w / bandCount;
+    bands[i].col2 = (i+1) * w / bandCount - 1;
+  }
+  QtConcurrent::blockingMap(bands, &PictureFlowSoftwareRenderer::renderColumnBand);
+#endif
+}
+
+void PictureFlowSoftwareRenderer::renderColumnBand(ColumnBand& band)
+{
+  band.renderer->renderColumns(band.bits, band.col1, band.col2);
+}
+
+// Renders the columns computed by renderSlide() to the offscreen buffer.
+void PictureFlowSoftwareRenderer::renderColumns(QRgb* bits, int col1, int col2)
+{
+  const int h = buffer.height();
+  const int pixelstep = buffer.bytesPerLine() / sizeof(QRgb);
+  const SlideColumn* slideColumns = columns.constData();
+
+  // Pixels of the slides which are blended with the background
+  QVector<QRgb> upper(h/2 + 1);
+  QVector<QRgb> lower(h/2 + 1);
+
+  for(int x = col1; x <= col2; x++)
+  {
+    const SlideColumn& column = slideColumns[x];
+    if(!column.pixels)
+      continue;
+
+    int y1 = h/2;
+    int y2 = y1+ 1;
+    QRgb* pixel1 = bits + y1 * pixelstep + x;
+    QRgb* pixel2 = bits + y2 * pixelstep + x;
+
+    int dy = column.dy;
+    int p1 = column.center*PFREAL_ONE - dy/2;
+    int p2 = column.center*PFREAL_ONE + dy/2;
+
+    const QRgb *ptr = column.pixels;
+    if(column.blend == 256)
+      while((y1 >= 0) && (y2 < h) && (p1 >= 0))
+      {
+        *pixel1 = ptr[p1 >> PFREAL_SHIFT];
+        *pixel2 = ptr[p2 >> PFREAL_SHIFT];
+        p1 -= dy;
+        p2 += dy;
+        y1--;
+        y2++;
+        pixel1 -= pixelstep;
+        pixel2 += pixelstep;
+      }
+    else
+    {
+      // Gather the pixels to blend them all at once
+      int count = 0;
+      while((y1 >= 0) && (y2 < h) && (p1 >= 0))
+      {
+        upper[count] = ptr[p1 >> PFREAL_SHIFT];
+        lower[count] = ptr[p2 >> PFREAL_SHIFT];
+        p1 -= dy;
+        p2 += dy;
+        y1--;
+        y2++;
+        count++;
+      }
+
+      blendPixels(upper.data(), count, bgcolor, column.blend);
+      blendPixels(lower.data(), count, bgcolor, column.blend);
+
+      for(int i = 0; i < count; i++)
+      {
+        *pixel1 = upper[i];
+        *pixel2 = lower[i];
+        pixel1 -= pixelstep;
+        pixel2 += pixelstep;
+      }
+    }
+  }
 }
 
 void PictureFlowSoftwareRenderer::renderCaption()
@@ -982,6 +1106,7 @@ PictureFlow::PictureFlow(QWidget* widget_): QWidget(widget_)
   QObject::connect(&d->triggerTimer, SIGNAL(timeout()), this, SLOT(render()));
 
 #ifdef PICTUREFLOW_QT4
+  d->renderer->threadCount = QThread::idealThreadCount();
   setAttribute(Qt::WA_StaticContents, true);
   setAttribute(Qt::WA_OpaquePaintEvent, true);
   setAttribute(Qt::WA_NoSystemBackground, true);
@@ -1045,6 +1170,16 @@ void PictureFlow::setReflectionEffect(ReflectionEffect effect)
   triggerRender();
 }
 
+int PictureFlow::renderThreadCount() const
+{
+  return d->renderer->threadCount;
+}
+
+void PictureFlow::setRenderThreadCount(int count)
+{
+  d->renderer->threadCount = qMax(count, 1);
+}
+
 QImage PictureFlow::slide(int index) const
 {
   QImage* i = 0;
@@ -115,6 +115,17 @@ public:
   */
   void setReflectionEffect(ReflectionEffect effect);
 
+  /*!
+    Returns the number of threads used to render the slides.
+  */
+  int renderThreadCount() const;
+
+  /*!
+    Sets the number of threads used to render the slides. The default is the
+    number of processor cores.
+  */
+  void setRenderThreadCount(int count);
+
 
 public slots:
 
@@ -0,0 +1,112 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "PixelBlending.h"
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+namespace
+{
+#if defined(__AVX2__)
+// Blend 8 pixels, the channels being processed as 16 bits integers
+inline __m256i blend8(const __m256i pixels, const __m256i color, const __m256i alpha, const __m256i opaque)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = _mm256_unpacklo_epi8(pixels, zero);
+    __m256i hi = _mm256_unpackhi_epi8(pixels, zero);
+    lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(lo, alpha), color), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(hi, alpha), color), 8);
+    return _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque);
+}
+#endif
+
+#if defined(__SSE2__)
+// Blend 4 pixels, the channels being processed as 16 bits integers
+inline __m128i blend4(const __m128i pixels, const __m128i color, const __m128i alpha, const __m128i opaque)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+    __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, alpha), color), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, alpha), color), 8);
+    return _mm_or_si128(_mm_packus_epi16(lo, hi), opaque);
+}
+#endif
+}
+
+void blendPixels(QRgb* pixels, const int count, const QRgb color, const int alpha)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    // The weighted color is the same for all pixels; the sums are at most
+    // 255 * 256 and fit in 16 bits integers
+    const __m128i color4 = _mm_set1_epi32(color);
+    const __m128i colorWeighted = _mm_mullo_epi16(_mm_unpacklo_epi8(color4, _mm_setzero_si128()),
+                                                  _mm_set1_epi16(256 - alpha));
+    const __m128i alpha4 = _mm_set1_epi16(alpha);
+    const __m128i opaque4 = _mm_set1_epi32(0xFF000000);
+
+#  if defined(__AVX2__)
+    const __m256i colorWeighted8 = _mm256_broadcastsi128_si256(colorWeighted);
+    const __m256i alpha8 = _mm256_set1_epi16(alpha);
+    const __m256i opaque8 = _mm256_set1_epi32(0xFF000000);
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256i* p = reinterpret_cast<__m256i*>(pixels + i);
+        _mm256_storeu_si256(p, blend8(_mm256_loadu_si256(p), colorWeighted8,
+                                      alpha8, opaque8));
+    }
+#  endif
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i* p = reinterpret_cast<__m128i*>(pixels + i);
+        _mm_storeu_si128(p, blend4(_mm_loadu_si128(p), colorWeighted,
+                                   alpha4, opaque4));
+    }
+#endif
+
+    for(; i < count; ++i)
+        pixels[i] = blendPixel(pixels[i], color, alpha);
+}
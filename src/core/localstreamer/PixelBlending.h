@@ -0,0 +1,77 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef PIXELBLENDING_H
+#define PIXELBLENDING_H
+
+#include <QRgb>
+
+/**
+ * Blend a pixel with a color.
+ *
+ * Each channel is computed as (pixel * alpha + color * (256 - alpha)) / 256;
+ * the result is opaque.
+ * @param pixel The pixel.
+ * @param color The color to blend with.
+ * @param alpha The weight of the pixel, in the range [0, 256].
+ * @return The blended pixel.
+ */
+inline QRgb blendPixel(const QRgb pixel, const QRgb color, const int alpha)
+{
+    // Red and blue are processed together, in separate 16 bits lanes
+    const uint a = alpha;
+    const uint b = 256 - alpha;
+    const uint rb = (((pixel & 0xFF00FF) * a + (color & 0xFF00FF) * b) >> 8) & 0xFF00FF;
+    const uint g = (((pixel & 0x00FF00) * a + (color & 0x00FF00) * b) >> 8) & 0x00FF00;
+    return 0xFF000000 | rb | g;
+}
+
+/**
+ * Blend an array of pixels with a color, in place.
+ *
+ * Uses AVX2 or SSE2 instructions when the compiler targets them, with the
+ * same result as blendPixel().
+ * @param pixels The pixels.
+ * @param count The number of pixels.
+ * @param color The color to blend with.
+ * @param alpha The weight of the pixels, in the range [0, 256].
+ */
+void blendPixels(QRgb* pixels, const int count, const QRgb color, const int alpha);
+
+#endif // PIXELBLENDING_H
@@ -55,6 +55,8 @@
 
 #define WEBPAGE_DEFAULT_ZOOM   2.0
 
+#define UPDATE_INTERVAL_MS     30
+
 WebkitPixelStreamer::WebkitPixelStreamer(const QSize& webpageSize, const QString& url)
     : PixelStreamer()
     , authenticationHelper_(new WebkitAuthenticationHelper(webView_))
@@ -62,6 +64,20 @@ WebkitPixelStreamer::WebkitPixelStreamer(const QSize& webpageSize, const QString
     , interactionModeActive_(false)
     , initialWidth_( std::max( webpageSize.width(), WEBPAGE_MIN_WIDTH ))
 {
+    timer_.setSingleShot(true);
+    timer_.setInterval(UPDATE_INTERVAL_MS);
+    connect(&timer_, SIGNAL(timeout()), this, SLOT(update()));
+
+    // Without a view, the page reports the damaged regions through the
+    // repaintRequested() and scrollRequested() signals instead of updating
+    // the (hidden) widget. This must be done before setting the viewport size.
+    QWebPage* page = webView_.page();
+    page->setView(0);
+    connect(page, SIGNAL(repaintRequested(QRect)),
+            this, SLOT(onRepaintRequested(QRect)));
+    connect(page, SIGNAL(scrollRequested(int,int,QRect)),
+            this, SLOT(onScrollRequested(int,int,QRect)));
+
     setSize( webpageSize * WEBPAGE_DEFAULT_ZOOM );
     webView_.setZoomFactor(WEBPAGE_DEFAULT_ZOOM);
 
@@ -76,8 +92,6 @@ WebkitPixelStreamer::WebkitPixelStreamer(const QSize& webpageSize, const QString
 
     setUrl(url);
 
-    connect(&timer_, SIGNAL(timeout()), this, SLOT(update()));
-    timer_.start(30);
 }
 
 WebkitPixelStreamer::~WebkitPixelStreamer()
@@ -260,6 +274,7 @@ void WebkitPixelStreamer::setSize(const QSize& webpageSize)
     QSize newSize( std::max(webpageSize.width(), WEBPAGE_MIN_WIDTH), std::max(webpageSize.height(), WEBPAGE_MIN_HEIGHT) );
 
     webView_.page()->setViewportSize( newSize );
+    addDirtyRegion( QRect( QPoint(), newSize ));
 }
 
 void WebkitPixelStreamer::recomputeZoomFactor()
@@ -277,17 +292,49 @@ void WebkitPixelStreamer::update()
     QMutexLocker locker(&mutex_);
 
     QWebPage* page = webView_.page();
-    if( !page->viewportSize().isEmpty())
+    if( page->viewportSize().isEmpty() || dirtyRegion_.isEmpty( ))
+        return;
+
+    if (image_.size() != page->viewportSize())
     {
-        if (image_.size() != page->viewportSize())
-            image_ = QImage( page->viewportSize(), QImage::Format_ARGB32 );
+        image_ = QImage( page->viewportSize(), QImage::Format_ARGB32 );
+        dirtyRegion_ = QRegion( image_.rect( ));
+    }
 
-        QPainter painter( &image_ );
-        page->mainFrame()->render( &painter );
-        painter.end();
+    // The page may request new repaints while rendering
+    const QRegion region = dirtyRegion_ & image_.rect();
+    dirtyRegion_ = QRegion();
 
-        emit imageUpdated(image_);
-    }
+    QPainter painter( &image_ );
+    page->mainFrame()->render( &painter, QWebFrame::AllLayers, region );
+    painter.end();
+
+    emit imageUpdated(image_);
+}
+
+void WebkitPixelStreamer::onRepaintRequested(const QRect& dirtyRect)
+{
+    addDirtyRegion( dirtyRect );
+}
+
+void WebkitPixelStreamer::onScrollRequested(int dx, int dy, const QRect& rectToScroll)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+
+    // The scrolled contents are repainted rather than moved in the image
+    addDirtyRegion( rectToScroll );
+}
+
+void WebkitPixelStreamer::addDirtyRegion(const QRegion& region)
+{
+    // Not locked: the page may signal damage while the mutex is held
+    if( region.isEmpty( ))
+        return;
+
+    dirtyRegion_ += region;
+    if( !timer_.isActive( ))
+        timer_.start();
 }
 
 QWebHitTestResult WebkitPixelStreamer::performHitTest(const Event &dcEvent) const
@@ -44,6 +44,7 @@
 
 #include <QString>
 #include <QImage>
+#include <QRegion>
 #include <QTimer>
 #include <QWebView>
 #include <QMutex>
@@ -59,6 +60,9 @@ class WebkitHtmlSelectReplacer;
 
 /**
  * Stream webpages with user interaction support.
+ *
+ * The page is repainted only in the regions damaged by WebKit, at most once
+ * per update interval, and no image is emitted while the page is idle.
  */
 class WebkitPixelStreamer : public PixelStreamer
 {
@@ -96,6 +100,8 @@ public slots:
 
 private slots:
     void update();
+    void onRepaintRequested(const QRect& dirtyRect);
+    void onScrollRequested(int dx, int dy, const QRect& rectToScroll);
 
 private:
     QWebView webView_;
@@ -105,6 +111,7 @@ private:
     QMutex mutex_;
 
     QImage image_;
+    QRegion dirtyRegion_;
 
     bool interactionModeActive_;
 
@@ -123,6 +130,7 @@ private:
     QPoint getPointerPosition(const Event &dcEvent) const;
     bool isWebGLElement(const QWebElement &element) const;
     void setSize(const QSize& webpageSize);
+    void addDirtyRegion(const QRegion& region);
     void recomputeZoomFactor();
 };
 
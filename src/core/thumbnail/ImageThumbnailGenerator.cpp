@@ -43,6 +43,11 @@
 #include <QImageReader>
 
 #include "log.h"
+#include "config.h"
+
+#if ENABLE_TIFF_SUPPORT
+#  include "TiffPyramidReader.h"
+#endif
 
 #define SIZEOF_MEGABYTE  (1024*1024)
 #define MAX_IMAGE_FILE_SIZE (100*SIZEOF_MEGABYTE)
@@ -56,13 +61,42 @@ QImage ImageThumbnailGenerator::generate(const QString &filename) const
 {
     QImage img;
 
+#if ENABLE_TIFF_SUPPORT
+    // Tiled TIFF files are read from their coarsest level, whatever their size
+    if( TiffPyramidReader::hasTiffExtension( filename ))
+    {
+        TiffPyramidReader tiffReader;
+        if( tiffReader.open( filename ))
+        {
+            const QRect region( QPoint( 0, 0 ), tiffReader.getImageSize( ));
+            img = tiffReader.readRegion( region, size_ );
+            if( !img.isNull( ))
+            {
+                addMetadataToImage( img, filename );
+                return img;
+            }
+        }
+    }
+#endif
+
     QImageReader reader( filename );
     if( reader.canRead( ))
     {
-        if (QFileInfo(filename).size() < MAX_IMAGE_FILE_SIZE)
+        // Decoders which support it, like JPEG, decode directly at the
+        // thumbnail resolution; the others decode the full image first
+        const bool scaledDecoding = reader.supportsOption( QImageIOHandler::ScaledSize );
+        if( scaledDecoding || QFileInfo(filename).size() < MAX_IMAGE_FILE_SIZE )
         {
+            QSize scaledSize = reader.size();
+            if( scaledSize.isValid( ))
+                scaledSize.scale( size_, aspectRatioMode_ );
+            else
+                scaledSize = size_;
+            reader.setScaledSize( scaledSize );
+
             img = reader.read();
-            img = img.scaled(size_, aspectRatioMode_);
+            if( img.size() != scaledSize )
+                img = img.scaled(size_, aspectRatioMode_);
         }
         else
         {
@@ -55,12 +55,14 @@ QImage MovieThumbnailGenerator::generate(const QString &filename) const
     if( !movie.isValid() )
         return createErrorImage("movie");
 
-    if ( !movie.jumpTo( PREVIEW_RELATIVE_POSITION * movie.getDuration( )))
+    QSize scaledSize( movie.getWidth(), movie.getHeight( ));
+    scaledSize.scale( size_, aspectRatioMode_ );
+
+    // The frame is converted directly at the thumbnail resolution
+    QImage image = movie.decodeImage( PREVIEW_RELATIVE_POSITION * movie.getDuration(), scaledSize );
+    if ( image.isNull( ))
         return createErrorImage("movie");
 
-    QImage image( (uchar*)movie.getData(), movie.getWidth(), movie.getHeight(), QImage::Format_ARGB32 );
-    image = image.scaled(size_, aspectRatioMode_);
-    image = image.rgbSwapped();
     addMetadataToImage(image, filename);
     return image;
 }
@@ -50,7 +50,8 @@ PDFThumbnailGenerator::PDFThumbnailGenerator(const QSize &size)
 QImage PDFThumbnailGenerator::generate(const QString &filename) const
 {
     PDF pdf(filename);
-    QImage image = pdf.renderToImage();
+    // Render the page directly at the resolution of the thumbnail
+    QImage image = pdf.renderToImage(size_);
 
     if (image.isNull())
     {
@@ -58,7 +59,6 @@ QImage PDFThumbnailGenerator::generate(const QString &filename) const
         return createErrorImage("pdf");
     }
 
-    image = image.scaled(size_, aspectRatioMode_);
     addMetadataToImage(image, filename);
     return image;
 }
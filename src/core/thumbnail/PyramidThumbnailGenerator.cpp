@@ -41,6 +41,7 @@
 
 #include <QImageReader>
 
+#include "ImagePyramidContainer.h"
 #include "log.h"
 
 PyramidThumbnailGenerator::PyramidThumbnailGenerator(const QSize &size)
@@ -50,6 +51,22 @@ PyramidThumbnailGenerator::PyramidThumbnailGenerator(const QSize &size)
 
 QImage PyramidThumbnailGenerator::generate(const QString &filename) const
 {
+    if (ImagePyramidContainer::isContainer(filename))
+    {
+        ImagePyramidContainer container;
+        QImage image;
+        if (container.open(filename))
+            image = container.readTileImage(0, 0, 0);
+        if (!image.isNull())
+        {
+            image = image.scaled(size_, aspectRatioMode_);
+            addMetadataToImage(image, filename);
+            return image;
+        }
+        put_flog(LOG_ERROR, "could not open pyramid container: %s", filename.toLatin1().constData());
+        return createErrorImage("pyramid");
+    }
+
     QImageReader reader( filename + "amid/0.jpg" );
     if (reader.canRead())
     {
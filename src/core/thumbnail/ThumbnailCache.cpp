@@ -0,0 +1,260 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ThumbnailCache.h"
+
+#include "log.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDesktopServices>
+#include <QFileInfo>
+#include <QHostInfo>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <utime.h>
+
+#define SIZEOF_MEGABYTE  (1024*1024)
+#define DEFAULT_MEMORY_CAPACITY (64*SIZEOF_MEGABYTE)
+#define DEFAULT_DISK_CAPACITY (512*SIZEOF_MEGABYTE)
+#define DISK_LOW_WATERMARK 0.8
+
+#define THUMBNAIL_CACHE_FOLDER "thumbnails"
+#define THUMBNAIL_FILE_EXTENSION ".png"
+#define THUMBNAIL_FILE_FORMAT "PNG"
+
+namespace
+{
+// QCache counts the cost of its objects with an int
+int getMemoryCost(const QImage& image)
+{
+    return std::max(image.byteCount() / 1024, 1);
+}
+
+bool isLessRecentlyUsed(const QFileInfo& a, const QFileInfo& b)
+{
+    return std::max(a.lastRead(), a.lastModified()) <
+           std::max(b.lastRead(), b.lastModified());
+}
+}
+
+ThumbnailCache::ThumbnailCache(const QString& directory, const qint64 memoryCapacity,
+                               const qint64 diskCapacity)
+    : directory_(directory)
+    , diskCapacity_(diskCapacity)
+    , diskUsage_(0)
+    , trimRequested_(false)
+{
+    memoryCache_.setMaxCost(std::max(memoryCapacity / 1024, (qint64)1));
+
+    if(!directory_.mkpath("."))
+        put_flog(LOG_WARN, "could not create thumbnail cache folder: %s",
+                 directory.toLocal8Bit().constData());
+
+    trimFuture_ = QtConcurrent::run(this, &ThumbnailCache::trimDiskCache);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    QMutexLocker locker(&mutex_);
+    QFuture<void> trimFuture = trimFuture_;
+    locker.unlock();
+
+    trimFuture.waitForFinished();
+}
+
+ThumbnailCache& ThumbnailCache::getDefaultCache()
+{
+    static ThumbnailCache cache(QDir(QDesktopServices::storageLocation(QDesktopServices::CacheLocation))
+                                .absoluteFilePath(THUMBNAIL_CACHE_FOLDER),
+                                DEFAULT_MEMORY_CAPACITY, DEFAULT_DISK_CAPACITY);
+    return cache;
+}
+
+bool ThumbnailCache::find(const QString& filename, const QSize& size, QImage& image)
+{
+    const QString key = makeKey(filename, size);
+    if(key.isEmpty())
+        return false;
+
+    {
+        QMutexLocker locker(&mutex_);
+        if(const QImage* cachedImage = memoryCache_.object(key))
+        {
+            image = *cachedImage;
+            return true;
+        }
+    }
+
+    const QString cacheFilename = getCacheFilename(key);
+    if(!QFile::exists(cacheFilename))
+        return false;
+
+    QImage diskImage;
+    if(!diskImage.load(cacheFilename, THUMBNAIL_FILE_FORMAT))
+    {
+        put_flog(LOG_WARN, "removing invalid cached thumbnail: %s",
+                 cacheFilename.toLocal8Bit().constData());
+        QFile::remove(cacheFilename);
+        return false;
+    }
+
+    // Mark the file as recently used, the access time is not always updated
+    utime(QFile::encodeName(cacheFilename).constData(), 0);
+
+    insertInMemory(key, diskImage);
+    image = diskImage;
+    return true;
+}
+
+void ThumbnailCache::insert(const QString& filename, const QSize& size, const QImage& image)
+{
+    const QString key = makeKey(filename, size);
+    if(key.isEmpty() || image.isNull())
+        return;
+
+    insertInMemory(key, image);
+
+    // Write to a temporary file first, as other processes may read the same entry
+    const QString cacheFilename = getCacheFilename(key);
+    const QString tempFilename = QString("%1.%2.%3.tmp").arg(cacheFilename)
+                                 .arg(QHostInfo::localHostName())
+                                 .arg(QCoreApplication::applicationPid());
+
+    if(!image.save(tempFilename, THUMBNAIL_FILE_FORMAT))
+    {
+        put_flog(LOG_WARN, "could not write cached thumbnail: %s",
+                 tempFilename.toLocal8Bit().constData());
+        QFile::remove(tempFilename);
+        return;
+    }
+
+    QFile::remove(cacheFilename);
+    if(!QFile::rename(tempFilename, cacheFilename))
+    {
+        QFile::remove(tempFilename);
+        return;
+    }
+
+    QMutexLocker locker(&mutex_);
+    diskUsage_ += QFileInfo(cacheFilename).size();
+    if(diskUsage_ <= diskCapacity_)
+        return;
+
+    if(trimFuture_.isFinished())
+        trimFuture_ = QtConcurrent::run(this, &ThumbnailCache::trimDiskCache);
+    else
+        trimRequested_ = true;
+}
+
+void ThumbnailCache::trimDiskCache()
+{
+    bool trimAgain = true;
+    while(trimAgain)
+    {
+        const qint64 diskUsage = removeLeastRecentlyUsedFiles();
+
+        // Files inserted during the trimming may not have been counted
+        QMutexLocker locker(&mutex_);
+        diskUsage_ = diskUsage;
+        trimAgain = trimRequested_;
+        trimRequested_ = false;
+    }
+}
+
+QString ThumbnailCache::makeKey(const QString& filename, const QSize& size)
+{
+    const QFileInfo fileInfo(filename);
+    if(!fileInfo.exists())
+        return QString();
+
+    const QString id = QString("%1|%2|%3|%4x%5").arg(fileInfo.absoluteFilePath())
+                       .arg(fileInfo.size())
+                       .arg(fileInfo.lastModified().toMSecsSinceEpoch())
+                       .arg(size.width()).arg(size.height());
+
+    return QString(QCryptographicHash::hash(id.toUtf8(), QCryptographicHash::Md5).toHex());
+}
+
+qint64 ThumbnailCache::removeLeastRecentlyUsedFiles()
+{
+    // Use a separate QDir, its entry list is not shared with the other threads
+    const QDir directory(directory_.path());
+    QFileInfoList files = directory.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+
+    qint64 diskUsage = 0;
+    foreach(const QFileInfo& file, files)
+        diskUsage += file.size();
+
+    if(diskUsage <= diskCapacity_)
+        return diskUsage;
+
+    std::sort(files.begin(), files.end(), isLessRecentlyUsed);
+
+    // Go below the capacity, so that the next insertions do not trim again
+    const qint64 targetUsage = diskCapacity_ * DISK_LOW_WATERMARK;
+
+    size_t removedCount = 0;
+    for(QFileInfoList::const_iterator it = files.begin();
+        it != files.end() && diskUsage > targetUsage; ++it)
+    {
+        if(QFile::remove(it->absoluteFilePath()))
+        {
+            diskUsage -= it->size();
+            ++removedCount;
+        }
+    }
+
+    put_flog(LOG_DEBUG, "removed %d files from the thumbnail cache", (int)removedCount);
+    return diskUsage;
+}
+
+QString ThumbnailCache::getCacheFilename(const QString& key) const
+{
+    return directory_.absoluteFilePath(key + THUMBNAIL_FILE_EXTENSION);
+}
+
+void ThumbnailCache::insertInMemory(const QString& key, const QImage& image)
+{
+    QMutexLocker locker(&mutex_);
+    // QCache requires a <T>* and takes ownership, so we have to create new QImage
+    memoryCache_.insert(key, new QImage(image), getMemoryCost(image));
+}
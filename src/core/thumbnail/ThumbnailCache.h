@@ -0,0 +1,132 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QCache>
+#include <QDir>
+#include <QFuture>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+
+#include <boost/noncopyable.hpp>
+
+/**
+ * A persistent cache of thumbnails, shared by all the ThumbnailGenerators.
+ *
+ * Thumbnails are addressed by a hash of the absolute path, size and
+ * modification time of their source file and of the requested thumbnail size,
+ * so that modifying a file invalidates all of its thumbnails. The images are
+ * stored as PNG files in a folder on disk, with the most recently used ones
+ * also kept in memory.
+ *
+ * Outdated files are never read again; they are removed in the background
+ * with the least recently used ones when the folder exceeds its capacity,
+ * when the cache is opened and whenever insertions exceed it.
+ * All methods are thread-safe, and several processes can share the folder.
+ */
+class ThumbnailCache : public boost::noncopyable
+{
+public:
+    /**
+     * Open a cache folder, creating it if needed, and trim it in the background.
+     * @param directory The folder where thumbnails are stored.
+     * @param memoryCapacity The maximum memory used by the thumbnails, in bytes.
+     * @param diskCapacity The maximum disk space used by the thumbnails, in bytes.
+     */
+    ThumbnailCache(const QString& directory, const qint64 memoryCapacity,
+                   const qint64 diskCapacity);
+
+    /** Wait for the background trimming to finish. */
+    ~ThumbnailCache();
+
+    /** @return The cache shared by the ThumbnailGenerators of this process. */
+    static ThumbnailCache& getDefaultCache();
+
+    /**
+     * Get a thumbnail from the cache.
+     * @param filename The source file of the thumbnail.
+     * @param size The requested thumbnail size.
+     * @param image Set to the cached thumbnail if found.
+     * @return true if the thumbnail was found.
+     */
+    bool find(const QString& filename, const QSize& size, QImage& image);
+
+    /**
+     * Store a thumbnail in memory and on disk.
+     * @param filename The source file of the thumbnail, which must exist.
+     * @param size The requested thumbnail size.
+     * @param image The thumbnail.
+     */
+    void insert(const QString& filename, const QSize& size, const QImage& image);
+
+    /**
+     * Remove the least recently used files until the disk usage is well below
+     * the capacity. Called in the background when the cache is opened and when
+     * insertions exceed the capacity.
+     */
+    void trimDiskCache();
+
+    /**
+     * Get the key of a thumbnail.
+     * @return The key, or an empty string if the file does not exist.
+     */
+    static QString makeKey(const QString& filename, const QSize& size);
+
+private:
+    QDir directory_;
+    const qint64 diskCapacity_;
+
+    QMutex mutex_;
+    QCache<QString, QImage> memoryCache_;
+
+    // Estimated size of the folder, updated by insertions and trimming
+    qint64 diskUsage_;
+    QFuture<void> trimFuture_;
+    bool trimRequested_;
+
+    qint64 removeLeastRecentlyUsedFiles();
+    QString getCacheFilename(const QString& key) const;
+    void insertInMemory(const QString& key, const QImage& image);
+};
+
+#endif // THUMBNAILCACHE_H
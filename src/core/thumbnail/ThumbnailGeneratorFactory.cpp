@@ -45,12 +45,14 @@
 #  include "../PDFContent.h"
 #endif
 
+#include "CachedThumbnailGenerator.h"
 #include "DefaultThumbnailGenerator.h"
 #include "FolderThumbnailGenerator.h"
 #include "ImageThumbnailGenerator.h"
 #include "MovieThumbnailGenerator.h"
 #include "PyramidThumbnailGenerator.h"
 #include "StateThumbnailGenerator.h"
+#include "ThumbnailCache.h"
 
 #include "MovieContent.h"
 #include "TextureContent.h"
@@ -65,13 +67,25 @@ ThumbnailGeneratorFactory::ThumbnailGeneratorFactory()
 
 ThumbnailGeneratorPtr ThumbnailGeneratorFactory::getGenerator(const QString &filename, const QSize &size)
 {
-    const QString& extension = QFileInfo(filename).suffix().toLower();
-
+    // Folder mosaics are composed from the cached thumbnails of their files
     if (!filename.isEmpty() && QDir(filename).exists())
     {
         return ThumbnailGeneratorPtr(new FolderThumbnailGenerator(size));
     }
 
+    const ThumbnailGeneratorPtr generator = getFileGenerator(filename, size);
+    if (!generator)
+        return ThumbnailGeneratorPtr(new DefaultThumbnailGenerator(size));
+
+    return ThumbnailGeneratorPtr(new CachedThumbnailGenerator(generator,
+                                                              ThumbnailCache::getDefaultCache(),
+                                                              size));
+}
+
+ThumbnailGeneratorPtr ThumbnailGeneratorFactory::getFileGenerator(const QString &filename, const QSize &size)
+{
+    const QString& extension = QFileInfo(filename).suffix().toLower();
+
     if( extension == "dcx" )
     {
         return ThumbnailGeneratorPtr(new StateThumbnailGenerator(size));
@@ -99,7 +113,7 @@ ThumbnailGeneratorPtr ThumbnailGeneratorFactory::getGenerator(const QString &fil
     }
 #endif
 
-    return ThumbnailGeneratorPtr(new DefaultThumbnailGenerator(size));
+    return ThumbnailGeneratorPtr();
 }
 
 ThumbnailGeneratorPtr ThumbnailGeneratorFactory::getDefaultGenerator(const QSize &size)
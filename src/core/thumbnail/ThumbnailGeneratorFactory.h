@@ -55,11 +55,19 @@ class ThumbnailGeneratorFactory
 public:
     ThumbnailGeneratorFactory();
 
+    /**
+     * Get a generator for a file or folder.
+     * The thumbnails of supported files are kept in the default ThumbnailCache.
+     */
     static ThumbnailGeneratorPtr getGenerator(const QString& filename, const QSize& size);
 
     static ThumbnailGeneratorPtr getDefaultGenerator(const QSize& size);
 
     static FolderThumbnailGeneratorPtr getFolderGenerator(const QSize& size);
+
+private:
+    /** @return The uncached generator for a file type, or null if unsupported. */
+    static ThumbnailGeneratorPtr getFileGenerator(const QString& filename, const QSize& size);
 };
 
 #endif // THUMBNAILGENERATORFACTORY_H
@@ -58,7 +58,9 @@ class Renderable;
 class DisplayGroupRenderer;
 class FactoryObject;
 class PixelStreamFrame;
+struct MoviePackets;
 class SkeletonState;
+class TiffPyramidReader;
 
 namespace dc
 {
@@ -80,7 +82,9 @@ typedef boost::shared_ptr<Renderable> RenderablePtr;
 typedef boost::shared_ptr<DisplayGroupRenderer> DisplayGroupRendererPtr;
 typedef boost::shared_ptr<FactoryObject> FactoryObjectPtr;
 typedef boost::shared_ptr<PixelStreamFrame> PixelStreamFramePtr;
+typedef boost::shared_ptr<MoviePackets> MoviePacketsPtr;
 typedef boost::shared_ptr<SkeletonState> SkeletonStatePtr;
+typedef boost::shared_ptr<TiffPyramidReader> TiffPyramidReaderPtr;
 
 typedef std::vector< ContentWindowManagerPtr > ContentWindowManagerPtrs;
 typedef std::vector<MarkerPtr> MarkerPtrs;
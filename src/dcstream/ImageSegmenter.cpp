@@ -46,6 +46,7 @@
 #include "log.h"
 
 #include <QtConcurrentMap>
+#include <cstring>
 
 namespace dc
 {
@@ -121,6 +122,40 @@ bool ImageSegmenter::generateJpeg( const ImageWrapper& image,
     return result;
 }
 
+// Copy the region of a segment, converting BGRA images to RGBA which is the
+// only raw format supported by the receiver
+void copySegmentData( const ImageWrapper& image,
+                      const PixelStreamSegmentParameters& parameters,
+                      char* buffer )
+{
+    // assume imageBuffer isn't padded
+    const size_t bytesPerPixel = image.getBytesPerPixel();
+    const size_t imagePitch = image.width * bytesPerPixel;
+    const size_t segmentPitch = parameters.width * bytesPerPixel;
+    const char* lineData = (const char*)image.data +
+        (parameters.y - image.y) * imagePitch +
+        (parameters.x - image.x) * bytesPerPixel;
+
+    for( unsigned int i = 0; i < parameters.height; ++i )
+    {
+        if( image.pixelFormat == BGRA )
+        {
+            for( size_t j = 0; j < segmentPitch; j += 4 )
+            {
+                buffer[j] = lineData[j+2];
+                buffer[j+1] = lineData[j+1];
+                buffer[j+2] = lineData[j];
+                buffer[j+3] = lineData[j+3];
+            }
+        }
+        else
+            memcpy( buffer, lineData, segmentPitch );
+
+        buffer += segmentPitch;
+        lineData += imagePitch;
+    }
+}
+
 bool ImageSegmenter::generateRaw( const ImageWrapper &image,
                                   const Handler& handler ) const
 {
@@ -132,30 +167,10 @@ bool ImageSegmenter::generateRaw( const ImageWrapper &image,
     {
         PixelStreamSegment segment;
         segment.parameters = *it;
-        segment.imageData.reserve( segment.parameters.width *
-                                   segment.parameters.height *
-                                   image.getBytesPerPixel( ));
-
-        if (segmentParams.size() == 1)
-        {
-            // If we are not segmenting the image, just append the image data
-            segment.imageData.append((const char*)image.data, image.getBufferSize());
-        }
-        else // Copy the image subregion
-        {
-            // assume imageBuffer isn't padded
-            const size_t imagePitch = image.width * image.getBytesPerPixel();
-            const char* lineData = (const char*)image.data +
-                segment.parameters.y*imagePitch +
-                segment.parameters.x*image.getBytesPerPixel();
-
-            for (unsigned int i=0; i < segment.parameters.height; ++i)
-            {
-                segment.imageData.append( lineData, segment.parameters.width *
-                                                    image.getBytesPerPixel( ));
-                lineData += imagePitch;
-            }
-        }
+        segment.imageData.resize( segment.parameters.width *
+                                  segment.parameters.height *
+                                  image.getBytesPerPixel( ));
+        copySegmentData( image, segment.parameters, segment.imageData.data( ));
 
         if( !handler( segment ))
             return false;
@@ -164,6 +179,21 @@ bool ImageSegmenter::generateRaw( const ImageWrapper &image,
     return true;
 }
 
+SegmentParameters ImageSegmenter::copyRaw( const ImageWrapper& image,
+                                           unsigned char* buffer ) const
+{
+    const SegmentParameters& segmentParams = generateSegmentParameters( image );
+
+    for( SegmentParameters::const_iterator it = segmentParams.begin();
+         it != segmentParams.end(); ++it )
+    {
+        copySegmentData( image, *it, (char*)buffer );
+        buffer += it->width * it->height * image.getBytesPerPixel();
+    }
+
+    return segmentParams;
+}
+
 void ImageSegmenter::setNominalSegmentDimensions(const unsigned int nominalSegmentWidth, const unsigned int nominalSegmentHeight)
 {
     nominalSegmentWidth_ = nominalSegmentWidth;
@@ -98,6 +98,18 @@ public:
     void setNominalSegmentDimensions( const unsigned int nominalSegmentWidth,
                                       const unsigned int nominalSegmentHeight );
 
+    /**
+     * Copy the raw segments of an image one after the other in a buffer.
+     *
+     * BGRA images are converted to RGBA, like in generate().
+     *
+     * @param image The image to be segmented
+     * @param buffer The destination, of at least image.getBufferSize() bytes
+     * @return The parameters of the segments, in the order of the buffer
+     */
+    SegmentParameters copyRaw( const ImageWrapper& image,
+                               unsigned char* buffer ) const;
+
 private:
     SegmentParameters generateSegmentParameters(const ImageWrapper &image) const;
 
@@ -42,6 +42,7 @@
 #include "NetworkProtocol.h"
 #include "log.h"
 
+#include <QtNetwork/QHostAddress>
 #include <QtNetwork/QTcpSocket>
 
 #define RECEIVE_TIMEOUT_MS                 1000
@@ -73,6 +74,17 @@ bool Socket::isConnected() const
     return socket_->state() == QTcpSocket::ConnectedState;
 }
 
+bool Socket::isLocal() const
+{
+    if( !isConnected( ))
+        return false;
+
+    const QHostAddress peer = socket_->peerAddress();
+    return peer == QHostAddress::LocalHost ||
+           peer == QHostAddress::LocalHostIPv6 ||
+           peer == socket_->localAddress();
+}
+
 int Socket::getFileDescriptor() const
 {
     return socket_->socketDescriptor();
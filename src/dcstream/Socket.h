@@ -73,6 +73,9 @@ public:
     /** Is the Socket connected */
     bool isConnected() const;
 
+    /** Is the Socket connected to a host on the local machine */
+    bool isLocal() const;
+
     /**
      * Is there a pending message
      * @param messageSize Minimum size of the message
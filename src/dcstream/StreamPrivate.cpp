@@ -45,10 +45,14 @@
 #include "StreamSendWorker.h"
 #include "PixelStreamSegment.h"
 #include "PixelStreamSegmentParameters.h"
+#include "SharedFrameRing.h"
 
 #include <boost/thread/thread.hpp>
 #define SEGMENT_SIZE 512
 
+#define SHARED_FRAME_SLOT_COUNT  3
+#define SHARED_FRAME_TIMEOUT_MS  1000
+
 namespace dc
 {
 
@@ -58,6 +62,7 @@ StreamPrivate::StreamPrivate( const std::string &name,
     , dcSocket_( address )
     , registeredForEvents_(false)
     , sendWorker_( 0 )
+    , sharedFramesSupported_( true )
 {
     imageSegmenter_.setNominalSegmentDimensions(SEGMENT_SIZE, SEGMENT_SIZE);
 
@@ -75,6 +80,7 @@ StreamPrivate::StreamPrivate( const std::string &name,
 StreamPrivate::~StreamPrivate()
 {
     delete sendWorker_;
+    sharedFrames_.reset();
 
     if( !dcSocket_.isConnected( ))
         return;
@@ -88,13 +94,17 @@ StreamPrivate::~StreamPrivate()
 bool StreamPrivate::send( const ImageWrapper& image )
 {
     if( image.compressionPolicy != COMPRESSION_ON &&
-        image.pixelFormat != dc::RGBA )
+        image.pixelFormat != dc::RGBA && image.pixelFormat != dc::BGRA )
     {
         put_flog(LOG_ERROR, "Currently, RAW images can only be sent in RGBA "
-                            "format. Other formats support remain to be implemented.");
+                            "or BGRA format. Other formats support remain to be "
+                            "implemented.");
         return false;
     }
 
+    if( image.compressionPolicy != COMPRESSION_ON && sendShared( image ))
+        return true;
+
     const ImageSegmenter::Handler sendFunc =
         boost::bind( &StreamPrivate::sendPixelStreamSegment, this, _1 );
     return imageSegmenter_.generate( image, sendFunc );
@@ -136,6 +146,72 @@ bool StreamPrivate::sendPixelStreamSegment(const PixelStreamSegment &segment)
     return dcSocket_.send(mh, message);
 }
 
+bool StreamPrivate::sendShared( const ImageWrapper& image )
+{
+    if( !sharedFramesSupported_ || !dcSocket_.isLocal( ))
+        return false;
+
+    const size_t frameSize = image.getBufferSize();
+    if( !sharedFrames_ || sharedFrames_->getSlotSize() < frameSize )
+        openSharedFrames( frameSize );
+
+    // Use the socket until the DisplayCluster has attached to the ring
+    if( !sharedFrames_ || !sharedFrames_->isReaderAttached( ))
+        return false;
+
+    const int slot = sharedFrames_->acquireSlot( SHARED_FRAME_TIMEOUT_MS );
+    if( slot < 0 )
+    {
+        put_flog( LOG_DEBUG, "no shared frame released in time" );
+        return false;
+    }
+
+    const SegmentParameters segmentParams =
+        imageSegmenter_.copyRaw( image, sharedFrames_->getSlotData( slot ));
+
+    // Message payload: the slot index followed by the segment references
+    QByteArray message;
+    const uint32_t slotIndex = slot;
+    message.append( (const char*)(&slotIndex), sizeof(uint32_t) );
+
+    uint32_t offset = 0;
+    for( SegmentParameters::const_iterator it = segmentParams.begin();
+         it != segmentParams.end(); ++it )
+    {
+        SharedSegmentReference reference;
+        reference.parameters = *it;
+        reference.offset = offset;
+        reference.size = it->width * it->height * image.getBytesPerPixel();
+        message.append( (const char*)(&reference), sizeof(SharedSegmentReference) );
+
+        offset += reference.size;
+    }
+
+    MessageHeader mh( MESSAGE_TYPE_PIXELSTREAM_SHARED, message.size(), name_ );
+
+    QMutexLocker locker( &sendLock_ );
+    return dcSocket_.send( mh, message );
+}
+
+void StreamPrivate::openSharedFrames( const size_t frameSize )
+{
+    sharedFrames_.reset( new SharedFrameRing( SHARED_FRAME_SLOT_COUNT,
+                                              frameSize ));
+    if( !sharedFrames_->isOpen( ))
+    {
+        sharedFrames_.reset();
+        sharedFramesSupported_ = false;
+        return;
+    }
+
+    const std::string& name = sharedFrames_->getName();
+    const QByteArray message( name.c_str(), name.size( ));
+    MessageHeader mh( MESSAGE_TYPE_PIXELSTREAM_SHARED_OPEN, message.size(), name_ );
+
+    QMutexLocker locker( &sendLock_ );
+    dcSocket_.send( mh, message );
+}
+
 bool StreamPrivate::sendCommand(const QString& command)
 {
     QByteArray message;
@@ -48,6 +48,7 @@
 #include "Stream.h" // Stream::Future
 
 #include <QMutex>
+#include <boost/scoped_ptr.hpp>
 #include <string>
 
 class QString;
@@ -57,6 +58,7 @@ namespace dc
 
 struct PixelStreamSegment;
 struct PixelStreamSegmentParameters;
+class SharedFrameRing;
 class StreamSendWorker;
 
 /**
@@ -127,6 +129,20 @@ public:
 
 private:
     StreamSendWorker* sendWorker_;
+
+    /** Frame buffers shared with a DisplayCluster running on the same host */
+    boost::scoped_ptr<SharedFrameRing> sharedFrames_;
+    bool sharedFramesSupported_;
+
+    /**
+     * Send a raw image through the shared frame ring.
+     * @return false if the ring is not usable, the image must then be sent
+     *         through the socket
+     */
+    bool sendShared( const ImageWrapper& image );
+
+    /** Create a new shared frame ring and announce it to the DisplayCluster */
+    void openSharedFrames( const size_t frameSize );
 };
 
 }
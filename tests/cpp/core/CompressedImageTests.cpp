@@ -0,0 +1,140 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE CompressedImageTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "CompressedImage.h"
+
+#include <cstdlib>
+
+namespace
+{
+QImage createGradient(const int width, const int height, const bool alpha)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    for(int y = 0; y < height; ++y)
+        for(int x = 0; x < width; ++x)
+            image.setPixel(x, y, qRgba(x * 255 / width, y * 255 / height, 128,
+                                       alpha ? (x + y) * 255 / (width + height) : 255));
+    return image;
+}
+
+int getMaxError(const QImage& image1, const QImage& image2, const bool alpha)
+{
+    int maxError = 0;
+    for(int y = 0; y < image1.height(); ++y)
+    {
+        for(int x = 0; x < image1.width(); ++x)
+        {
+            const QRgb pixel1 = image1.pixel(x, y);
+            const QRgb pixel2 = image2.pixel(x, y);
+            maxError = std::max(maxError, std::abs(qRed(pixel1) - qRed(pixel2)));
+            maxError = std::max(maxError, std::abs(qGreen(pixel1) - qGreen(pixel2)));
+            maxError = std::max(maxError, std::abs(qBlue(pixel1) - qBlue(pixel2)));
+            if(alpha)
+                maxError = std::max(maxError, std::abs(qAlpha(pixel1) - qAlpha(pixel2)));
+        }
+    }
+    return maxError;
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestBlocksSize )
+{
+    BOOST_CHECK_EQUAL( CompressedImage::getBlocksSize(QSize(512, 512), CompressedImage::BC1), 512 * 512 / 2 );
+    BOOST_CHECK_EQUAL( CompressedImage::getBlocksSize(QSize(512, 512), CompressedImage::BC3), 512 * 512 );
+
+    // Incomplete blocks are padded
+    BOOST_CHECK_EQUAL( CompressedImage::getBlocksSize(QSize(5, 3), CompressedImage::BC1), 2 * 8 );
+
+    const CompressedImage image(QImage(513, 300, QImage::Format_RGB32), CompressedImage::BC1);
+    BOOST_CHECK_EQUAL( image.blocks().size(), 129 * 75 * 8 );
+}
+
+BOOST_AUTO_TEST_CASE( TestSolidColorIsExact )
+{
+    // Colors which are exactly representable in RGB565
+    QImage image(10, 7, QImage::Format_RGB32);
+    image.fill(qRgb(255, 0, 132));
+
+    const CompressedImage compressed(image, CompressedImage::BC1);
+    BOOST_REQUIRE( !compressed.isNull( ));
+    BOOST_CHECK_EQUAL( compressed.size().width(), 10 );
+    BOOST_CHECK_EQUAL( compressed.size().height(), 7 );
+
+    const QImage decompressed = compressed.decompress();
+    BOOST_REQUIRE_EQUAL( decompressed.width(), 10 );
+    BOOST_REQUIRE_EQUAL( decompressed.height(), 7 );
+    BOOST_CHECK_EQUAL( getMaxError(image, decompressed, true), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( TestGradientRoundTrip )
+{
+    const QImage image = createGradient(64, 48, false);
+
+    const CompressedImage bc1(image, CompressedImage::BC1);
+    BOOST_CHECK_LE( getMaxError(image, bc1.decompress(), false), 16 );
+
+    const QImage imageWithAlpha = createGradient(64, 48, true);
+
+    const CompressedImage bc3(imageWithAlpha, CompressedImage::BC3);
+    BOOST_CHECK_EQUAL( bc3.format(), CompressedImage::BC3 );
+    BOOST_CHECK_LE( getMaxError(imageWithAlpha, bc3.decompress(), true), 16 );
+}
+
+BOOST_AUTO_TEST_CASE( TestSerialization )
+{
+    const CompressedImage image(createGradient(30, 20, true), CompressedImage::BC3);
+    const QByteArray data = image.toData();
+
+    BOOST_CHECK( CompressedImage::isCompressedImage(data));
+
+    const CompressedImage copy = CompressedImage::fromData(data);
+    BOOST_REQUIRE( !copy.isNull( ));
+    BOOST_CHECK_EQUAL( copy.format(), CompressedImage::BC3 );
+    BOOST_CHECK( copy.size() == image.size( ));
+    BOOST_CHECK( copy.blocks() == image.blocks( ));
+
+    // Truncated or foreign data is rejected
+    BOOST_CHECK( CompressedImage::fromData(data.left(data.size() - 1)).isNull( ));
+    BOOST_CHECK( CompressedImage::fromData(QByteArray("\xff\xd8\xff\xe0")).isNull( ));
+    BOOST_CHECK( !CompressedImage::isCompressedImage(QByteArray("\xff\xd8\xff\xe0")));
+}
@@ -62,6 +62,13 @@ namespace ut = boost::unit_test;
 #define CONFIG_EXPECTED_URL "http://bbp.epfl.ch"
 #define CONFIG_EXPECTED_DEFAULT_URL "http://www.google.com"
 
+#define CONFIG_EXPECTED_HOST_MEMORY_BUDGET 4096
+#define CONFIG_EXPECTED_GPU_MEMORY_BUDGET 2048
+#define CONFIG_EXPECTED_DEFAULT_HOST_MEMORY_BUDGET 2048
+#define CONFIG_EXPECTED_DEFAULT_GPU_MEMORY_BUDGET 1024
+#define CONFIG_EXPECTED_SHARED_TILE_CACHE_BUDGET 512
+#define CONFIG_EXPECTED_DEFAULT_SHARED_TILE_CACHE_BUDGET 0
+
 BOOST_GLOBAL_FIXTURE( MinimalGlobalQtApp );
 
 void testBaseParameters(const Configuration& config)
@@ -99,6 +106,8 @@ BOOST_AUTO_TEST_CASE( test_configuration )
     Configuration config(CONFIG_TEST_FILENAME);
 
     testBaseParameters(config);
+
+    BOOST_CHECK_EQUAL( config.getStreamMoviesFromMaster(), true );
 }
 
 BOOST_AUTO_TEST_CASE( test_wall_configuration )
@@ -110,6 +119,20 @@ BOOST_AUTO_TEST_CASE( test_wall_configuration )
     BOOST_CHECK_EQUAL( config.getHost().toStdString(), CONFIG_EXPECTED_HOST_NAME );
 
     BOOST_CHECK_EQUAL( config.getScreenCount(), 1 );
+
+    BOOST_CHECK_EQUAL( config.getHostMemoryBudget(), CONFIG_EXPECTED_HOST_MEMORY_BUDGET );
+    BOOST_CHECK_EQUAL( config.getGPUMemoryBudget(), CONFIG_EXPECTED_GPU_MEMORY_BUDGET );
+    BOOST_CHECK_EQUAL( config.getSharedTileCacheBudget(), CONFIG_EXPECTED_SHARED_TILE_CACHE_BUDGET );
+}
+
+BOOST_AUTO_TEST_CASE( test_wall_configuration_default_values )
+{
+    WallConfiguration config(CONFIG_TEST_FILENAME_II, 1);
+
+    BOOST_CHECK_EQUAL( config.getHostMemoryBudget(), CONFIG_EXPECTED_DEFAULT_HOST_MEMORY_BUDGET );
+    BOOST_CHECK_EQUAL( config.getGPUMemoryBudget(), CONFIG_EXPECTED_DEFAULT_GPU_MEMORY_BUDGET );
+    BOOST_CHECK_EQUAL( config.getSharedTileCacheBudget(), CONFIG_EXPECTED_DEFAULT_SHARED_TILE_CACHE_BUDGET );
+    BOOST_CHECK_EQUAL( config.getStreamMoviesFromMaster(), false );
 }
 
 BOOST_AUTO_TEST_CASE( test_master_configuration )
@@ -0,0 +1,113 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE DockPrefetchWindowTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "localstreamer/DockPrefetchWindow.h"
+
+namespace
+{
+std::vector<int> makeSlides(const int* slides, const size_t count)
+{
+    return std::vector<int>(slides, slides + count);
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestSlidesAroundCenter )
+{
+    DockPrefetchWindow window(2, 16, 0.5);
+    window.reset(5);
+
+    BOOST_CHECK_EQUAL( window.getLookAheadRadius(), 2 );
+
+    const int expected[] = { 5, 6, 4, 7, 3 };
+    const std::vector<int> slides = window.getSlides(20);
+    BOOST_CHECK_EQUAL_COLLECTIONS( slides.begin(), slides.end(),
+                                   expected, expected + 5 );
+
+    BOOST_CHECK( window.getSlides(0).empty( ));
+}
+
+BOOST_AUTO_TEST_CASE( TestSlidesAreClampedToFlow )
+{
+    DockPrefetchWindow window(2, 16, 0.5);
+
+    window.reset(0);
+    const int expectedFirst[] = { 0, 1, 2 };
+    BOOST_CHECK( window.getSlides(10) == makeSlides(expectedFirst, 3));
+
+    window.reset(9);
+    const int expectedLast[] = { 9, 8, 7 };
+    BOOST_CHECK( window.getSlides(10) == makeSlides(expectedLast, 3));
+
+    // The center is kept inside the flow, for instance after slides are removed
+    window.reset(30);
+    BOOST_CHECK( window.getSlides(10) == makeSlides(expectedLast, 3));
+}
+
+BOOST_AUTO_TEST_CASE( TestWindowExtendsWithScrollingSpeed )
+{
+    DockPrefetchWindow window(2, 16, 0.5);
+    window.setCenter(0, 10.0);
+
+    // 10 slides per second to the right
+    window.setCenter(1, 10.1);
+    window.setCenter(2, 10.2);
+    BOOST_CHECK_EQUAL( window.getLookAheadRadius(), 2 + 5 );
+
+    const int expected[] = { 2, 3, 1, 4, 0, 5, 6, 7, 8, 9 };
+    BOOST_CHECK( window.getSlides(100) == makeSlides(expected, 10));
+
+    // Faster scrolling is limited by the maximum radius
+    window.setCenter(50, 10.3);
+    BOOST_CHECK_EQUAL( window.getLookAheadRadius(), 16 );
+
+    // Scrolling back to the left restarts the estimation
+    window.setCenter(49, 10.4);
+    BOOST_CHECK_EQUAL( window.getLookAheadRadius(), 2 + 5 );
+    const std::vector<int> slides = window.getSlides(100);
+    BOOST_CHECK_EQUAL( slides[1], 48 );
+    BOOST_CHECK_EQUAL( slides[2], 50 );
+
+    // The motion is forgotten after a pause
+    window.setCenter(48, 20.0);
+    BOOST_CHECK_EQUAL( window.getLookAheadRadius(), 2 );
+}
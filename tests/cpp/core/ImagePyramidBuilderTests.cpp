@@ -0,0 +1,165 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE ImagePyramidBuilderTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "MinimalGlobalQtApp.h"
+
+#include "ImagePyramidBuilder.h"
+#include "DynamicTexture.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QTextStream>
+
+#define TEST_IMAGE_WIDTH  1300
+#define TEST_IMAGE_HEIGHT 700
+
+BOOST_GLOBAL_FIXTURE( MinimalGlobalQtApp );
+
+namespace
+{
+QString createTestImage(const QDir& dir, const QString& extension)
+{
+    QImage image(TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, QImage::Format_RGB32);
+    for(int y = 0; y < image.height(); ++y)
+        for(int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgb(x % 256, y % 256, (x + y) % 256));
+
+    const QString filename = dir.absoluteFilePath("image.").append(extension);
+    image.save(filename);
+    return filename;
+}
+
+QStringList listTiles(const QString& folder)
+{
+    QStringList filters;
+    filters << QString("*.").append(DynamicTexture::pyramidImageExtension);
+    QStringList tiles = QDir(folder).entryList(filters, QDir::Files, QDir::Name);
+    return tiles;
+}
+
+void removeFolder(const QString& folder)
+{
+    QDir dir(folder);
+    foreach(const QString& file, dir.entryList(QDir::Files))
+        dir.remove(file);
+    QDir().rmdir(folder);
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestSameLayoutAsDynamicTexture )
+{
+    const QDir dir(QDir::tempPath());
+    const QString imageFilename = createTestImage(dir, "jpg");
+    const QString builderFolder = dir.absoluteFilePath("builder") + DynamicTexture::pyramidFolderSuffix;
+    const QString referenceFolder = dir.absoluteFilePath("reference") + DynamicTexture::pyramidFolderSuffix;
+
+    ImagePyramidBuilder builder(imageFilename, builderFolder);
+    builder.setEncodingThreadCount(2);
+    builder.setMaxStripSize(1); // Read one row of tiles at a time
+    BOOST_REQUIRE( builder.build( ));
+
+    DynamicTexturePtr reference(new DynamicTexture(imageFilename));
+    BOOST_REQUIRE( reference->generateImagePyramid(referenceFolder));
+
+    const QStringList tiles = listTiles(builderFolder);
+    const QStringList referenceTiles = listTiles(referenceFolder);
+
+    // 1300x700 has three levels: 1 + 4 + 16 tiles
+    BOOST_CHECK_EQUAL( tiles.size(), 21 );
+    BOOST_CHECK_EQUAL( tiles.join(",").toStdString(),
+                       referenceTiles.join(",").toStdString() );
+
+    foreach(const QString& tile, tiles)
+    {
+        const QSize size = QImageReader(builderFolder + tile).size();
+        const QSize referenceSize = QImageReader(referenceFolder + tile).size();
+        BOOST_CHECK_EQUAL( size.width(), referenceSize.width() );
+        BOOST_CHECK_EQUAL( size.height(), referenceSize.height() );
+    }
+
+    QFile metadata(builderFolder + DynamicTexture::pyramidMetadataFilename);
+    BOOST_REQUIRE( metadata.open(QIODevice::ReadOnly));
+    const QString expectedMetadata = QString("\"%1\" %2 %3").arg(builderFolder)
+            .arg(TEST_IMAGE_WIDTH).arg(TEST_IMAGE_HEIGHT);
+    BOOST_CHECK_EQUAL( QTextStream(&metadata).readAll().toStdString(),
+                       expectedMetadata.toStdString() );
+
+    BOOST_CHECK( QFile::exists(dir.absoluteFilePath("builder.") + DynamicTexture::pyramidFileExtension));
+
+    removeFolder(builderFolder);
+    removeFolder(referenceFolder);
+    QFile::remove(dir.absoluteFilePath("builder.") + DynamicTexture::pyramidFileExtension);
+    QFile::remove(dir.absoluteFilePath("reference.") + DynamicTexture::pyramidFileExtension);
+    QFile::remove(imageFilename);
+}
+
+BOOST_AUTO_TEST_CASE( TestImageWhichCannotBeReadInStrips )
+{
+    const QDir dir(QDir::tempPath());
+    const QString imageFilename = createTestImage(dir, "png");
+    const QString folder = dir.absoluteFilePath("png") + DynamicTexture::pyramidFolderSuffix;
+
+    ImagePyramidBuilder builder(imageFilename, folder);
+    builder.setEncodingThreadCount(2);
+
+    // PNG images are only read if they fit in one strip
+    builder.setMaxStripSize(TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * 4 - 1);
+    BOOST_CHECK( !builder.build( ));
+
+    builder.setMaxStripSize(TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * 4);
+    BOOST_CHECK( builder.build( ));
+    BOOST_CHECK_EQUAL( listTiles(folder).size(), 21 );
+
+    removeFolder(folder);
+    QFile::remove(dir.absoluteFilePath("png.") + DynamicTexture::pyramidFileExtension);
+    QFile::remove(imageFilename);
+}
+
+BOOST_AUTO_TEST_CASE( TestMissingImage )
+{
+    const QString folder = QDir::temp().absoluteFilePath("missing") + DynamicTexture::pyramidFolderSuffix;
+    ImagePyramidBuilder builder(QDir::temp().absoluteFilePath("missing.png"), folder);
+    BOOST_CHECK( !builder.build( ));
+}
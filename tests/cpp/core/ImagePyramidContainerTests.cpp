@@ -0,0 +1,187 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE ImagePyramidContainerTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "MinimalGlobalQtApp.h"
+
+#include "ImagePyramidBuilder.h"
+#include "ImagePyramidContainer.h"
+#include "DynamicTexture.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+
+#include <cstdlib>
+
+#define TEST_IMAGE_WIDTH  1300
+#define TEST_IMAGE_HEIGHT 700
+
+BOOST_GLOBAL_FIXTURE( MinimalGlobalQtApp );
+
+namespace
+{
+QByteArray readFile(const QString& filename)
+{
+    QFile file(filename);
+    file.open(QIODevice::ReadOnly);
+    return file.readAll();
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestTileFilenames )
+{
+    BOOST_CHECK_EQUAL( ImagePyramidContainer::getTileFilename(0, 0, 0).toStdString(), "0.jpg" );
+    BOOST_CHECK_EQUAL( ImagePyramidContainer::getTileFilename(1, 0, 1).toStdString(), "0-1.jpg" );
+    BOOST_CHECK_EQUAL( ImagePyramidContainer::getTileFilename(1, 1, 0).toStdString(), "0-3.jpg" );
+    BOOST_CHECK_EQUAL( ImagePyramidContainer::getTileFilename(2, 3, 2).toStdString(), "0-2-3.jpg" );
+
+    BOOST_CHECK_EQUAL( ImagePyramidContainer::getLevelCount(QSize(512, 300), 512), 1 );
+    BOOST_CHECK_EQUAL( ImagePyramidContainer::getLevelCount(QSize(1300, 700), 512), 3 );
+}
+
+BOOST_AUTO_TEST_CASE( TestConvertAndRead )
+{
+    const QDir dir(QDir::tempPath());
+
+    QImage image(TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, QImage::Format_RGB32);
+    image.fill(0xff336699);
+    const QString imageFilename = dir.absoluteFilePath("container.png");
+    BOOST_REQUIRE( image.save(imageFilename));
+
+    const QString pyramidFolder = dir.absoluteFilePath("container") + DynamicTexture::pyramidFolderSuffix;
+    const QString metadataFilename = dir.absoluteFilePath("container.") + DynamicTexture::pyramidFileExtension;
+    const QString containerFilename = dir.absoluteFilePath("container-single.") + DynamicTexture::pyramidFileExtension;
+
+    ImagePyramidBuilder builder(imageFilename, pyramidFolder);
+    BOOST_REQUIRE( builder.build( ));
+
+    BOOST_CHECK( !ImagePyramidContainer::isContainer(metadataFilename));
+    BOOST_REQUIRE( ImagePyramidContainer::convert(metadataFilename, containerFilename));
+    BOOST_CHECK( ImagePyramidContainer::isContainer(containerFilename));
+
+    ImagePyramidContainer container;
+    BOOST_REQUIRE( container.open(containerFilename));
+    BOOST_CHECK_EQUAL( container.getImageSize().width(), TEST_IMAGE_WIDTH );
+    BOOST_CHECK_EQUAL( container.getImageSize().height(), TEST_IMAGE_HEIGHT );
+    BOOST_REQUIRE_EQUAL( container.getLevelCount(), 3 );
+
+    for(int depth = 0; depth < container.getLevelCount(); ++depth)
+    {
+        for(int row = 0; row < (1 << depth); ++row)
+        {
+            for(int column = 0; column < (1 << depth); ++column)
+            {
+                const QString tile = pyramidFolder + ImagePyramidContainer::getTileFilename(depth, row, column);
+                const QByteArray data = container.readTile(depth, row, column);
+                BOOST_CHECK( !data.isEmpty( ));
+                BOOST_CHECK( data == readFile(tile));
+            }
+        }
+    }
+
+    std::vector<int> treePath;
+    treePath.push_back(0);
+    treePath.push_back(2);
+    treePath.push_back(1);
+    BOOST_CHECK( container.readTile(treePath) == readFile(pyramidFolder + "0-2-1.jpg"));
+
+    BOOST_CHECK( container.readTile(3, 0, 0).isEmpty( ));
+    BOOST_CHECK( container.readTile(1, 2, 0).isEmpty( ));
+
+    // DynamicTexture detects the container transparently
+    DynamicTexturePtr dynamicTexture(new DynamicTexture(containerFilename));
+    int width = 0, height = 0;
+    dynamicTexture->getDimensions(width, height);
+    BOOST_CHECK_EQUAL( width, TEST_IMAGE_WIDTH );
+    BOOST_CHECK_EQUAL( height, TEST_IMAGE_HEIGHT );
+
+    foreach(const QString& file, QDir(pyramidFolder).entryList(QDir::Files))
+        QFile::remove(pyramidFolder + file);
+    QDir().rmdir(pyramidFolder);
+    QFile::remove(metadataFilename);
+    QFile::remove(containerFilename);
+    QFile::remove(imageFilename);
+}
+
+BOOST_AUTO_TEST_CASE( TestConvertToCompressedTiles )
+{
+    const QDir dir(QDir::tempPath());
+
+    QImage image(TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, QImage::Format_RGB32);
+    image.fill(0xff336699);
+    const QString imageFilename = dir.absoluteFilePath("compressed.png");
+    BOOST_REQUIRE( image.save(imageFilename));
+
+    const QString pyramidFolder = dir.absoluteFilePath("compressed") + DynamicTexture::pyramidFolderSuffix;
+    const QString metadataFilename = dir.absoluteFilePath("compressed.") + DynamicTexture::pyramidFileExtension;
+
+    ImagePyramidBuilder builder(imageFilename, pyramidFolder);
+    BOOST_REQUIRE( builder.build( ));
+
+    // The container replaces the metadata file, the JPEG tiles are kept
+    BOOST_REQUIRE( ImagePyramidContainer::convert(metadataFilename, metadataFilename,
+                                                  ImagePyramidContainer::TILES_BC1));
+
+    ImagePyramidContainer container;
+    BOOST_REQUIRE( container.open(metadataFilename));
+    BOOST_CHECK_EQUAL( container.getTileFormat(), ImagePyramidContainer::TILES_BC1 );
+
+    const QImage jpegTile(pyramidFolder + "0-1.jpg");
+    const CompressedImage tile = CompressedImage::fromData(container.readTile(1, 0, 1));
+    BOOST_REQUIRE( !tile.isNull( ));
+    BOOST_CHECK_EQUAL( tile.format(), CompressedImage::BC1 );
+    BOOST_CHECK( tile.size() == jpegTile.size( ));
+
+    const QImage decompressed = container.readTileImage(1, 0, 1);
+    BOOST_REQUIRE( decompressed.size() == jpegTile.size( ));
+    const QRgb pixel = decompressed.pixel(decompressed.width() / 2, decompressed.height() / 2);
+    BOOST_CHECK_LE( std::abs(qRed(pixel) - 0x33), 8 );
+    BOOST_CHECK_LE( std::abs(qGreen(pixel) - 0x66), 8 );
+    BOOST_CHECK_LE( std::abs(qBlue(pixel) - 0x99), 8 );
+
+    foreach(const QString& file, QDir(pyramidFolder).entryList(QDir::Files))
+        QFile::remove(pyramidFolder + file);
+    QDir().rmdir(pyramidFolder);
+    QFile::remove(metadataFilename);
+    QFile::remove(imageFilename);
+}
@@ -0,0 +1,152 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE MovieFrameQueueTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "MovieFrameQueue.h"
+
+#include <algorithm>
+
+#define FRAME_BYTES 16
+#define QUEUE_SIZE  3
+
+namespace
+{
+// Decode one frame whose data is filled with the given value
+void decodeFrame(MovieFrameQueue& queue, const double timestamp, const uint8_t value)
+{
+    double seekPosition = 0.0;
+    BOOST_REQUIRE_EQUAL( queue.waitForRequest(seekPosition), MovieFrameQueue::DECODE );
+
+    uint8_t* buffer = queue.getWriteBuffer();
+    BOOST_REQUIRE( buffer );
+    std::fill(buffer, buffer + FRAME_BYTES, value);
+    queue.push(timestamp, QRect(0, 0, FRAME_BYTES / 4, 1));
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestSelectFrameMatchingPosition )
+{
+    MovieFrameQueue queue(FRAME_BYTES, QUEUE_SIZE);
+    BOOST_CHECK( !queue.getCurrentFrame( ));
+    BOOST_CHECK_EQUAL( queue.getMemoryUsage(), (QUEUE_SIZE + 2) * FRAME_BYTES );
+
+    decodeFrame(queue, 0.0, 10);
+    decodeFrame(queue, 0.1, 11);
+    decodeFrame(queue, 0.2, 12);
+
+    BOOST_CHECK( queue.update(0.05) );
+    BOOST_REQUIRE( queue.getCurrentFrame( ));
+    BOOST_CHECK_EQUAL( queue.getCurrentFrame()[0], 10 );
+    BOOST_CHECK( queue.getCurrentFrameRegion() == QRect(0, 0, FRAME_BYTES / 4, 1));
+    BOOST_CHECK_EQUAL( queue.getCurrentFrameTimestamp(), 0.0 );
+
+    // No newer frame yet
+    BOOST_CHECK( !queue.update(0.09) );
+    BOOST_CHECK_EQUAL( queue.getCurrentFrame()[0], 10 );
+
+    // Late frames are skipped
+    BOOST_CHECK( queue.update(0.25) );
+    BOOST_CHECK_EQUAL( queue.getCurrentFrame()[FRAME_BYTES-1], 12 );
+    BOOST_CHECK_EQUAL( queue.getCurrentFrameTimestamp(), 0.2 );
+    BOOST_CHECK_EQUAL( queue.getPosition(), 0.25 );
+}
+
+BOOST_AUTO_TEST_CASE( TestDecodingReusesConsumedFrames )
+{
+    MovieFrameQueue queue(FRAME_BYTES, QUEUE_SIZE);
+
+    // The current frame is never overwritten while decoding ahead
+    for( int i = 0; i < 20; ++i )
+    {
+        decodeFrame(queue, i * 0.1, i);
+        BOOST_CHECK( queue.update(i * 0.1) );
+        BOOST_CHECK_EQUAL( queue.getCurrentFrame()[0], i );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( TestSeekDropsQueuedFrames )
+{
+    MovieFrameQueue queue(FRAME_BYTES, QUEUE_SIZE);
+
+    decodeFrame(queue, 0.0, 1);
+    BOOST_CHECK( queue.update(0.0) );
+    decodeFrame(queue, 0.1, 2);
+
+    // A frame decoded before the seek request was processed is dropped
+    double seekPosition = 0.0;
+    BOOST_REQUIRE_EQUAL( queue.waitForRequest(seekPosition), MovieFrameQueue::DECODE );
+    queue.seek(5.0);
+    queue.push(0.2, QRect(0, 0, FRAME_BYTES / 4, 1));
+
+    BOOST_CHECK( !queue.update(5.0) );
+    BOOST_CHECK_EQUAL( queue.getCurrentFrame()[0], 1 );
+
+    BOOST_REQUIRE_EQUAL( queue.waitForRequest(seekPosition), MovieFrameQueue::SEEK );
+    BOOST_CHECK_EQUAL( seekPosition, 5.0 );
+
+    decodeFrame(queue, 5.0, 3);
+    BOOST_CHECK( queue.update(5.0) );
+    BOOST_CHECK_EQUAL( queue.getCurrentFrame()[0], 3 );
+}
+
+BOOST_AUTO_TEST_CASE( TestEndOfStream )
+{
+    MovieFrameQueue queue(FRAME_BYTES, QUEUE_SIZE);
+
+    decodeFrame(queue, 0.0, 1);
+
+    double seekPosition = 0.0;
+    BOOST_REQUIRE_EQUAL( queue.waitForRequest(seekPosition), MovieFrameQueue::DECODE );
+    queue.setEndOfStream();
+
+    // The last frame has not been displayed yet
+    BOOST_CHECK( !queue.isEndOfStream( ));
+    BOOST_CHECK( queue.update(1.0) );
+    BOOST_CHECK( queue.isEndOfStream( ));
+
+    queue.seek(0.0);
+    BOOST_CHECK( !queue.isEndOfStream( ));
+    BOOST_CHECK_EQUAL( queue.waitForRequest(seekPosition), MovieFrameQueue::SEEK );
+
+    queue.stop();
+    BOOST_CHECK_EQUAL( queue.waitForRequest(seekPosition), MovieFrameQueue::STOP );
+}
@@ -0,0 +1,170 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE MovieKeyframeIndexTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "MovieKeyframeIndex.h"
+
+#include <QDir>
+#include <QFile>
+
+#define STREAM_INDEX 1
+
+namespace
+{
+const QString movieFilename = QDir::tempPath() + "/dc_test_keyframes.mov";
+const QString indexFilename = QDir::tempPath() + "/dc_test_keyframes.idx";
+
+// A keyframe every 12 frames of 1000 time base units
+void fillIndex(MovieKeyframeIndex& index, const int count)
+{
+    for( int i = 0; i < count; ++i )
+    {
+        MovieKeyframeIndex::Keyframe keyframe;
+        keyframe.pts = i * 12000 + 2000;
+        keyframe.dts = i * 12000;
+        keyframe.position = i * 4096;
+        index.addKeyframe(keyframe);
+    }
+    index.setReady();
+}
+
+void writeMovieFile(const QByteArray& data)
+{
+    QFile file(movieFilename);
+    BOOST_REQUIRE( file.open(QIODevice::WriteOnly) );
+    file.write(data);
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestFindKeyframe )
+{
+    MovieKeyframeIndex::Keyframe keyframe;
+    keyframe.pts = 2000;
+    keyframe.dts = 0;
+    keyframe.position = 0;
+
+    // Not usable before it is complete
+    MovieKeyframeIndex index;
+    index.addKeyframe(keyframe);
+    BOOST_CHECK( !index.findKeyframe(2000, keyframe) );
+    index.setReady();
+    BOOST_CHECK( index.findKeyframe(2000, keyframe) );
+
+    MovieKeyframeIndex filledIndex;
+    fillIndex(filledIndex, 5);
+    BOOST_CHECK_EQUAL( filledIndex.getKeyframeCount(), 5 );
+
+    // Nothing is presented before the first keyframe
+    BOOST_CHECK( !filledIndex.findKeyframe(1999, keyframe) );
+
+    BOOST_REQUIRE( filledIndex.findKeyframe(2000, keyframe) );
+    BOOST_CHECK_EQUAL( keyframe.dts, 0 );
+
+    BOOST_REQUIRE( filledIndex.findKeyframe(37999, keyframe) );
+    BOOST_CHECK_EQUAL( keyframe.dts, 24000 );
+    BOOST_CHECK_EQUAL( keyframe.position, 2 * 4096 );
+
+    BOOST_REQUIRE( filledIndex.findKeyframe(38000, keyframe) );
+    BOOST_CHECK_EQUAL( keyframe.dts, 36000 );
+
+    BOOST_REQUIRE( filledIndex.findKeyframe(1000000, keyframe) );
+    BOOST_CHECK_EQUAL( keyframe.dts, 48000 );
+}
+
+BOOST_AUTO_TEST_CASE( TestSaveAndLoad )
+{
+    writeMovieFile(QByteArray(64, 'a'));
+
+    MovieKeyframeIndex index;
+    fillIndex(index, 7);
+    BOOST_REQUIRE( index.save(indexFilename, movieFilename, STREAM_INDEX) );
+
+    MovieKeyframeIndex loadedIndex;
+    BOOST_REQUIRE( loadedIndex.load(indexFilename, movieFilename, STREAM_INDEX) );
+    BOOST_CHECK( loadedIndex.isReady() );
+    BOOST_CHECK_EQUAL( loadedIndex.getKeyframeCount(), 7 );
+
+    MovieKeyframeIndex::Keyframe keyframe;
+    BOOST_REQUIRE( loadedIndex.findKeyframe(74000, keyframe) );
+    BOOST_CHECK_EQUAL( keyframe.pts, 74000 );
+    BOOST_CHECK_EQUAL( keyframe.dts, 72000 );
+    BOOST_CHECK_EQUAL( keyframe.position, 6 * 4096 );
+
+    // The index of another stream can't be used
+    MovieKeyframeIndex otherStreamIndex;
+    BOOST_CHECK( !otherStreamIndex.load(indexFilename, movieFilename, STREAM_INDEX + 1) );
+
+    // The index is outdated once the movie changes
+    writeMovieFile(QByteArray(128, 'b'));
+    MovieKeyframeIndex outdatedIndex;
+    BOOST_CHECK( !outdatedIndex.load(indexFilename, movieFilename, STREAM_INDEX) );
+    BOOST_CHECK( !outdatedIndex.isReady() );
+
+    QFile::remove(indexFilename);
+    QFile::remove(movieFilename);
+}
+
+BOOST_AUTO_TEST_CASE( TestLoadInvalidFile )
+{
+    writeMovieFile(QByteArray(64, 'a'));
+
+    QFile file(indexFilename);
+    BOOST_REQUIRE( file.open(QIODevice::WriteOnly) );
+    file.write("not an index");
+    file.close();
+
+    MovieKeyframeIndex index;
+    BOOST_CHECK( !index.load(indexFilename, movieFilename, STREAM_INDEX) );
+    BOOST_CHECK( !index.load(QDir::tempPath() + "/dc_test_missing.idx", movieFilename, STREAM_INDEX) );
+
+    QFile::remove(indexFilename);
+    QFile::remove(movieFilename);
+}
+
+BOOST_AUTO_TEST_CASE( TestCacheFilename )
+{
+    const QString filename = MovieKeyframeIndex::getCacheFilename("/data/movie.mov");
+
+    BOOST_CHECK( filename.endsWith(".idx") );
+    BOOST_CHECK( filename == MovieKeyframeIndex::getCacheFilename("/data/movie.mov") );
+    BOOST_CHECK( filename != MovieKeyframeIndex::getCacheFilename("/data/other.mov") );
+}
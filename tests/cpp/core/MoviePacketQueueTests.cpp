@@ -0,0 +1,169 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE MoviePacketQueueTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "MoviePacketQueue.h"
+
+namespace
+{
+// One packet per 0.1 second with a keyframe every 5 packets
+std::vector<MoviePacket> createPackets(const int count, const uint32_t loop = 0)
+{
+    std::vector<MoviePacket> packets(count);
+    for( int i = 0; i < count; ++i )
+    {
+        packets[i].pts = i;
+        packets[i].dts = i;
+        packets[i].timestamp = i * 0.1;
+        packets[i].keyframe = (i % 5 == 0);
+        packets[i].loop = loop;
+        packets[i].data.resize(8, i);
+    }
+    return packets;
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestPushPop )
+{
+    MoviePacketQueue queue;
+
+    MoviePacket packet;
+    bool discontinuity = true;
+    BOOST_CHECK( !queue.pop(packet, discontinuity, 0) );
+
+    queue.push(createPackets(3));
+    BOOST_CHECK_EQUAL( queue.getSize(), 3 );
+
+    for( int i = 0; i < 3; ++i )
+    {
+        BOOST_REQUIRE( queue.pop(packet, discontinuity, 0) );
+        BOOST_CHECK_EQUAL( packet.pts, i );
+        BOOST_CHECK_EQUAL( packet.data.size(), 8 );
+        BOOST_CHECK( !discontinuity );
+    }
+    BOOST_CHECK_EQUAL( queue.getSize(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( TestTrimKeepsLastKeyframeBeforePosition )
+{
+    MoviePacketQueue queue;
+    queue.push(createPackets(12));
+
+    // Nothing to drop before the first keyframe after the position
+    queue.trim(0.3);
+    BOOST_CHECK_EQUAL( queue.getSize(), 12 );
+
+    queue.trim(0.75);
+    BOOST_CHECK_EQUAL( queue.getSize(), 7 );
+
+    MoviePacket packet;
+    bool discontinuity = false;
+    BOOST_REQUIRE( queue.pop(packet, discontinuity, 0) );
+    BOOST_CHECK_EQUAL( packet.pts, 5 );
+    BOOST_CHECK( packet.keyframe );
+    BOOST_CHECK( discontinuity );
+
+    BOOST_REQUIRE( queue.pop(packet, discontinuity, 0) );
+    BOOST_CHECK( !discontinuity );
+}
+
+BOOST_AUTO_TEST_CASE( TestNewLoopDropsPreviousPackets )
+{
+    MoviePacketQueue queue;
+    queue.push(createPackets(4, 0));
+    queue.push(createPackets(4, 1));
+
+    // Packets of the next loop are not trimmed with the current position
+    queue.trim(10.0);
+    BOOST_CHECK_EQUAL( queue.getSize(), 8 );
+
+    // The decoder does not get ahead of the current loop
+    MoviePacket packet;
+    bool discontinuity = false;
+    for( int i = 0; i < 4; ++i )
+        BOOST_REQUIRE( queue.pop(packet, discontinuity, 0) );
+    BOOST_CHECK( queue.isEndOfLoop() );
+    BOOST_CHECK( !queue.pop(packet, discontinuity, 0) );
+
+    queue.push(createPackets(2, 0));
+    queue.setLoop(1);
+    BOOST_CHECK_EQUAL( queue.getSize(), 4 );
+
+    BOOST_CHECK( !queue.isEndOfLoop() );
+
+    // Late packets of a previous loop are ignored
+    queue.push(createPackets(2, 0));
+    BOOST_CHECK_EQUAL( queue.getSize(), 4 );
+
+    BOOST_REQUIRE( queue.pop(packet, discontinuity, 0) );
+    BOOST_CHECK_EQUAL( packet.loop, 1 );
+    BOOST_CHECK_EQUAL( packet.pts, 0 );
+    BOOST_CHECK( discontinuity );
+}
+
+BOOST_AUTO_TEST_CASE( TestRewindToLastKeyframe )
+{
+    MoviePacketQueue queue;
+    queue.push(createPackets(12));
+
+    MoviePacket packet;
+    bool discontinuity = false;
+    for( int i = 0; i < 8; ++i )
+        BOOST_REQUIRE( queue.pop(packet, discontinuity, 0) );
+    BOOST_CHECK_EQUAL( queue.getSize(), 4 );
+
+    // The popped packets after the keyframe are kept
+    queue.trim(0.75);
+    BOOST_CHECK_EQUAL( queue.getSize(), 4 );
+
+    BOOST_REQUIRE( queue.pop(packet, discontinuity, 0) );
+    BOOST_CHECK_EQUAL( packet.pts, 8 );
+    BOOST_CHECK( !discontinuity );
+
+    queue.rewind();
+    BOOST_CHECK_EQUAL( queue.getSize(), 7 );
+
+    BOOST_REQUIRE( queue.pop(packet, discontinuity, 0) );
+    BOOST_CHECK_EQUAL( packet.pts, 5 );
+    BOOST_CHECK( packet.keyframe );
+    BOOST_CHECK( discontinuity );
+}
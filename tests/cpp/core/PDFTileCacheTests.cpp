@@ -0,0 +1,178 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE PDFTileCacheTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "PDFTileCache.h"
+
+#include <QMutexLocker>
+
+#include <boost/bind.hpp>
+
+namespace
+{
+const QSizeF pageSize(1000, 500); // Level 0 is 512x256 pixels
+
+struct Rasterizer
+{
+    Rasterizer() : renderCount(0) {}
+
+    QImage render(const QSize& size, const QRect& region)
+    {
+        QMutexLocker locker(&mutex);
+        ++renderCount;
+        lastSize = size;
+        lastRegion = region;
+
+        QImage image(region.size(), QImage::Format_ARGB32);
+        image.fill(Qt::white);
+        return image;
+    }
+
+    QMutex mutex;
+    int renderCount;
+    QSize lastSize;
+    QRect lastRegion;
+};
+}
+
+BOOST_AUTO_TEST_CASE( TestLevelsDoubleTheResolution )
+{
+    Rasterizer rasterizer;
+    TileLoadScheduler scheduler;
+    PDFTileCache cache(pageSize, boost::bind(&Rasterizer::render, &rasterizer, _1, _2), scheduler);
+
+    BOOST_CHECK( cache.getLevelSize(0) == QSize(512, 256) );
+    BOOST_CHECK( cache.getLevelSize(1) == QSize(1024, 512) );
+    BOOST_CHECK( cache.getLevelSize(3) == QSize(4096, 2048) );
+
+    BOOST_CHECK_EQUAL( cache.getLevel(QSizeF(100, 50)), 0 );
+    BOOST_CHECK_EQUAL( cache.getLevel(QSizeF(512, 256)), 0 );
+    BOOST_CHECK_EQUAL( cache.getLevel(QSizeF(600, 300)), 1 );
+    BOOST_CHECK_EQUAL( cache.getLevel(QSizeF(2048, 1024)), 2 );
+    BOOST_CHECK_EQUAL( cache.getLevel(QSizeF(1e9, 1e9)), cache.getLevelCount() - 1 );
+}
+
+BOOST_AUTO_TEST_CASE( TestTilesCoveringRegion )
+{
+    Rasterizer rasterizer;
+    TileLoadScheduler scheduler;
+    PDFTileCache cache(pageSize, boost::bind(&Rasterizer::render, &rasterizer, _1, _2), scheduler);
+
+    const std::vector<PDFTileId> all = cache.getTileIds(1, QRectF(0, 0, 1, 1));
+    BOOST_REQUIRE_EQUAL( all.size(), 2 );
+    BOOST_CHECK( all[0] == PDFTileId(1, 0, 0) );
+    BOOST_CHECK( all[1] == PDFTileId(1, 1, 0) );
+
+    const std::vector<PDFTileId> right = cache.getTileIds(1, QRectF(0.6, 0.2, 0.1, 0.1));
+    BOOST_REQUIRE_EQUAL( right.size(), 1 );
+    BOOST_CHECK( right[0] == PDFTileId(1, 1, 0) );
+    BOOST_CHECK( cache.getTileCoordinates(right[0]) == QRectF(0.5, 0, 0.5, 1) );
+
+    BOOST_CHECK_EQUAL( cache.getTileIds(2, QRectF(0.3, 0.4, 0.4, 0.2)).size(), 4 );
+    BOOST_CHECK( cache.getTileIds(2, QRectF(1.5, 0, 1, 1)).empty( ));
+}
+
+BOOST_AUTO_TEST_CASE( TestTileIsRasterizedOnce )
+{
+    Rasterizer rasterizer;
+    TileLoadScheduler scheduler;
+    PDFTileCache cache(pageSize, boost::bind(&Rasterizer::render, &rasterizer, _1, _2), scheduler);
+
+    PDFTilePtr tile = cache.request(PDFTileId(2, 1, 1), TilePriority(2, 1.), 1);
+    tile->waitForImage();
+
+    BOOST_REQUIRE( tile->isRendered( ));
+    BOOST_CHECK( tile->getImage().size() == QSize(512, 512) );
+    BOOST_CHECK( rasterizer.lastSize == QSize(2048, 1024) );
+    BOOST_CHECK( rasterizer.lastRegion == QRect(512, 512, 512, 512) );
+    BOOST_CHECK( tile->getCoordinates() == QRectF(0.25, 0.5, 0.25, 0.5) );
+
+    scheduler.nextFrame();
+    BOOST_CHECK( cache.request(PDFTileId(2, 1, 1), TilePriority(2, 1.), 2) == tile );
+    BOOST_CHECK_EQUAL( rasterizer.renderCount, 1 );
+    BOOST_CHECK_EQUAL( cache.getMemoryUsage(), size_t(512 * 512 * 4) );
+}
+
+BOOST_AUTO_TEST_CASE( TestCoarserTileIsUsedAsFallback )
+{
+    Rasterizer rasterizer;
+    TileLoadScheduler scheduler;
+    PDFTileCache cache(pageSize, boost::bind(&Rasterizer::render, &rasterizer, _1, _2), scheduler);
+
+    BOOST_CHECK( !cache.findCoarserTile(PDFTileId(2, 3, 1)) );
+
+    PDFTilePtr root = cache.request(PDFTileId(), TilePriority(0, 0.), 1);
+    root->waitForImage();
+
+    BOOST_CHECK( cache.findCoarserTile(PDFTileId(2, 3, 1)) == root );
+    BOOST_CHECK( !cache.findCoarserTile(PDFTileId()) );
+
+    PDFTilePtr parent = cache.request(PDFTileId(1, 1, 0), TilePriority(1, 1.), 1);
+    parent->waitForImage();
+
+    BOOST_CHECK( cache.findCoarserTile(PDFTileId(2, 3, 1)) == parent );
+    BOOST_CHECK( cache.findCoarserTile(PDFTileId(2, 1, 1)) == root );
+}
+
+BOOST_AUTO_TEST_CASE( TestTrimEvictsLeastRecentlyUsedTiles )
+{
+    Rasterizer rasterizer;
+    TileLoadScheduler scheduler;
+    PDFTileCache cache(pageSize, boost::bind(&Rasterizer::render, &rasterizer, _1, _2), scheduler);
+
+    cache.request(PDFTileId(1, 0, 0), TilePriority(1, 1.), 1);
+    cache.request(PDFTileId(1, 1, 0), TilePriority(1, 1.), 2);
+    cache.request(PDFTileId(), TilePriority(0, 0.), 3);
+    cache.request(PDFTileId(2, 0, 0), TilePriority(2, 1.), 3);
+    BOOST_CHECK_EQUAL( cache.getTileCount(), 4 );
+
+    cache.trim(3);
+    BOOST_CHECK_EQUAL( cache.getTileCount(), 3 );
+    BOOST_CHECK( !cache.find(PDFTileId(1, 0, 0)) );
+    BOOST_CHECK( cache.find(PDFTileId(1, 1, 0)) );
+
+    // Tiles of the current frame are kept
+    cache.trim(0);
+    BOOST_CHECK_EQUAL( cache.getTileCount(), 2 );
+    BOOST_CHECK( cache.find(PDFTileId()) );
+    BOOST_CHECK( cache.find(PDFTileId(2, 0, 0)) );
+}
@@ -0,0 +1,87 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE PixelBlendingTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "localstreamer/PixelBlending.h"
+
+#include <cstdlib>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE( TestBlendPixel )
+{
+    const QRgb red = qRgb(255, 0, 0);
+    const QRgb blue = qRgb(0, 0, 255);
+
+    BOOST_CHECK_EQUAL( blendPixel(red, blue, 256), red );
+    BOOST_CHECK_EQUAL( blendPixel(red, blue, 0), blue );
+    BOOST_CHECK_EQUAL( blendPixel(red, blue, 128), qRgb(127, 0, 127) );
+
+    // The result is opaque
+    BOOST_CHECK_EQUAL( blendPixel(qRgba(10, 20, 30, 0), qRgba(10, 20, 30, 0), 64),
+                       qRgb(10, 20, 30) );
+}
+
+BOOST_AUTO_TEST_CASE( TestBlendPixelsMatchesBlendPixel )
+{
+    std::srand(42);
+    const QRgb color = qRgb(12, 200, 97);
+
+    // All the vectorized paths and the remaining pixels are covered
+    for( int count = 0; count < 40; ++count )
+    {
+        for( int alpha = 0; alpha <= 256; alpha += 32 )
+        {
+            std::vector<QRgb> pixels(count);
+            for( int i = 0; i < count; ++i )
+                pixels[i] = qRgba(std::rand() % 256, std::rand() % 256,
+                                  std::rand() % 256, std::rand() % 256);
+
+            std::vector<QRgb> expected(pixels);
+            for( int i = 0; i < count; ++i )
+                expected[i] = blendPixel(expected[i], color, alpha);
+
+            blendPixels(pixels.data(), count, color, alpha);
+            BOOST_CHECK_EQUAL_COLLECTIONS( pixels.begin(), pixels.end(),
+                                           expected.begin(), expected.end( ));
+        }
+    }
+}
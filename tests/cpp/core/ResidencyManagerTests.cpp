@@ -0,0 +1,147 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE ResidencyManagerTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "ResidencyManager.h"
+
+namespace
+{
+const size_t HOST_BUDGET = 1000;
+const size_t GPU_BUDGET = 100;
+const ResidencyKey KEY_A(CONTENT_TYPE_TEXTURE, "a.png");
+const ResidencyKey KEY_B(CONTENT_TYPE_TEXTURE, "b.png");
+const ResidencyKey KEY_C(CONTENT_TYPE_MOVIE, "c.mov");
+}
+
+BOOST_AUTO_TEST_CASE( TestHitsAndMisses )
+{
+    ResidencyManager manager(HOST_BUDGET, GPU_BUDGET);
+
+    manager.touch(KEY_A, 0);
+    manager.touch(KEY_A, 0);
+    manager.touch(KEY_A, 1);
+    manager.touch(KEY_A, 1);
+    manager.touch(KEY_B, 1);
+    manager.update(KEY_C, 0, 0, 1);
+    manager.update(KEY_A, 0, 0, 1);
+
+    BOOST_CHECK_EQUAL( manager.getObjectCount(), 3 );
+    BOOST_CHECK_EQUAL( manager.getHitCount(), 1 );
+    BOOST_CHECK_EQUAL( manager.getMissCount(), 3 );
+}
+
+BOOST_AUTO_TEST_CASE( TestMemoryUsage )
+{
+    ResidencyManager manager(HOST_BUDGET, GPU_BUDGET);
+
+    manager.update(KEY_A, 100, 10, 0);
+    manager.update(KEY_B, 200, 20, 0);
+    BOOST_CHECK_EQUAL( manager.getHostMemoryUsage(), 300 );
+    BOOST_CHECK_EQUAL( manager.getGPUMemoryUsage(), 30 );
+
+    manager.update(KEY_A, 50, 40, 0);
+    BOOST_CHECK_EQUAL( manager.getHostMemoryUsage(), 250 );
+    BOOST_CHECK_EQUAL( manager.getGPUMemoryUsage(), 60 );
+
+    manager.remove(KEY_B);
+    BOOST_CHECK_EQUAL( manager.getHostMemoryUsage(), 50 );
+    BOOST_CHECK_EQUAL( manager.getGPUMemoryUsage(), 40 );
+
+    manager.clear();
+    BOOST_CHECK_EQUAL( manager.getObjectCount(), 0 );
+    BOOST_CHECK_EQUAL( manager.getHostMemoryUsage(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( TestNoEvictionWithinBudget )
+{
+    ResidencyManager manager(HOST_BUDGET, GPU_BUDGET);
+
+    manager.update(KEY_A, 500, 50, 0);
+    manager.update(KEY_B, 500, 50, 0);
+
+    BOOST_CHECK( manager.collect(10).empty() );
+    BOOST_CHECK_EQUAL( manager.getObjectCount(), 2 );
+}
+
+BOOST_AUTO_TEST_CASE( TestEvictLeastRecentlyUsedDownToLowWatermark )
+{
+    ResidencyManager manager(HOST_BUDGET, GPU_BUDGET, 0.5f);
+
+    manager.update(KEY_A, 400, 0, 2);
+    manager.update(KEY_B, 400, 0, 1);
+    manager.update(KEY_C, 400, 0, 3);
+
+    // 1200 > 1000: B then A must go to reach 500
+    const ResidencyKeys evicted = manager.collect(3);
+
+    BOOST_REQUIRE_EQUAL( evicted.size(), 2 );
+    BOOST_CHECK( evicted[0] == KEY_B );
+    BOOST_CHECK( evicted[1] == KEY_A );
+    BOOST_CHECK_EQUAL( manager.getHostMemoryUsage(), 400 );
+    BOOST_CHECK_EQUAL( manager.getEvictionCount(), 2 );
+}
+
+BOOST_AUTO_TEST_CASE( TestGPUBudgetTriggersEviction )
+{
+    ResidencyManager manager(HOST_BUDGET, GPU_BUDGET);
+
+    manager.update(KEY_A, 0, 60, 0);
+    manager.update(KEY_B, 0, 60, 1);
+
+    const ResidencyKeys evicted = manager.collect(2);
+
+    BOOST_REQUIRE_EQUAL( evicted.size(), 1 );
+    BOOST_CHECK( evicted[0] == KEY_A );
+    BOOST_CHECK_EQUAL( manager.getGPUMemoryUsage(), 60 );
+}
+
+BOOST_AUTO_TEST_CASE( TestObjectsInUseAreNotEvicted )
+{
+    ResidencyManager manager(HOST_BUDGET, GPU_BUDGET);
+
+    manager.update(KEY_A, 800, 0, 5);
+    manager.update(KEY_B, 800, 0, 5);
+
+    BOOST_CHECK( manager.collect(5).empty() );
+    BOOST_CHECK_EQUAL( manager.getObjectCount(), 2 );
+    BOOST_CHECK_EQUAL( manager.getHostMemoryUsage(), 1600 );
+}
@@ -0,0 +1,205 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE SharedTileCacheTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "SharedTileCache.h"
+
+#include <unistd.h>
+
+namespace
+{
+const int TILE_SIZE = 16;
+const size_t TILE_BYTES = TILE_SIZE * TILE_SIZE * 4;
+
+QString getSegmentName(const QString& test)
+{
+    return QString("/dctest-") + test + "-" + QString::number(getpid());
+}
+
+QImage createTile(const QRgb color)
+{
+    QImage image(TILE_SIZE, TILE_SIZE, QImage::Format_RGB32);
+    image.fill(color);
+    return image;
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestMakeKey )
+{
+    const SharedTileCache::Key key1 = SharedTileCache::makeKey("image.pyr#0-1-2");
+    const SharedTileCache::Key key2 = SharedTileCache::makeKey("image.pyr#0-1-2");
+    const SharedTileCache::Key key3 = SharedTileCache::makeKey("image.pyr#0-2-1");
+
+    BOOST_CHECK_EQUAL( key1.hash1, key2.hash1 );
+    BOOST_CHECK_EQUAL( key1.hash2, key2.hash2 );
+    BOOST_CHECK( key1.hash1 != key3.hash1 || key1.hash2 != key3.hash2 );
+    BOOST_CHECK( key1.hash1 != 0 );
+}
+
+BOOST_AUTO_TEST_CASE( TestPublishedTileIsSharedBetweenProcesses )
+{
+    // Two instances with the same name behave like two processes of a host
+    SharedTileCache first(getSegmentName("shared"), 4 * TILE_BYTES, TILE_SIZE);
+    SharedTileCache second(getSegmentName("shared"), 64 * TILE_BYTES, TILE_SIZE);
+    BOOST_REQUIRE( first.isOpen() );
+    BOOST_REQUIRE( second.isOpen() );
+
+    // The capacity of the existing segment is used
+    BOOST_CHECK_EQUAL( second.getSlotCount(), 4 );
+
+    const SharedTileCache::Key key = SharedTileCache::makeKey("tile");
+    QImage image;
+    SharedTileCache::Claim claim;
+
+    BOOST_REQUIRE_EQUAL( first.acquire(key, image, claim), SharedTileCache::CLAIMED );
+    BOOST_CHECK( claim.slot >= 0 );
+
+    // The tile is being decoded by the first process
+    SharedTileCache::Claim otherClaim;
+    BOOST_CHECK_EQUAL( second.acquire(key, image, otherClaim), SharedTileCache::PENDING );
+    BOOST_CHECK_EQUAL( otherClaim.slot, -1 );
+    BOOST_CHECK( image.isNull() );
+
+    const QImage tile = createTile(qRgb(255, 0, 0));
+    first.publish(claim, tile);
+    BOOST_CHECK_EQUAL( claim.slot, -1 );
+
+    BOOST_CHECK_EQUAL( second.acquire(key, image, otherClaim), SharedTileCache::HIT );
+    BOOST_CHECK( image == tile );
+}
+
+BOOST_AUTO_TEST_CASE( TestAbandonedClaimCanBeClaimedAgain )
+{
+    SharedTileCache first(getSegmentName("abandon"), 4 * TILE_BYTES, TILE_SIZE);
+    SharedTileCache second(getSegmentName("abandon"), 4 * TILE_BYTES, TILE_SIZE);
+
+    const SharedTileCache::Key key = SharedTileCache::makeKey("tile");
+    QImage image;
+    SharedTileCache::Claim claim;
+
+    BOOST_REQUIRE_EQUAL( first.acquire(key, image, claim), SharedTileCache::CLAIMED );
+    first.abandon(claim);
+    BOOST_CHECK_EQUAL( claim.slot, -1 );
+
+    BOOST_CHECK_EQUAL( second.acquire(key, image, claim), SharedTileCache::CLAIMED );
+    second.abandon(claim);
+}
+
+BOOST_AUTO_TEST_CASE( TestOutdatedClaimIsNotPublished )
+{
+    SharedTileCache first(getSegmentName("outdated"), 4 * TILE_BYTES, TILE_SIZE);
+    SharedTileCache second(getSegmentName("outdated"), 4 * TILE_BYTES, TILE_SIZE);
+
+    const SharedTileCache::Key key = SharedTileCache::makeKey("tile");
+    QImage image;
+    SharedTileCache::Claim claim;
+
+    BOOST_REQUIRE_EQUAL( first.acquire(key, image, claim), SharedTileCache::CLAIMED );
+    const SharedTileCache::Claim outdatedClaim = claim;
+    first.abandon(claim);
+
+    SharedTileCache::Claim otherClaim;
+    BOOST_REQUIRE_EQUAL( second.acquire(key, image, otherClaim), SharedTileCache::CLAIMED );
+    BOOST_REQUIRE_EQUAL( otherClaim.slot, outdatedClaim.slot );
+
+    // The slot now belongs to the second process
+    claim = outdatedClaim;
+    first.publish(claim, createTile(qRgb(1, 1, 1)));
+    BOOST_CHECK_EQUAL( claim.slot, -1 );
+    BOOST_CHECK( !first.find(key, image) );
+
+    second.publish(otherClaim, createTile(qRgb(2, 2, 2)));
+    BOOST_CHECK( first.find(key, image) );
+    BOOST_CHECK( image == createTile(qRgb(2, 2, 2)) );
+}
+
+BOOST_AUTO_TEST_CASE( TestLeastRecentlyUsedTileIsEvicted )
+{
+    SharedTileCache cache(getSegmentName("evict"), 2 * TILE_BYTES, TILE_SIZE);
+    BOOST_REQUIRE_EQUAL( cache.getSlotCount(), 2 );
+
+    const SharedTileCache::Key key1 = SharedTileCache::makeKey("tile1");
+    const SharedTileCache::Key key2 = SharedTileCache::makeKey("tile2");
+    const SharedTileCache::Key key3 = SharedTileCache::makeKey("tile3");
+    QImage image;
+    SharedTileCache::Claim claim;
+
+    BOOST_REQUIRE_EQUAL( cache.acquire(key1, image, claim), SharedTileCache::CLAIMED );
+    cache.publish(claim, createTile(qRgb(1, 1, 1)));
+    BOOST_REQUIRE_EQUAL( cache.acquire(key2, image, claim), SharedTileCache::CLAIMED );
+    cache.publish(claim, createTile(qRgb(2, 2, 2)));
+
+    // Use tile1 so that tile2 is the least recently used
+    BOOST_CHECK( cache.find(key1, image) );
+
+    BOOST_REQUIRE_EQUAL( cache.acquire(key3, image, claim), SharedTileCache::CLAIMED );
+    cache.publish(claim, createTile(qRgb(3, 3, 3)));
+
+    BOOST_CHECK( cache.find(key1, image) );
+    BOOST_CHECK( !cache.find(key2, image) );
+    BOOST_CHECK( cache.find(key3, image) );
+    BOOST_CHECK( image == createTile(qRgb(3, 3, 3)) );
+}
+
+BOOST_AUTO_TEST_CASE( TestOversizedTileIsNotPublished )
+{
+    SharedTileCache cache(getSegmentName("oversized"), 4 * TILE_BYTES, TILE_SIZE);
+
+    const SharedTileCache::Key key = SharedTileCache::makeKey("tile");
+    QImage image;
+    SharedTileCache::Claim claim;
+
+    BOOST_REQUIRE_EQUAL( cache.acquire(key, image, claim), SharedTileCache::CLAIMED );
+    cache.publish(claim, QImage(2 * TILE_SIZE, TILE_SIZE, QImage::Format_RGB32));
+    BOOST_CHECK_EQUAL( claim.slot, -1 );
+    BOOST_CHECK( !cache.find(key, image) );
+}
+
+BOOST_AUTO_TEST_CASE( TestSegmentIsRemovedByLastProcess )
+{
+    {
+        SharedTileCache cache(getSegmentName("unlink"), 4 * TILE_BYTES, TILE_SIZE);
+        BOOST_REQUIRE_EQUAL( cache.getSlotCount(), 4 );
+    }
+    SharedTileCache cache(getSegmentName("unlink"), 8 * TILE_BYTES, TILE_SIZE);
+    BOOST_CHECK_EQUAL( cache.getSlotCount(), 8 );
+}
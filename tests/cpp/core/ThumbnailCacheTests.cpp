@@ -0,0 +1,168 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE ThumbnailCacheTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "thumbnail/ThumbnailCache.h"
+
+#include <QDir>
+#include <QFile>
+
+#define MEMORY_CAPACITY (1024*1024)
+#define DISK_CAPACITY (1024*1024)
+
+namespace
+{
+const QString sourceFilename = QDir::tempPath() + "/dc_test_thumbnail_source.txt";
+const QString cacheDirectory = QDir::tempPath() + "/dc_test_thumbnails";
+const QSize thumbnailSize(64, 32);
+
+void writeSourceFile(const QByteArray& data)
+{
+    QFile file(sourceFilename);
+    BOOST_REQUIRE( file.open(QIODevice::WriteOnly) );
+    file.write(data);
+}
+
+void clearCacheDirectory()
+{
+    QDir dir(cacheDirectory);
+    foreach(const QString& filename, dir.entryList(QDir::Files))
+        dir.remove(filename);
+}
+
+QImage createThumbnail()
+{
+    QImage image(thumbnailSize, QImage::Format_RGB32);
+    image.fill(qRgb(10, 20, 30));
+    image.setText("source", sourceFilename);
+    return image;
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestMakeKey )
+{
+    BOOST_CHECK( ThumbnailCache::makeKey(QDir::tempPath() + "/dc_no_such_file",
+                                         thumbnailSize).isEmpty( ));
+
+    writeSourceFile(QByteArray(16, 'a'));
+    const QString key = ThumbnailCache::makeKey(sourceFilename, thumbnailSize);
+    BOOST_CHECK( !key.isEmpty( ));
+    BOOST_CHECK( key == ThumbnailCache::makeKey(sourceFilename, thumbnailSize));
+    BOOST_CHECK( key != ThumbnailCache::makeKey(sourceFilename, QSize(32, 64)));
+
+    // A modified file gets new keys
+    writeSourceFile(QByteArray(32, 'b'));
+    BOOST_CHECK( key != ThumbnailCache::makeKey(sourceFilename, thumbnailSize));
+}
+
+BOOST_AUTO_TEST_CASE( TestFindInsertedThumbnail )
+{
+    clearCacheDirectory();
+    writeSourceFile(QByteArray(16, 'a'));
+
+    QImage image;
+    {
+        ThumbnailCache cache(cacheDirectory, MEMORY_CAPACITY, DISK_CAPACITY);
+        BOOST_CHECK( !cache.find(sourceFilename, thumbnailSize, image));
+
+        cache.insert(sourceFilename, thumbnailSize, createThumbnail());
+        BOOST_REQUIRE( cache.find(sourceFilename, thumbnailSize, image));
+        BOOST_CHECK( image.size() == thumbnailSize );
+        BOOST_CHECK( !cache.find(sourceFilename, QSize(32, 64), image));
+    }
+
+    // The thumbnail and its metadata are read back from the disk
+    ThumbnailCache cache(cacheDirectory, MEMORY_CAPACITY, DISK_CAPACITY);
+    BOOST_REQUIRE( cache.find(sourceFilename, thumbnailSize, image));
+    BOOST_CHECK( image.size() == thumbnailSize );
+    BOOST_CHECK_EQUAL( image.pixel(0, 0), qRgb(10, 20, 30));
+    BOOST_CHECK( image.text("source") == sourceFilename );
+}
+
+BOOST_AUTO_TEST_CASE( TestModifiedFileIsNotFound )
+{
+    clearCacheDirectory();
+    writeSourceFile(QByteArray(16, 'a'));
+
+    ThumbnailCache cache(cacheDirectory, MEMORY_CAPACITY, DISK_CAPACITY);
+    cache.insert(sourceFilename, thumbnailSize, createThumbnail());
+
+    writeSourceFile(QByteArray(32, 'b'));
+
+    QImage image;
+    BOOST_CHECK( !cache.find(sourceFilename, thumbnailSize, image));
+}
+
+BOOST_AUTO_TEST_CASE( TestTrimDiskCache )
+{
+    clearCacheDirectory();
+    writeSourceFile(QByteArray(16, 'a'));
+
+    {
+        ThumbnailCache cache(cacheDirectory, MEMORY_CAPACITY, DISK_CAPACITY);
+        cache.insert(sourceFilename, thumbnailSize, createThumbnail());
+        BOOST_CHECK_EQUAL( QDir(cacheDirectory).entryList(QDir::Files).size(), 1 );
+    }
+
+    {
+        ThumbnailCache cache(cacheDirectory, MEMORY_CAPACITY, 0);
+        cache.trimDiskCache();
+        BOOST_CHECK( QDir(cacheDirectory).entryList(QDir::Files).isEmpty( ));
+    }
+
+    ThumbnailCache cache(cacheDirectory, MEMORY_CAPACITY, DISK_CAPACITY);
+    QImage image;
+    BOOST_CHECK( !cache.find(sourceFilename, thumbnailSize, image));
+}
+
+BOOST_AUTO_TEST_CASE( TestInsertTrimsDiskCache )
+{
+    clearCacheDirectory();
+    writeSourceFile(QByteArray(16, 'a'));
+
+    {
+        ThumbnailCache cache(cacheDirectory, MEMORY_CAPACITY, 0);
+        cache.insert(sourceFilename, thumbnailSize, createThumbnail());
+        // The destructor waits for the trimming started by the insertion
+    }
+    BOOST_CHECK( QDir(cacheDirectory).entryList(QDir::Files).isEmpty( ));
+}
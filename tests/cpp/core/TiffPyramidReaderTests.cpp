@@ -0,0 +1,194 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE TiffPyramidReaderTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "MinimalGlobalQtApp.h"
+
+#include "TiffPyramidReader.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+
+#include <vector>
+
+#define TEST_IMAGE_WIDTH  1000
+#define TEST_IMAGE_HEIGHT 600
+#define TEST_TILE_SIZE    256
+
+BOOST_GLOBAL_FIXTURE( MinimalGlobalQtApp );
+
+namespace
+{
+const QString tiffFilename = QDir::tempPath() + "/dc_test_pyramid.tif";
+
+// The left half of the image is red, the right half is blue
+QRgb getTestColor(const int x, const int width)
+{
+    return x < width / 2 ? qRgb(255, 0, 0) : qRgb(0, 0, 255);
+}
+
+bool writeTiledDirectory(TIFF* tiff, const int width, const int height, const bool reduced)
+{
+    TIFFSetField(tiff, TIFFTAG_SUBFILETYPE, reduced ? FILETYPE_REDUCEDIMAGE : 0);
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, width);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, height);
+    TIFFSetField(tiff, TIFFTAG_TILEWIDTH, TEST_TILE_SIZE);
+    TIFFSetField(tiff, TIFFTAG_TILELENGTH, TEST_TILE_SIZE);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+
+    std::vector<unsigned char> tile(TIFFTileSize(tiff));
+    for(int tileY = 0; tileY < height; tileY += TEST_TILE_SIZE)
+    {
+        for(int tileX = 0; tileX < width; tileX += TEST_TILE_SIZE)
+        {
+            for(int y = 0; y < TEST_TILE_SIZE; ++y)
+            {
+                for(int x = 0; x < TEST_TILE_SIZE; ++x)
+                {
+                    const QRgb color = getTestColor(tileX + x, width);
+                    unsigned char* pixel = &tile[3 * (y * TEST_TILE_SIZE + x)];
+                    pixel[0] = qRed(color);
+                    pixel[1] = qGreen(color);
+                    pixel[2] = qBlue(color);
+                }
+            }
+            if(TIFFWriteTile(tiff, &tile[0], tileX, tileY, 0, 0) < 0)
+                return false;
+        }
+    }
+    return TIFFWriteDirectory(tiff);
+}
+
+bool writeTestTiff(const QString& filename)
+{
+    TIFF* tiff = TIFFOpen(filename.toLocal8Bit().constData(), "w");
+    if(!tiff)
+        return false;
+
+    const bool success =
+            writeTiledDirectory(tiff, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, false) &&
+            writeTiledDirectory(tiff, TEST_IMAGE_WIDTH / 4, TEST_IMAGE_HEIGHT / 4, true) &&
+            writeTiledDirectory(tiff, TEST_IMAGE_WIDTH / 2, TEST_IMAGE_HEIGHT / 2, true);
+    TIFFClose(tiff);
+    return success;
+}
+
+bool isColorClose(const QRgb color1, const QRgb color2)
+{
+    return qAbs(qRed(color1) - qRed(color2)) < 8 &&
+           qAbs(qGreen(color1) - qGreen(color2)) < 8 &&
+           qAbs(qBlue(color1) - qBlue(color2)) < 8;
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestTiffExtension )
+{
+    BOOST_CHECK( TiffPyramidReader::hasTiffExtension( "image.tif" ));
+    BOOST_CHECK( TiffPyramidReader::hasTiffExtension( "/data/image.TIFF" ));
+    BOOST_CHECK( !TiffPyramidReader::hasTiffExtension( "image.png" ));
+    BOOST_CHECK( !TiffPyramidReader::hasTiffExtension( "image.pyr" ));
+}
+
+BOOST_AUTO_TEST_CASE( TestOpenTiledTiff )
+{
+    BOOST_REQUIRE( writeTestTiff( tiffFilename ));
+
+    TiffPyramidReader reader;
+    BOOST_REQUIRE( reader.open( tiffFilename ));
+    BOOST_CHECK_EQUAL( reader.getImageSize().width(), TEST_IMAGE_WIDTH );
+    BOOST_CHECK_EQUAL( reader.getImageSize().height(), TEST_IMAGE_HEIGHT );
+    BOOST_CHECK_EQUAL( reader.getLevelCount(), 3 );
+
+    QFile::remove( tiffFilename );
+}
+
+BOOST_AUTO_TEST_CASE( TestOpenInvalidFile )
+{
+    TiffPyramidReader reader;
+    BOOST_CHECK( !reader.open( QDir::tempPath() + "/dc_test_missing.tif" ));
+    BOOST_CHECK_EQUAL( reader.getLevelCount(), 0 );
+    BOOST_CHECK( reader.readRegion( QRect( 0, 0, 10, 10 ), QSize( 10, 10 )).isNull( ));
+}
+
+BOOST_AUTO_TEST_CASE( TestReadRegion )
+{
+    BOOST_REQUIRE( writeTestTiff( tiffFilename ));
+
+    TiffPyramidReader reader;
+    BOOST_REQUIRE( reader.open( tiffFilename ));
+
+    // The whole image from an overview level
+    const QRect fullImage( 0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT );
+    const QImage thumbnail = reader.readRegion( fullImage, QSize( 200, 200 ));
+    BOOST_REQUIRE( !thumbnail.isNull( ));
+    BOOST_CHECK_EQUAL( thumbnail.width(), 200 );
+    BOOST_CHECK_EQUAL( thumbnail.height(), 120 );
+    BOOST_CHECK( isColorClose( thumbnail.pixel( 10, 60 ), qRgb( 255, 0, 0 )));
+    BOOST_CHECK( isColorClose( thumbnail.pixel( 190, 60 ), qRgb( 0, 0, 255 )));
+
+    // A region spanning several full resolution tiles
+    const QRect region( 400, 200, 200, 300 );
+    const QImage image = reader.readRegion( region, region.size( ));
+    BOOST_REQUIRE( !image.isNull( ));
+    BOOST_CHECK_EQUAL( image.size().width(), region.width( ));
+    BOOST_CHECK_EQUAL( image.size().height(), region.height( ));
+    BOOST_CHECK( isColorClose( image.pixel( 10, 150 ), qRgb( 255, 0, 0 )));
+    BOOST_CHECK( isColorClose( image.pixel( 190, 150 ), qRgb( 0, 0, 255 )));
+
+    // Much smaller than the coarsest level, averaged while decoding
+    const QImage icon = reader.readRegion( fullImage, QSize( 20, 20 ));
+    BOOST_REQUIRE( !icon.isNull( ));
+    BOOST_CHECK_EQUAL( icon.width(), 20 );
+    BOOST_CHECK_EQUAL( icon.height(), 12 );
+    BOOST_CHECK( isColorClose( icon.pixel( 2, 6 ), qRgb( 255, 0, 0 )));
+    BOOST_CHECK( isColorClose( icon.pixel( 17, 6 ), qRgb( 0, 0, 255 )));
+
+    // Regions outside of the image are clipped
+    BOOST_CHECK( reader.readRegion( QRect( 2000, 0, 10, 10 ), QSize( 10, 10 )).isNull( ));
+
+    QFile::remove( tiffFilename );
+}
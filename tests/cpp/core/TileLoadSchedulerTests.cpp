@@ -0,0 +1,245 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE TileLoadSchedulerTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "TileLoadScheduler.h"
+
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QStringList>
+
+namespace
+{
+struct Recorder
+{
+    QStringList readOrder;
+    QMutex mutex;
+    QSemaphore decoded;
+};
+
+class RecordingTile : public TileSource
+{
+public:
+    RecordingTile(const QString& name, Recorder& recorder, QSemaphore* blocker = 0)
+        : name_(name)
+        , recorder_(recorder)
+        , blocker_(blocker)
+    {}
+
+    QByteArray readTileData() override
+    {
+        if(blocker_)
+            blocker_->acquire();
+
+        QMutexLocker locker(&recorder_.mutex);
+        recorder_.readOrder.append(name_);
+        return name_.toAscii();
+    }
+
+    void decodeTileData(const QByteArray& data) override
+    {
+        decoded_ = QString(data);
+        recorder_.decoded.release();
+    }
+
+    QString decoded_;
+
+private:
+    QString name_;
+    Recorder& recorder_;
+    QSemaphore* blocker_;
+};
+typedef boost::shared_ptr<RecordingTile> RecordingTilePtr;
+
+class PostponedTile : public RecordingTile
+{
+public:
+    PostponedTile(const QString& name, Recorder& recorder, const int postponeCount)
+        : RecordingTile(name, recorder)
+        , postponeCount_(postponeCount)
+    {}
+
+    bool prepareTileRead() override
+    {
+        const bool ready = postponeCount_ == 0;
+        if(!ready)
+            --postponeCount_;
+        prepared.release();
+        return ready;
+    }
+
+    QSemaphore prepared;
+
+private:
+    int postponeCount_;
+};
+typedef boost::shared_ptr<PostponedTile> PostponedTilePtr;
+}
+
+BOOST_AUTO_TEST_CASE( TestWaitForFinishedLoadsTile )
+{
+    Recorder recorder;
+    RecordingTilePtr tile(new RecordingTile("tile", recorder));
+
+    TileLoadScheduler scheduler;
+    TileLoadRequestPtr request = scheduler.request(tile, TilePriority(0, 1.));
+    request->waitForFinished();
+
+    BOOST_CHECK( request->isFinished( ));
+    BOOST_CHECK( !request->isCancelled( ));
+    BOOST_CHECK_EQUAL( tile->decoded_.toStdString(), "tile" );
+    BOOST_CHECK_EQUAL( recorder.readOrder.size(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE( TestPriorityAndCancellation )
+{
+    Recorder recorder;
+    QSemaphore blocker;
+
+    // One I/O thread dispatches at most two requests, keep them busy
+    TileLoadScheduler scheduler(1, 1);
+    RecordingTilePtr busy1(new RecordingTile("busy1", recorder, &blocker));
+    RecordingTilePtr busy2(new RecordingTile("busy2", recorder, &blocker));
+    scheduler.request(busy1, TilePriority(0, 1.));
+    scheduler.request(busy2, TilePriority(0, 1.));
+
+    RecordingTilePtr fine(new RecordingTile("fine", recorder));
+    RecordingTilePtr coarse(new RecordingTile("coarse", recorder));
+    RecordingTilePtr small(new RecordingTile("small", recorder));
+    RecordingTilePtr large(new RecordingTile("large", recorder));
+    RecordingTilePtr hidden(new RecordingTile("hidden", recorder));
+
+    TileLoadRequestPtr fineRequest = scheduler.request(fine, TilePriority(2, 100.));
+    TileLoadRequestPtr coarseRequest = scheduler.request(coarse, TilePriority(0, 1.));
+    TileLoadRequestPtr smallRequest = scheduler.request(small, TilePriority(1, 10.));
+    TileLoadRequestPtr largeRequest = scheduler.request(large, TilePriority(1, 100.));
+    TileLoadRequestPtr hiddenRequest = scheduler.request(hidden, TilePriority(0, 1000.));
+    BOOST_CHECK_EQUAL( scheduler.getQueuedCount(), 5 );
+
+    // The hidden tile is not renewed in the next frame
+    scheduler.nextFrame();
+    scheduler.renew(fineRequest, TilePriority(2, 100.));
+    scheduler.renew(coarseRequest, TilePriority(0, 1.));
+    scheduler.renew(smallRequest, TilePriority(1, 10.));
+    scheduler.renew(largeRequest, TilePriority(1, 100.));
+    scheduler.nextFrame();
+
+    BOOST_CHECK( hiddenRequest->isCancelled( ));
+    BOOST_CHECK_EQUAL( scheduler.getQueuedCount(), 4 );
+
+    // Do not use waitForFinished(), which would load queued tiles in this thread
+    blocker.release(2);
+    recorder.decoded.acquire(6);
+
+    QStringList expectedOrder;
+    expectedOrder << "busy1" << "busy2" << "coarse" << "large" << "small" << "fine";
+    BOOST_CHECK_EQUAL( recorder.readOrder.join(",").toStdString(),
+                       expectedOrder.join(",").toStdString() );
+    BOOST_CHECK( hidden->decoded_.isEmpty( ));
+}
+
+BOOST_AUTO_TEST_CASE( TestPrefetchPriorityAndStatistics )
+{
+    Recorder recorder;
+    QSemaphore blocker;
+
+    TileLoadScheduler scheduler(1, 1);
+    RecordingTilePtr busy1(new RecordingTile("busy1", recorder, &blocker));
+    RecordingTilePtr busy2(new RecordingTile("busy2", recorder, &blocker));
+    scheduler.request(busy1, TilePriority(0, 1.));
+    scheduler.request(busy2, TilePriority(0, 1.));
+
+    RecordingTilePtr prefetched(new RecordingTile("prefetched", recorder));
+    RecordingTilePtr unused(new RecordingTile("unused", recorder));
+    RecordingTilePtr visible(new RecordingTile("visible", recorder));
+
+    TileLoadRequestPtr prefetchedRequest = scheduler.request(prefetched, TilePriority(0, 100., true));
+    TileLoadRequestPtr unusedRequest = scheduler.request(unused, TilePriority(0, 100., true));
+    TileLoadRequestPtr visibleRequest = scheduler.request(visible, TilePriority(3, 1.));
+
+    // The prefetched tile becomes visible, and is still predicted
+    scheduler.nextFrame();
+    scheduler.renew(visibleRequest, TilePriority(3, 1.));
+    scheduler.renew(prefetchedRequest, TilePriority(0, 100.));
+    scheduler.renew(prefetchedRequest, TilePriority(0, 100., true));
+    scheduler.nextFrame();
+
+    BOOST_CHECK( unusedRequest->isCancelled( ));
+
+    blocker.release(2);
+    recorder.decoded.acquire(4);
+
+    QStringList expectedOrder;
+    expectedOrder << "busy1" << "busy2" << "prefetched" << "visible";
+    BOOST_CHECK_EQUAL( recorder.readOrder.join(",").toStdString(),
+                       expectedOrder.join(",").toStdString() );
+
+    const TilePrefetchStatistics statistics = scheduler.getPrefetchStatistics();
+    BOOST_CHECK_EQUAL( statistics.requested, 2 );
+    BOOST_CHECK_EQUAL( statistics.used, 1 );
+    BOOST_CHECK_EQUAL( statistics.usedReady, 0 );
+    BOOST_CHECK_EQUAL( statistics.cancelled, 1 );
+    BOOST_CHECK_EQUAL( statistics.getHitRate(), 0. );
+}
+
+BOOST_AUTO_TEST_CASE( TestPostponedTileIsReadInNextFrame )
+{
+    Recorder recorder;
+    PostponedTilePtr tile(new PostponedTile("tile", recorder, 1));
+
+    TileLoadScheduler scheduler(1, 1);
+    TileLoadRequestPtr request = scheduler.request(tile, TilePriority(0, 1.));
+
+    // The request is queued again without reading the tile
+    tile->prepared.acquire();
+    while(scheduler.getQueuedCount() == 0)
+        QThread::yieldCurrentThread();
+    BOOST_CHECK( !request->isFinished( ));
+    BOOST_CHECK_EQUAL( tile->prepared.available(), 0 );
+
+    scheduler.renew(request, TilePriority(0, 1.));
+    scheduler.nextFrame();
+    recorder.decoded.acquire();
+
+    BOOST_CHECK_EQUAL( tile->decoded_.toStdString(), "tile" );
+    BOOST_CHECK_EQUAL( recorder.readOrder.size(), 1 );
+}
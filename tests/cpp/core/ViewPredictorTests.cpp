@@ -0,0 +1,134 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE ViewPredictorTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "ViewPredictor.h"
+
+namespace
+{
+const double EPSILON = 1e-9;
+
+QRectF makeView(const double centerX, const double centerY, const double zoom)
+{
+    return QRectF(centerX - 0.5/zoom, centerY - 0.5/zoom, 1./zoom, 1./zoom);
+}
+}
+
+BOOST_AUTO_TEST_CASE( TestNoPredictionWithoutMotion )
+{
+    ViewPredictor predictor;
+    QRectF view;
+
+    predictor.addView(0, makeView(0.5, 0.5, 1.));
+    predictor.addView(1, makeView(0.5, 0.5, 1.));
+    BOOST_CHECK( !predictor.predict(view));
+
+    predictor.addView(2, makeView(0.5, 0.5, 1.));
+    BOOST_CHECK( !predictor.predict(view));
+}
+
+BOOST_AUTO_TEST_CASE( TestPredictPan )
+{
+    ViewPredictor predictor(5);
+    QRectF view;
+
+    predictor.addView(10, makeView(0.50, 0.5, 2.));
+    predictor.addView(11, makeView(0.51, 0.5, 2.));
+    predictor.addView(12, makeView(0.52, 0.5, 2.));
+
+    // Several views in the same frame (multiple GLWindows) are ignored
+    predictor.addView(12, makeView(0.9, 0.9, 4.));
+
+    BOOST_REQUIRE( predictor.predict(view));
+    BOOST_CHECK_CLOSE( view.center().x(), 0.57, 1e-6 );
+    BOOST_CHECK_CLOSE( view.center().y(), 0.5, 1e-6 );
+    BOOST_CHECK_CLOSE( view.width(), 0.5, 1e-6 );
+    BOOST_CHECK_EQUAL( predictor.getLastFrameIndex(), 12 );
+}
+
+BOOST_AUTO_TEST_CASE( TestPredictZoom )
+{
+    ViewPredictor predictor(2);
+    QRectF view;
+
+    predictor.addView(0, makeView(0.5, 0.5, 1.));
+    predictor.addView(1, makeView(0.5, 0.5, 2.));
+    predictor.addView(2, makeView(0.5, 0.5, 4.));
+
+    BOOST_REQUIRE( predictor.predict(view));
+    BOOST_CHECK_CLOSE( view.width(), 1./16., 1e-6 );
+    BOOST_CHECK_CLOSE( view.height(), 1./16., 1e-6 );
+    BOOST_CHECK_SMALL( view.center().x() - 0.5, EPSILON );
+}
+
+BOOST_AUTO_TEST_CASE( TestNoPredictionWhenDirectionChanges )
+{
+    ViewPredictor predictor;
+    QRectF view;
+
+    predictor.addView(0, makeView(0.50, 0.5, 2.));
+    predictor.addView(1, makeView(0.51, 0.5, 2.));
+    predictor.addView(2, makeView(0.52, 0.5, 2.));
+    BOOST_CHECK( predictor.predict(view));
+
+    predictor.addView(3, makeView(0.51, 0.5, 2.));
+    BOOST_CHECK( !predictor.predict(view));
+
+    predictor.addView(4, makeView(0.50, 0.5, 2.));
+    BOOST_CHECK( predictor.predict(view));
+    BOOST_CHECK( view.center().x() < 0.5 );
+}
+
+BOOST_AUTO_TEST_CASE( TestHistoryRestartsAfterSkippedFrame )
+{
+    ViewPredictor predictor;
+    QRectF view;
+
+    predictor.addView(0, makeView(0.50, 0.5, 2.));
+    predictor.addView(1, makeView(0.51, 0.5, 2.));
+    predictor.addView(3, makeView(0.52, 0.5, 2.));
+    BOOST_CHECK( !predictor.predict(view));
+
+    predictor.addView(4, makeView(0.53, 0.5, 2.));
+    predictor.addView(5, makeView(0.54, 0.5, 2.));
+    BOOST_CHECK( predictor.predict(view));
+}
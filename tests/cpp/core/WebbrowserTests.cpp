@@ -47,6 +47,7 @@ namespace ut = boost::unit_test;
 #include <QWebFrame>
 #include <QWebPage>
 #include <QWebView>
+#include <QTimer>
 
 #include "GlobalQtApp.h"
 
@@ -55,6 +56,15 @@ namespace ut = boost::unit_test;
 
 BOOST_GLOBAL_FIXTURE( GlobalQtApp );
 
+namespace
+{
+void processEventsFor( const int ms )
+{
+    QTimer::singleShot( ms, QApplication::instance(), SLOT(quit()));
+    QApplication::instance()->exec();
+}
+}
+
 BOOST_AUTO_TEST_CASE( test_webgl_support )
 {
     if( !hasGLXDisplay( ))
@@ -265,3 +275,32 @@ BOOST_AUTO_TEST_CASE( test_localstorage )
 
     delete streamer;
 }
+
+BOOST_AUTO_TEST_CASE( test_images_are_sent_only_when_page_changes )
+{
+    if( !hasGLXDisplay( ))
+        return;
+
+    WebkitPixelStreamer* streamer = new WebkitPixelStreamer( QSize(640, 480), EMPTY_PAGE_URL );
+    int frames = 0;
+    QObject::connect( streamer, &PixelStreamer::imageUpdated,
+                      [&frames]( QImage ) { ++frames; } );
+    QObject::connect( streamer->getView(), SIGNAL(loadFinished(bool)),
+                      QApplication::instance(), SLOT(quit()));
+    QApplication::instance()->exec();
+
+    processEventsFor( 200 );
+    BOOST_CHECK( frames > 0 );
+
+    // An idle page does not generate any image
+    frames = 0;
+    processEventsFor( 200 );
+    BOOST_CHECK_EQUAL( frames, 0 );
+
+    QWebFrame* frame = streamer->getView()->page()->mainFrame();
+    frame->evaluateJavaScript( "document.body.style.background = 'red';" );
+    processEventsFor( 200 );
+    BOOST_CHECK( frames > 0 );
+
+    delete streamer;
+}
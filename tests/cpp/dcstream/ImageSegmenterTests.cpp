@@ -313,3 +313,68 @@ BOOST_AUTO_TEST_CASE( testImageSegmenterNonUniformSegmentationData )
                                        dataOut, dataOut+segment.imageData.size() );
     }
 }
+
+
+BOOST_AUTO_TEST_CASE( testImageSegmenterRawBgraIsConvertedToRgba )
+{
+    char dataIn[] =
+    {
+        1,2,3,4, 5,6,7,8,
+        9,10,11,12, 13,14,15,16
+    };
+    char dataExpected[] =
+    {
+        3,2,1,4, 7,6,5,8,
+        11,10,9,12, 15,14,13,16
+    };
+
+    dc::ImageWrapper imageWrapper(dataIn, 2, 2, dc::BGRA);
+    imageWrapper.compressionPolicy = dc::COMPRESSION_OFF;
+
+    dc::ImageSegmenter segmenter;
+    dc::PixelStreamSegments segments;
+    const dc::ImageSegmenter::Handler appendFunc =
+        boost::bind( &append, boost::ref( segments ), _1 );
+
+    segmenter.generate( imageWrapper, appendFunc );
+    BOOST_REQUIRE_EQUAL( segments.size(), 1 );
+
+    const char* dataOut = segments.front().imageData.constData();
+    BOOST_CHECK_EQUAL_COLLECTIONS( dataExpected, dataExpected+sizeof(dataExpected),
+                                   dataOut, dataOut+segments.front().imageData.size() );
+}
+
+
+BOOST_AUTO_TEST_CASE( testImageSegmenterCopyRawMatchesGenerate )
+{
+    char dataIn[4*8*3];
+    for( size_t i = 0; i < sizeof(dataIn); ++i )
+        dataIn[i] = char(i);
+
+    dc::ImageWrapper imageWrapper(dataIn, 4, 8, dc::RGB);
+    imageWrapper.compressionPolicy = dc::COMPRESSION_OFF;
+
+    dc::ImageSegmenter segmenter;
+    segmenter.setNominalSegmentDimensions(3,5);
+
+    dc::PixelStreamSegments segments;
+    const dc::ImageSegmenter::Handler appendFunc =
+        boost::bind( &append, boost::ref( segments ), _1 );
+    segmenter.generate( imageWrapper, appendFunc );
+
+    unsigned char buffer[sizeof(dataIn)];
+    const dc::SegmentParameters parameters = segmenter.copyRaw( imageWrapper, buffer );
+    BOOST_REQUIRE_EQUAL( parameters.size(), segments.size( ));
+
+    const char* dataOut = (const char*)buffer;
+    for( size_t i = 0; i < segments.size(); ++i )
+    {
+        BOOST_CHECK_EQUAL( parameters[i].x, segments[i].parameters.x );
+        BOOST_CHECK_EQUAL( parameters[i].y, segments[i].parameters.y );
+
+        const QByteArray& expected = segments[i].imageData;
+        BOOST_CHECK_EQUAL_COLLECTIONS( expected.constData(), expected.constData()+expected.size(),
+                                       dataOut, dataOut+expected.size() );
+        dataOut += expected.size();
+    }
+}
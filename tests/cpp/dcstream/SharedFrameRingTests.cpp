@@ -0,0 +1,121 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE SharedFrameRingTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "SharedFrameRing.h"
+
+#include <cstring>
+
+namespace
+{
+const uint32_t SLOT_COUNT = 3;
+const size_t SLOT_SIZE = 1000;
+}
+
+BOOST_AUTO_TEST_CASE( TestWriterWaitsForReader )
+{
+    dc::SharedFrameRing writer( SLOT_COUNT, SLOT_SIZE );
+    BOOST_REQUIRE( writer.isOpen( ));
+    BOOST_CHECK_EQUAL( writer.getSlotCount(), SLOT_COUNT );
+    BOOST_CHECK( writer.getSlotSize() >= SLOT_SIZE );
+
+    BOOST_CHECK( !writer.isReaderAttached( ));
+    BOOST_CHECK_EQUAL( writer.acquireSlot( 0 ), -1 );
+
+    {
+        dc::SharedFrameRing reader( writer.getName( ));
+        BOOST_REQUIRE( reader.isOpen( ));
+        BOOST_CHECK( writer.isReaderAttached( ));
+        BOOST_CHECK_EQUAL( reader.getSlotCount(), SLOT_COUNT );
+        BOOST_CHECK_EQUAL( reader.getSlotSize(), writer.getSlotSize( ));
+    }
+    BOOST_CHECK( !writer.isReaderAttached( ));
+}
+
+BOOST_AUTO_TEST_CASE( TestSlotDataIsShared )
+{
+    dc::SharedFrameRing writer( SLOT_COUNT, SLOT_SIZE );
+    dc::SharedFrameRing reader( writer.getName( ));
+    BOOST_REQUIRE( reader.isOpen( ));
+
+    const int slot = writer.acquireSlot( 0 );
+    BOOST_REQUIRE( slot >= 0 );
+    memset( writer.getSlotData( slot ), 42, SLOT_SIZE );
+
+    const unsigned char* data = reader.getSlotData( slot );
+    BOOST_REQUIRE( data );
+    BOOST_CHECK_EQUAL( data[0], 42 );
+    BOOST_CHECK_EQUAL( data[SLOT_SIZE-1], 42 );
+
+    BOOST_CHECK( !reader.getSlotData( SLOT_COUNT ));
+    BOOST_CHECK( !reader.getSlotData( -1 ));
+}
+
+BOOST_AUTO_TEST_CASE( TestSlotsAreReusedOnlyOnceReleased )
+{
+    dc::SharedFrameRing writer( SLOT_COUNT, SLOT_SIZE );
+    dc::SharedFrameRing reader( writer.getName( ));
+    BOOST_REQUIRE( reader.isOpen( ));
+
+    const int slot0 = writer.acquireSlot( 0 );
+    const int slot1 = writer.acquireSlot( 0 );
+    const int slot2 = writer.acquireSlot( 0 );
+    BOOST_CHECK_EQUAL( slot0, 0 );
+    BOOST_CHECK_EQUAL( slot1, 1 );
+    BOOST_CHECK_EQUAL( slot2, 2 );
+
+    // All the slots are being read
+    BOOST_CHECK_EQUAL( writer.acquireSlot( 10 ), -1 );
+
+    reader.releaseSlot( slot1 );
+    BOOST_CHECK_EQUAL( writer.acquireSlot( 0 ), slot1 );
+}
+
+BOOST_AUTO_TEST_CASE( TestNameIsUnlinkedOnceAttached )
+{
+    dc::SharedFrameRing writer( SLOT_COUNT, SLOT_SIZE );
+    dc::SharedFrameRing reader( writer.getName( ));
+    BOOST_REQUIRE( reader.isOpen( ));
+
+    dc::SharedFrameRing secondReader( writer.getName( ));
+    BOOST_CHECK( !secondReader.isOpen( ));
+}
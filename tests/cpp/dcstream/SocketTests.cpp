@@ -58,6 +58,7 @@ BOOST_AUTO_TEST_CASE( testSocketConnectionValidWhenReturnedCorrectNetworkProtoco
     dc::Socket socket( "localhost", server.serverPort());
 
     BOOST_CHECK( socket.isConnected() );
+    BOOST_CHECK( socket.isLocal() );
 
     thread.quit();
     thread.wait();
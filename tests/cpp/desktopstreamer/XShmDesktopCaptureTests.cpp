@@ -0,0 +1,127 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE XShmDesktopCapture
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "XShmDesktopCapture.h"
+
+#include <X11/Xlib.h>
+
+// The tests are skipped when no suitable X display is available; they are
+// meant to be run in a virtual framebuffer: xvfb-run -s "-screen 0 640x480x24"
+
+namespace
+{
+const QRect captureArea( 0, 0, 128, 96 );
+const QRect drawnRect( 16, 8, 32, 24 );
+
+void fillRootWindow( const QRect& rect, const unsigned long color )
+{
+    Display* display = XOpenDisplay( 0 );
+    const Window root = DefaultRootWindow( display );
+    GC gc = XCreateGC( display, root, 0, 0 );
+    XSetSubwindowMode( display, gc, IncludeInferiors );
+    XSetForeground( display, gc, color );
+    XFillRectangle( display, root, gc, rect.x(), rect.y(),
+                    rect.width(), rect.height( ));
+    XSync( display, False );
+    XFreeGC( display, gc );
+    XCloseDisplay( display );
+}
+}
+
+BOOST_AUTO_TEST_CASE( test_first_capture_reports_whole_image_as_damaged )
+{
+    XShmDesktopCapture capture;
+    if( !capture.isValid( ))
+        return;
+
+    QRegion damage;
+    const QImage image = capture.capture( captureArea, damage );
+
+    BOOST_REQUIRE( !image.isNull( ));
+    BOOST_CHECK( image.size() == captureArea.size( ));
+    BOOST_CHECK( image.format() == QImage::Format_RGB32 );
+    BOOST_CHECK( damage == QRegion( image.rect( )));
+}
+
+BOOST_AUTO_TEST_CASE( test_capture_reports_no_damage_when_idle )
+{
+    XShmDesktopCapture capture;
+    if( !capture.isValid( ))
+        return;
+
+    QRegion damage;
+    capture.capture( captureArea, damage );
+    BOOST_REQUIRE( !capture.capture( captureArea, damage ).isNull( ));
+
+    BOOST_CHECK( damage.isEmpty( ));
+}
+
+BOOST_AUTO_TEST_CASE( test_capture_reports_damage_and_content_of_changes )
+{
+    XShmDesktopCapture capture;
+    if( !capture.isValid( ))
+        return;
+
+    QRegion damage;
+    capture.capture( captureArea, damage );
+
+    fillRootWindow( drawnRect, 0xff0000 );
+    QImage image = capture.capture( captureArea, damage );
+    BOOST_REQUIRE( !image.isNull( ));
+
+    BOOST_CHECK( ( QRegion( drawnRect ) - damage ).isEmpty( ));
+    BOOST_CHECK_EQUAL( image.pixel( drawnRect.center( )), qRgb( 255, 0, 0 ));
+
+    // Damage is reported in image coordinates
+    const QRect shiftedArea = captureArea.translated( 8, 4 );
+    capture.capture( shiftedArea, damage );
+
+    fillRootWindow( drawnRect, 0x0000ff );
+    image = capture.capture( shiftedArea, damage );
+    BOOST_REQUIRE( !image.isNull( ));
+
+    const QRect expectedDamage = drawnRect.translated( -8, -4 );
+    BOOST_CHECK( ( QRegion( expectedDamage ) - damage ).isEmpty( ));
+    BOOST_CHECK_EQUAL( image.pixel( expectedDamage.center( )),
+                       qRgb( 0, 0, 255 ));
+}
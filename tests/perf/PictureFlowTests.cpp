@@ -0,0 +1,163 @@
+/*********************************************************************/
+/* Copyright (c) 2014, EPFL/Blue Brain Project                       */
+/*                     Raphael Dumusc <raphael.dumusc@epfl.ch>       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE PictureFlow
+#include <boost/test/unit_test.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+namespace ut = boost::unit_test;
+
+#include "GlobalQtApp.h"
+#include "localstreamer/Pictureflow.h"
+#include "localstreamer/PixelBlending.h"
+
+#include <QThread>
+
+// Compares the rendering speed of the Dock cover flow using a single thread
+// and all the processor cores, as well as the blending of the faded slides
+// with the per-channel division of the previous renderer.
+
+#define DOCK_WIDTH  (3840)
+#define DOCK_HEIGHT (1080)
+#define SLIDE_SIZE  (512)
+#define NSLIDES (32)
+#define NFRAMES (200)
+#define NBLENDS (1000)
+
+BOOST_GLOBAL_FIXTURE( GlobalQtApp )
+
+namespace
+{
+class Timer
+{
+public:
+    void start()
+    {
+        lastTime_ = boost::posix_time::microsec_clock::universal_time();
+    }
+
+    void restart()
+    {
+        start();
+    }
+
+    float elapsed()
+    {
+        const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+        return (float)(now - lastTime_).total_milliseconds();
+    }
+private:
+    boost::posix_time::ptime lastTime_;
+};
+
+// The blending used by the renderer before the SIMD implementation
+QRgb blendColorReference( const QRgb c1, const QRgb c2, const int blend )
+{
+    const int r = qRed(c1) * blend/256 + qRed(c2)*(256-blend)/256;
+    const int g = qGreen(c1) * blend/256 + qGreen(c2)*(256-blend)/256;
+    const int b = qBlue(c1) * blend/256 + qBlue(c2)*(256-blend)/256;
+    return qRgb(r, g, b);
+}
+
+float renderFrames( PictureFlow& flow )
+{
+    Timer timer;
+    timer.start();
+    for( int i = 0; i < NFRAMES; ++i )
+    {
+        flow.setCenterIndex( i % NSLIDES );
+        flow.render();
+    }
+    return timer.elapsed() / 1000.f;
+}
+}
+
+BOOST_AUTO_TEST_CASE( testRenderThroughput )
+{
+    if( !QApplication::instance( ))
+        return; // need X server to create a QWidget
+
+    PictureFlow flow;
+    flow.resize( DOCK_WIDTH, DOCK_HEIGHT );
+    flow.setSlideSize( QSize( SLIDE_SIZE, SLIDE_SIZE ));
+    flow.setReflectionEffect( PictureFlow::BlurredReflection );
+
+    for( int i = 0; i < NSLIDES; ++i )
+    {
+        QImage image( SLIDE_SIZE, SLIDE_SIZE, QImage::Format_RGB32 );
+        image.fill( qRgb( i * 7 % 256, i * 13 % 256, i * 29 % 256 ));
+        flow.addSlide( image, QString::number( i ));
+    }
+
+    // Prepare the surfaces of all the slides
+    flow.setRenderThreadCount( 1 );
+    renderFrames( flow );
+
+    float time = renderFrames( flow );
+    std::cout << "1 thread:  " << NFRAMES / time << " FPS" << std::endl;
+
+    flow.setRenderThreadCount( QThread::idealThreadCount( ));
+    time = renderFrames( flow );
+    std::cout << flow.renderThreadCount() << " threads: " << NFRAMES / time
+              << " FPS" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( testBlendThroughput )
+{
+    std::vector<QRgb> pixels( DOCK_HEIGHT );
+    for( size_t i = 0; i < pixels.size(); ++i )
+        pixels[i] = qrand();
+    const QRgb background = qRgb( 32, 64, 128 );
+    const size_t npixels = pixels.size() * NBLENDS;
+
+    Timer timer;
+    timer.start();
+    for( int i = 0; i < NBLENDS; ++i )
+        for( size_t j = 0; j < pixels.size(); ++j )
+            pixels[j] = blendColorReference( pixels[j], background, i % 256 );
+    float time = timer.elapsed() / 1000.f;
+    std::cout << "reference blend: " << npixels / float(1024*1024) / time
+              << " megapixel/s" << std::endl;
+
+    timer.restart();
+    for( int i = 0; i < NBLENDS; ++i )
+        blendPixels( pixels.data(), int(pixels.size( )), background, i % 256 );
+    time = timer.elapsed() / 1000.f;
+    std::cout << "simd blend: " << npixels / float(1024*1024) / time
+              << " megapixel/s" << std::endl;
+}